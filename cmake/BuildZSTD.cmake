@@ -24,6 +24,10 @@ macro(zstd_build)
         third_party/zstd/lib/compress/zstd_compress_superblock.c
         third_party/zstd/lib/compress/zstd_compress_sequences.c
         third_party/zstd/lib/compress/zstd_compress_literals.c
+        third_party/zstd/lib/dictBuilder/cover.c
+        third_party/zstd/lib/dictBuilder/fastcover.c
+        third_party/zstd/lib/dictBuilder/divsufsort.c
+        third_party/zstd/lib/dictBuilder/zdict.c
     )
 
     if (CC_HAS_WNO_IMPLICIT_FALLTHROUGH)
@@ -37,7 +41,8 @@ macro(zstd_build)
     set(ZSTD_LIBRARIES zstd)
     set(ZSTD_INCLUDE_DIRS
             ${CMAKE_CURRENT_SOURCE_DIR}/third_party/zstd/lib
-            ${CMAKE_CURRENT_SOURCE_DIR}/third_party/zstd/lib/common)
+            ${CMAKE_CURRENT_SOURCE_DIR}/third_party/zstd/lib/common
+            ${CMAKE_CURRENT_SOURCE_DIR}/third_party/zstd/lib/dictBuilder)
     include_directories(${ZSTD_INCLUDE_DIRS})
     find_package_message(ZSTD "Using bundled ZSTD"
         "${ZSTD_LIBRARIES}:${ZSTD_INCLUDE_DIRS}")
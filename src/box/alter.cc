@@ -240,6 +240,45 @@ index_opts_decode(struct index_opts *opts, const char *map,
 			 "less than or equal to 1");
 		return -1;
 	}
+	if (opts->compaction_strategy == index_compaction_strategy_MAX) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 BOX_INDEX_FIELD_OPTS, "compaction_strategy must be "
+			 "either leveled or tiered");
+		return -1;
+	}
+	if (opts->compaction_ttl < 0) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 BOX_INDEX_FIELD_OPTS,
+			 "compaction_ttl must be greater than or equal to 0");
+		return -1;
+	}
+	if (opts->compression == index_compression_MAX) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 BOX_INDEX_FIELD_OPTS,
+			 "compression must be either none or zstd");
+		return -1;
+	}
+	if (opts->compression_level < 1 ||
+	    opts->compression_level > INDEX_COMPRESSION_LEVEL_MAX) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 BOX_INDEX_FIELD_OPTS,
+			 tt_sprintf("compression_level must be between 1 "
+				    "and %d", INDEX_COMPRESSION_LEVEL_MAX));
+		return -1;
+	}
+	if (opts->cache_share < 0 || opts->cache_share > 1) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 BOX_INDEX_FIELD_OPTS,
+			 "cache_share must be between 0 and 1");
+		return -1;
+	}
+	if (opts->readahead_pages > INDEX_READAHEAD_PAGES_MAX) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 BOX_INDEX_FIELD_OPTS,
+			 tt_sprintf("readahead_pages must be less than or "
+				    "equal to %d", INDEX_READAHEAD_PAGES_MAX));
+		return -1;
+	}
 	return 0;
 }
 
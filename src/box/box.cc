@@ -82,6 +82,7 @@
 #include "msgpack.h"
 #include "raft.h"
 #include "trivia/util.h"
+#include "version.h"
 
 enum {
 	IPROTO_THREADS_MAX = 1000,
@@ -206,6 +207,18 @@ box_check_memtx_min_tuple_size(ssize_t memtx_min_tuple_size)
 		  "specified value is out of bounds");
 }
 
+static int
+box_check_memtx_checkpoint_max_deltas(void)
+{
+	int max_deltas = cfg_geti("memtx_checkpoint_max_deltas");
+	if (max_deltas < 0) {
+		diag_set(ClientError, ER_CFG, "memtx_checkpoint_max_deltas",
+			 "must be greater than or equal to 0");
+		return -1;
+	}
+	return max_deltas;
+}
+
 int
 box_process_rw(struct request *request, struct space *space,
 	       struct tuple **result)
@@ -217,7 +230,9 @@ box_process_rw(struct request *request, struct space *space,
 	if (is_autocommit && (txn = txn_begin()) == NULL)
 		return -1;
 	assert(iproto_type_is_dml(request->type));
-	rmean_collect(rmean_box, request->type, 1);
+	/* Range deletions are accounted as DELETE in box.stat(). */
+	rmean_collect(rmean_box, request->type == IPROTO_DELETE_RANGE ?
+		      IPROTO_DELETE : request->type, 1);
 	if (access_check_space(space, PRIV_W) != 0)
 		goto rollback;
 	if (txn_begin_stmt(txn, space, request->type) != 0)
@@ -998,6 +1013,72 @@ box_check_wal_cleanup_delay(void)
 	return value;
 }
 
+static double
+box_check_wal_commit_delay(void)
+{
+	double value = cfg_getd("wal_commit_delay");
+	if (value < 0) {
+		diag_set(ClientError, ER_CFG, "wal_commit_delay",
+			 "value must be >= 0");
+		return -1;
+	}
+	return value;
+}
+
+static int64_t
+box_check_wal_commit_min_size(void)
+{
+	int64_t size = cfg_geti64("wal_commit_min_size");
+	if (size < 0) {
+		diag_set(ClientError, ER_CFG, "wal_commit_min_size",
+			 "value must be >= 0");
+		return -1;
+	}
+	return size;
+}
+
+static int
+box_check_wal_spare_files(void)
+{
+	int count = cfg_geti("wal_spare_files");
+	if (count < 0 || count > WAL_SPARE_FILES_MAX) {
+		diag_set(ClientError, ER_CFG, "wal_spare_files",
+			 tt_sprintf("the value must be between 0 and %d",
+				    WAL_SPARE_FILES_MAX));
+		return -1;
+	}
+	return count;
+}
+
+static int
+box_check_wal_compression(void)
+{
+	const char *name = cfg_gets("wal_compression");
+	int compression = strindex(wal_compression_strs, name,
+				   wal_compression_MAX);
+	if (compression == wal_compression_MAX) {
+		diag_set(ClientError, ER_CFG, "wal_compression",
+			 "the value must be either none or zstd");
+		return -1;
+	}
+	return compression;
+}
+
+static int
+box_check_wal_compression_level(int *level)
+{
+	*level = cfg_geti("wal_compression_level");
+	if (*level < WAL_COMPRESSION_LEVEL_MIN ||
+	    *level > WAL_COMPRESSION_LEVEL_MAX) {
+		diag_set(ClientError, ER_CFG, "wal_compression_level",
+			 tt_sprintf("the value must be between %d and %d",
+				    WAL_COMPRESSION_LEVEL_MIN,
+				    WAL_COMPRESSION_LEVEL_MAX));
+		return -1;
+	}
+	return 0;
+}
+
 static void
 box_check_readahead(int readahead)
 {
@@ -1041,6 +1122,55 @@ box_check_memory_quota(const char *quota_name)
 	return -1;
 }
 
+static int
+box_check_vinyl_max_subcompactions(void)
+{
+	int count = cfg_geti("vinyl_max_subcompactions");
+	if (count <= 0) {
+		diag_set(ClientError, ER_CFG, "vinyl_max_subcompactions",
+			 "must be greater than 0");
+		return -1;
+	}
+	return count;
+}
+
+static int
+box_check_vinyl_upsert_squash_threshold(void)
+{
+	int threshold = cfg_geti("vinyl_upsert_squash_threshold");
+	if (threshold < 0 || threshold > VINYL_UPSERT_SQUASH_THRESHOLD_MAX) {
+		diag_set(ClientError, ER_CFG, "vinyl_upsert_squash_threshold",
+			 tt_sprintf("the value must be between 0 and %d",
+				    VINYL_UPSERT_SQUASH_THRESHOLD_MAX));
+		return -1;
+	}
+	return threshold;
+}
+
+static double
+box_check_vinyl_max_write_stall(void)
+{
+	double timeout = cfg_getd("vinyl_max_write_stall");
+	if (timeout < 0) {
+		diag_set(ClientError, ER_CFG, "vinyl_max_write_stall",
+			 "must be greater than or equal to 0");
+		return -1;
+	}
+	return timeout;
+}
+
+static int64_t
+box_check_vinyl_max_compaction_debt(void)
+{
+	int64_t size = cfg_geti64("vinyl_max_compaction_debt");
+	if (size < 0) {
+		diag_set(ClientError, ER_CFG, "vinyl_max_compaction_debt",
+			 "must be greater than or equal to 0");
+		return -1;
+	}
+	return size;
+}
+
 static void
 box_check_vinyl_options(void)
 {
@@ -1054,6 +1184,16 @@ box_check_vinyl_options(void)
 
 	if (box_check_memory_quota("vinyl_memory") < 0)
 		diag_raise();
+	if (box_check_memory_quota("vinyl_page_index_cache") < 0)
+		diag_raise();
+	if (box_check_vinyl_max_subcompactions() < 0)
+		diag_raise();
+	if (box_check_vinyl_upsert_squash_threshold() < 0)
+		diag_raise();
+	if (box_check_vinyl_max_write_stall() < 0)
+		diag_raise();
+	if (box_check_vinyl_max_compaction_debt() < 0)
+		diag_raise();
 
 	if (read_threads < 1) {
 		tnt_raise(ClientError, ER_CFG, "vinyl_read_threads",
@@ -1162,9 +1302,22 @@ box_check_config(void)
 		diag_raise();
 	if (box_check_wal_cleanup_delay() < 0)
 		diag_raise();
+	if (box_check_wal_commit_delay() < 0)
+		diag_raise();
+	if (box_check_wal_commit_min_size() < 0)
+		diag_raise();
+	int wal_compression_level;
+	if (box_check_wal_compression() < 0)
+		diag_raise();
+	if (box_check_wal_compression_level(&wal_compression_level) != 0)
+		diag_raise();
+	if (box_check_wal_spare_files() < 0)
+		diag_raise();
 	if (box_check_memory_quota("memtx_memory") < 0)
 		diag_raise();
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
+	if (box_check_memtx_checkpoint_max_deltas() < 0)
+		diag_raise();
 	box_check_small_alloc_options();
 	box_check_vinyl_options();
 	if (box_check_iproto_options() != 0)
@@ -1764,6 +1917,18 @@ box_set_memtx_max_tuple_size(void)
 			cfg_geti("memtx_max_tuple_size"));
 }
 
+void
+box_set_memtx_checkpoint_max_deltas(void)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	int max_deltas = box_check_memtx_checkpoint_max_deltas();
+	if (max_deltas < 0)
+		diag_raise();
+	memtx_engine_set_checkpoint_max_deltas(memtx, max_deltas);
+}
+
 void
 box_set_too_long_threshold(void)
 {
@@ -1814,6 +1979,55 @@ box_set_wal_queue_max_size(void)
 	return 0;
 }
 
+int
+box_set_wal_commit_delay(void)
+{
+	double delay = box_check_wal_commit_delay();
+	if (delay < 0)
+		return -1;
+	wal_set_commit_delay(delay);
+	return 0;
+}
+
+int
+box_set_wal_commit_min_size(void)
+{
+	int64_t size = box_check_wal_commit_min_size();
+	if (size < 0)
+		return -1;
+	wal_set_commit_min_size(size);
+	return 0;
+}
+
+void
+box_set_wal_direct_io(void)
+{
+	wal_set_direct_io(cfg_geti("wal_direct_io") != 0);
+}
+
+int
+box_set_wal_compression(void)
+{
+	int compression = box_check_wal_compression();
+	if (compression < 0)
+		return -1;
+	int level;
+	if (box_check_wal_compression_level(&level) != 0)
+		return -1;
+	wal_set_compression((enum wal_compression)compression, level);
+	return 0;
+}
+
+int
+box_set_wal_spare_files(void)
+{
+	int count = box_check_wal_spare_files();
+	if (count < 0)
+		return -1;
+	wal_set_spare_files(count);
+	return 0;
+}
+
 int
 box_set_wal_cleanup_delay(void)
 {
@@ -1859,6 +2073,61 @@ box_set_vinyl_cache(void)
 	vinyl_engine_set_cache(vinyl, cfg_geti64("vinyl_cache"));
 }
 
+void
+box_set_vinyl_page_index_cache(void)
+{
+	struct engine *vinyl = engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	ssize_t size = box_check_memory_quota("vinyl_page_index_cache");
+	if (size < 0)
+		diag_raise();
+	vinyl_engine_set_page_index_cache(vinyl, size);
+}
+
+void
+box_set_vinyl_max_subcompactions(void)
+{
+	struct engine *vinyl = engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	int count = box_check_vinyl_max_subcompactions();
+	if (count < 0)
+		diag_raise();
+	vinyl_engine_set_max_subcompactions(vinyl, count);
+}
+
+void
+box_set_vinyl_max_write_stall(void)
+{
+	struct engine *vinyl = engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	double timeout = box_check_vinyl_max_write_stall();
+	if (timeout < 0)
+		diag_raise();
+	vinyl_engine_set_max_write_stall(vinyl, timeout);
+}
+
+void
+box_set_vinyl_max_compaction_debt(void)
+{
+	struct engine *vinyl = engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	int64_t size = box_check_vinyl_max_compaction_debt();
+	if (size < 0)
+		diag_raise();
+	vinyl_engine_set_max_compaction_debt(vinyl, size);
+}
+
+void
+box_set_vinyl_upsert_squash_threshold(void)
+{
+	struct engine *vinyl = engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	int threshold = box_check_vinyl_upsert_squash_threshold();
+	if (threshold < 0)
+		diag_raise();
+	vinyl_engine_set_upsert_squash_threshold(vinyl, threshold);
+}
+
 void
 box_set_vinyl_timeout(void)
 {
@@ -2067,11 +2336,11 @@ box_process1(struct request *request, box_tuple_t **result)
 	return box_process_rw(request, space, result);
 }
 
-API_EXPORT int
-box_select(uint32_t space_id, uint32_t index_id,
-	   int iterator, uint32_t offset, uint32_t limit,
-	   const char *key, const char *key_end,
-	   struct port *port)
+int
+box_select_ex(uint32_t space_id, uint32_t index_id,
+	      int iterator, uint32_t offset, uint32_t limit,
+	      const char *key, const char *key_end, bool is_covering,
+	      bool fill_cache, struct port *port)
 {
 	(void)key_end;
 
@@ -2108,12 +2377,14 @@ box_select(uint32_t space_id, uint32_t index_id,
 	if (txn_begin_ro_stmt(space, &txn, &svp) != 0)
 		return -1;
 
-	struct iterator *it = index_create_iterator(index, type,
-						    key, part_count);
+	struct iterator *it = is_covering ?
+		index_create_covering_iterator(index, type, key, part_count) :
+		index_create_iterator(index, type, key, part_count);
 	if (it == NULL) {
 		txn_rollback_stmt(txn);
 		return -1;
 	}
+	it->fill_cache = fill_cache;
 
 	int rc = 0;
 	uint32_t found = 0;
@@ -2143,6 +2414,16 @@ box_select(uint32_t space_id, uint32_t index_id,
 	return 0;
 }
 
+API_EXPORT int
+box_select(uint32_t space_id, uint32_t index_id,
+	   int iterator, uint32_t offset, uint32_t limit,
+	   const char *key, const char *key_end,
+	   struct port *port)
+{
+	return box_select_ex(space_id, index_id, iterator, offset, limit,
+			     key, key_end, false, true, port);
+}
+
 API_EXPORT int
 box_insert(uint32_t space_id, const char *tuple, const char *tuple_end,
 	   box_tuple_t **result)
@@ -2186,6 +2467,63 @@ box_delete(uint32_t space_id, uint32_t index_id, const char *key,
 	return box_process1(&request, result);
 }
 
+/**
+ * DELETE_RANGE isn't part of the upstream protocol so a replica
+ * that doesn't know it fails to apply the row. Allow it only if
+ * every other replica of the replica set is following this
+ * instance and runs a version not older than ours. A replica
+ * that isn't connected may run any version, so it blocks range
+ * deletion, too.
+ */
+static int
+box_check_delete_range_replicas(void)
+{
+	replicaset_foreach(replica) {
+		if (tt_uuid_is_equal(&replica->uuid, &INSTANCE_UUID))
+			continue;
+		if (replica->relay == NULL ||
+		    relay_get_state(replica->relay) != RELAY_FOLLOW ||
+		    relay_get_version_id(replica->relay) <
+		    tarantool_version_id()) {
+			diag_set(ClientError, ER_UNSUPPORTED,
+				 tt_sprintf("Replica %s",
+					    tt_uuid_str(&replica->uuid)),
+				 "delete_range()");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int
+box_delete_range(uint32_t space_id, uint32_t index_id, const char *key,
+		 const char *key_end, const char *key_last,
+		 const char *key_last_end)
+{
+	mp_tuple_assert(key, key_end);
+	mp_tuple_assert(key_last, key_last_end);
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return -1;
+	if (!space_is_vinyl(space)) {
+		diag_set(ClientError, ER_UNSUPPORTED, space->engine->name,
+			 "delete_range()");
+		return -1;
+	}
+	if (box_check_delete_range_replicas() != 0)
+		return -1;
+	struct request request;
+	memset(&request, 0, sizeof(request));
+	request.type = IPROTO_DELETE_RANGE;
+	request.space_id = space_id;
+	request.index_id = index_id;
+	request.key = key;
+	request.key_end = key_end;
+	request.tuple = key_last;
+	request.tuple_end = key_last_end;
+	return box_process1(&request, NULL);
+}
+
 API_EXPORT int
 box_update(uint32_t space_id, uint32_t index_id, const char *key,
 	   const char *key_end, const char *ops, const char *ops_end,
@@ -2949,6 +3287,7 @@ engine_init()
 				    cfg_getd("slab_alloc_factor"));
 	engine_register((struct engine *)memtx);
 	box_set_memtx_max_tuple_size();
+	box_set_memtx_checkpoint_max_deltas();
 
 	struct sysview_engine *sysview = sysview_engine_new_xc();
 	engine_register((struct engine *)sysview);
@@ -2968,6 +3307,11 @@ engine_init()
 	engine_register((struct engine *)vinyl);
 	box_set_vinyl_max_tuple_size();
 	box_set_vinyl_cache();
+	box_set_vinyl_page_index_cache();
+	box_set_vinyl_max_subcompactions();
+	box_set_vinyl_upsert_squash_threshold();
+	box_set_vinyl_max_write_stall();
+	box_set_vinyl_max_compaction_debt();
 	box_set_vinyl_timeout();
 }
 
@@ -3240,6 +3584,8 @@ local_recovery(const struct tt_uuid *instance_uuid,
 	memtx_engine_recover_snapshot_xc(memtx, checkpoint_vclock);
 
 	engine_begin_final_recovery_xc();
+	if (cfg_geti("wal_recovery_read_ahead"))
+		recover_wals_read_ahead(recovery, &wal_stream.base);
 	recover_remaining_wals(recovery, &wal_stream.base, NULL, false);
 	if (wal_stream_has_tx(&wal_stream)) {
 		diag_set(XlogError, "found a not finished transaction "
@@ -3624,5 +3970,6 @@ box_reset_stat(void)
 	rmean_cleanup(rmean_box);
 	rmean_cleanup(rmean_error);
 	engine_reset_stat();
+	wal_reset_stat();
 	space_foreach(box_reset_space_stat, NULL);
 }
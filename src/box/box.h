@@ -244,11 +244,22 @@ void box_set_checkpoint_interval(void);
 void box_set_checkpoint_wal_threshold(void);
 int box_set_wal_queue_max_size(void);
 int box_set_wal_cleanup_delay(void);
+int box_set_wal_commit_delay(void);
+int box_set_wal_commit_min_size(void);
+int box_set_wal_spare_files(void);
+void box_set_wal_direct_io(void);
+int box_set_wal_compression(void);
 void box_set_memtx_memory(void);
 void box_set_memtx_max_tuple_size(void);
+void box_set_memtx_checkpoint_max_deltas(void);
 void box_set_vinyl_memory(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
+void box_set_vinyl_page_index_cache(void);
+void box_set_vinyl_max_subcompactions(void);
+void box_set_vinyl_upsert_squash_threshold(void);
+void box_set_vinyl_max_write_stall(void);
+void box_set_vinyl_max_compaction_debt(void);
 void box_set_vinyl_timeout(void);
 int box_set_election_mode(void);
 int box_set_election_timeout(void);
@@ -283,6 +294,24 @@ box_select(uint32_t space_id, uint32_t index_id,
 	   const char *key, const char *key_end,
 	   struct port *port);
 
+/**
+ * Same as box_select(), but takes extra options.
+ *
+ * If @a is_covering is set, the index is only required to return
+ * indexed fields and fields covered by the index: other fields
+ * of returned tuples may be set to nil. Lets a covering vinyl
+ * index skip primary index lookups.
+ *
+ * If @a fill_cache is unset, tuples read by the request aren't
+ * added to the engine read cache. Useful for big scans that
+ * would otherwise evict the working set from the cache.
+ */
+int
+box_select_ex(uint32_t space_id, uint32_t index_id,
+	      int iterator, uint32_t offset, uint32_t limit,
+	      const char *key, const char *key_end, bool is_covering,
+	      bool fill_cache, struct port *port);
+
 /** \cond public */
 
 /*
@@ -512,6 +541,31 @@ box_session_push(const char *data, const char *data_end);
 
 /** \endcond public */
 
+/**
+ * Execute a DELETE_RANGE request: delete all tuples whose keys
+ * are within [key, key_last]. Partial keys are allowed. Only
+ * supported by the primary index of a vinyl space and must be
+ * the only statement of its transaction. DELETE_RANGE isn't part
+ * of the upstream protocol so it's refused unless all replicas
+ * following this instance are known to support it. Not a part
+ * of the module API for the same reason.
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier
+ * \param key encoded lower bound in MsgPack Array format.
+ * \param key_end the end of encoded \a key.
+ * \param key_last encoded upper bound in MsgPack Array format.
+ * \param key_last_end the end of encoded \a key_last.
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ * \sa \code box.space[space_id].index[index_id]:delete_range(key, key_last)
+ * \endcode
+ */
+int
+box_delete_range(uint32_t space_id, uint32_t index_id, const char *key,
+		 const char *key_end, const char *key_last,
+		 const char *key_last_end);
+
 /**
  * Used to be entry point to the
  * Box: callbacks into the request processor.
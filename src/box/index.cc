@@ -450,6 +450,7 @@ iterator_create(struct iterator *it, struct index *index)
 	it->space_id = index->def->space_id;
 	it->index_id = index->def->iid;
 	it->index = index;
+	it->fill_cache = true;
 }
 
 int
@@ -720,6 +721,14 @@ generic_index_create_iterator(struct index *base, enum iterator_type type,
 	return NULL;
 }
 
+struct iterator *
+generic_index_create_covering_iterator(struct index *index,
+				       enum iterator_type type,
+				       const char *key, uint32_t part_count)
+{
+	/* Full tuples contain all covered fields. */
+	return index_create_iterator(index, type, key, part_count);
+}
 
 struct snapshot_iterator *
 generic_index_create_snapshot_iterator(struct index *index)
@@ -257,6 +257,11 @@ struct iterator {
 	 * state has not changed since the last lookup.
 	 */
 	struct index *index;
+	/**
+	 * If unset, tuples read by the iterator aren't added
+	 * to the engine read cache. Set by default.
+	 */
+	bool fill_cache;
 };
 
 /**
@@ -300,6 +305,12 @@ struct snapshot_iterator {
 	 * Destroy the iterator.
 	 */
 	void (*free)(struct snapshot_iterator *);
+	/**
+	 * Snapshot generation of the tuple returned by the last
+	 * call to next(). Only set by memtx iterators, see
+	 * memtx_engine::snapshot_version.
+	 */
+	uint32_t version;
 };
 
 /**
@@ -430,6 +441,15 @@ struct index_vtab {
 	struct iterator *(*create_iterator)(struct index *index,
 			enum iterator_type type,
 			const char *key, uint32_t part_count);
+	/**
+	 * Create an index iterator that is only required to
+	 * return indexed fields and fields covered by the index
+	 * (see index_opts::covers). Other fields of returned
+	 * tuples may be set to nil.
+	 */
+	struct iterator *(*create_covering_iterator)(struct index *index,
+			enum iterator_type type,
+			const char *key, uint32_t part_count);
 	/**
 	 * Create an ALL iterator with personal read view so further
 	 * index modifications will not affect the iteration results.
@@ -683,6 +703,14 @@ index_create_iterator(struct index *index, enum iterator_type type,
 	return index->vtab->create_iterator(index, type, key, part_count);
 }
 
+static inline struct iterator *
+index_create_covering_iterator(struct index *index, enum iterator_type type,
+			       const char *key, uint32_t part_count)
+{
+	return index->vtab->create_covering_iterator(index, type,
+						     key, part_count);
+}
+
 static inline struct snapshot_iterator *
 index_create_snapshot_iterator(struct index *index)
 {
@@ -762,6 +790,10 @@ int generic_index_reserve(struct index *, uint32_t);
 struct iterator *
 generic_index_create_iterator(struct index *base, enum iterator_type type,
 			      const char *key, uint32_t part_count);
+struct iterator *
+generic_index_create_covering_iterator(struct index *index,
+				       enum iterator_type type,
+				       const char *key, uint32_t part_count);
 int generic_index_build_next(struct index *, struct tuple *);
 void generic_index_end_build(struct index *);
 int
@@ -34,11 +34,16 @@
 #include "tuple_format.h"
 #include "json/json.h"
 #include "fiber.h"
+#include "column_mask.h"
 
 const char *index_type_strs[] = { "HASH", "TREE", "BITSET", "RTREE" };
 
 const char *rtree_index_distance_type_strs[] = { "EUCLID", "MANHATTAN" };
 
+const char *index_compaction_strategy_strs[] = { "leveled", "tiered" };
+
+const char *index_compression_strs[] = { "none", "zstd" };
+
 const struct index_opts index_opts_default = {
 	/* .unique              = */ true,
 	/* .dimension           = */ 2,
@@ -48,12 +53,47 @@ const struct index_opts index_opts_default = {
 	/* .run_count_per_level = */ 2,
 	/* .run_size_ratio      = */ 3.5,
 	/* .bloom_fpr           = */ 0.05,
+	/* .compaction_strategy = */ INDEX_COMPACTION_LEVELED,
+	/* .compaction_ttl      = */ 0,
+	/* .blob_threshold      = */ 0,
+	/* .compression         = */ INDEX_COMPRESSION_ZSTD,
+	/* .compression_level   = */ 3,
+	/* .compression_dict_size = */ 0,
+	/* .covers              = */ 0,
+	/* .cache_share         = */ 1,
+	/* .readahead_pages     = */ 0,
 	/* .lsn                 = */ 0,
 	/* .stat                = */ NULL,
 	/* .func                = */ 0,
 	/* .hint                = */ true,
 };
 
+/**
+ * Decode the array of covered field numbers into a column mask.
+ */
+static int
+index_opts_covers_decode(const char **str, uint32_t len, char *opt,
+			 uint32_t errcode, uint32_t field_no)
+{
+	uint64_t covers = 0;
+	for (uint32_t i = 0; i < len; i++) {
+		if (mp_typeof(**str) != MP_UINT) {
+			diag_set(ClientError, errcode, field_no,
+				 "covers must be an array of field numbers");
+			return -1;
+		}
+		uint64_t fieldno = mp_decode_uint(str);
+		if (fieldno >= 63) {
+			diag_set(ClientError, errcode, field_no,
+				 "covers may only include the first 63 fields");
+			return -1;
+		}
+		column_mask_set_fieldno(&covers, fieldno);
+	}
+	memcpy(opt, &covers, sizeof(covers));
+	return 0;
+}
+
 const struct opt_def index_opts_reg[] = {
 	OPT_DEF("unique", OPT_BOOL, struct index_opts, is_unique),
 	OPT_DEF("dimension", OPT_INT64, struct index_opts, dimension),
@@ -64,6 +104,21 @@ const struct opt_def index_opts_reg[] = {
 	OPT_DEF("run_count_per_level", OPT_INT64, struct index_opts, run_count_per_level),
 	OPT_DEF("run_size_ratio", OPT_FLOAT, struct index_opts, run_size_ratio),
 	OPT_DEF("bloom_fpr", OPT_FLOAT, struct index_opts, bloom_fpr),
+	OPT_DEF_ENUM("compaction_strategy", index_compaction_strategy,
+		     struct index_opts, compaction_strategy, NULL),
+	OPT_DEF("compaction_ttl", OPT_FLOAT, struct index_opts, compaction_ttl),
+	OPT_DEF("blob_threshold", OPT_UINT32, struct index_opts, blob_threshold),
+	OPT_DEF_ENUM("compression", index_compression, struct index_opts,
+		     compression, NULL),
+	OPT_DEF("compression_level", OPT_UINT32, struct index_opts,
+		compression_level),
+	OPT_DEF("compression_dict_size", OPT_UINT32, struct index_opts,
+		compression_dict_size),
+	OPT_DEF_ARRAY("covers", struct index_opts, covers,
+		      index_opts_covers_decode),
+	OPT_DEF("cache_share", OPT_FLOAT, struct index_opts, cache_share),
+	OPT_DEF("readahead_pages", OPT_UINT32, struct index_opts,
+		readahead_pages),
 	OPT_DEF("lsn", OPT_INT64, struct index_opts, lsn),
 	OPT_DEF("func", OPT_UINT32, struct index_opts, func_id),
 	OPT_DEF_LEGACY("sql"),
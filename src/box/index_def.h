@@ -58,6 +58,43 @@ enum rtree_index_distance_type {
 };
 extern const char *rtree_index_distance_type_strs[];
 
+/** Vinyl LSM tree compaction strategy. */
+enum index_compaction_strategy {
+	/**
+	 * Keep a fixed number of runs per level and compact
+	 * a level into the next one as soon as it overflows.
+	 * The last level always holds a single run. Keeps read
+	 * and space amplification low.
+	 */
+	INDEX_COMPACTION_LEVELED,
+	/**
+	 * Let runs of similar size accumulate and compact them
+	 * together only when their number exceeds the limit.
+	 * Each statement is rewritten once per tier, which cuts
+	 * write amplification at the cost of more runs to read.
+	 */
+	INDEX_COMPACTION_TIERED,
+	index_compaction_strategy_MAX
+};
+extern const char *index_compaction_strategy_strs[];
+
+/** Compression codec of vinyl run pages. */
+enum index_compression {
+	/** Store pages uncompressed. Fastest to read. */
+	INDEX_COMPRESSION_NONE,
+	/** Compress pages with zstd. */
+	INDEX_COMPRESSION_ZSTD,
+	index_compression_MAX
+};
+extern const char *index_compression_strs[];
+
+enum {
+	/** Max zstd compression level of vinyl run pages. */
+	INDEX_COMPRESSION_LEVEL_MAX = 22,
+	/** Max number of pages a vinyl run iterator reads ahead. */
+	INDEX_READAHEAD_PAGES_MAX = 64,
+};
+
 /** Simple alias to represent logarithm metrics. */
 typedef int16_t log_est_t;
 
@@ -153,6 +190,48 @@ struct index_opts {
 	double run_size_ratio;
 	/* Bloom filter false positive rate. */
 	double bloom_fpr;
+	/** Vinyl LSM tree compaction strategy. */
+	enum index_compaction_strategy compaction_strategy;
+	/**
+	 * If a range of a vinyl LSM tree hasn't been compacted
+	 * entirely for longer than this many seconds, it is
+	 * scheduled for compaction. 0 disables the feature.
+	 */
+	double compaction_ttl;
+	/**
+	 * Values of non-indexed fields of a vinyl primary index
+	 * that are at least this many bytes long are stored out
+	 * of run files, in blob files. 0 disables the feature.
+	 */
+	uint32_t blob_threshold;
+	/** Compression codec of vinyl run pages. */
+	enum index_compression compression;
+	/** Zstd compression level of vinyl run pages. */
+	uint32_t compression_level;
+	/**
+	 * If greater than 0, a zstd dictionary of up to this many
+	 * bytes is trained on the data of each compacted vinyl run
+	 * and used for compressing its pages.
+	 */
+	uint32_t compression_dict_size;
+	/**
+	 * Column mask of non-indexed fields stored in a vinyl
+	 * secondary index along with the key so that a read that
+	 * only needs these fields can skip the primary index
+	 * lookup. 0 if the index doesn't cover any fields.
+	 */
+	uint64_t covers;
+	/**
+	 * Max share of the vinyl tuple cache that may be occupied
+	 * by statements of this index, from 0 to 1. Lets limit
+	 * the cache footprint of an index that is mostly scanned.
+	 */
+	double cache_share;
+	/**
+	 * Max number of pages a vinyl run iterator reads ahead
+	 * once it detects sequential access. 0 disables readahead.
+	 */
+	uint32_t readahead_pages;
 	/**
 	 * LSN from the time of index creation.
 	 */
@@ -213,6 +292,26 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->run_size_ratio < o2->run_size_ratio ? -1 : 1;
 	if (o1->bloom_fpr != o2->bloom_fpr)
 		return o1->bloom_fpr < o2->bloom_fpr ? -1 : 1;
+	if (o1->compaction_strategy != o2->compaction_strategy)
+		return o1->compaction_strategy < o2->compaction_strategy ?
+		       -1 : 1;
+	if (o1->compaction_ttl != o2->compaction_ttl)
+		return o1->compaction_ttl < o2->compaction_ttl ? -1 : 1;
+	if (o1->blob_threshold != o2->blob_threshold)
+		return o1->blob_threshold < o2->blob_threshold ? -1 : 1;
+	if (o1->compression != o2->compression)
+		return o1->compression < o2->compression ? -1 : 1;
+	if (o1->compression_level != o2->compression_level)
+		return o1->compression_level < o2->compression_level ? -1 : 1;
+	if (o1->compression_dict_size != o2->compression_dict_size)
+		return o1->compression_dict_size <
+		       o2->compression_dict_size ? -1 : 1;
+	if (o1->covers != o2->covers)
+		return o1->covers < o2->covers ? -1 : 1;
+	if (o1->cache_share != o2->cache_share)
+		return o1->cache_share < o2->cache_share ? -1 : 1;
+	if (o1->readahead_pages != o2->readahead_pages)
+		return o1->readahead_pages < o2->readahead_pages ? -1 : 1;
 	if (o1->func_id != o2->func_id)
 		return o1->func_id - o2->func_id;
 	if (o1->hint != o2->hint)
@@ -278,6 +278,24 @@ const char *vy_run_info_key_strs[VY_RUN_INFO_KEY_MAX] = {
 	"bloom filter legacy",
 	"bloom filter",
 	"stmt stat",
+	"part count",
+	"blobs",
+	"dict",
+};
+
+const char *vy_part_info_key_strs[VY_PART_INFO_KEY_MAX] = {
+	NULL,
+	"offset",
+	"size",
+	"unpacked size",
+	"page count",
+	"min key",
+	"row count",
+	"bytes",
+	"bytes compressed",
+	"index size",
+	"bloom size",
+	"bloom filter",
 };
 
 const char *vy_row_index_key_strs[VY_ROW_INDEX_KEY_MAX] = {
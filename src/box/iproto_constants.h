@@ -268,10 +268,25 @@ enum iproto_type {
 	VY_INDEX_PAGE_INFO = 101,
 	/** Vinyl row index stored in .run file */
 	VY_RUN_ROW_INDEX = 102,
+	/** Vinyl page index partition info stored in .index file */
+	VY_INDEX_PART_INFO = 103,
 
 	/** Non-final response type. */
 	IPROTO_CHUNK = 128,
 
+	/**
+	 * Types of requests that aren't part of the upstream protocol
+	 * are allocated starting from this value, far away from the
+	 * ranges upstream uses, so that they never collide.
+	 */
+	IPROTO_TYPE_VENDOR_MIN = 1 << 14,
+	/**
+	 * DELETE_RANGE request: delete all tuples whose primary
+	 * keys fall in [KEY, TUPLE]. Only written to WAL, not
+	 * accepted from network clients.
+	 */
+	IPROTO_DELETE_RANGE = IPROTO_TYPE_VENDOR_MIN,
+
 	/**
 	 * Error codes = (IPROTO_TYPE_ERROR | ER_XXX from errcode.h)
 	 */
@@ -306,6 +321,8 @@ iproto_type_name(uint16_t type)
 		return iproto_type_strs[type];
 
 	switch (type) {
+	case IPROTO_DELETE_RANGE:
+		return "DELETE_RANGE";
 	case IPROTO_RAFT:
 		return "RAFT";
 	case IPROTO_PROMOTE:
@@ -320,6 +337,8 @@ iproto_type_name(uint16_t type)
 		return "PAGEINFO";
 	case VY_RUN_ROW_INDEX:
 		return "ROWINDEX";
+	case VY_INDEX_PART_INFO:
+		return "PARTINFO";
 	default:
 		return NULL;
 	}
@@ -343,7 +362,8 @@ static inline bool
 iproto_type_is_dml(uint16_t type)
 {
 	return (type >= IPROTO_SELECT && type <= IPROTO_DELETE) ||
-		type == IPROTO_UPSERT || type == IPROTO_NOP;
+		type == IPROTO_UPSERT || type == IPROTO_NOP ||
+		type == IPROTO_DELETE_RANGE;
 }
 
 /**
@@ -355,6 +375,10 @@ dml_request_key_map(uint16_t type)
 {
 	/** Advanced requests don't have a defined key map. */
 	assert(iproto_type_is_dml(type));
+	if (type == IPROTO_DELETE_RANGE) {
+		return (1ULL << IPROTO_SPACE_ID) | (1ULL << IPROTO_KEY) |
+		       (1ULL << IPROTO_TUPLE);
+	}
 	extern const uint64_t iproto_body_key_map[];
 	return iproto_body_key_map[type];
 }
@@ -428,6 +452,12 @@ enum vy_run_info_key {
 	VY_RUN_INFO_BLOOM = 7,
 	/** Number of statements of each type (map). */
 	VY_RUN_INFO_STMT_STAT = 8,
+	/** Number of page index partitions stored in the run file. */
+	VY_RUN_INFO_PART_COUNT = 9,
+	/** IDs of runs whose blob files are referenced (array). */
+	VY_RUN_INFO_BLOBS = 10,
+	/** Zstd dictionary run pages are compressed with. */
+	VY_RUN_INFO_DICT = 11,
 	/** The last key in this enum + 1 */
 	VY_RUN_INFO_KEY_MAX
 };
@@ -479,6 +509,50 @@ vy_page_info_key_name(enum vy_page_info_key key)
 	return vy_page_info_key_strs[key];
 }
 
+/**
+ * Xrow keys for Vinyl page index partition information.
+ * @sa struct vy_run_part.
+ */
+enum vy_part_info_key {
+	/** Offset of the partition in the run file. */
+	VY_PART_INFO_OFFSET = 1,
+	/** Size of the partition in the run file. */
+	VY_PART_INFO_SIZE = 2,
+	/** Size of the partition in memory, i.e. unpacked. */
+	VY_PART_INFO_UNPACKED_SIZE = 3,
+	/** Number of pages in the partition. */
+	VY_PART_INFO_PAGE_COUNT = 4,
+	/** Minimal key stored in the partition. */
+	VY_PART_INFO_MIN_KEY = 5,
+	/** Number of statements in the partition pages. */
+	VY_PART_INFO_ROW_COUNT = 6,
+	/** Size of the partition pages in memory, i.e. unpacked. */
+	VY_PART_INFO_BYTES = 7,
+	/** Size of the partition pages in the run file. */
+	VY_PART_INFO_BYTES_COMPRESSED = 8,
+	/** Size of memory needed to store the partition page index. */
+	VY_PART_INFO_INDEX_SIZE = 9,
+	/** Size of memory needed to store the partition bloom filter. */
+	VY_PART_INFO_BLOOM_SIZE = 10,
+	/** Bloom filter for keys stored in the partition. */
+	VY_PART_INFO_BLOOM = 11,
+	/** The last key in this enum + 1 */
+	VY_PART_INFO_KEY_MAX
+};
+
+/**
+ * Return vy_part_info key name by @a key code.
+ * @param key key
+ */
+static inline const char *
+vy_part_info_key_name(enum vy_part_info_key key)
+{
+	if (key <= 0 || key >= VY_PART_INFO_KEY_MAX)
+		return NULL;
+	extern const char *vy_part_info_key_strs[];
+	return vy_part_info_key_strs[key];
+}
+
 /**
  * Xrow keys for Vinyl row index.
  * @sa struct vy_page_info.
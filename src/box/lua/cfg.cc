@@ -177,6 +177,46 @@ lbox_cfg_set_wal_cleanup_delay(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_wal_commit_delay(struct lua_State *L)
+{
+	if (box_set_wal_commit_delay() < 0)
+		luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_commit_min_size(struct lua_State *L)
+{
+	if (box_set_wal_commit_min_size() < 0)
+		luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_spare_files(struct lua_State *L)
+{
+	if (box_set_wal_spare_files() < 0)
+		luaT_error(L);
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_direct_io(struct lua_State *L)
+{
+	(void) L;
+	box_set_wal_direct_io();
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_compression(struct lua_State *L)
+{
+	if (box_set_wal_compression() < 0)
+		luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_cfg_set_read_only(struct lua_State *L)
 {
@@ -210,6 +250,17 @@ lbox_cfg_set_memtx_max_tuple_size(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_memtx_checkpoint_max_deltas(struct lua_State *L)
+{
+	try {
+		box_set_memtx_checkpoint_max_deltas();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_vinyl_memory(struct lua_State *L)
 {
@@ -243,6 +294,61 @@ lbox_cfg_set_vinyl_cache(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_vinyl_page_index_cache(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_page_index_cache();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_max_subcompactions(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_max_subcompactions();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_upsert_squash_threshold(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_upsert_squash_threshold();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_max_write_stall(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_max_write_stall();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_max_compaction_debt(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_max_compaction_debt();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_vinyl_timeout(struct lua_State *L)
 {
@@ -414,12 +520,23 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_checkpoint_wal_threshold", lbox_cfg_set_checkpoint_wal_threshold},
 		{"cfg_set_wal_queue_max_size", lbox_cfg_set_wal_queue_max_size},
 		{"cfg_set_wal_cleanup_delay", lbox_cfg_set_wal_cleanup_delay},
+		{"cfg_set_wal_commit_delay", lbox_cfg_set_wal_commit_delay},
+		{"cfg_set_wal_commit_min_size", lbox_cfg_set_wal_commit_min_size},
+		{"cfg_set_wal_spare_files", lbox_cfg_set_wal_spare_files},
+		{"cfg_set_wal_direct_io", lbox_cfg_set_wal_direct_io},
+		{"cfg_set_wal_compression", lbox_cfg_set_wal_compression},
 		{"cfg_set_read_only", lbox_cfg_set_read_only},
 		{"cfg_set_memtx_memory", lbox_cfg_set_memtx_memory},
 		{"cfg_set_memtx_max_tuple_size", lbox_cfg_set_memtx_max_tuple_size},
+		{"cfg_set_memtx_checkpoint_max_deltas", lbox_cfg_set_memtx_checkpoint_max_deltas},
 		{"cfg_set_vinyl_memory", lbox_cfg_set_vinyl_memory},
 		{"cfg_set_vinyl_max_tuple_size", lbox_cfg_set_vinyl_max_tuple_size},
 		{"cfg_set_vinyl_cache", lbox_cfg_set_vinyl_cache},
+		{"cfg_set_vinyl_page_index_cache", lbox_cfg_set_vinyl_page_index_cache},
+		{"cfg_set_vinyl_max_subcompactions", lbox_cfg_set_vinyl_max_subcompactions},
+		{"cfg_set_vinyl_upsert_squash_threshold", lbox_cfg_set_vinyl_upsert_squash_threshold},
+		{"cfg_set_vinyl_max_write_stall", lbox_cfg_set_vinyl_max_write_stall},
+		{"cfg_set_vinyl_max_compaction_debt", lbox_cfg_set_vinyl_max_compaction_debt},
 		{"cfg_set_vinyl_timeout", lbox_cfg_set_vinyl_timeout},
 		{"cfg_set_election_mode", lbox_cfg_set_election_mode},
 		{"cfg_set_election_timeout", lbox_cfg_set_election_timeout},
@@ -108,12 +108,37 @@ static const char *lua_sources[] = {
 	NULL
 };
 
+/**
+ * Commit the current transaction.
+ *
+ * Accepts an optional table of options:
+ *
+ * - wait: 'complete' (default) to wait until the transaction is
+ *   written to WAL or 'none' to return as soon as it's submitted.
+ */
 static int
 lbox_commit(lua_State *L)
 {
-	if (box_txn_commit() != 0)
+	enum txn_commit_wait_mode mode = TXN_COMMIT_WAIT_COMPLETE;
+	if (!lua_isnoneornil(L, 1)) {
+		if (lua_gettop(L) != 1 || !lua_istable(L, 1))
+			goto usage;
+		lua_getfield(L, 1, "wait");
+		if (!lua_isnil(L, -1)) {
+			if (lua_type(L, -1) != LUA_TSTRING)
+				goto usage;
+			mode = STR2ENUM(txn_commit_wait_mode,
+					lua_tostring(L, -1));
+			if (mode == txn_commit_wait_mode_MAX)
+				goto usage;
+		}
+		lua_pop(L, 1);
+	}
+	if (box_txn_commit_mode(mode) != 0)
 		return luaT_error(L);
 	return 0;
+usage:
+	return luaL_error(L, "Usage: box.commit([{wait = 'complete'|'none'}])");
 }
 
 static int
@@ -42,6 +42,7 @@ local default_cfg = {
     strip_core          = true,
     memtx_min_tuple_size = 16,
     memtx_max_tuple_size = 1024 * 1024,
+    memtx_checkpoint_max_deltas = 0,
     slab_alloc_granularity = 8,
     slab_alloc_factor   = 1.05,
     iproto_threads      = 1,
@@ -52,7 +53,12 @@ local default_cfg = {
     vinyl_dir           = '.',
     vinyl_memory        = 128 * 1024 * 1024,
     vinyl_cache         = 128 * 1024 * 1024,
+    vinyl_page_index_cache = 128 * 1024 * 1024,
     vinyl_max_tuple_size = 1024 * 1024,
+    vinyl_max_subcompactions = 1,
+    vinyl_upsert_squash_threshold = 128,
+    vinyl_max_write_stall = 0,
+    vinyl_max_compaction_debt = 0,
     vinyl_read_threads  = 1,
     vinyl_write_threads = 4,
     vinyl_timeout       = 60,
@@ -75,6 +81,13 @@ local default_cfg = {
     wal_dir_rescan_delay= 2,
     wal_queue_max_size  = 16 * 1024 * 1024,
     wal_cleanup_delay   = 4 * 3600,
+    wal_commit_delay    = 0,
+    wal_commit_min_size = 64 * 1024,
+    wal_spare_files     = 0,
+    wal_direct_io       = false,
+    wal_compression     = 'zstd',
+    wal_compression_level = 3,
+    wal_recovery_read_ahead = false,
     force_recovery      = false,
     replication         = nil,
     instance_uuid       = nil,
@@ -147,6 +160,7 @@ local template_cfg = {
     strip_core          = 'boolean',
     memtx_min_tuple_size  = 'number',
     memtx_max_tuple_size  = 'number',
+    memtx_checkpoint_max_deltas = 'number',
     slab_alloc_granularity = 'number',
     slab_alloc_factor   = 'number',
     iproto_threads      = 'number',
@@ -156,7 +170,12 @@ local template_cfg = {
     vinyl_dir           = 'string',
     vinyl_memory        = 'number',
     vinyl_cache               = 'number',
+    vinyl_page_index_cache    = 'number',
     vinyl_max_tuple_size      = 'number',
+    vinyl_max_subcompactions  = 'number',
+    vinyl_upsert_squash_threshold = 'number',
+    vinyl_max_write_stall     = 'number',
+    vinyl_max_compaction_debt = 'number',
     vinyl_read_threads        = 'number',
     vinyl_write_threads       = 'number',
     vinyl_timeout             = 'number',
@@ -179,6 +198,13 @@ local template_cfg = {
     wal_max_size        = 'number',
     wal_dir_rescan_delay= 'number',
     wal_cleanup_delay   = 'number',
+    wal_commit_delay    = 'number',
+    wal_commit_min_size = 'number',
+    wal_spare_files     = 'number',
+    wal_direct_io       = 'boolean',
+    wal_compression     = 'string',
+    wal_compression_level = 'number',
+    wal_recovery_read_ahead = 'boolean',
     force_recovery      = 'boolean',
     replication         = 'string, number, table',
     instance_uuid       = 'string',
@@ -298,9 +324,15 @@ local dynamic_cfg = {
     read_only               = private.cfg_set_read_only,
     memtx_memory            = private.cfg_set_memtx_memory,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
+    memtx_checkpoint_max_deltas = private.cfg_set_memtx_checkpoint_max_deltas,
     vinyl_memory            = private.cfg_set_vinyl_memory,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
+    vinyl_max_subcompactions = private.cfg_set_vinyl_max_subcompactions,
+    vinyl_upsert_squash_threshold = private.cfg_set_vinyl_upsert_squash_threshold,
+    vinyl_max_write_stall   = private.cfg_set_vinyl_max_write_stall,
+    vinyl_max_compaction_debt = private.cfg_set_vinyl_max_compaction_debt,
     vinyl_cache             = private.cfg_set_vinyl_cache,
+    vinyl_page_index_cache  = private.cfg_set_vinyl_page_index_cache,
     vinyl_timeout           = private.cfg_set_vinyl_timeout,
     checkpoint_count        = private.cfg_set_checkpoint_count,
     checkpoint_interval     = private.cfg_set_checkpoint_interval,
@@ -314,6 +346,12 @@ local dynamic_cfg = {
     -- do nothing, affects new replicas, which query this value on start
     wal_dir_rescan_delay    = function() end,
     wal_cleanup_delay       = private.cfg_set_wal_cleanup_delay,
+    wal_commit_delay        = private.cfg_set_wal_commit_delay,
+    wal_commit_min_size     = private.cfg_set_wal_commit_min_size,
+    wal_spare_files         = private.cfg_set_wal_spare_files,
+    wal_direct_io           = private.cfg_set_wal_direct_io,
+    wal_compression         = private.cfg_set_wal_compression,
+    wal_compression_level   = private.cfg_set_wal_compression,
     custom_proc_title       = function()
         require('title').update(box.cfg.custom_proc_title)
     end,
@@ -390,9 +428,15 @@ local dynamic_cfg_skip_at_load = {
     listen                  = true,
     memtx_memory            = true,
     memtx_max_tuple_size    = true,
+    memtx_checkpoint_max_deltas = true,
     vinyl_memory            = true,
     vinyl_max_tuple_size    = true,
+    vinyl_max_subcompactions = true,
+    vinyl_upsert_squash_threshold = true,
+    vinyl_max_write_stall   = true,
+    vinyl_max_compaction_debt = true,
     vinyl_cache             = true,
+    vinyl_page_index_cache  = true,
     vinyl_timeout           = true,
     too_long_threshold      = true,
     election_mode           = true,
@@ -101,10 +101,12 @@ port_msgpack_dump_lua(struct port *base, struct lua_State *L, bool is_flat)
 static int
 lbox_select(lua_State *L)
 {
-	if (lua_gettop(L) != 6 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
-		!lua_isnumber(L, 3) || !lua_isnumber(L, 4) || !lua_isnumber(L, 5)) {
+	int argc = lua_gettop(L);
+	if (argc < 6 || argc > 8 || !lua_isnumber(L, 1) ||
+	    !lua_isnumber(L, 2) || !lua_isnumber(L, 3) ||
+	    !lua_isnumber(L, 4) || !lua_isnumber(L, 5)) {
 		return luaL_error(L, "Usage index:select(iterator, offset, "
-				  "limit, key)");
+				  "limit, key[, is_covering[, fill_cache]])");
 	}
 
 	uint32_t space_id = lua_tonumber(L, 1);
@@ -113,12 +115,16 @@ lbox_select(lua_State *L)
 	uint32_t offset = lua_tonumber(L, 4);
 	uint32_t limit = lua_tonumber(L, 5);
 
+	bool is_covering = argc >= 7 && lua_toboolean(L, 7);
+	bool fill_cache = argc < 8 || lua_isnil(L, 8) || lua_toboolean(L, 8);
+
 	size_t key_len;
 	const char *key = lbox_encode_tuple_on_gc(L, 6, &key_len);
 
 	struct port port;
-	if (box_select(space_id, index_id, iterator, offset, limit,
-		       key, key + key_len, &port) != 0) {
+	if (box_select_ex(space_id, index_id, iterator, offset, limit,
+			  key, key + key_len, is_covering, fill_cache,
+			  &port) != 0) {
 		return luaT_error(L);
 	}
 
@@ -844,6 +844,28 @@ local function update_index_parts(format, parts)
     return result, parts_can_be_simplified
 end
 
+--
+-- Convert fields covered by an index (names or 1-based numbers)
+-- into 0-based field numbers stored in _index.
+--
+local function update_index_covers(format, covers)
+    local result = {}
+    for i, field in ipairs(covers) do
+        local what = "options.covers[" .. i .. "]"
+        if type(field) ~= 'number' and type(field) ~= 'string' then
+            box.error(box.error.ILLEGAL_PARAMS, what .. ": " ..
+                      "field (name or number) is expected")
+        end
+        local idx, path = format_field_resolve(format, field, what)
+        if path ~= nil then
+            box.error(box.error.ILLEGAL_PARAMS, what .. ": " ..
+                      "JSON path is not supported")
+        end
+        table.insert(result, idx)
+    end
+    return result
+end
+
 --
 -- Convert index parts into 1.6.6 format if they
 -- don't use collation, is_nullable and exclude_null options
@@ -1062,6 +1084,15 @@ local index_options = {
     range_size = 'number',
     page_size = 'number',
     bloom_fpr = 'number',
+    compaction_strategy = 'string',
+    compaction_ttl = 'number',
+    blob_threshold = 'number',
+    compression = 'string',
+    compression_level = 'number',
+    compression_dict_size = 'number',
+    covers = 'table',
+    cache_share = 'number',
+    readahead_pages = 'number',
     func = 'number, string',
     hint = 'boolean',
 }
@@ -1209,9 +1240,21 @@ box.schema.index.create = function(space_id, name, options)
             run_count_per_level = options.run_count_per_level,
             run_size_ratio = options.run_size_ratio,
             bloom_fpr = options.bloom_fpr,
+            compaction_strategy = options.compaction_strategy,
+            compaction_ttl = options.compaction_ttl,
+            blob_threshold = options.blob_threshold,
+            compression = options.compression,
+            compression_level = options.compression_level,
+            compression_dict_size = options.compression_dict_size,
+            covers = options.covers,
+            cache_share = options.cache_share,
+            readahead_pages = options.readahead_pages,
             func = options.func,
             hint = options.hint,
     }
+    if index_opts.covers ~= nil then
+        index_opts.covers = update_index_covers(format, index_opts.covers)
+    end
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
         uint = 'unsigned';
@@ -1357,6 +1400,9 @@ box.schema.index.alter = function(space_id, index_id, options)
             index_opts[k] = options[k]
         end
     end
+    if options.covers ~= nil then
+        index_opts.covers = update_index_covers(format, options.covers)
+    end
     if options.hint and
        (options.type ~= 'tree' or box.space[space_id].engine ~= 'memtx') then
         box.error(box.error.MODIFY_INDEX, space.index[index_id].name,
@@ -1930,6 +1976,8 @@ end
 local function check_select_opts(opts, key_is_nil)
     local offset = 0
     local limit = 4294967295
+    local covering = false
+    local fill_cache = true
     local iterator = check_iterator_type(opts, key_is_nil)
     if opts ~= nil then
         if opts.offset ~= nil then
@@ -1938,12 +1986,23 @@ local function check_select_opts(opts, key_is_nil)
         if opts.limit ~= nil then
             limit = opts.limit
         end
+        if opts.covering ~= nil then
+            covering = opts.covering
+        end
+        if opts.fill_cache ~= nil then
+            fill_cache = opts.fill_cache
+        end
     end
-    return iterator, offset, limit
+    return iterator, offset, limit, covering, fill_cache
 end
 
 base_index_mt.select_ffi = function(index, key, opts)
     check_index_arg(index, 'select')
+    if opts ~= nil and (opts.covering or opts.fill_cache == false) then
+        -- Covering and non-caching selects are rare enough
+        -- to go without FFI.
+        return base_index_mt.select_luac(index, key, opts)
+    end
     local ibuf = cord_ibuf_take()
     local key, key_end = tuple_encode(ibuf, key)
     local iterator, offset, limit = check_select_opts(opts, key + 1 >= key_end)
@@ -1969,9 +2028,10 @@ end
 base_index_mt.select_luac = function(index, key, opts)
     check_index_arg(index, 'select')
     local key = keify(key)
-    local iterator, offset, limit = check_select_opts(opts, #key == 0)
+    local iterator, offset, limit, covering, fill_cache =
+        check_select_opts(opts, #key == 0)
     return internal.select(index.space_id, index.id, iterator,
-        offset, limit, key)
+        offset, limit, key, covering, fill_cache)
 end
 
 base_index_mt.update = function(index, key, ops)
@@ -1982,6 +2042,11 @@ base_index_mt.delete = function(index, key)
     check_index_arg(index, 'delete')
     return internal.delete(index.space_id, index.id, keify(key));
 end
+base_index_mt.delete_range = function(index, from, to)
+    check_index_arg(index, 'delete_range')
+    return internal.delete_range(index.space_id, index.id, keify(from),
+                                 keify(to));
+end
 
 base_index_mt.stat = function(index)
     return internal.stat(index.space_id, index.id);
@@ -53,6 +53,7 @@ extern "C" {
 #include "box/coll_id_cache.h"
 #include "box/replication.h" /* GROUP_LOCAL */
 #include "box/iproto_constants.h" /* iproto_type_name */
+#include "box/column_mask.h"
 #include "vclock/vclock.h"
 
 /**
@@ -437,6 +438,67 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			lua_pushnumber(L, index_opts->bloom_fpr);
 			lua_setfield(L, -2, "bloom_fpr");
 
+			if (index_opts->compaction_strategy !=
+			    INDEX_COMPACTION_LEVELED) {
+				lua_pushstring(L,
+					index_compaction_strategy_strs[
+					index_opts->compaction_strategy]);
+				lua_setfield(L, -2, "compaction_strategy");
+			}
+
+			if (index_opts->compaction_ttl > 0) {
+				lua_pushnumber(L, index_opts->compaction_ttl);
+				lua_setfield(L, -2, "compaction_ttl");
+			}
+
+			if (index_opts->blob_threshold > 0) {
+				lua_pushnumber(L, index_opts->blob_threshold);
+				lua_setfield(L, -2, "blob_threshold");
+			}
+
+			if (index_opts->compression !=
+			    INDEX_COMPRESSION_ZSTD) {
+				lua_pushstring(L, index_compression_strs[
+					index_opts->compression]);
+				lua_setfield(L, -2, "compression");
+			}
+
+			if (index_opts->compression_level !=
+			    index_opts_default.compression_level) {
+				lua_pushnumber(L,
+					index_opts->compression_level);
+				lua_setfield(L, -2, "compression_level");
+			}
+
+			if (index_opts->compression_dict_size > 0) {
+				lua_pushnumber(L,
+					index_opts->compression_dict_size);
+				lua_setfield(L, -2, "compression_dict_size");
+			}
+
+			if (index_opts->covers != 0) {
+				lua_newtable(L);
+				int covered_count = 0;
+				for (uint32_t i = 0; i < 63; i++) {
+					if (!column_mask_fieldno_is_set(
+						index_opts->covers, i))
+						continue;
+					lua_pushnumber(L, i + TUPLE_INDEX_BASE);
+					lua_rawseti(L, -2, ++covered_count);
+				}
+				lua_setfield(L, -2, "covers");
+			}
+
+			if (index_opts->cache_share < 1) {
+				lua_pushnumber(L, index_opts->cache_share);
+				lua_setfield(L, -2, "cache_share");
+			}
+
+			if (index_opts->readahead_pages > 0) {
+				lua_pushnumber(L, index_opts->readahead_pages);
+				lua_setfield(L, -2, "readahead_pages");
+			}
+
 			lua_settable(L, -3);
 		}
 		lua_setfield(L, -2, index_def->name);
@@ -42,6 +42,7 @@
 #include "box/iproto.h"
 #include "box/engine.h"
 #include "box/vinyl.h"
+#include "box/wal.h"
 #include "box/sql.h"
 #include "info/info.h"
 #include "lua/info.h"
@@ -125,6 +126,15 @@ lbox_stat_vinyl(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_stat_wal(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	wal_stat(&h);
+	return 1;
+}
+
 static int
 lbox_stat_reset(struct lua_State *L)
 {
@@ -227,6 +237,7 @@ box_lua_stat_init(struct lua_State *L)
 {
 	static const struct luaL_Reg statlib [] = {
 		{"vinyl", lbox_stat_vinyl},
+		{"wal", lbox_stat_wal},
 		{"reset", lbox_stat_reset},
 		{"sql", lbox_stat_sql},
 		{NULL, NULL}
@@ -34,6 +34,8 @@
 #include <small/quota.h>
 #include <small/small.h>
 #include <small/mempool.h>
+#include <small/ibuf.h>
+#include <qsort_arg.h>
 
 #include "fiber.h"
 #include "errinj.h"
@@ -60,6 +62,12 @@ checkpoint_cancel(struct checkpoint *ckpt);
 static void
 replica_join_cancel(struct cord *replica_join_cord);
 
+static void
+memtx_engine_track_stmt(struct memtx_engine *memtx, struct txn_stmt *stmt);
+
+static void
+memtx_engine_untrack_changes(struct memtx_engine *memtx);
+
 struct PACKED memtx_tuple {
 	/*
 	 * sic: the header of the tuple is used
@@ -72,10 +80,31 @@ struct PACKED memtx_tuple {
 	struct tuple base;
 };
 
+/**
+ * Primary key of a tuple deleted since the last checkpoint, stored
+ * in memtx_engine::deleted_keys. Followed by the key data.
+ */
+struct PACKED memtx_deleted_key {
+	/** Id of the space the tuple was deleted from. */
+	uint32_t space_id;
+	/** Size of the key data. */
+	uint32_t size;
+	/** MessagePack array of the key parts. */
+	char data[0];
+};
+
 enum {
 	OBJSIZE_MIN = 16,
 	SLAB_SIZE = 16 * 1024 * 1024,
 	MAX_TUPLE_SIZE = 1 * 1024 * 1024,
+	/** Initial size of memtx_engine::deleted_keys. */
+	MEMTX_DELETED_KEYS_BUF_SIZE = 16 * 1024,
+	/**
+	 * Max size of memtx_engine::deleted_keys is memtx_memory
+	 * divided by this. Once it's exceeded, the next checkpoint
+	 * is a full one.
+	 */
+	MEMTX_DELETED_KEYS_MAX_RATIO = 16,
 };
 
 static int
@@ -144,6 +173,7 @@ memtx_engine_shutdown(struct engine *engine)
 	small_alloc_destroy(&memtx->alloc);
 	slab_cache_destroy(&memtx->slab_cache);
 	tuple_arena_destroy(&memtx->arena);
+	ibuf_destroy(&memtx->deleted_keys);
 	xdir_destroy(&memtx->snap_dir);
 	free(memtx);
 }
@@ -152,12 +182,110 @@ static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row, int *is_space_system);
 
-int
-memtx_engine_recover_snapshot(struct memtx_engine *memtx,
-			      const struct vclock *vclock)
+/**
+ * End of the fast path: all tuples are loaded, build primary keys
+ * and proceed to applying rows one by one.
+ */
+static int
+memtx_engine_end_initial_recovery(struct memtx_engine *memtx)
+{
+	assert(memtx->state == MEMTX_INITIAL_RECOVERY);
+	space_foreach(memtx_end_build_primary_key, memtx);
+
+	if (!memtx->force_recovery && !memtx_tx_manager_use_mvcc_engine) {
+		/*
+		 * Fast start path: "play out" WAL
+		 * records using the primary key only,
+		 * then bulk-build all secondary keys.
+		 */
+		memtx->state = MEMTX_FINAL_RECOVERY;
+	} else {
+		/*
+		 * If force_recovery = true, it's
+		 * a disaster recovery mode. Build
+		 * secondary keys before reading the WAL,
+		 * to detect and discard duplicates in
+		 * unique keys.
+		 */
+		memtx->state = MEMTX_OK;
+		if (space_foreach(memtx_build_secondary_keys, memtx) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * Find the checkpoint the snapshot with the given vclock is based
+ * on. Returns 0 and sets @a base if the snapshot is incremental,
+ * 1 if it's a full one, -1 on error.
+ */
+static int
+memtx_engine_snapshot_base(struct memtx_engine *memtx,
+			   const struct vclock *vclock, struct vclock *base)
+{
+	struct xlog_cursor cursor;
+	if (xdir_open_cursor(&memtx->snap_dir, vclock_sum(vclock),
+			     &cursor) != 0)
+		return -1;
+	int rc = 1;
+	if (vclock_is_set(&cursor.meta.prev_vclock)) {
+		vclock_copy(base, &cursor.meta.prev_vclock);
+		rc = 0;
+		if (vclock_sum(base) >= vclock_sum(vclock)) {
+			diag_set(XlogError, "%s: invalid base checkpoint %s",
+				 cursor.name, vclock_to_string(base));
+			rc = -1;
+		}
+	}
+	xlog_cursor_close(&cursor, false);
+	return rc;
+}
+
+/**
+ * Collect the vclocks of all snapshots needed to recover the
+ * checkpoint with the given vclock, newest first. The last one
+ * is a full snapshot, the rest are incremental. On success
+ * returns the number of snapshots and sets @a chain to an array
+ * that must be freed by the caller. On error returns -1.
+ */
+static int
+memtx_engine_snapshot_chain(struct memtx_engine *memtx,
+			    const struct vclock *vclock,
+			    struct vclock **chain)
+{
+	struct vclock *res = NULL;
+	int count = 0;
+	struct vclock base;
+	vclock_copy(&base, vclock);
+	while (true) {
+		size_t size = (count + 1) * sizeof(*res);
+		struct vclock *new_res = realloc(res, size);
+		if (new_res == NULL) {
+			diag_set(OutOfMemory, size, "realloc",
+				 "snapshot chain");
+			goto fail;
+		}
+		res = new_res;
+		vclock_copy(&res[count++], &base);
+		int rc = memtx_engine_snapshot_base(memtx, &res[count - 1],
+						    &base);
+		if (rc < 0)
+			goto fail;
+		if (rc > 0)
+			break;
+	}
+	*chain = res;
+	return count;
+fail:
+	free(res);
+	return -1;
+}
+
+/** Load rows from the snapshot file with the given vclock. */
+static int
+memtx_engine_recover_snapshot_file(struct memtx_engine *memtx,
+				   const struct vclock *vclock, bool is_delta)
 {
-	/* Process existing snapshot */
-	say_info("recovery start");
 	int64_t signature = vclock_sum(vclock);
 	const char *filename = xdir_format_filename(&memtx->snap_dir,
 						    signature, NONE);
@@ -195,7 +323,11 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 		}
 	}
 	xlog_cursor_close(&cursor, false);
-	if (rc < 0 || is_space_system < 0)
+	/*
+	 * A full snapshot must contain system spaces while an
+	 * incremental one may have no data rows at all.
+	 */
+	if (rc < 0 || (is_space_system < 0 && !is_delta))
 		return -1;
 
 	/**
@@ -213,6 +345,41 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 	return 0;
 }
 
+int
+memtx_engine_recover_snapshot(struct memtx_engine *memtx,
+			      const struct vclock *vclock)
+{
+	/* Process existing snapshot */
+	say_info("recovery start");
+	/*
+	 * An incremental snapshot only stores changes made since
+	 * the checkpoint it is based on, so load the full snapshot
+	 * the chain starts from and apply the rest on top of it.
+	 */
+	struct vclock *chain;
+	int count = memtx_engine_snapshot_chain(memtx, vclock, &chain);
+	if (count < 0)
+		return -1;
+	int rc = memtx_engine_recover_snapshot_file(memtx, &chain[count - 1],
+						    false);
+	/* Deltas replace and delete tuples, which needs primary keys. */
+	if (rc == 0 && count > 1 && memtx->state == MEMTX_INITIAL_RECOVERY)
+		rc = memtx_engine_end_initial_recovery(memtx);
+	for (int i = count - 2; i >= 0 && rc == 0; i--)
+		rc = memtx_engine_recover_snapshot_file(memtx, &chain[i], true);
+	free(chain);
+	if (rc != 0)
+		return -1;
+	/*
+	 * Tuples created from now on, including those recovered
+	 * from WAL, must go to the next incremental checkpoint.
+	 */
+	memtx->checkpoint_delta_count = count - 1;
+	memtx->checkpoint_needs_full = false;
+	memtx->checkpoint_version = ++memtx->snapshot_version;
+	return 0;
+}
+
 static int
 memtx_engine_recover_raft(const struct xrow_header *row)
 {
@@ -230,7 +397,9 @@ memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row, int *is_space_system)
 {
 	assert(row->bodycnt == 1); /* always 1 for read */
-	if (row->type != IPROTO_INSERT) {
+	/* Incremental snapshots also contain REPLACE and DELETE rows. */
+	if (row->type != IPROTO_INSERT && row->type != IPROTO_REPLACE &&
+	    row->type != IPROTO_DELETE) {
 		if (row->type == IPROTO_RAFT)
 			return memtx_engine_recover_raft(row);
 		diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE,
@@ -308,33 +477,13 @@ static int
 memtx_engine_begin_final_recovery(struct engine *engine)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
-	if (memtx->state == MEMTX_OK)
+	/*
+	 * The initial recovery could have been ended while
+	 * loading incremental snapshots.
+	 */
+	if (memtx->state != MEMTX_INITIAL_RECOVERY)
 		return 0;
-
-	assert(memtx->state == MEMTX_INITIAL_RECOVERY);
-	/* End of the fast path: loaded the primary key. */
-	space_foreach(memtx_end_build_primary_key, memtx);
-
-	if (!memtx->force_recovery && !memtx_tx_manager_use_mvcc_engine) {
-		/*
-		 * Fast start path: "play out" WAL
-		 * records using the primary key only,
-		 * then bulk-build all secondary keys.
-		 */
-		memtx->state = MEMTX_FINAL_RECOVERY;
-	} else {
-		/*
-		 * If force_recovery = true, it's
-		 * a disaster recovery mode. Build
-		 * secondary keys before reading the WAL,
-		 * to detect and discard duplicates in
-		 * unique keys.
-		 */
-		memtx->state = MEMTX_OK;
-		if (space_foreach(memtx_build_secondary_keys, memtx) != 0)
-			return -1;
-	}
-	return 0;
+	return memtx_engine_end_initial_recovery(memtx);
 }
 
 static int
@@ -375,11 +524,14 @@ memtx_engine_begin(struct engine *engine, struct txn *txn)
 static int
 memtx_engine_prepare(struct engine *engine, struct txn *txn)
 {
-	(void)engine;
+	struct memtx_engine *memtx = (struct memtx_engine *)engine;
 	struct txn_stmt *stmt;
+	bool track = memtx->checkpoint_max_deltas > 0;
 	stailq_foreach_entry(stmt, &txn->stmts, next) {
 		if (stmt->add_story != NULL || stmt->del_story != NULL)
 			memtx_tx_history_prepare_stmt(stmt);
+		if (track)
+			memtx_engine_track_stmt(memtx, stmt);
 	}
 	return 0;
 }
@@ -404,8 +556,7 @@ static void
 memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 				struct txn_stmt *stmt)
 {
-	(void)engine;
-	(void)txn;
+	struct memtx_engine *memtx = (struct memtx_engine *)engine;
 	if (stmt->old_tuple == NULL && stmt->new_tuple == NULL)
 		return;
 	struct space *space = stmt->space;
@@ -413,6 +564,12 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 		/* The space was deleted. Nothing to rollback. */
 		return;
 	}
+	/*
+	 * The change was logged for the next incremental checkpoint
+	 * on prepare, and there's no way to unlog it.
+	 */
+	if (txn->psn != 0 && !space_is_temporary(space))
+		memtx_engine_untrack_changes(memtx);
 	struct memtx_space *memtx_space = (struct memtx_space *)space;
 	uint32_t index_count;
 
@@ -508,15 +665,15 @@ checkpoint_write_row(struct xlog *l, struct xrow_header *row)
 }
 
 static int
-checkpoint_write_tuple(struct xlog *l, uint32_t space_id, uint32_t group_id,
-		       const char *data, uint32_t size)
+checkpoint_write_tuple(struct xlog *l, uint16_t type, uint32_t space_id,
+		       uint32_t group_id, const char *data, uint32_t size)
 {
 	struct request_replace_body body;
 	request_replace_body_create(&body, space_id);
 
 	struct xrow_header row;
 	memset(&row, 0, sizeof(struct xrow_header));
-	row.type = IPROTO_INSERT;
+	row.type = type;
 	row.group_id = group_id;
 
 	row.bodycnt = 2;
@@ -527,10 +684,29 @@ checkpoint_write_tuple(struct xlog *l, uint32_t space_id, uint32_t group_id,
 	return checkpoint_write_row(l, &row);
 }
 
+/** Key deleted from a space since the base checkpoint. */
+struct checkpoint_deleted_key {
+	struct memtx_deleted_key *key;
+	/** Set if the space has a tuple with this key. */
+	bool is_found;
+};
+
 struct checkpoint_entry {
 	uint32_t space_id;
 	uint32_t group_id;
 	struct snapshot_iterator *iterator;
+	/**
+	 * Primary key definition, used to match tuples against
+	 * deleted keys. Only set for incremental checkpoints.
+	 */
+	struct key_def *key_def;
+	/**
+	 * Keys of tuples deleted from the space, sorted and
+	 * without duplicates. Filled by the checkpoint thread.
+	 */
+	struct checkpoint_deleted_key *deleted;
+	/** Number of entries in the deleted array. */
+	size_t deleted_count;
 	struct rlist link;
 };
 
@@ -551,8 +727,161 @@ struct checkpoint {
 	 * checkpoint already exists.
 	 */
 	bool touch;
+	/**
+	 * Set if the checkpoint is incremental, i.e. only stores
+	 * changes made since the checkpoint with base_vclock.
+	 */
+	bool is_delta;
+	/** The vclock of the checkpoint this one is based on. */
+	struct vclock base_vclock;
+	/**
+	 * Tuples with a snapshot version greater than or equal to
+	 * this one were created after the base checkpoint.
+	 */
+	uint32_t base_version;
+	/**
+	 * Value of memtx_engine::snapshot_version after the read
+	 * view of the checkpoint was created.
+	 */
+	uint32_t version;
+	/** Keys deleted since the base checkpoint. */
+	struct ibuf deleted_keys;
+	/** Tuples referenced by memtx_engine_pin_tuple(). */
+	struct tuple **pinned;
+	size_t pinned_count;
+	size_t pinned_capacity;
+	/**
+	 * Set if a tuple couldn't be pinned so the checkpoint
+	 * may miss it and must fail.
+	 */
+	bool pin_failed;
+	/**
+	 * Set if incremental checkpoints were disabled while this
+	 * one was running. Tuples aren't pinned after that so the
+	 * checkpoint must fail, too.
+	 */
+	bool is_cancelled;
 };
 
+/**
+ * Take a reference to a tuple that may be written by the running
+ * incremental checkpoint. Without it the tuple could be freed in
+ * the delayed mode, which overwrites its snapshot version, so the
+ * checkpoint thread wouldn't know it has to write it.
+ */
+static void
+memtx_engine_pin_tuple(struct memtx_engine *memtx, struct tuple *tuple)
+{
+	struct checkpoint *ckpt = memtx->checkpoint;
+	uint32_t version = memtx_tuple_version(tuple);
+	if (ckpt->pin_failed || ckpt->is_cancelled ||
+	    version < ckpt->base_version || version >= ckpt->version)
+		return;
+	if (ckpt->pinned_count == ckpt->pinned_capacity) {
+		size_t capacity = MAX(ckpt->pinned_capacity * 2, 64);
+		size_t size = capacity * sizeof(*ckpt->pinned);
+		struct tuple **pinned = realloc(ckpt->pinned, size);
+		if (pinned == NULL) {
+			ckpt->pin_failed = true;
+			return;
+		}
+		ckpt->pinned = pinned;
+		ckpt->pinned_capacity = capacity;
+	}
+	tuple_ref(tuple);
+	ckpt->pinned[ckpt->pinned_count++] = tuple;
+}
+
+/**
+ * Stop tracking changes for the next incremental checkpoint. It
+ * will be a full one.
+ */
+static void
+memtx_engine_untrack_changes(struct memtx_engine *memtx)
+{
+	memtx->checkpoint_needs_full = true;
+	ibuf_reinit(&memtx->deleted_keys);
+}
+
+/**
+ * Allocate space for deleted keys in memtx_engine::deleted_keys.
+ * Returns NULL if the log would grow beyond its limit.
+ */
+static void *
+memtx_engine_alloc_deleted_keys(struct memtx_engine *memtx, size_t size)
+{
+	size_t max_size = quota_total(&memtx->quota) /
+			  MEMTX_DELETED_KEYS_MAX_RATIO;
+	if (ibuf_used(&memtx->deleted_keys) + size > max_size)
+		return NULL;
+	return ibuf_alloc(&memtx->deleted_keys, size);
+}
+
+/**
+ * Remember a change made by a statement for the next incremental
+ * checkpoint. New tuples are found by their snapshot version so
+ * only primary keys of deleted tuples are logged.
+ */
+static void
+memtx_engine_track_stmt(struct memtx_engine *memtx, struct txn_stmt *stmt)
+{
+	struct space *space = stmt->space;
+	if (space == NULL || space_is_temporary(space) ||
+	    (stmt->old_tuple == NULL && stmt->new_tuple == NULL))
+		return;
+	if (stmt->old_tuple != NULL && memtx->checkpoint != NULL &&
+	    memtx->checkpoint->is_delta)
+		memtx_engine_pin_tuple(memtx, stmt->old_tuple);
+	if (memtx->checkpoint_max_deltas == 0 || memtx->checkpoint_needs_full)
+		return;
+	/*
+	 * Schema changes may affect spaces as a whole, which can't
+	 * be expressed by an incremental checkpoint.
+	 */
+	if (space_id(space) < BOX_SYSTEM_ID_MAX &&
+	    space_id(space) != BOX_SEQUENCE_DATA_ID) {
+		memtx_engine_untrack_changes(memtx);
+		return;
+	}
+	/*
+	 * A tuple allocated before the last checkpoint and
+	 * committed after it (possible with MVCC) would be
+	 * missed by the next incremental checkpoint.
+	 */
+	uint32_t base_version = memtx->checkpoint != NULL ?
+				memtx->checkpoint->version :
+				memtx->checkpoint_version;
+	if (stmt->new_tuple != NULL &&
+	    memtx_tuple_version(stmt->new_tuple) < base_version) {
+		memtx_engine_untrack_changes(memtx);
+		return;
+	}
+	if (stmt->new_tuple != NULL || stmt->old_tuple == NULL)
+		return;
+	struct key_def *key_def = space_index(space, 0)->def->key_def;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t size;
+	const char *key = tuple_extract_key(stmt->old_tuple, key_def,
+					    MULTIKEY_NONE, &size);
+	if (key == NULL) {
+		diag_clear(diag_get());
+		memtx_engine_untrack_changes(memtx);
+		return;
+	}
+	struct memtx_deleted_key *deleted =
+		memtx_engine_alloc_deleted_keys(memtx, sizeof(*deleted) + size);
+	if (deleted == NULL) {
+		region_truncate(region, region_svp);
+		memtx_engine_untrack_changes(memtx);
+		return;
+	}
+	deleted->space_id = space_id(space);
+	deleted->size = size;
+	memcpy(deleted->data, key, size);
+	region_truncate(region, region_svp);
+}
+
 static struct checkpoint *
 checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
 {
@@ -572,6 +901,16 @@ checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
 	vclock_create(&ckpt->vclock);
 	box_raft_checkpoint_local(&ckpt->raft);
 	ckpt->touch = false;
+	ckpt->is_delta = false;
+	vclock_create(&ckpt->base_vclock);
+	ckpt->base_version = 0;
+	ckpt->version = 0;
+	ibuf_create(&ckpt->deleted_keys, cord_slab_cache(), 0);
+	ckpt->pinned = NULL;
+	ckpt->pinned_count = 0;
+	ckpt->pinned_capacity = 0;
+	ckpt->pin_failed = false;
+	ckpt->is_cancelled = false;
 	return ckpt;
 }
 
@@ -580,9 +919,17 @@ checkpoint_delete(struct checkpoint *ckpt)
 {
 	struct checkpoint_entry *entry, *tmp;
 	rlist_foreach_entry_safe(entry, &ckpt->entries, link, tmp) {
-		entry->iterator->free(entry->iterator);
+		if (entry->iterator != NULL)
+			entry->iterator->free(entry->iterator);
+		if (entry->key_def != NULL)
+			key_def_delete(entry->key_def);
+		free(entry->deleted);
 		free(entry);
 	}
+	for (size_t i = 0; i < ckpt->pinned_count; i++)
+		tuple_unref(ckpt->pinned[i]);
+	free(ckpt->pinned);
+	ibuf_destroy(&ckpt->deleted_keys);
 	xdir_destroy(&ckpt->dir);
 	free(ckpt);
 }
@@ -631,6 +978,9 @@ checkpoint_add_space(struct space *sp, void *data)
 			 "malloc", "struct checkpoint_entry");
 		return -1;
 	}
+	entry->key_def = NULL;
+	entry->deleted = NULL;
+	entry->deleted_count = 0;
 	rlist_add_tail_entry(&ckpt->entries, entry, link);
 
 	entry->space_id = space_id(sp);
@@ -638,7 +988,11 @@ checkpoint_add_space(struct space *sp, void *data)
 	entry->iterator = index_create_snapshot_iterator(pk);
 	if (entry->iterator == NULL)
 		return -1;
-
+	if (ckpt->is_delta) {
+		entry->key_def = key_def_dup(pk->def->key_def);
+		if (entry->key_def == NULL)
+			return -1;
+	}
 	return 0;
 };
 
@@ -659,6 +1013,209 @@ finish:
 	return rc;
 }
 
+/** Order deleted keys by space id, qsort() callback. */
+static int
+memtx_deleted_key_cmp_space(const void *a, const void *b)
+{
+	const struct memtx_deleted_key *key_a =
+		*(const struct memtx_deleted_key **)a;
+	const struct memtx_deleted_key *key_b =
+		*(const struct memtx_deleted_key **)b;
+	if (key_a->space_id != key_b->space_id)
+		return key_a->space_id < key_b->space_id ? -1 : 1;
+	return 0;
+}
+
+/** Order deleted keys of a space, qsort_arg() callback. */
+static int
+memtx_deleted_key_cmp(const void *a, const void *b, void *arg)
+{
+	const struct memtx_deleted_key *key_a =
+		*(const struct memtx_deleted_key **)a;
+	const struct memtx_deleted_key *key_b =
+		*(const struct memtx_deleted_key **)b;
+	return key_compare(key_a->data, HINT_NONE, key_b->data, HINT_NONE,
+			   (struct key_def *)arg);
+}
+
+/**
+ * Return the position of the first key with space id greater than
+ * or equal to the given one in an array sorted by space id.
+ */
+static size_t
+memtx_deleted_key_lower_bound(struct memtx_deleted_key **keys, size_t count,
+			      uint32_t space_id)
+{
+	size_t begin = 0, end = count;
+	while (begin < end) {
+		size_t mid = begin + (end - begin) / 2;
+		if (keys[mid]->space_id < space_id)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	return begin;
+}
+
+/**
+ * Distribute keys deleted since the base checkpoint among the
+ * checkpoint entries, sorting them by primary key and dropping
+ * duplicates.
+ */
+static int
+checkpoint_sort_deleted_keys(struct checkpoint *ckpt)
+{
+	struct ibuf *buf = &ckpt->deleted_keys;
+	size_t count = 0;
+	for (char *pos = buf->rpos; pos < buf->wpos; count++) {
+		struct memtx_deleted_key *key = (struct memtx_deleted_key *)pos;
+		pos += sizeof(*key) + key->size;
+	}
+	if (count == 0)
+		return 0;
+	size_t size = count * sizeof(struct memtx_deleted_key *);
+	struct memtx_deleted_key **keys = malloc(size);
+	if (keys == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "deleted keys");
+		return -1;
+	}
+	count = 0;
+	for (char *pos = buf->rpos; pos < buf->wpos; count++) {
+		keys[count] = (struct memtx_deleted_key *)pos;
+		pos += sizeof(*keys[count]) + keys[count]->size;
+	}
+	qsort(keys, count, sizeof(*keys), memtx_deleted_key_cmp_space);
+
+	int rc = 0;
+	struct checkpoint_entry *entry;
+	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		size_t begin = memtx_deleted_key_lower_bound(keys, count,
+							     entry->space_id);
+		size_t end = memtx_deleted_key_lower_bound(keys, count,
+							   entry->space_id + 1);
+		if (begin == end)
+			continue;
+		qsort_arg(keys + begin, end - begin, sizeof(*keys),
+			  memtx_deleted_key_cmp, entry->key_def);
+		size = (end - begin) * sizeof(*entry->deleted);
+		entry->deleted = malloc(size);
+		if (entry->deleted == NULL) {
+			diag_set(OutOfMemory, size, "malloc", "deleted keys");
+			rc = -1;
+			break;
+		}
+		size_t unique = 0;
+		for (size_t i = begin; i < end; i++) {
+			if (unique > 0 &&
+			    memtx_deleted_key_cmp(&keys[i - 1], &keys[i],
+						  entry->key_def) == 0)
+				continue;
+			entry->deleted[unique].key = keys[i];
+			entry->deleted[unique].is_found = false;
+			unique++;
+		}
+		entry->deleted_count = unique;
+	}
+	free(keys);
+	return rc;
+}
+
+/**
+ * Look up the primary key of a tuple among the keys deleted from
+ * the space and mark it found: the tuple was inserted back, so
+ * the key must not be written as deleted.
+ */
+static int
+checkpoint_entry_undelete(struct checkpoint_entry *entry,
+			  const char *data, uint32_t size)
+{
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t key_size;
+	const char *key = tuple_extract_key_raw(data, data + size,
+						entry->key_def, MULTIKEY_NONE,
+						&key_size);
+	if (key == NULL)
+		return -1;
+	size_t begin = 0, end = entry->deleted_count;
+	while (begin < end) {
+		size_t mid = begin + (end - begin) / 2;
+		struct checkpoint_deleted_key *deleted = &entry->deleted[mid];
+		int cmp = key_compare(deleted->key->data, HINT_NONE,
+				      key, HINT_NONE, entry->key_def);
+		if (cmp == 0) {
+			deleted->is_found = true;
+			break;
+		}
+		if (cmp < 0)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	region_truncate(region, region_svp);
+	return 0;
+}
+
+/** Write a row deleting a tuple by primary key. */
+static int
+checkpoint_write_delete(struct xlog *l, uint32_t space_id, uint32_t group_id,
+			const char *key, uint32_t size)
+{
+	struct request request;
+	memset(&request, 0, sizeof(request));
+	request.type = IPROTO_DELETE;
+	request.space_id = space_id;
+	request.index_id = 0;
+	request.key = key;
+	request.key_end = key + size;
+
+	struct xrow_header row;
+	memset(&row, 0, sizeof(struct xrow_header));
+	row.type = IPROTO_DELETE;
+	row.group_id = group_id;
+	int bodycnt = xrow_encode_dml(&request, &fiber()->gc, row.body);
+	if (bodycnt < 0)
+		return -1;
+	row.bodycnt = bodycnt;
+	return checkpoint_write_row(l, &row);
+}
+
+/** Write the snapshot data of a space. */
+static int
+checkpoint_write_entry(struct checkpoint *ckpt, struct xlog *snap,
+		       struct checkpoint_entry *entry)
+{
+	int rc;
+	uint32_t size;
+	const char *data;
+	struct snapshot_iterator *it = entry->iterator;
+	uint16_t type = ckpt->is_delta ? IPROTO_REPLACE : IPROTO_INSERT;
+	while ((rc = it->next(it, &data, &size)) == 0 && data != NULL) {
+		if (entry->deleted_count > 0 &&
+		    checkpoint_entry_undelete(entry, data, size) != 0)
+			return -1;
+		/* Skip tuples stored in the base checkpoint. */
+		if (ckpt->is_delta && it->version < ckpt->base_version)
+			continue;
+		if (checkpoint_write_tuple(snap, type, entry->space_id,
+					   entry->group_id, data, size) != 0)
+			return -1;
+	}
+	if (rc != 0)
+		return -1;
+	for (size_t i = 0; i < entry->deleted_count; i++) {
+		struct checkpoint_deleted_key *deleted = &entry->deleted[i];
+		if (deleted->is_found)
+			continue;
+		if (checkpoint_write_delete(snap, entry->space_id,
+					    entry->group_id,
+					    deleted->key->data,
+					    deleted->key->size) != 0)
+			return -1;
+	}
+	return 0;
+}
+
 static int
 checkpoint_f(va_list ap)
 {
@@ -667,6 +1224,12 @@ checkpoint_f(va_list ap)
 	if (ckpt->touch) {
 		if (xdir_touch_xlog(&ckpt->dir, &ckpt->vclock) == 0)
 			return 0;
+		/*
+		 * An incremental checkpoint based on itself makes
+		 * no sense, fail it.
+		 */
+		if (ckpt->is_delta)
+			return -1;
 		/*
 		 * Failed to touch an existing snapshot, create
 		 * a new one.
@@ -675,23 +1238,34 @@ checkpoint_f(va_list ap)
 	}
 
 	struct xlog snap;
-	if (xdir_create_xlog(&ckpt->dir, &snap, &ckpt->vclock) != 0)
-		return -1;
-
-	say_info("saving snapshot `%s'", snap.filename);
+	if (ckpt->is_delta) {
+		/*
+		 * An incremental snapshot refers to the snapshot
+		 * it's based on with the PrevVClock header.
+		 */
+		struct xlog_meta meta;
+		xlog_meta_create(&meta, ckpt->dir.filetype,
+				 ckpt->dir.instance_uuid, &ckpt->vclock,
+				 &ckpt->base_vclock);
+		const char *filename =
+			xdir_format_filename(&ckpt->dir,
+					     vclock_sum(&ckpt->vclock), NONE);
+		if (xlog_create(&snap, filename, ckpt->dir.open_wflags,
+				&meta, &ckpt->dir.opts) != 0)
+			return -1;
+		say_info("saving incremental snapshot `%s' based on %s",
+			 snap.filename, vclock_to_string(&ckpt->base_vclock));
+	} else {
+		if (xdir_create_xlog(&ckpt->dir, &snap, &ckpt->vclock) != 0)
+			return -1;
+		say_info("saving snapshot `%s'", snap.filename);
+	}
 	ERROR_INJECT_SLEEP(ERRINJ_SNAP_WRITE_DELAY);
+	if (checkpoint_sort_deleted_keys(ckpt) != 0)
+		goto fail;
 	struct checkpoint_entry *entry;
 	rlist_foreach_entry(entry, &ckpt->entries, link) {
-		int rc;
-		uint32_t size;
-		const char *data;
-		struct snapshot_iterator *it = entry->iterator;
-		while ((rc = it->next(it, &data, &size)) == 0 && data != NULL) {
-			if (checkpoint_write_tuple(&snap, entry->space_id,
-					entry->group_id, data, size) != 0)
-				goto fail;
-		}
-		if (rc != 0)
+		if (checkpoint_write_entry(ckpt, &snap, entry) != 0)
 			goto fail;
 	}
 	if (checkpoint_write_raft(&snap, &ckpt->raft) != 0)
@@ -714,16 +1288,40 @@ memtx_engine_begin_checkpoint(struct engine *engine, bool is_scheduled)
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
 
 	assert(memtx->checkpoint == NULL);
-	memtx->checkpoint = checkpoint_new(memtx->snap_dir.dirname,
-					   memtx->snap_io_rate_limit);
-	if (memtx->checkpoint == NULL)
+	struct checkpoint *ckpt = checkpoint_new(memtx->snap_dir.dirname,
+						 memtx->snap_io_rate_limit);
+	if (ckpt == NULL)
 		return -1;
+	memtx->checkpoint = ckpt;
+
+	if (memtx->checkpoint_max_deltas > 0 &&
+	    !memtx->checkpoint_needs_full &&
+	    memtx->checkpoint_delta_count < memtx->checkpoint_max_deltas &&
+	    xdir_last_vclock(&memtx->snap_dir, &ckpt->base_vclock) >= 0) {
+		ckpt->is_delta = true;
+		ckpt->base_version = memtx->checkpoint_version;
+		/* Hand the keys deleted so far over to the checkpoint. */
+		ibuf_destroy(&ckpt->deleted_keys);
+		ckpt->deleted_keys = memtx->deleted_keys;
+		ibuf_create(&memtx->deleted_keys, cord_slab_cache(),
+			    MEMTX_DELETED_KEYS_BUF_SIZE);
+	} else {
+		ibuf_reinit(&memtx->deleted_keys);
+	}
 
-	if (space_foreach(checkpoint_add_space, memtx->checkpoint) != 0) {
-		checkpoint_delete(memtx->checkpoint);
+	if (space_foreach(checkpoint_add_space, ckpt) != 0) {
+		checkpoint_delete(ckpt);
 		memtx->checkpoint = NULL;
+		memtx_engine_untrack_changes(memtx);
 		return -1;
 	}
+	/*
+	 * Each snapshot iterator bumps snapshot_version so all
+	 * tuples created from now on have a greater version than
+	 * those in the read view.
+	 */
+	ckpt->version = memtx->snapshot_version;
+	memtx->checkpoint_needs_full = memtx->checkpoint_max_deltas == 0;
 	return 0;
 }
 
@@ -756,6 +1354,18 @@ memtx_engine_wait_checkpoint(struct engine *engine,
 		diag_log();
 
 	memtx->checkpoint->waiting_for_snap_thread = false;
+	if (result == 0 && memtx->checkpoint->pin_failed) {
+		diag_set(OutOfMemory, memtx->checkpoint->pinned_capacity *
+			 sizeof(struct tuple *), "realloc", "pinned tuples");
+		diag_log();
+		result = -1;
+	}
+	if (result == 0 && memtx->checkpoint->is_cancelled) {
+		say_error("incremental checkpoint was cancelled because "
+			  "memtx_checkpoint_max_deltas was set to 0");
+		diag_set(ClientError, ER_READ_VIEW_ABORTED);
+		result = -1;
+	}
 	return result;
 }
 
@@ -793,8 +1403,33 @@ memtx_engine_commit_checkpoint(struct engine *engine,
 		xdir_add_vclock(&memtx->snap_dir, &memtx->checkpoint->vclock);
 	}
 
-	checkpoint_delete(memtx->checkpoint);
+	struct checkpoint *ckpt = memtx->checkpoint;
+	if (!ckpt->touch) {
+		memtx->checkpoint_version = ckpt->version;
+		memtx->checkpoint_delta_count = ckpt->is_delta ?
+			memtx->checkpoint_delta_count + 1 : 0;
+	} else if (ckpt->is_delta) {
+		/*
+		 * No new checkpoint was made, so the next one is
+		 * still based on the last one and must include
+		 * the keys handed over to this checkpoint.
+		 */
+		size_t size = ibuf_used(&ckpt->deleted_keys);
+		void *keys = size == 0 ? NULL :
+			     memtx_engine_alloc_deleted_keys(memtx, size);
+		if (keys != NULL)
+			memcpy(keys, ckpt->deleted_keys.rpos, size);
+		else if (size != 0)
+			memtx_engine_untrack_changes(memtx);
+	} else {
+		memtx_engine_untrack_changes(memtx);
+	}
+
+	bool is_delta = ckpt->is_delta;
+	checkpoint_delete(ckpt);
 	memtx->checkpoint = NULL;
+	if (is_delta)
+		fiber_wakeup(memtx->gc_fiber);
 }
 
 static void
@@ -819,16 +1454,33 @@ memtx_engine_abort_checkpoint(struct engine *engine)
 				     INPROGRESS);
 	(void) coio_unlink(filename);
 
+	/* Changes handed over to the checkpoint are lost. */
+	memtx_engine_untrack_changes(memtx);
+	bool is_delta = memtx->checkpoint->is_delta;
 	checkpoint_delete(memtx->checkpoint);
 	memtx->checkpoint = NULL;
+	if (is_delta)
+		fiber_wakeup(memtx->gc_fiber);
 }
 
 static void
 memtx_engine_collect_garbage(struct engine *engine, const struct vclock *vclock)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
-	xdir_collect_garbage(&memtx->snap_dir, vclock_sum(vclock),
-			     XDIR_GC_ASYNC);
+	/*
+	 * Keep all snapshots the given checkpoint depends on. If
+	 * the chain can't be read, keep all of them.
+	 */
+	struct vclock *chain;
+	int count = memtx_engine_snapshot_chain(memtx, vclock, &chain);
+	if (count >= 0) {
+		xdir_collect_garbage(&memtx->snap_dir,
+				     vclock_sum(&chain[count - 1]),
+				     XDIR_GC_ASYNC);
+		free(chain);
+	} else {
+		diag_log();
+	}
 	xdir_collect_inprogress(&memtx->snap_dir);
 }
 
@@ -837,9 +1489,20 @@ memtx_engine_backup(struct engine *engine, const struct vclock *vclock,
 		    engine_backup_cb cb, void *cb_arg)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
-	const char *filename = xdir_format_filename(&memtx->snap_dir,
-						    vclock_sum(vclock), NONE);
-	return cb(filename, cb_arg);
+	/* An incremental snapshot is useless without its base. */
+	struct vclock *chain;
+	int count = memtx_engine_snapshot_chain(memtx, vclock, &chain);
+	if (count < 0)
+		return -1;
+	int rc = 0;
+	for (int i = 0; i < count && rc == 0; i++) {
+		const char *filename =
+			xdir_format_filename(&memtx->snap_dir,
+					     vclock_sum(&chain[i]), NONE);
+		rc = cb(filename, cb_arg);
+	}
+	free(chain);
+	return rc;
 }
 
 struct memtx_join_entry {
@@ -995,6 +1658,13 @@ memtx_engine_memory_stat(struct engine *engine, struct engine_memory_stat *stat)
 	small_stats(&memtx->alloc, &data_stats, small_stats_noop_cb, NULL);
 	stat->data += data_stats.used;
 	stat->index += index_stats.totals.used;
+	/* Change tracking for incremental checkpoints. */
+	stat->index += ibuf_capacity(&memtx->deleted_keys);
+	struct checkpoint *ckpt = memtx->checkpoint;
+	if (ckpt != NULL) {
+		stat->index += ibuf_capacity(&ckpt->deleted_keys);
+		stat->index += ckpt->pinned_capacity * sizeof(*ckpt->pinned);
+	}
 }
 
 static const struct engine_vtab memtx_engine_vtab = {
@@ -1032,7 +1702,13 @@ static const struct engine_vtab memtx_engine_vtab = {
 static void
 memtx_engine_run_gc(struct memtx_engine *memtx, bool *stop)
 {
-	*stop = stailq_empty(&memtx->gc_queue);
+	/*
+	 * Freeing tuples overwrites their snapshot versions, which
+	 * an incremental checkpoint in progress relies on. Wait for
+	 * it to complete.
+	 */
+	*stop = stailq_empty(&memtx->gc_queue) ||
+		(memtx->checkpoint != NULL && memtx->checkpoint->is_delta);
 	if (*stop)
 		return;
 
@@ -1152,6 +1828,9 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 		       MEMTX_ITERATOR_SIZE);
 	memtx->num_reserved_extents = 0;
 	memtx->reserved_extents = NULL;
+	ibuf_create(&memtx->deleted_keys, cord_slab_cache(),
+		    MEMTX_DELETED_KEYS_BUF_SIZE);
+	memtx->checkpoint_needs_full = true;
 
 	memtx->state = MEMTX_INITIALIZED;
 	memtx->max_tuple_size = MAX_TUPLE_SIZE;
@@ -1202,6 +1881,23 @@ memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size)
 	memtx->max_tuple_size = max_size;
 }
 
+void
+memtx_engine_set_checkpoint_max_deltas(struct memtx_engine *memtx,
+				       int max_deltas)
+{
+	/* Changes made so far weren't tracked. */
+	if (max_deltas == 0 || memtx->checkpoint_max_deltas == 0)
+		memtx_engine_untrack_changes(memtx);
+	/*
+	 * Changes aren't tracked while the option is off so a running
+	 * incremental checkpoint can't be completed.
+	 */
+	if (max_deltas == 0 && memtx->checkpoint != NULL &&
+	    memtx->checkpoint->is_delta)
+		memtx->checkpoint->is_cancelled = true;
+	memtx->checkpoint_max_deltas = max_deltas;
+}
+
 void
 memtx_enter_delayed_free_mode(struct memtx_engine *memtx)
 {
@@ -1303,6 +1999,12 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 	tuple_format_unref(format);
 }
 
+uint32_t
+memtx_tuple_version(struct tuple *tuple)
+{
+	return container_of(tuple, struct memtx_tuple, base)->version;
+}
+
 void
 metmx_tuple_chunk_delete(struct tuple_format *format, const char *data)
 {
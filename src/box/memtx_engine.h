@@ -36,6 +36,7 @@
 #include <small/quota.h>
 #include <small/small.h>
 #include <small/mempool.h>
+#include <small/ibuf.h>
 
 #include "engine.h"
 #include "xlog.h"
@@ -117,6 +118,33 @@ struct memtx_engine {
 	struct xdir snap_dir;
 	/** Limit disk usage of checkpointing (bytes per second). */
 	uint64_t snap_io_rate_limit;
+	/**
+	 * Max number of incremental checkpoints made in a row after
+	 * a full one, box.cfg.memtx_checkpoint_max_deltas. Zero
+	 * disables incremental checkpoints.
+	 */
+	int checkpoint_max_deltas;
+	/** Number of incremental checkpoints since the last full one. */
+	int checkpoint_delta_count;
+	/**
+	 * Set if changes made since the last checkpoint aren't
+	 * tracked so the next checkpoint must be a full one.
+	 */
+	bool checkpoint_needs_full;
+	/**
+	 * Value of snapshot_version right after the last checkpoint
+	 * was taken. Tuples created after that have a greater or
+	 * equal version and so must go to the next incremental
+	 * checkpoint.
+	 */
+	uint32_t checkpoint_version;
+	/**
+	 * Primary keys of tuples deleted since the last checkpoint,
+	 * see memtx_deleted_key. Only maintained if incremental
+	 * checkpoints are enabled. Limited by a fraction of
+	 * memtx_memory, see MEMTX_DELETED_KEYS_MAX_RATIO.
+	 */
+	struct ibuf deleted_keys;
 	/** Skip invalid snapshot records if this flag is set. */
 	bool force_recovery;
 	/**
@@ -228,6 +256,10 @@ memtx_engine_set_memory(struct memtx_engine *memtx, size_t size);
 void
 memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size);
 
+void
+memtx_engine_set_checkpoint_max_deltas(struct memtx_engine *memtx,
+				       int max_deltas);
+
 /**
  * Enter tuple delayed free mode: tuple allocated before the call
  * won't be freed until memtx_leave_delayed_free_mode() is called.
@@ -253,6 +285,13 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end);
 void
 memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple);
 
+/**
+ * Return the snapshot generation of a memtx tuple, i.e. the value
+ * of memtx_engine::snapshot_version at the time it was allocated.
+ */
+uint32_t
+memtx_tuple_version(struct tuple *tuple);
+
 /** Tuple format vtab for memtx engine. */
 extern struct tuple_format_vtab memtx_tuple_format_vtab;
 
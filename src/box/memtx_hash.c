@@ -511,6 +511,7 @@ hash_snapshot_iterator_next(struct snapshot_iterator *iterator,
 
 		if (tuple != NULL) {
 			*data = tuple_data_range(*res, size);
+			iterator->version = memtx_tuple_version(*res);
 			return 0;
 		}
 	}
@@ -563,6 +564,8 @@ static const struct index_vtab memtx_hash_index_vtab = {
 	/* .get = */ memtx_hash_index_get,
 	/* .replace = */ memtx_hash_index_replace,
 	/* .create_iterator = */ memtx_hash_index_create_iterator,
+	/* .create_covering_iterator = */
+		generic_index_create_covering_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_hash_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
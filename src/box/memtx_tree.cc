@@ -1584,6 +1584,7 @@ tree_snapshot_iterator_next(struct snapshot_iterator *iterator,
 
 		if (tuple != NULL) {
 			*data = tuple_data_range(tuple, size);
+			iterator->version = memtx_tuple_version(tuple);
 			return 0;
 		}
 	}
@@ -1648,6 +1649,8 @@ static const struct index_vtab memtx_tree_no_hint_index_vtab = {
 	/* .get = */ memtx_tree_index_get<false>,
 	/* .replace = */ memtx_tree_index_replace<false>,
 	/* .create_iterator = */ memtx_tree_index_create_iterator<false>,
+	/* .create_covering_iterator = */
+		generic_index_create_covering_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator<false>,
 	/* .stat = */ generic_index_stat,
@@ -1678,6 +1681,8 @@ static const struct index_vtab memtx_tree_use_hint_index_vtab = {
 	/* .get = */ memtx_tree_index_get<true>,
 	/* .replace = */ memtx_tree_index_replace<true>,
 	/* .create_iterator = */ memtx_tree_index_create_iterator<true>,
+	/* .create_covering_iterator = */
+		generic_index_create_covering_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator<true>,
 	/* .stat = */ generic_index_stat,
@@ -1708,6 +1713,8 @@ static const struct index_vtab memtx_tree_index_multikey_vtab = {
 	/* .get = */ memtx_tree_index_get<true>,
 	/* .replace = */ memtx_tree_index_replace_multikey,
 	/* .create_iterator = */ memtx_tree_index_create_iterator<true>,
+	/* .create_covering_iterator = */
+		generic_index_create_covering_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator<true>,
 	/* .stat = */ generic_index_stat,
@@ -1738,6 +1745,8 @@ static const struct index_vtab memtx_tree_func_index_vtab = {
 	/* .get = */ memtx_tree_index_get<true>,
 	/* .replace = */ memtx_tree_func_index_replace,
 	/* .create_iterator = */ memtx_tree_index_create_iterator<true>,
+	/* .create_covering_iterator = */
+		generic_index_create_covering_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator<true>,
 	/* .stat = */ generic_index_stat,
@@ -1774,6 +1783,8 @@ static const struct index_vtab memtx_tree_disabled_index_vtab = {
 	/* .get = */ generic_index_get,
 	/* .replace = */ disabled_index_replace,
 	/* .create_iterator = */ generic_index_create_iterator,
+	/* .create_covering_iterator = */
+		generic_index_create_covering_iterator,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
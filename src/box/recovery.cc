@@ -41,6 +41,8 @@
 #include "replication.h"
 #include "session.h"
 #include "coio_file.h"
+#include "cbus.h"
+#include "fiber_cond.h"
 #include "error.h"
 
 /*
@@ -112,6 +114,7 @@ recovery_new(const char *wal_dirname, bool force_recovery,
 
 	r->watcher = NULL;
 	rlist_create(&r->on_close_log);
+	r->skip_local_rows = false;
 
 	guard.is_active = false;
 	return r;
@@ -164,18 +167,19 @@ recovery_close_log(struct recovery *r)
 	trigger_run_xc(&r->on_close_log, NULL);
 }
 
+/**
+ * Check that no WAL files are missing between the WAL file
+ * with the given vclock and meta and the previously recovered
+ * one, which has @prev_vclock (NULL if it's the first WAL
+ * file recovered), and promote the recovery clock.
+ */
 static void
-recovery_open_log(struct recovery *r, const struct vclock *vclock)
+recovery_check_log(struct recovery *r, const struct vclock *vclock,
+		   const struct xlog_meta *meta,
+		   const struct vclock *prev_vclock)
 {
 	XlogGapError *e;
-	struct xlog_meta meta = r->cursor.meta;
-	enum xlog_cursor_state state = r->cursor.state;
-
-	recovery_close_log(r);
-
-	xdir_open_cursor_xc(&r->wal_dir, vclock_sum(vclock), &r->cursor);
-
-	if (state == XLOG_CURSOR_NEW &&
+	if (prev_vclock == NULL &&
 	    vclock_compare(vclock, &r->vclock) > 0) {
 		/*
 		 * This is the first WAL we are about to scan
@@ -186,9 +190,9 @@ recovery_open_log(struct recovery *r, const struct vclock *vclock)
 		goto gap_error;
 	}
 
-	if (state != XLOG_CURSOR_NEW &&
-	    vclock_is_set(&r->cursor.meta.prev_vclock) &&
-	    vclock_compare(&r->cursor.meta.prev_vclock, &meta.vclock) != 0) {
+	if (prev_vclock != NULL &&
+	    vclock_is_set(&meta->prev_vclock) &&
+	    vclock_compare(&meta->prev_vclock, prev_vclock) != 0) {
 		/*
 		 * WALs are missing between the last scanned WAL
 		 * and the next one.
@@ -218,6 +222,28 @@ gap_error:
 	goto out;
 }
 
+static void
+recovery_open_log(struct recovery *r, const struct vclock *vclock)
+{
+	struct xlog_meta meta = r->cursor.meta;
+	enum xlog_cursor_state state = r->cursor.state;
+
+	recovery_close_log(r);
+
+	xdir_open_cursor_xc(&r->wal_dir, vclock_sum(vclock), &r->cursor);
+
+	recovery_check_log(r, vclock, &r->cursor.meta,
+			   state == XLOG_CURSOR_NEW ? NULL : &meta.vclock);
+	/*
+	 * The first file may start long before the recovery
+	 * vclock. Skip the rows we don't need without reading
+	 * them if the file has an index. The next files start
+	 * exactly at the recovery vclock.
+	 */
+	if (state == XLOG_CURSOR_NEW)
+		xlog_cursor_seek(&r->cursor, &r->vclock, r->skip_local_rows);
+}
+
 void
 recovery_delete(struct recovery *r)
 {
@@ -235,6 +261,50 @@ recovery_delete(struct recovery *r)
 	free(r);
 }
 
+/** Count a row read from a WAL file and yield once in a while. */
+static void
+recovery_count_row(struct xstream *stream)
+{
+	if (++stream->row_count % WAL_ROWS_PER_YIELD == 0) {
+		xstream_yield(stream);
+	}
+	if (stream->row_count % 100000 == 0)
+		say_info("%.1fM rows processed",
+			 stream->row_count / 1000000.);
+}
+
+/** Apply a row read from a WAL file unless it was applied before. */
+static void
+recover_row(struct recovery *r, struct xstream *stream,
+	    struct xrow_header *row)
+{
+	int64_t current_lsn = vclock_get(&r->vclock, row->replica_id);
+	if (row->lsn <= current_lsn)
+		return; /* already applied, skip */
+
+	/*
+	 * All rows in xlog files have an assigned replica
+	 * id. The only exception are local rows, which
+	 * are signed with a zero replica id.
+	 */
+	assert(row->replica_id != 0 || row->group_id == GROUP_LOCAL);
+	/*
+	 * We can promote the vclock either before or
+	 * after xstream_write(): it only makes any impact
+	 * in case of forced recovery, when we skip the
+	 * failed row anyway.
+	 */
+	vclock_follow_xrow(&r->vclock, row);
+	if (xstream_write(stream, row) != 0) {
+		if (!r->wal_dir.force_recovery)
+			diag_raise();
+
+		say_error("skipping row {%u: %lld}",
+			  (unsigned)row->replica_id, (long long)row->lsn);
+		diag_log();
+	}
+}
+
 /**
  * Read all rows in a file starting from the last position.
  * Advance the position. If end of file is reached,
@@ -249,12 +319,7 @@ recover_xlog(struct recovery *r, struct xstream *stream,
 	struct xrow_header row;
 	while (xlog_cursor_next_xc(&r->cursor, &row,
 				   r->wal_dir.force_recovery) == 0) {
-		if (++stream->row_count % WAL_ROWS_PER_YIELD == 0) {
-			xstream_yield(stream);
-		}
-		if (stream->row_count % 100000 == 0)
-			say_info("%.1fM rows processed",
-				 stream->row_count / 1000000.);
+		recovery_count_row(stream);
 		/*
 		 * Read the next row from xlog file.
 		 *
@@ -266,31 +331,7 @@ recover_xlog(struct recovery *r, struct xstream *stream,
 		if (stop_vclock != NULL &&
 		    r->vclock.signature >= stop_vclock->signature)
 			return;
-		int64_t current_lsn = vclock_get(&r->vclock, row.replica_id);
-		if (row.lsn <= current_lsn)
-			continue; /* already applied, skip */
-
-		/*
-		 * All rows in xlog files have an assigned replica
-		 * id. The only exception are local rows, which
-		 * are signed with a zero replica id.
-		 */
-		assert(row.replica_id != 0 || row.group_id == GROUP_LOCAL);
-		/*
-		 * We can promote the vclock either before or
-		 * after xstream_write(): it only makes any impact
-		 * in case of forced recovery, when we skip the
-		 * failed row anyway.
-		 */
-		vclock_follow_xrow(&r->vclock, &row);
-		if (xstream_write(stream, &row) != 0) {
-			if (!r->wal_dir.force_recovery)
-				diag_raise();
-
-			say_error("skipping row {%u: %lld}",
-				  (unsigned)row.replica_id, (long long)row.lsn);
-			diag_log();
-		}
+		recover_row(r, stream, &row);
 	}
 }
 
@@ -369,6 +410,399 @@ recovery_finalize(struct recovery *r)
 	recovery_close_log(r);
 }
 
+/* }}} */
+
+/* {{{ WAL read-ahead */
+
+/*
+ * Reading WAL files (disk I/O, decompression, checksum checks,
+ * decoding of row headers) takes a considerable part of local
+ * recovery time. To speed it up, all WAL files but the last one
+ * can be read by a separate thread while tx is applying the rows
+ * read before. Rows are applied in the order they were written,
+ * so the result is the same as with recover_remaining_wals().
+ */
+
+enum {
+	/** Size of row bodies read in one batch. */
+	RECOVERY_BATCH_SIZE = 1024 * 1024,
+	/** Max number of batches read, but not applied yet. */
+	RECOVERY_BATCH_COUNT = 4,
+};
+
+/** A batch of rows read from a WAL file by the reader thread. */
+struct recovery_batch {
+	/** Link in recovery_reader::batches. */
+	struct stailq_entry in_batches;
+	/** Set if this is the first batch read from the file. */
+	bool is_first;
+	/** Set if this is the last batch read from the file. */
+	bool is_last;
+	/** Set if the EOF marker was read. */
+	bool is_eof;
+	/** Meta of the file. Set only for the first batch. */
+	struct xlog_meta meta;
+	/** Name of the file. */
+	char name[PATH_MAX];
+	/** Rows. Their bodies are stored in @data. */
+	struct xrow_header *rows;
+	int row_count;
+	int row_capacity;
+	/** Row bodies. */
+	char *data;
+	size_t data_size;
+	size_t data_capacity;
+};
+
+static struct recovery_batch *
+recovery_batch_new(void)
+{
+	struct recovery_batch *batch = (struct recovery_batch *)
+		calloc(1, sizeof(*batch));
+	if (batch == NULL)
+		diag_set(OutOfMemory, sizeof(*batch), "malloc",
+			 "struct recovery_batch");
+	return batch;
+}
+
+static void
+recovery_batch_delete(struct recovery_batch *batch)
+{
+	free(batch->rows);
+	free(batch->data);
+	free(batch);
+}
+
+/**
+ * Append a copy of a row to a batch. Until the batch is
+ * complete, row bodies store offsets in the data buffer,
+ * because the buffer may be reallocated.
+ */
+static int
+recovery_batch_add_row(struct recovery_batch *batch,
+		       const struct xrow_header *row)
+{
+	if (batch->row_count == batch->row_capacity) {
+		int capacity = MAX(batch->row_capacity * 2, 64);
+		size_t size = capacity * sizeof(*batch->rows);
+		struct xrow_header *rows = (struct xrow_header *)
+			realloc(batch->rows, size);
+		if (rows == NULL) {
+			diag_set(OutOfMemory, size, "realloc",
+				 "recovery batch rows");
+			return -1;
+		}
+		batch->rows = rows;
+		batch->row_capacity = capacity;
+	}
+	size_t len = 0;
+	for (int i = 0; i < row->bodycnt; i++)
+		len += row->body[i].iov_len;
+	if (batch->data_size + len > batch->data_capacity) {
+		size_t capacity = MAX(batch->data_capacity * 2,
+				      batch->data_size + len);
+		char *data = (char *)realloc(batch->data, capacity);
+		if (data == NULL) {
+			diag_set(OutOfMemory, capacity, "realloc",
+				 "recovery batch data");
+			return -1;
+		}
+		batch->data = data;
+		batch->data_capacity = capacity;
+	}
+	struct xrow_header *copy = &batch->rows[batch->row_count++];
+	*copy = *row;
+	for (int i = 0; i < row->bodycnt; i++) {
+		memcpy(batch->data + batch->data_size, row->body[i].iov_base,
+		       row->body[i].iov_len);
+		copy->body[i].iov_base = (void *)(uintptr_t)batch->data_size;
+		batch->data_size += row->body[i].iov_len;
+	}
+	return 0;
+}
+
+/** Turn row body offsets into pointers once the batch is complete. */
+static void
+recovery_batch_complete(struct recovery_batch *batch)
+{
+	for (int i = 0; i < batch->row_count; i++) {
+		struct xrow_header *row = &batch->rows[i];
+		for (int j = 0; j < row->bodycnt; j++) {
+			row->body[j].iov_base = batch->data +
+				(uintptr_t)row->body[j].iov_base;
+		}
+	}
+}
+
+struct recovery_reader {
+	/** Thread reading WAL files. */
+	struct cord cord;
+	/** Pipe from tx to the reader thread. */
+	struct cpipe reader_pipe;
+	/** Pipe from the reader thread to tx. */
+	struct cpipe tx_pipe;
+	/**
+	 * WAL directory. Used by the reader thread, not modified
+	 * by tx while the reader is running.
+	 */
+	struct xdir *dir;
+	/** Signatures of the WAL files to read. */
+	int64_t *signatures;
+	/** Number of the WAL files to read. */
+	int signature_count;
+	/** Index of the next WAL file to read. */
+	int next_signature;
+	/** WAL file being read. Used by the reader thread. */
+	struct xlog_cursor cursor;
+	/** Batches read, but not applied yet. */
+	struct stailq batches;
+	/** Length of the batches list. */
+	int batch_count;
+	/** Fiber sending read requests to the reader thread. */
+	struct fiber *fiber;
+	/** Signalled when a batch is read or applied. */
+	struct fiber_cond cond;
+	/** Set when the fiber is done reading. */
+	bool is_done;
+	/** Set to make the fiber stop reading. */
+	bool is_stopped;
+	/** Error that stopped reading, if any. */
+	struct diag diag;
+};
+
+struct recovery_read_msg {
+	struct cbus_call_msg base;
+	struct recovery_reader *reader;
+	/** Batch to fill. */
+	struct recovery_batch *batch;
+	/** Set if all the files have been read. */
+	bool is_done;
+};
+
+/** Read the next batch of rows, executed by the reader thread. */
+static int
+recovery_read_f(struct cbus_call_msg *base)
+{
+	struct recovery_read_msg *msg = (struct recovery_read_msg *)base;
+	struct recovery_reader *reader = msg->reader;
+	struct recovery_batch *batch = msg->batch;
+	struct xlog_cursor *cursor = &reader->cursor;
+	if (!xlog_cursor_is_open(cursor)) {
+		if (reader->next_signature == reader->signature_count) {
+			msg->is_done = true;
+			return 0;
+		}
+		int64_t signature = reader->signatures[reader->next_signature++];
+		if (xdir_open_cursor(reader->dir, signature, cursor) != 0)
+			return -1;
+		batch->is_first = true;
+		batch->meta = cursor->meta;
+	}
+	snprintf(batch->name, sizeof(batch->name), "%s", cursor->name);
+	while (batch->data_size < RECOVERY_BATCH_SIZE) {
+		struct xrow_header row;
+		int rc = xlog_cursor_next(cursor, &row,
+					  reader->dir->force_recovery);
+		if (rc < 0)
+			return -1;
+		if (rc > 0) {
+			batch->is_last = true;
+			batch->is_eof = xlog_cursor_is_eof(cursor);
+			xlog_cursor_close(cursor, false);
+			break;
+		}
+		if (recovery_batch_add_row(batch, &row) != 0)
+			return -1;
+	}
+	recovery_batch_complete(batch);
+	return 0;
+}
+
+static int
+recovery_reader_thread_f(va_list ap)
+{
+	struct recovery_reader *reader = va_arg(ap, struct recovery_reader *);
+	struct cbus_endpoint endpoint;
+
+	cpipe_create(&reader->tx_pipe, "tx_prio");
+	cbus_endpoint_create(&endpoint, cord_name(cord()),
+			     fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&reader->tx_pipe);
+	if (xlog_cursor_is_open(&reader->cursor))
+		xlog_cursor_close(&reader->cursor, false);
+	return 0;
+}
+
+/**
+ * Tx fiber requesting batches from the reader thread. Keeps
+ * up to RECOVERY_BATCH_COUNT batches ready to be applied.
+ */
+static int
+recovery_reader_f(va_list ap)
+{
+	struct recovery_reader *reader = va_arg(ap, struct recovery_reader *);
+	while (!reader->is_stopped) {
+		if (reader->batch_count >= RECOVERY_BATCH_COUNT) {
+			fiber_cond_wait(&reader->cond);
+			continue;
+		}
+		struct recovery_batch *batch = recovery_batch_new();
+		if (batch == NULL) {
+			diag_move(diag_get(), &reader->diag);
+			break;
+		}
+		struct recovery_read_msg msg;
+		msg.reader = reader;
+		msg.batch = batch;
+		msg.is_done = false;
+		bool cancellable = fiber_set_cancellable(false);
+		int rc = cbus_call(&reader->reader_pipe, &reader->tx_pipe,
+				   &msg.base, recovery_read_f, NULL,
+				   TIMEOUT_INFINITY);
+		fiber_set_cancellable(cancellable);
+		if (rc != 0 || msg.is_done) {
+			recovery_batch_delete(batch);
+			if (rc != 0)
+				diag_move(diag_get(), &reader->diag);
+			break;
+		}
+		stailq_add_tail_entry(&reader->batches, batch, in_batches);
+		reader->batch_count++;
+		fiber_cond_broadcast(&reader->cond);
+	}
+	reader->is_done = true;
+	fiber_cond_broadcast(&reader->cond);
+	return 0;
+}
+
+static void
+recovery_reader_start(struct recovery_reader *reader, struct xdir *dir,
+		      int64_t *signatures, int signature_count)
+{
+	memset(reader, 0, sizeof(*reader));
+	reader->dir = dir;
+	reader->signatures = signatures;
+	reader->signature_count = signature_count;
+	stailq_create(&reader->batches);
+	fiber_cond_create(&reader->cond);
+	diag_create(&reader->diag);
+	if (cord_costart(&reader->cord, "wal_reader",
+			 recovery_reader_thread_f, reader) != 0)
+		diag_raise();
+	cpipe_create(&reader->reader_pipe, "wal_reader");
+	reader->fiber = fiber_new("wal_reader", recovery_reader_f);
+	if (reader->fiber == NULL)
+		panic("failed to start the WAL reader fiber");
+	fiber_set_joinable(reader->fiber, true);
+	fiber_start(reader->fiber, reader);
+}
+
+static void
+recovery_reader_stop(struct recovery_reader *reader)
+{
+	reader->is_stopped = true;
+	fiber_cond_broadcast(&reader->cond);
+	fiber_join(reader->fiber);
+	struct recovery_batch *batch, *next;
+	stailq_foreach_entry_safe(batch, next, &reader->batches, in_batches)
+		recovery_batch_delete(batch);
+	cbus_stop_loop(&reader->reader_pipe);
+	cpipe_destroy(&reader->reader_pipe);
+	if (cord_join(&reader->cord) != 0)
+		panic("failed to join the WAL reader thread");
+	fiber_cond_destroy(&reader->cond);
+	diag_destroy(&reader->diag);
+}
+
+/**
+ * Return the next batch read by the reader thread or NULL if
+ * all the files have been read. Throws if reading failed.
+ */
+static struct recovery_batch *
+recovery_reader_next(struct recovery_reader *reader)
+{
+	while (stailq_empty(&reader->batches)) {
+		if (reader->is_done) {
+			if (!diag_is_empty(&reader->diag)) {
+				diag_move(&reader->diag, diag_get());
+				diag_raise();
+			}
+			return NULL;
+		}
+		fiber_cond_wait(&reader->cond);
+	}
+	struct recovery_batch *batch =
+		stailq_shift_entry(&reader->batches, struct recovery_batch,
+				   in_batches);
+	reader->batch_count--;
+	fiber_cond_broadcast(&reader->cond);
+	return batch;
+}
+
+void
+recover_wals_read_ahead(struct recovery *r, struct xstream *stream)
+{
+	assert(!xlog_cursor_is_open(&r->cursor));
+	struct vclockset *index = &r->wal_dir.index;
+	struct vclock *last = vclockset_last(index);
+	struct vclock *clock = vclockset_match(index, &r->vclock);
+	int count = 0;
+	for (struct vclock *c = clock; c != NULL && c != last;
+	     c = vclockset_next(index, c))
+		count++;
+	if (count == 0)
+		return;
+
+	size_t size = count * sizeof(int64_t);
+	int64_t *signatures = (int64_t *)malloc(size);
+	if (signatures == NULL)
+		tnt_raise(OutOfMemory, size, "malloc", "signatures");
+	count = 0;
+	for (struct vclock *c = clock; c != last; c = vclockset_next(index, c))
+		signatures[count++] = vclock_sum(c);
+
+	say_info("reading %d WAL files ahead", count);
+
+	struct recovery_reader reader;
+	recovery_reader_start(&reader, &r->wal_dir, signatures, count);
+	auto guard = make_scoped_guard([&]{
+		recovery_reader_stop(&reader);
+		free(signatures);
+	});
+
+	struct vclock prev_vclock, file_vclock;
+	bool is_first_file = true;
+	struct recovery_batch *batch;
+	while ((batch = recovery_reader_next(&reader)) != NULL) {
+		auto batch_guard = make_scoped_guard([=]{
+			recovery_batch_delete(batch);
+		});
+		if (batch->is_first) {
+			vclock_copy(&file_vclock, &batch->meta.vclock);
+			recovery_check_log(r, &file_vclock, &batch->meta,
+					   is_first_file ? NULL : &prev_vclock);
+			is_first_file = false;
+			say_info("recover from `%s'", batch->name);
+		}
+		for (int i = 0; i < batch->row_count; i++) {
+			recovery_count_row(stream);
+			recover_row(r, stream, &batch->rows[i]);
+		}
+		if (batch->is_last) {
+			if (batch->is_eof) {
+				say_info("done `%s'", batch->name);
+			} else {
+				say_warn("file `%s` wasn't correctly closed",
+					 batch->name);
+			}
+			vclock_copy(&prev_vclock, &file_vclock);
+			trigger_run_xc(&r->on_close_log, NULL);
+		}
+	}
+}
+
 
 /* }}} */
 
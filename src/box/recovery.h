@@ -56,6 +56,13 @@ struct recovery {
 	struct fiber *watcher;
 	/** List of triggers invoked when the current WAL is closed. */
 	struct rlist on_close_log;
+	/**
+	 * Set if the consumer isn't interested in replica-local
+	 * rows, i.e. rows with replica_id 0, e.g. a relay. Then
+	 * such rows may be skipped regardless of the 0th vclock
+	 * component when seeking in a WAL file.
+	 */
+	bool skip_local_rows;
 };
 
 struct recovery *
@@ -104,4 +111,13 @@ void
 recover_remaining_wals(struct recovery *r, struct xstream *stream,
 		       const struct vclock *stop_vclock, bool scan_dir);
 
+/**
+ * Recover all WAL files since the current vclock except the
+ * last one, reading them ahead in a separate thread. The rest
+ * is supposed to be recovered with recover_remaining_wals().
+ * Throws an exception on error.
+ */
+void
+recover_wals_read_ahead(struct recovery *r, struct xstream *stream);
+
 #endif /* TARANTOOL_RECOVERY_H_INCLUDED */
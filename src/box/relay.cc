@@ -220,6 +220,12 @@ relay_get_state(const struct relay *relay)
 	return relay->state;
 }
 
+uint32_t
+relay_get_version_id(const struct relay *relay)
+{
+	return relay->version_id;
+}
+
 const struct vclock *
 relay_vclock(const struct relay *relay)
 {
@@ -474,6 +480,8 @@ relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
 	 */
 	vclock_copy(&relay->recv_vclock, start_vclock);
 	relay->r = recovery_new(wal_dir(), false, start_vclock);
+	/* Replica-local rows are never relayed, see relay_send_row(). */
+	relay->r->skip_local_rows = true;
 	vclock_copy(&relay->stop_vclock, stop_vclock);
 
 	int rc = cord_costart(&relay->cord, "final_join",
@@ -953,6 +961,7 @@ relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 	 */
 	vclock_copy(&relay->recv_vclock, replica_clock);
 	relay->r = recovery_new(wal_dir(), false, replica_clock);
+	relay->r->skip_local_rows = true;
 	vclock_copy(&relay->tx.vclock, replica_clock);
 	relay->version_id = replica_version_id;
 
@@ -1024,6 +1033,7 @@ relay_restart_recovery(struct relay *relay)
 	vclock_copy(&restart_vclock, &relay->recv_vclock);
 	vclock_reset(&restart_vclock, 0, vclock_get(&relay->r->vclock, 0));
 	struct recovery *r = recovery_new(wal_dir(), false, &restart_vclock);
+	r->skip_local_rows = true;
 	rlist_swap(&relay->r->on_close_log, &r->on_close_log);
 	recovery_delete(relay->r);
 	relay->r = r;
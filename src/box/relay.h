@@ -77,6 +77,13 @@ relay_get_diag(struct relay *relay);
 enum relay_state
 relay_get_state(const struct relay *relay);
 
+/**
+ * Return the version of the replica the relay is feeding,
+ * see version_id().
+ */
+uint32_t
+relay_get_version_id(const struct relay *relay);
+
 /**
  * Returns relay's vclock
  * @param relay relay
@@ -585,6 +585,12 @@ space_execute_dml(struct space *space, struct txn *txn,
 		if (space->vtab->execute_upsert(space, txn, request) != 0)
 			return -1;
 		break;
+	case IPROTO_DELETE_RANGE:
+		*result = NULL;
+		if (space->vtab->execute_delete_range(space, txn,
+						      request) != 0)
+			return -1;
+		break;
 	default:
 		*result = NULL;
 	}
@@ -671,6 +677,17 @@ generic_space_bsize(struct space *space)
 	return 0;
 }
 
+int
+generic_space_execute_delete_range(struct space *space, struct txn *txn,
+				   struct request *request)
+{
+	(void)txn;
+	(void)request;
+	diag_set(ClientError, ER_UNSUPPORTED, space->engine->name,
+		 "delete_range()");
+	return -1;
+}
+
 int
 generic_space_ephemeral_replace(struct space *space, const char *tuple,
 				const char *tuple_end)
@@ -67,6 +67,8 @@ struct space_vtab {
 	int (*execute_update)(struct space *, struct txn *,
 			      struct request *, struct tuple **result);
 	int (*execute_upsert)(struct space *, struct txn *, struct request *);
+	int (*execute_delete_range)(struct space *, struct txn *,
+				    struct request *);
 
 	int (*ephemeral_replace)(struct space *, const char *, const char *);
 
@@ -567,6 +569,8 @@ space_pop_constraint_id(struct space *space, const char *name);
  * Virtual method stubs.
  */
 size_t generic_space_bsize(struct space *);
+int generic_space_execute_delete_range(struct space *, struct txn *,
+				       struct request *);
 int generic_space_ephemeral_replace(struct space *, const char *, const char *);
 int generic_space_ephemeral_delete(struct space *, const char *);
 int generic_space_ephemeral_rowid_next(struct space *, uint64_t *);
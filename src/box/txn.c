@@ -44,6 +44,8 @@ double too_long_threshold;
 /** Last prepare-sequence-number that was assigned to prepared TX. */
 int64_t txn_last_psn = 0;
 
+const char *txn_commit_wait_mode_strs[] = {"complete", "none"};
+
 /* Txn cache. */
 static struct stailq txn_cache = {NULL, &txn_cache.first};
 
@@ -914,6 +916,21 @@ txn_commit(struct txn *txn)
 		limbo_entry = txn_limbo_append(&txn_limbo, origin_id, txn);
 		if (limbo_entry == NULL)
 			goto rollback_abort;
+	} else if (txn_has_flag(txn, TXN_NO_WAIT)) {
+		/*
+		 * The caller doesn't want to wait for the write.
+		 * The transaction is completed and freed by
+		 * txn_on_journal_write() then. The number of such
+		 * transactions in flight is bounded by the journal
+		 * queue size: submission yields while it's full.
+		 */
+		txn->fiber = NULL;
+		fiber_set_txn(fiber(), NULL);
+		if (journal_write_try_async(req) != 0) {
+			txn->fiber = fiber();
+			goto rollback_io;
+		}
+		return 0;
 	}
 
 	fiber_set_txn(fiber(), NULL);
@@ -1052,6 +1069,12 @@ box_txn_begin(void)
 
 int
 box_txn_commit(void)
+{
+	return box_txn_commit_mode(TXN_COMMIT_WAIT_COMPLETE);
+}
+
+int
+box_txn_commit_mode(enum txn_commit_wait_mode mode)
 {
 	struct txn *txn = in_txn();
 	/**
@@ -1066,6 +1089,8 @@ box_txn_commit(void)
 		diag_set(ClientError, ER_COMMIT_IN_SUB_STMT);
 		return -1;
 	}
+	if (mode == TXN_COMMIT_WAIT_NONE)
+		txn_set_flags(txn, TXN_NO_WAIT);
 	int rc = txn_commit(txn);
 	fiber_gc();
 	return rc;
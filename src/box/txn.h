@@ -91,8 +91,27 @@ enum txn_flag {
 	 * example, when applier receives snapshot from master.
 	 */
 	TXN_FORCE_ASYNC = 0x40,
+	/**
+	 * Commit returns as soon as the transaction is submitted
+	 * to the journal without waiting for the write to complete.
+	 * Ignored if the transaction has to wait for synchronous
+	 * replication (TXN_WAIT_SYNC).
+	 */
+	TXN_NO_WAIT = 0x80,
 };
 
+/** How long box.commit() waits for a transaction. */
+enum txn_commit_wait_mode {
+	/** Wait until the transaction is written to the journal. */
+	TXN_COMMIT_WAIT_COMPLETE,
+	/** Return as soon as the transaction is submitted. */
+	TXN_COMMIT_WAIT_NONE,
+	txn_commit_wait_mode_MAX,
+};
+
+/** Names of the commit wait modes, as accepted by box.commit(). */
+extern const char *txn_commit_wait_mode_strs[];
+
 enum {
 	/**
 	 * Maximum recursion depth for on_replace triggers.
@@ -777,6 +796,16 @@ box_txn_begin(void);
 API_EXPORT int
 box_txn_commit(void);
 
+/**
+ * Commit the current transaction like box_txn_commit() does,
+ * but wait for the journal write according to @a mode.
+ * With TXN_COMMIT_WAIT_NONE a journal write failure isn't
+ * reported to the caller: the transaction is rolled back
+ * and its on_rollback triggers are run.
+ */
+int
+box_txn_commit_mode(enum txn_commit_wait_mode mode);
+
 /**
  * Rollback the current transaction.
  * May fail if called from a nested
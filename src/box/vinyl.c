@@ -261,6 +261,10 @@ vy_info_append_regulator(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "dump_watermark", r->dump_watermark);
 	info_append_int(h, "rate_limit", vy_quota_get_rate_limit(r->quota,
 							VY_QUOTA_CONSUMER_TX));
+	info_append_double(h, "write_stall", r->write_stall);
+	info_append_int(h, "compaction_debt", r->compaction_debt);
+	info_append_double(h, "dump_margin", r->dump_margin);
+	info_append_double(h, "rate_limit_scale", r->rate_limit_scale);
 	info_table_end(h); /* regulator */
 }
 
@@ -295,8 +299,10 @@ vy_info_append_memory(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "tx", vy_tx_manager_mem_used(env->xm));
 	info_append_int(h, "level0", lsregion_used(&env->mem_env.allocator));
 	info_append_int(h, "tuple_cache", env->cache_env.mem_used);
-	info_append_int(h, "page_index", env->lsm_env.page_index_size);
-	info_append_int(h, "bloom_filter", env->lsm_env.bloom_size);
+	info_append_int(h, "page_index", env->lsm_env.page_index_size +
+			env->run_env.part_page_index_size);
+	info_append_int(h, "bloom_filter", env->lsm_env.bloom_size +
+			env->run_env.part_bloom_size);
 	info_table_end(h); /* memory */
 }
 
@@ -380,6 +386,7 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	info_table_begin(h, "upsert");
 	info_append_int(h, "squashed", stat->upsert.squashed);
 	info_append_int(h, "applied", stat->upsert.applied);
+	info_append_int(h, "scheduled", stat->upsert.scheduled);
 	info_table_end(h); /* upsert */
 
 	info_table_begin(h, "memory");
@@ -409,6 +416,10 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	info_append_int(h, "hit", stat->disk.iterator.bloom_hit);
 	info_append_int(h, "miss", stat->disk.iterator.bloom_miss);
 	info_table_end(h); /* bloom */
+	info_table_begin(h, "readahead");
+	info_append_int(h, "pages", stat->disk.iterator.readahead.pages);
+	info_append_int(h, "used", stat->disk.iterator.readahead.used);
+	info_table_end(h); /* readahead */
 	info_table_end(h); /* iterator */
 	info_table_begin(h, "dump");
 	info_append_int(h, "count", stat->disk.dump.count);
@@ -508,6 +519,8 @@ vinyl_engine_memory_stat(struct engine *engine, struct engine_memory_stat *stat)
 	stat->index += env->mem_env.tree_extent_size;
 	stat->index += env->lsm_env.bloom_size;
 	stat->index += env->lsm_env.page_index_size;
+	stat->index += env->run_env.part_bloom_size;
+	stat->index += env->run_env.part_page_index_size;
 	stat->cache += env->cache_env.mem_used;
 	stat->tx += vy_tx_manager_mem_used(env->xm);
 }
@@ -559,6 +572,24 @@ vy_lsm_find(struct space *space, uint32_t iid)
 	return vy_lsm(index);
 }
 
+/**
+ * Return true if any secondary index of the space covers
+ * fields. Such an index may be read without looking up full
+ * tuples in the primary index so DELETE statements must be
+ * written to it immediately rather than deferred until primary
+ * index compaction, which means that DML requests have to read
+ * overwritten tuples.
+ */
+static bool
+vy_space_has_covering_index(struct space *space)
+{
+	for (uint32_t i = 1; i < space->index_count; i++) {
+		if (vy_lsm_is_covering(vy_lsm(space->index[i])))
+			return true;
+	}
+	return false;
+}
+
 /**
  * Wrapper around vy_lsm_find() which ensures that
  * the found index is unique.
@@ -676,6 +707,20 @@ vinyl_space_check_index_def(struct space *space, struct index_def *index_def)
 			 "functional index");
 		return -1;
 	}
+	if (index_def->opts.covers != 0) {
+		if (index_def->iid == 0) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "primary index can't cover fields");
+			return -1;
+		}
+		if (key_def->is_multikey) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "multikey index can't cover fields");
+			return -1;
+		}
+	}
 	return 0;
 }
 
@@ -904,6 +949,7 @@ vinyl_index_update_def(struct index *index)
 {
 	struct vy_lsm *lsm = vy_lsm(index);
 	lsm->opts = index->def->opts;
+	vy_cache_set_max_share(&lsm->cache, lsm->opts.cache_share);
 	key_def_copy(lsm->key_def, index->def->key_def);
 	key_def_copy(lsm->cmp_def, index->def->cmp_def);
 }
@@ -933,6 +979,13 @@ vinyl_index_def_change_requires_rebuild(struct index *index,
 		return true;
 	if (old_def->opts.func_id != new_def->opts.func_id)
 		return true;
+	/*
+	 * Runs of a covering index store covered fields along
+	 * with the key so they have to be rewritten if the set
+	 * of covered fields changes.
+	 */
+	if (old_def->opts.covers != new_def->opts.covers)
+		return true;
 
 	assert(index_depends_on_pk(index));
 	const struct key_def *old_cmp_def = old_def->cmp_def;
@@ -1086,6 +1139,9 @@ vinyl_space_check_format(struct space *space, struct tuple_format *format)
 	ctx.format = format;
 	ctx.is_failed = false;
 	diag_create(&ctx.diag);
+	ctx.bulk_tuples = NULL;
+	ctx.bulk_tuple_count = 0;
+	ctx.bulk_tuple_capacity = 0;
 	trigger_create(&on_replace, vy_check_format_on_replace, &ctx, NULL);
 	trigger_add(&space->on_replace, &on_replace);
 
@@ -1129,6 +1185,9 @@ vinyl_space_check_format(struct space *space, struct tuple_format *format)
 	}
 	vy_read_iterator_close(&itr);
 out:
+	for (int i = 0; i < ctx.bulk_tuple_count; i++)
+		tuple_unref(ctx.bulk_tuples[i]);
+	free(ctx.bulk_tuples);
 	diag_destroy(&ctx.diag);
 	trigger_clear(&on_replace);
 	txn_can_yield(txn, could_yield);
@@ -1261,6 +1320,7 @@ vy_is_committed(struct vy_env *env, struct vy_lsm *lsm)
  * @param tx          Current transaction.
  * @param rv          Read view.
  * @param entry       Tuple read from a secondary index.
+ * @param fill_cache  Add the found tuple to the primary index cache.
  * @param[out] result The found tuple is stored here. Must be
  *                    unreferenced after usage.
  *
@@ -1270,7 +1330,8 @@ vy_is_committed(struct vy_env *env, struct vy_lsm *lsm)
 static int
 vy_get_by_secondary_tuple(struct vy_lsm *lsm, struct vy_tx *tx,
 			  const struct vy_read_view **rv,
-			  struct vy_entry entry, struct vy_entry *result)
+			  struct vy_entry entry, bool fill_cache,
+			  struct vy_entry *result)
 {
 	int rc = 0;
 	assert(lsm->index_id > 0);
@@ -1356,7 +1417,7 @@ vy_get_by_secondary_tuple(struct vy_lsm *lsm, struct vy_tx *tx,
 		goto out;
 	}
 
-	if ((*rv)->vlsn == INT64_MAX) {
+	if (fill_cache && (*rv)->vlsn == INT64_MAX) {
 		vy_cache_add(&lsm->pk->cache, pk_entry,
 			     vy_entry_none(), key, ITER_EQ);
 	}
@@ -1410,8 +1471,8 @@ vy_get(struct vy_lsm *lsm, struct vy_tx *tx,
 		if (vy_point_lookup(lsm, tx, rv, key, &partial) != 0)
 			return -1;
 		if (lsm->index_id > 0 && partial.stmt != NULL) {
-			rc = vy_get_by_secondary_tuple(lsm, tx, rv,
-						       partial, &entry);
+			rc = vy_get_by_secondary_tuple(lsm, tx, rv, partial,
+						       true, &entry);
 			tuple_unref(partial.stmt);
 			if (rc != 0)
 				return -1;
@@ -1434,7 +1495,8 @@ vy_get(struct vy_lsm *lsm, struct vy_tx *tx,
 				tuple_ref(entry.stmt);
 			break;
 		}
-		rc = vy_get_by_secondary_tuple(lsm, tx, rv, partial, &entry);
+		rc = vy_get_by_secondary_tuple(lsm, tx, rv, partial,
+					       true, &entry);
 		if (rc != 0 || entry.stmt != NULL)
 			break;
 	}
@@ -1736,13 +1798,16 @@ vy_delete(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 	if (vy_unique_key_validate(lsm, key, part_count))
 		return -1;
 	/*
-	 * There are two cases when need to get the full tuple
+	 * There are three cases when need to get the full tuple
 	 * before deletion.
 	 * - if the space has on_replace triggers and need to pass
 	 *   to them the old tuple.
 	 * - if deletion is done by a secondary index.
+	 * - if the space has covering indexes, which can't
+	 *   tolerate deferred DELETEs.
 	 */
-	if (lsm->index_id > 0 || !rlist_empty(&space->on_replace)) {
+	if (lsm->index_id > 0 || !rlist_empty(&space->on_replace) ||
+	    vy_space_has_covering_index(space)) {
 		if (vy_get_by_raw_key(lsm, tx, vy_tx_read_view(tx),
 				      key, part_count, &stmt->old_tuple) != 0)
 			return -1;
@@ -1828,7 +1893,14 @@ vy_perform_update(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 			       column_mask) != 0)
 		return -1;
 
-	vy_stmt_set_flags(stmt->new_tuple, VY_STMT_UPDATE);
+	/*
+	 * The flag lets the write iterator turn the REPLACE into
+	 * INSERT in secondary indexes, because DELETE + REPLACE for
+	 * an unchanged key is optimized out by vy_tx_set(). This
+	 * isn't done for covering indexes so don't set the flag.
+	 */
+	if (!vy_space_has_covering_index(space))
+		vy_stmt_set_flags(stmt->new_tuple, VY_STMT_UPDATE);
 
 	if (vy_tx_set(tx, pk, stmt->new_tuple) != 0)
 		return -1;
@@ -2273,9 +2345,11 @@ vy_replace(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 	/*
 	 * Get the overwritten tuple from the primary index if
 	 * the space has on_replace triggers, in which case we
-	 * need to pass the old tuple to trigger callbacks.
+	 * need to pass the old tuple to trigger callbacks, or
+	 * covering indexes, which need the DELETE right away.
 	 */
-	if (!rlist_empty(&space->on_replace)) {
+	if (!rlist_empty(&space->on_replace) ||
+	    vy_space_has_covering_index(space)) {
 		if (vy_get(pk, tx, vy_tx_read_view(tx),
 			   stmt->new_tuple, &stmt->old_tuple) != 0)
 			return -1;
@@ -2390,6 +2464,53 @@ vinyl_space_execute_upsert(struct space *space, struct txn *txn,
 	return vy_upsert(env, tx, stmt, space, request);
 }
 
+static int
+vinyl_space_execute_delete_range(struct space *space, struct txn *txn,
+				 struct request *request)
+{
+	struct vy_env *env = vy_env(space->engine);
+	struct vy_tx *tx = txn->engine_tx;
+	if (request->index_id != 0) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "range deletion by a secondary index");
+		return -1;
+	}
+	struct vy_lsm *pk = vy_lsm_find(space, 0);
+	if (pk == NULL)
+		return -1;
+	if (vy_is_committed(env, pk))
+		return 0;
+	/*
+	 * The tombstone may have been recovered from the metadata
+	 * log, in which case we must not add it again.
+	 */
+	if (env->status == VINYL_FINAL_RECOVERY_LOCAL &&
+	    vy_lsm_find_tombstone_by_lsn(pk,
+			vclock_sum(env->recovery_vclock)) != NULL)
+		return 0;
+	/*
+	 * Deleted tuples aren't looked up so we can't pass them
+	 * to triggers.
+	 */
+	if (env->status == VINYL_ONLINE &&
+	    (!rlist_empty(&space->on_replace) ||
+	     !rlist_empty(&space->before_replace))) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "range deletion in a space with triggers");
+		return -1;
+	}
+	struct index_def *index_def = space_index(space, 0)->def;
+	const char *key = request->key;
+	uint32_t part_count = mp_decode_array(&key);
+	if (key_validate(index_def, ITER_GE, key, part_count) != 0)
+		return -1;
+	const char *key_last = request->tuple;
+	part_count = mp_decode_array(&key_last);
+	if (key_validate(index_def, ITER_LE, key_last, part_count) != 0)
+		return -1;
+	return vy_tx_delete_range(tx, pk, request->key, request->tuple);
+}
+
 static int
 vinyl_engine_begin(struct engine *engine, struct txn *txn)
 {
@@ -2408,7 +2529,7 @@ vinyl_engine_prepare(struct engine *engine, struct txn *txn)
 	struct vy_tx *tx = txn->engine_tx;
 	assert(tx != NULL);
 
-	if (tx->write_size > 0 &&
+	if ((tx->write_size > 0 || tx->tombstone != NULL) &&
 	    vinyl_check_wal(env, "DML") != 0)
 		return -1;
 
@@ -2538,6 +2659,13 @@ vy_env_trigger_dump_cb(struct vy_regulator *regulator)
 	return 0;
 }
 
+static size_t
+vy_env_compaction_debt_cb(struct vy_regulator *regulator)
+{
+	struct vy_env *env = container_of(regulator, struct vy_env, regulator);
+	return MAX(env->lsm_env.compaction_queue_size, 0);
+}
+
 static void
 vy_env_dump_complete_cb(struct vy_scheduler *scheduler,
 			int64_t dump_generation, double dump_duration)
@@ -2614,7 +2742,8 @@ vy_env_new(const char *path, size_t memory,
 
 	vy_quota_create(&e->quota, memory, vy_env_quota_exceeded_cb);
 	vy_regulator_create(&e->regulator, &e->quota,
-			    vy_env_trigger_dump_cb);
+			    vy_env_trigger_dump_cb,
+			    vy_env_compaction_debt_cb);
 
 	struct slab_cache *slab_cache = cord_slab_cache();
 	mempool_create(&e->iterator_pool, slab_cache,
@@ -2699,6 +2828,13 @@ vinyl_engine_set_cache(struct engine *engine, size_t quota)
 	vy_cache_env_set_quota(&env->cache_env, quota);
 }
 
+void
+vinyl_engine_set_page_index_cache(struct engine *engine, size_t quota)
+{
+	struct vy_env *env = vy_env(engine);
+	vy_run_env_set_part_cache_quota(&env->run_env, quota);
+}
+
 int
 vinyl_engine_set_memory(struct engine *engine, size_t size)
 {
@@ -2719,6 +2855,39 @@ vinyl_engine_set_max_tuple_size(struct engine *engine, size_t max_size)
 	env->stmt_env.max_tuple_size = max_size;
 }
 
+void
+vinyl_engine_set_max_subcompactions(struct engine *engine, int count)
+{
+	struct vy_env *env = vy_env(engine);
+	env->scheduler.max_subcompactions = count;
+}
+
+void
+vinyl_engine_set_max_write_stall(struct engine *engine, double timeout)
+{
+	struct vy_env *env = vy_env(engine);
+	vy_regulator_set_max_write_stall(&env->regulator, timeout);
+}
+
+void
+vinyl_engine_set_max_compaction_debt(struct engine *engine, size_t size)
+{
+	struct vy_env *env = vy_env(engine);
+	vy_regulator_set_max_compaction_debt(&env->regulator, size);
+}
+
+static_assert(VINYL_UPSERT_SQUASH_THRESHOLD_MAX == VY_UPSERT_THRESHOLD,
+	      "upsert squash threshold must fit in n_upserts");
+
+void
+vinyl_engine_set_upsert_squash_threshold(struct engine *engine,
+					 int threshold)
+{
+	struct vy_env *env = vy_env(engine);
+	assert(threshold >= 0 && threshold <= VY_UPSERT_THRESHOLD);
+	env->lsm_env.upsert_squash_threshold = threshold;
+}
+
 void
 vinyl_engine_set_timeout(struct engine *engine, double timeout)
 {
@@ -3215,13 +3384,21 @@ vinyl_engine_backup(struct engine *engine, const struct vclock *vclock,
 			char path[PATH_MAX];
 			for (int type = 0; type < vy_file_MAX; type++) {
 				if (type == VY_FILE_RUN_INPROGRESS ||
-				    type == VY_FILE_INDEX_INPROGRESS)
+				    type == VY_FILE_INDEX_INPROGRESS ||
+				    type == VY_FILE_BLOB_INPROGRESS)
 					continue;
 				vy_run_snprint_path(path, sizeof(path),
 						    env->path,
 						    lsm_info->space_id,
 						    lsm_info->index_id,
 						    run_info->id, type);
+				/*
+				 * A blob file is only created if the run
+				 * has values stored out of line.
+				 */
+				if (type == VY_FILE_BLOB &&
+				    access(path, F_OK) != 0)
+					continue;
 				rc = cb(path, cb_arg);
 				if (rc != 0)
 					goto out;
@@ -3344,7 +3521,7 @@ vy_squash_process(struct vy_squash *squash)
 			break;
 		assert(vy_stmt_lsn(mem_entry.stmt) >= MAX_LSN);
 		vy_stmt_set_n_upserts(mem_entry.stmt, n_upserts);
-		if (n_upserts <= VY_UPSERT_THRESHOLD)
+		if (n_upserts < VY_UPSERT_THRESHOLD)
 			++n_upserts;
 		vy_mem_tree_iterator_prev(&mem->tree, &mem_itr);
 	}
@@ -3450,6 +3627,7 @@ vy_squash_schedule(struct vy_lsm *lsm, struct vy_entry entry, void *arg)
 
 	stailq_add_tail_entry(&sq->queue, squash, next);
 	fiber_cond_signal(&sq->cond);
+	lsm->stat.upsert.scheduled++;
 	return;
 fail:
 	diag_log();
@@ -3566,7 +3744,8 @@ vinyl_iterator_primary_next(struct iterator *base, struct tuple **ret)
 	struct vy_entry entry;
 	if (vy_read_iterator_next(&it->iterator, &entry) != 0)
 		goto fail;
-	vy_read_iterator_cache_add(&it->iterator, entry);
+	if (base->fill_cache)
+		vy_read_iterator_cache_add(&it->iterator, entry);
 	vinyl_iterator_account_read(it, start_time, entry.stmt);
 	if (entry.stmt == NULL) {
 		/* EOF. Close the iterator immediately. */
@@ -3608,7 +3787,9 @@ next:
 
 	if (partial.stmt == NULL) {
 		/* EOF. Close the iterator immediately. */
-		vy_read_iterator_cache_add(&it->iterator, vy_entry_none());
+		if (base->fill_cache)
+			vy_read_iterator_cache_add(&it->iterator,
+						   vy_entry_none());
 		vinyl_iterator_account_read(it, start_time, NULL);
 		vinyl_iterator_close(it);
 		*ret = NULL;
@@ -3617,11 +3798,12 @@ next:
 	ERROR_INJECT_YIELD(ERRINJ_VY_DELAY_PK_LOOKUP);
 	/* Get the full tuple from the primary index. */
 	if (vy_get_by_secondary_tuple(lsm, it->tx, vy_tx_read_view(it->tx),
-				      partial, &entry) != 0)
+				      partial, base->fill_cache, &entry) != 0)
 		goto fail;
 	if (entry.stmt == NULL)
 		goto next;
-	vy_read_iterator_cache_add(&it->iterator, entry);
+	if (base->fill_cache)
+		vy_read_iterator_cache_add(&it->iterator, entry);
 	vinyl_iterator_account_read(it, start_time, entry.stmt);
 	*ret = entry.stmt;
 	tuple_bless(*ret);
@@ -3635,6 +3817,57 @@ fail:
 	return -1;
 }
 
+/**
+ * Iterator over a covering secondary index that returns tuples
+ * read from the index as is, without looking up full tuples in
+ * the primary index. A returned tuple may lack fields that are
+ * neither indexed nor covered: they are set to nil.
+ *
+ * This is safe, because DELETE statements are never deferred for
+ * spaces with covering indexes (see vy_space_has_covering_index())
+ * so a covering index can't contain stale tuples. For the same
+ * reason, tracking reads in the secondary index is enough to
+ * detect conflicts.
+ */
+static int
+vinyl_iterator_covering_next(struct iterator *base, struct tuple **ret)
+{
+	double start_time = ev_monotonic_now(loop());
+
+	assert(base->next == vinyl_iterator_covering_next);
+	struct vinyl_iterator *it = (struct vinyl_iterator *)base;
+	struct vy_lsm *lsm = it->iterator.lsm;
+	assert(lsm->index_id > 0 && vy_lsm_is_covering(lsm));
+	/*
+	 * Make sure the LSM tree isn't deleted while we are
+	 * reading from it.
+	 */
+	vy_lsm_ref(lsm);
+
+	if (vinyl_iterator_check_tx(it) != 0)
+		goto fail;
+
+	struct vy_entry entry;
+	if (vy_read_iterator_next(&it->iterator, &entry) != 0)
+		goto fail;
+	if (base->fill_cache)
+		vy_read_iterator_cache_add(&it->iterator, entry);
+	vinyl_iterator_account_read(it, start_time, entry.stmt);
+	if (entry.stmt == NULL) {
+		/* EOF. Close the iterator immediately. */
+		vinyl_iterator_close(it);
+	} else {
+		tuple_bless(entry.stmt);
+	}
+	*ret = entry.stmt;
+	vy_lsm_unref(lsm);
+	return 0;
+fail:
+	vinyl_iterator_close(it);
+	vy_lsm_unref(lsm);
+	return -1;
+}
+
 static void
 vinyl_iterator_free(struct iterator *base)
 {
@@ -3705,6 +3938,22 @@ vinyl_index_create_iterator(struct index *base, enum iterator_type type,
 	return (struct iterator *)it;
 }
 
+static struct iterator *
+vinyl_index_create_covering_iterator(struct index *base,
+				     enum iterator_type type,
+				     const char *key, uint32_t part_count)
+{
+	struct iterator *it = vinyl_index_create_iterator(base, type,
+							  key, part_count);
+	/*
+	 * An index that doesn't cover any fields still has to
+	 * look up full tuples in the primary index.
+	 */
+	if (it != NULL && vy_lsm_is_covering(vy_lsm(base)))
+		it->next = vinyl_iterator_covering_next;
+	return it;
+}
+
 static int
 vinyl_snapshot_iterator_next(struct snapshot_iterator *base,
 			     const char **data, uint32_t *size)
@@ -3747,6 +3996,7 @@ vinyl_index_create_snapshot_iterator(struct index *base)
 	}
 	it->base.next = vinyl_snapshot_iterator_next;
 	it->base.free = vinyl_snapshot_iterator_free;
+	it->base.version = 0;
 
 	it->rv = vy_tx_manager_read_view(env->xm);
 	if (it->rv == NULL) {
@@ -3824,8 +4074,41 @@ struct vy_build_ctx {
 	bool is_failed;
 	/** Container for storing errors. */
 	struct diag diag;
+	/**
+	 * Tuples inserted into the space while the new index
+	 * was bulk loaded, see vy_build_bulk(). Their keys are
+	 * checked for uniqueness after the runs written by
+	 * worker threads are added to the LSM tree.
+	 */
+	struct tuple **bulk_tuples;
+	int bulk_tuple_count;
+	int bulk_tuple_capacity;
 };
 
+/**
+ * Remember a tuple inserted into the space while the new index
+ * is bulk loaded so that it can be checked for uniqueness later.
+ */
+static int
+vy_build_ctx_add_bulk_tuple(struct vy_build_ctx *ctx, struct tuple *tuple)
+{
+	if (ctx->bulk_tuple_count == ctx->bulk_tuple_capacity) {
+		int capacity = MAX(ctx->bulk_tuple_capacity * 2, 16);
+		size_t size = capacity * sizeof(*ctx->bulk_tuples);
+		struct tuple **tuples = realloc(ctx->bulk_tuples, size);
+		if (tuples == NULL) {
+			diag_set(OutOfMemory, size, "realloc",
+				 "struct tuple *");
+			return -1;
+		}
+		ctx->bulk_tuples = tuples;
+		ctx->bulk_tuple_capacity = capacity;
+	}
+	tuple_ref(tuple);
+	ctx->bulk_tuples[ctx->bulk_tuple_count++] = tuple;
+	return 0;
+}
+
 /**
  * This is an on_replace trigger callback that forwards DML requests
  * to the index that is currently being built.
@@ -3858,6 +4141,16 @@ vy_build_on_replace(struct trigger *trigger, void *event)
 					 lsm, stmt->new_tuple) != 0)
 		goto err;
 
+	/*
+	 * While the new index is bulk loaded, the check above
+	 * only sees statements forwarded by this trigger so
+	 * the tuple must be rechecked upon completion.
+	 */
+	if (ctx->check_unique_constraint && stmt->new_tuple != NULL &&
+	    lsm->is_bulk_loading &&
+	    vy_build_ctx_add_bulk_tuple(ctx, stmt->new_tuple) != 0)
+		goto err;
+
 	/* Forward the statement to the new LSM tree. */
 	if (stmt->old_tuple != NULL) {
 		struct tuple *delete = vy_stmt_new_surrogate_delete(format,
@@ -4151,6 +4444,120 @@ vy_build_recover(struct vy_env *env, struct vy_lsm *lsm, struct vy_lsm *pk)
 	return rc;
 }
 
+/**
+ * Check that there's at most one tuple with the given key in
+ * the new unique index. The key is a MessagePack array.
+ */
+static int
+vy_build_check_unique_key(void *arg, const char *key)
+{
+	struct vy_build_ctx *ctx = arg;
+	struct vy_lsm *lsm = ctx->lsm;
+	struct vy_env *env = lsm->env;
+	const struct vy_read_view **rv = &env->xm->p_committed_read_view;
+
+	struct vy_entry key_entry = vy_entry_key_from_msgpack(env->key_format,
+							      lsm->cmp_def,
+							      key);
+	if (key_entry.stmt == NULL)
+		return -1;
+
+	int rc;
+	struct tuple *found = NULL;
+	struct vy_entry partial, entry;
+	struct vy_read_iterator itr;
+	vy_read_iterator_open(&itr, lsm, NULL, ITER_EQ, key_entry, rv);
+	while ((rc = vy_read_iterator_next(&itr, &partial)) == 0) {
+		if (partial.stmt == NULL)
+			break;
+		rc = vy_get_by_secondary_tuple(lsm, NULL, rv, partial,
+					       false, &entry);
+		if (rc != 0)
+			break;
+		if (entry.stmt == NULL)
+			continue;
+		if (found == NULL) {
+			found = entry.stmt;
+			continue;
+		}
+		diag_set(ClientError, ER_TUPLE_FOUND, ctx->index_name,
+			 ctx->space_name, tuple_str(found),
+			 tuple_str(entry.stmt));
+		tuple_unref(entry.stmt);
+		rc = -1;
+		break;
+	}
+	vy_read_iterator_close(&itr);
+	if (found != NULL)
+		tuple_unref(found);
+	tuple_unref(key_entry.stmt);
+	return rc;
+}
+
+/**
+ * Check that keys of a tuple inserted into the space while the
+ * new index was bulk loaded are unique in the new index.
+ */
+static int
+vy_build_check_unique_tuple(struct vy_build_ctx *ctx, struct tuple *tuple)
+{
+	struct vy_lsm *lsm = ctx->lsm;
+	struct key_def *key_def = lsm->key_def;
+	int count = 1;
+	if (key_def->is_multikey)
+		count = tuple_multikey_count(tuple, key_def);
+	for (int i = 0; i < count; i++) {
+		int multikey_idx = key_def->is_multikey ? i : MULTIKEY_NONE;
+		if (key_def->is_nullable &&
+		    tuple_key_contains_null(tuple, key_def, multikey_idx))
+			continue;
+		struct region *region = &fiber()->gc;
+		size_t region_svp = region_used(region);
+		uint32_t size;
+		const char *key = tuple_extract_key(tuple, key_def,
+						    multikey_idx, &size);
+		int rc = key != NULL ? vy_build_check_unique_key(ctx, key) : -1;
+		region_truncate(region, region_svp);
+		if (rc != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * Build the new index from the primary index runs in worker
+ * threads, see vy_scheduler_build_lsm(). Statements committed
+ * after @build_lsn are forwarded to the new index by the
+ * on_replace trigger.
+ */
+static int
+vy_build_bulk(struct vy_env *env, struct space *src_space,
+	      struct vy_build_ctx *ctx, int64_t build_lsn)
+{
+	if (vy_scheduler_build_lsm(&env->scheduler, ctx->lsm, ctx->format,
+				   build_lsn, ctx->check_unique_constraint ?
+				   vy_build_check_unique_key : NULL, ctx) != 0)
+		return -1;
+	if (ctx->bulk_tuple_count == 0)
+		return 0;
+	/*
+	 * Make sure that all transactions that inserted tuples
+	 * while the index was bulk loaded have either been
+	 * committed or aborted before checking the tuples.
+	 */
+	bool need_wal_sync;
+	vy_tx_manager_abort_writers_for_ddl(env->xm, src_space,
+					    &need_wal_sync);
+	if (need_wal_sync && wal_sync(NULL) != 0)
+		return -1;
+	for (int i = 0; i < ctx->bulk_tuple_count; i++) {
+		if (vy_build_check_unique_tuple(ctx,
+						ctx->bulk_tuples[i]) != 0)
+			return -1;
+	}
+	return 0;
+}
+
 static int
 vinyl_space_build_index(struct space *src_space, struct index *new_index,
 			struct tuple_format *new_format,
@@ -4243,12 +4650,23 @@ vinyl_space_build_index(struct space *src_space, struct index *new_index,
 			goto out;
 	}
 
+	int64_t build_lsn = env->xm->lsn;
+
+	/*
+	 * If the space has data on disk and worker threads are
+	 * allowed to split compaction, build the new index from
+	 * the primary index runs in parallel.
+	 */
+	if (env->scheduler.max_subcompactions > 1 && pk->run_count > 0) {
+		rc = vy_build_bulk(env, src_space, &ctx, build_lsn);
+		goto dump;
+	}
+
 	struct vy_read_iterator itr;
 	vy_read_iterator_open(&itr, pk, NULL, ITER_ALL, pk->env->empty_key,
 			      &env->xm->p_committed_read_view);
 	int loops = 0;
 	struct vy_entry entry;
-	int64_t build_lsn = env->xm->lsn;
 	while ((rc = vy_read_iterator_next(&itr, &entry)) == 0) {
 		struct tuple *tuple = entry.stmt;
 		if (tuple == NULL)
@@ -4299,7 +4717,7 @@ vinyl_space_build_index(struct space *src_space, struct index *new_index,
 		ERROR_INJECT_YIELD(ERRINJ_BUILD_INDEX_DELAY);
 	}
 	vy_read_iterator_close(&itr);
-
+dump:
 	/*
 	 * Dump the new index upon build completion so that we don't
 	 * have to rebuild it on recovery. No need to trigger dump if
@@ -4566,6 +4984,7 @@ static const struct space_vtab vinyl_space_vtab = {
 	/* .execute_delete = */ vinyl_space_execute_delete,
 	/* .execute_update = */ vinyl_space_execute_update,
 	/* .execute_upsert = */ vinyl_space_execute_upsert,
+	/* .execute_delete_range = */ vinyl_space_execute_delete_range,
 	/* .ephemeral_replace = */ generic_space_ephemeral_replace,
 	/* .ephemeral_delete = */ generic_space_ephemeral_delete,
 	/* .ephemeral_rowid_next = */ generic_space_ephemeral_rowid_next,
@@ -4601,6 +5020,8 @@ static const struct index_vtab vinyl_index_vtab = {
 	/* .get = */ vinyl_index_get,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ vinyl_index_create_iterator,
+	/* .create_covering_iterator = */
+		vinyl_index_create_covering_iterator,
 	/* .create_snapshot_iterator = */
 		vinyl_index_create_snapshot_iterator,
 	/* .stat = */ vinyl_index_stat,
@@ -41,6 +41,11 @@ extern "C" {
 struct info_handler;
 struct engine;
 
+enum {
+	/** Max value of box.cfg.vinyl_upsert_squash_threshold. */
+	VINYL_UPSERT_SQUASH_THRESHOLD_MAX = 128,
+};
+
 struct engine *
 vinyl_engine_new(const char *dir, size_t memory,
 		 int read_threads, int write_threads, bool force_recovery);
@@ -57,6 +62,13 @@ vinyl_engine_stat(struct engine *engine, struct info_handler *handler);
 void
 vinyl_engine_set_cache(struct engine *engine, size_t quota);
 
+/**
+ * Update the size of memory used for caching page index and
+ * bloom filter partitions of large runs.
+ */
+void
+vinyl_engine_set_page_index_cache(struct engine *engine, size_t quota);
+
 /**
  * Update vinyl memory size.
  */
@@ -69,6 +81,35 @@ vinyl_engine_set_memory(struct engine *engine, size_t size);
 void
 vinyl_engine_set_max_tuple_size(struct engine *engine, size_t max_size);
 
+/**
+ * Update the max number of worker threads a compaction task
+ * can be split between.
+ */
+void
+vinyl_engine_set_max_subcompactions(struct engine *engine, int count);
+
+/**
+ * Update the max time a transaction may be throttled
+ * for, 0 means no limit.
+ */
+void
+vinyl_engine_set_max_write_stall(struct engine *engine, double timeout);
+
+/**
+ * Update the max size of data awaiting compaction,
+ * 0 means no limit.
+ */
+void
+vinyl_engine_set_max_compaction_debt(struct engine *engine, size_t size);
+
+/**
+ * Update the number of successive UPSERTs for the same key
+ * that triggers squashing them in the background.
+ */
+void
+vinyl_engine_set_upsert_squash_threshold(struct engine *engine,
+					 int threshold);
+
 /**
  * Update query timeout.
  */
@@ -0,0 +1,444 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "vy_blob.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <msgpuck.h>
+#include <small/ibuf.h>
+#include <small/region.h>
+
+#include "coio_file.h"
+#include "diag.h"
+#include "errcode.h"
+#include "fiber.h"
+#include "fio.h"
+#include "say.h"
+#include "trivia/util.h"
+#include "tt_static.h"
+#include "tuple.h"
+#include "xlog.h"
+#include "vy_stmt.h"
+
+enum {
+	/** Max size of a blob reference encoded in MsgPack. */
+	VY_BLOB_REF_SIZE_MAX = 32,
+	/** Size of the buffer used by a blob writer. */
+	VY_BLOB_WRITE_BUF_SIZE = 128 * 1024,
+};
+
+static inline uint32_t
+vy_blob_ref_payload_size(const struct vy_blob_ref *ref)
+{
+	return mp_sizeof_array(3) + mp_sizeof_uint(ref->run_id) +
+	       mp_sizeof_uint(ref->offset) + mp_sizeof_uint(ref->size);
+}
+
+static char *
+vy_blob_ref_encode(char *data, const struct vy_blob_ref *ref)
+{
+	data = mp_encode_extl(data, VY_BLOB_REF_EXT,
+			      vy_blob_ref_payload_size(ref));
+	data = mp_encode_array(data, 3);
+	data = mp_encode_uint(data, ref->run_id);
+	data = mp_encode_uint(data, ref->offset);
+	data = mp_encode_uint(data, ref->size);
+	return data;
+}
+
+/** Return true if the given MsgPack field is a blob reference. */
+static inline bool
+vy_blob_field_is_ref(const char *data)
+{
+	if (mp_typeof(*data) != MP_EXT)
+		return false;
+	int8_t type;
+	mp_decode_extl(&data, &type);
+	return type == VY_BLOB_REF_EXT;
+}
+
+static void
+vy_blob_ref_decode(const char *data, struct vy_blob_ref *ref)
+{
+	int8_t type;
+	mp_decode_extl(&data, &type);
+	assert(type == VY_BLOB_REF_EXT);
+	uint32_t count = mp_decode_array(&data);
+	assert(count == 3);
+	(void)count;
+	ref->run_id = mp_decode_uint(&data);
+	ref->offset = mp_decode_uint(&data);
+	ref->size = mp_decode_uint(&data);
+}
+
+/**
+ * Return true if a field of a statement stored in a run file
+ * must be moved to a blob file.
+ */
+static inline bool
+vy_blob_field_needs_move(uint32_t field_no, uint32_t field_no_min,
+			 uint32_t field_size, bool is_ref, bool has_refs,
+			 uint32_t threshold)
+{
+	if (threshold == 0 || field_no < field_no_min)
+		return false;
+	/*
+	 * A value that looks like a reference is moved regardless
+	 * of its size so as not to confuse it with a reference.
+	 */
+	if (is_ref)
+		return !has_refs;
+	return field_size >= threshold;
+}
+
+/**
+ * Create a copy of a REPLACE or INSERT statement with different
+ * tuple data.
+ */
+static struct tuple *
+vy_blob_stmt_copy(struct tuple *stmt, const char *data,
+		  const char *data_end, uint8_t flags)
+{
+	struct tuple *copy = vy_stmt_new_replace(tuple_format(stmt),
+						 data, data_end);
+	if (copy == NULL)
+		return NULL;
+	vy_stmt_set_type(copy, vy_stmt_type(stmt));
+	vy_stmt_set_lsn(copy, vy_stmt_lsn(stmt));
+	vy_stmt_set_flags(copy, flags);
+	return copy;
+}
+
+void
+vy_blob_writer_create(struct vy_blob_writer *writer, const char *path,
+		      int64_t run_id)
+{
+	memset(writer, 0, sizeof(*writer));
+	snprintf(writer->path, sizeof(writer->path), "%s", path);
+	writer->run_id = run_id;
+	writer->fd = -1;
+	ibuf_create(&writer->buf, &cord()->slabc, VY_BLOB_WRITE_BUF_SIZE);
+}
+
+void
+vy_blob_writer_destroy(struct vy_blob_writer *writer)
+{
+	if (writer->fd >= 0)
+		close(writer->fd);
+	ibuf_destroy(&writer->buf);
+	free(writer->ids);
+}
+
+/** Add a run id to the set of ids referenced by a blob writer. */
+static int
+vy_blob_writer_add_id(struct vy_blob_writer *writer, int64_t run_id)
+{
+	for (uint32_t i = 0; i < writer->id_count; i++) {
+		if (writer->ids[i] == run_id)
+			return 0;
+	}
+	if (writer->id_count == writer->id_capacity) {
+		uint32_t capacity = MAX(writer->id_capacity * 2, 8);
+		int64_t *ids = realloc(writer->ids, capacity * sizeof(*ids));
+		if (ids == NULL) {
+			diag_set(OutOfMemory, capacity * sizeof(*ids),
+				 "realloc", "blob ids");
+			return -1;
+		}
+		writer->ids = ids;
+		writer->id_capacity = capacity;
+	}
+	writer->ids[writer->id_count++] = run_id;
+	return 0;
+}
+
+/** Write buffered values to the blob file. */
+static int
+vy_blob_writer_flush(struct vy_blob_writer *writer)
+{
+	size_t used = ibuf_used(&writer->buf);
+	if (used == 0)
+		return 0;
+	if (writer->fd < 0) {
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s%s",
+			 writer->path, inprogress_suffix);
+		say_info("writing `%s'", path);
+		writer->fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+		if (writer->fd < 0) {
+			diag_set(SystemError, "failed to create file '%s'",
+				 path);
+			return -1;
+		}
+	}
+	if (fio_writen(writer->fd, writer->buf.rpos, used) < 0) {
+		diag_set(SystemError, "failed to write to file '%s'",
+			 writer->path);
+		return -1;
+	}
+	ibuf_reset(&writer->buf);
+	return 0;
+}
+
+/**
+ * Append a value to the blob file.
+ * @param writer    Blob writer.
+ * @param data      MsgPack value.
+ * @param size      Size of the value.
+ * @param[out] ref  Reference to the stored value.
+ */
+static int
+vy_blob_writer_append(struct vy_blob_writer *writer, const char *data,
+		      uint32_t size, struct vy_blob_ref *ref)
+{
+	if (writer->size == 0 &&
+	    vy_blob_writer_add_id(writer, writer->run_id) != 0)
+		return -1;
+	char *buf = ibuf_alloc(&writer->buf, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "ibuf", "blob value");
+		return -1;
+	}
+	memcpy(buf, data, size);
+	ref->run_id = writer->run_id;
+	ref->offset = writer->size;
+	ref->size = size;
+	writer->size += size;
+	if (ibuf_used(&writer->buf) >= VY_BLOB_WRITE_BUF_SIZE)
+		return vy_blob_writer_flush(writer);
+	return 0;
+}
+
+struct tuple *
+vy_blob_writer_separate(struct vy_blob_writer *writer, struct tuple *stmt,
+			uint32_t threshold)
+{
+	assert(vy_stmt_type(stmt) == IPROTO_REPLACE ||
+	       vy_stmt_type(stmt) == IPROTO_INSERT);
+	uint8_t flags = vy_stmt_flags(stmt);
+	bool has_refs = (flags & VY_STMT_BLOB) != 0;
+	if (threshold == 0 && !has_refs)
+		return stmt;
+	/*
+	 * Indexed fields must stay in the run file, because
+	 * compaction needs them, e.g. to generate deferred
+	 * DELETE statements for secondary indexes.
+	 */
+	uint32_t field_no_min = tuple_format(stmt)->index_field_count;
+	uint32_t bsize;
+	const char *data = tuple_data_range(stmt, &bsize);
+	const char *data_end = data + bsize;
+	/*
+	 * First, account references the statement already has
+	 * and count values to move.
+	 */
+	uint32_t move_count = 0;
+	const char *pos = data;
+	uint32_t field_count = mp_decode_array(&pos);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		bool is_ref = vy_blob_field_is_ref(field);
+		if (is_ref && has_refs) {
+			struct vy_blob_ref ref;
+			vy_blob_ref_decode(field, &ref);
+			if (vy_blob_writer_add_id(writer, ref.run_id) != 0)
+				return NULL;
+			continue;
+		}
+		if (is_ref && i < field_no_min) {
+			/*
+			 * An indexed field looks like a reference.
+			 * Don't mark the statement with VY_STMT_BLOB
+			 * so as not to confuse it with a reference.
+			 */
+			assert(!has_refs);
+			return stmt;
+		}
+		if (vy_blob_field_needs_move(i, field_no_min, pos - field,
+					     is_ref, has_refs, threshold))
+			move_count++;
+	}
+	if (move_count == 0)
+		return stmt;
+	/*
+	 * Second, move the values to the blob file and build
+	 * the new statement.
+	 */
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size = bsize + move_count * VY_BLOB_REF_SIZE_MAX;
+	char *buf = region_alloc(region, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region", "blob stmt");
+		return NULL;
+	}
+	struct tuple *result = NULL;
+	char *wpos = buf;
+	pos = data;
+	field_count = mp_decode_array(&pos);
+	wpos = mp_encode_array(wpos, field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		uint32_t field_size = pos - field;
+		bool is_ref = vy_blob_field_is_ref(field);
+		if (!vy_blob_field_needs_move(i, field_no_min, field_size,
+					      is_ref, has_refs, threshold)) {
+			memcpy(wpos, field, field_size);
+			wpos += field_size;
+			continue;
+		}
+		struct vy_blob_ref ref;
+		if (vy_blob_writer_append(writer, field, field_size,
+					  &ref) != 0)
+			goto out;
+		wpos = vy_blob_ref_encode(wpos, &ref);
+	}
+	assert(pos == data_end);
+	assert(wpos <= buf + size);
+	result = vy_blob_stmt_copy(stmt, buf, wpos, flags | VY_STMT_BLOB);
+out:
+	region_truncate(region, region_svp);
+	return result;
+}
+
+int
+vy_blob_writer_commit(struct vy_blob_writer *writer)
+{
+	if (writer->size == 0)
+		return 0;
+	if (vy_blob_writer_flush(writer) != 0)
+		return -1;
+	if (fsync(writer->fd) < 0) {
+		diag_set(SystemError, "failed to sync file '%s'",
+			 writer->path);
+		return -1;
+	}
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s%s", writer->path, inprogress_suffix);
+	if (rename(path, writer->path) < 0) {
+		diag_set(SystemError, "failed to rename '%s' file", path);
+		return -1;
+	}
+	return 0;
+}
+
+/** Read a value from a blob file. */
+static ssize_t
+vy_blob_pread(int fd, void *buf, size_t size, off_t offset)
+{
+	/* Don't block tx, see also vy_run_env_coio_call(). */
+	if (cord_is_main())
+		return coio_preadn(fd, buf, size, offset);
+	return fio_pread(fd, buf, size, offset);
+}
+
+struct tuple *
+vy_blob_resolve(struct tuple *stmt, vy_blob_fd_f blob_fd, void *arg)
+{
+	assert(vy_stmt_type(stmt) == IPROTO_REPLACE ||
+	       vy_stmt_type(stmt) == IPROTO_INSERT);
+	assert((vy_stmt_flags(stmt) & VY_STMT_BLOB) != 0);
+	uint32_t bsize;
+	const char *data = tuple_data_range(stmt, &bsize);
+	const char *data_end = data + bsize;
+
+	size_t size = bsize;
+	const char *pos = data;
+	uint32_t field_count = mp_decode_array(&pos);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		if (vy_blob_field_is_ref(field)) {
+			struct vy_blob_ref ref;
+			vy_blob_ref_decode(field, &ref);
+			size = size - (pos - field) + ref.size;
+		}
+	}
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	char *buf = region_alloc(region, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region", "blob stmt");
+		return NULL;
+	}
+	struct tuple *result = NULL;
+	char *wpos = buf;
+	pos = data;
+	field_count = mp_decode_array(&pos);
+	wpos = mp_encode_array(wpos, field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		if (!vy_blob_field_is_ref(field)) {
+			memcpy(wpos, field, pos - field);
+			wpos += pos - field;
+			continue;
+		}
+		struct vy_blob_ref ref;
+		vy_blob_ref_decode(field, &ref);
+		int fd = blob_fd(arg, ref.run_id);
+		if (fd < 0)
+			goto out;
+		ssize_t rc = vy_blob_pread(fd, wpos, ref.size, ref.offset);
+		if (rc < 0) {
+			diag_set(SystemError, "failed to read from file");
+			goto out;
+		}
+		const char *value = wpos;
+		if (rc != (ssize_t)ref.size ||
+		    mp_check(&value, wpos + ref.size) != 0 ||
+		    value != wpos + ref.size) {
+			diag_set(ClientError, ER_INVALID_RUN_FILE,
+				 tt_sprintf("Invalid blob reference "
+					    "[%lld, %llu, %u]",
+					    (long long)ref.run_id,
+					    (unsigned long long)ref.offset,
+					    (unsigned)ref.size));
+			goto out;
+		}
+		wpos += ref.size;
+	}
+	assert(pos == data_end);
+	assert(wpos == buf + size);
+	result = vy_blob_stmt_copy(stmt, buf, wpos,
+				   vy_stmt_flags(stmt) & ~VY_STMT_BLOB);
+out:
+	region_truncate(region, region_svp);
+	return result;
+}
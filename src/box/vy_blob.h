@@ -0,0 +1,162 @@
+#ifndef INCLUDES_TARANTOOL_BOX_VY_BLOB_H
+#define INCLUDES_TARANTOOL_BOX_VY_BLOB_H
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <small/ibuf.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Key-value separation.
+ *
+ * If blob_threshold is set for a vinyl primary index, values of
+ * non-indexed fields that are at least blob_threshold bytes long
+ * are stored out of the run file, in a blob file written along
+ * with the run. In the run file, such a value is replaced with
+ * a reference - a MsgPack extension of type VY_BLOB_REF_EXT
+ * storing the id of the run whose blob file has the value and
+ * the value offset and size - and the statement is marked with
+ * VY_STMT_BLOB.
+ *
+ * Compaction copies references as they are without reading the
+ * values so that only keys and references are rewritten over
+ * and over again. As a result, a run may reference blob files
+ * written along with older runs. A run that was compacted is
+ * kept until no live run references its blob file, see
+ * vy_lsm::blob_runs.
+ *
+ * References are resolved with vy_blob_resolve() before
+ * a statement is returned to the user or an UPSERT is applied
+ * to it.
+ */
+
+struct tuple;
+
+enum {
+	/** MsgPack extension type of a blob reference. */
+	VY_BLOB_REF_EXT = 127,
+};
+
+/** Reference to a value stored in a blob file. */
+struct vy_blob_ref {
+	/** ID of the run the blob file was written along with. */
+	int64_t run_id;
+	/** Offset of the value in the blob file. */
+	uint64_t offset;
+	/** Size of the value. */
+	uint32_t size;
+};
+
+/** Blob file writer. */
+struct vy_blob_writer {
+	/** Path to the blob file. */
+	char path[PATH_MAX];
+	/** ID of the run the blob file is written along with. */
+	int64_t run_id;
+	/** Blob file descriptor or -1 if it hasn't been created. */
+	int fd;
+	/** Size of the blob file, including buffered values. */
+	uint64_t size;
+	/** Values that haven't been written to the file yet. */
+	struct ibuf buf;
+	/**
+	 * IDs of runs whose blob files are referenced by written
+	 * statements, including the id of the run being written
+	 * if any value was stored in its blob file.
+	 */
+	int64_t *ids;
+	/** Number of entries in the ids array. */
+	uint32_t id_count;
+	/** Capacity of the ids array. */
+	uint32_t id_capacity;
+};
+
+/**
+ * Initialize a blob writer. The blob file isn't created until
+ * the first value is stored in it.
+ */
+void
+vy_blob_writer_create(struct vy_blob_writer *writer, const char *path,
+		      int64_t run_id);
+
+/** Destroy a blob writer, closing the file if it is open. */
+void
+vy_blob_writer_destroy(struct vy_blob_writer *writer);
+
+/**
+ * Move values of non-indexed fields of a REPLACE or INSERT
+ * statement that are at least @threshold bytes long to the
+ * blob file and account references the statement has.
+ * If @threshold is 0, values are never moved.
+ *
+ * Returns a new statement with the values replaced with
+ * references or @stmt itself if nothing was moved. The caller
+ * must unreference the new statement. Returns NULL and sets
+ * diag on memory or IO error.
+ */
+struct tuple *
+vy_blob_writer_separate(struct vy_blob_writer *writer, struct tuple *stmt,
+			uint32_t threshold);
+
+/**
+ * Flush the blob file to disk and link it to the final name.
+ * Does nothing if no value was stored.
+ */
+int
+vy_blob_writer_commit(struct vy_blob_writer *writer);
+
+/**
+ * Callback used by vy_blob_resolve() to get the descriptor of
+ * the blob file written along with the run with the given id.
+ * Returns -1 and sets diag if the file isn't found.
+ */
+typedef int
+(*vy_blob_fd_f)(void *arg, int64_t run_id);
+
+/**
+ * Replace references of a VY_STMT_BLOB statement with values
+ * read from blob files. Returns a new statement or NULL and
+ * sets diag on error.
+ */
+struct tuple *
+vy_blob_resolve(struct tuple *stmt, vy_blob_fd_f blob_fd, void *arg);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* INCLUDES_TARANTOOL_BOX_VY_BLOB_H */
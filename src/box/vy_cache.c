@@ -47,16 +47,24 @@ enum {
 	/* Flag in cache node that means that there are no values in DB
 	 * that greater than the current and less than the previous */
 	VY_CACHE_RIGHT_LINKED = 2,
+	/* Flag in cache node that means that the node is in the
+	 * protected LRU list, i.e. it was accessed more than once */
+	VY_CACHE_PROTECTED = 4,
 	/* Max number of deletes that are made by cleanup action per one
 	 * cache operation */
 	VY_CACHE_CLEANUP_MAX_STEPS = 10,
+	/* Max percentage of the cache quota that may be occupied
+	 * by nodes in the protected LRU list */
+	VY_CACHE_PROTECTED_PCT = 80,
 };
 
 void
 vy_cache_env_create(struct vy_cache_env *e, struct slab_cache *slab_cache)
 {
-	rlist_create(&e->cache_lru);
+	rlist_create(&e->probation_lru);
+	rlist_create(&e->protected_lru);
 	e->mem_used = 0;
+	e->protected_mem_used = 0;
 	e->mem_quota = 0;
 	mempool_create(&e->cache_node_mempool, slab_cache,
 		       sizeof(struct vy_cache_node));
@@ -95,7 +103,7 @@ vy_cache_node_new(struct vy_cache_env *env, struct vy_cache *cache,
 	node->flags = 0;
 	node->left_boundary_level = cache->cmp_def->part_count;
 	node->right_boundary_level = cache->cmp_def->part_count;
-	rlist_add(&env->cache_lru, &node->in_lru);
+	rlist_add(&env->probation_lru, &node->in_lru);
 	env->mem_used += vy_cache_node_size(node);
 	vy_stmt_counter_acct_tuple(&cache->stat.count, entry.stmt);
 	return node;
@@ -108,12 +116,44 @@ vy_cache_node_delete(struct vy_cache_env *env, struct vy_cache_node *node)
 				     node->entry.stmt);
 	assert(env->mem_used >= vy_cache_node_size(node));
 	env->mem_used -= vy_cache_node_size(node);
+	if (node->flags & VY_CACHE_PROTECTED) {
+		assert(env->protected_mem_used >= vy_cache_node_size(node));
+		env->protected_mem_used -= vy_cache_node_size(node);
+	}
 	tuple_unref(node->entry.stmt);
 	rlist_del(&node->in_lru);
 	TRASH(node);
 	mempool_free(&env->cache_node_mempool, node);
 }
 
+/**
+ * Move a node to the head of the protected LRU list. Called when
+ * a cached statement is accessed again. If the protected list
+ * outgrows its share of the quota, move its oldest nodes back to
+ * the probation list so that they are evicted first.
+ */
+static void
+vy_cache_node_promote(struct vy_cache_env *env, struct vy_cache_node *node)
+{
+	rlist_move(&env->protected_lru, &node->in_lru);
+	if (node->flags & VY_CACHE_PROTECTED)
+		return;
+	node->flags |= VY_CACHE_PROTECTED;
+	env->protected_mem_used += vy_cache_node_size(node);
+	size_t protected_quota = env->mem_quota / 100 *
+				 VY_CACHE_PROTECTED_PCT;
+	while (env->protected_mem_used > protected_quota) {
+		struct vy_cache_node *victim =
+			rlist_last_entry(&env->protected_lru,
+					 struct vy_cache_node, in_lru);
+		if (victim == node)
+			break;
+		victim->flags &= ~VY_CACHE_PROTECTED;
+		env->protected_mem_used -= vy_cache_node_size(victim);
+		rlist_move(&env->probation_lru, &victim->in_lru);
+	}
+}
+
 static void *
 vy_cache_tree_page_alloc(void *ctx)
 {
@@ -141,6 +181,7 @@ vy_cache_create(struct vy_cache *cache, struct vy_cache_env *env,
 	cache->env = env;
 	cache->cmp_def = cmp_def;
 	cache->is_primary = is_primary;
+	cache->max_share = 1;
 	cache->version = 1;
 	vy_cache_tree_create(&cache->cache_tree, cmp_def,
 			     vy_cache_tree_page_alloc,
@@ -166,7 +207,8 @@ vy_cache_destroy(struct vy_cache *cache)
 static void
 vy_cache_gc_step(struct vy_cache_env *env)
 {
-	struct rlist *lru = &env->cache_lru;
+	struct rlist *lru = !rlist_empty(&env->probation_lru) ?
+			    &env->probation_lru : &env->protected_lru;
 	struct vy_cache_node *node =
 		rlist_last_entry(lru, struct vy_cache_node, in_lru);
 	struct vy_cache *cache = node->cache;
@@ -229,13 +271,20 @@ vy_cache_add(struct vy_cache *cache, struct vy_entry curr,
 	     struct vy_entry prev, struct vy_entry key,
 	     enum iterator_type order)
 {
-	if (cache->env->mem_quota == 0) {
+	struct vy_cache_env *env = cache->env;
+	if (env->mem_quota == 0) {
 		/* Cache is disabled. */
 		return;
 	}
 
 	/* Delete some entries if quota overused */
-	vy_cache_gc(cache->env);
+	vy_cache_gc(env);
+
+	if (cache->max_share < 1 &&
+	    cache->stat.count.bytes >= cache->max_share * env->mem_quota) {
+		/* The index has used up its share of the cache. */
+		return;
+	}
 
 	if (curr.stmt != NULL && vy_stmt_lsn(curr.stmt) == INT64_MAX) {
 		/* Do not store a statement from write set of a tx */
@@ -317,10 +366,12 @@ vy_cache_add(struct vy_cache *cache, struct vy_entry curr,
 	}
 	assert(!vy_cache_tree_iterator_is_invalid(&inserted));
 	if (replaced != NULL) {
-		node->flags = replaced->flags;
+		node->flags = replaced->flags & ~VY_CACHE_PROTECTED;
 		node->left_boundary_level = replaced->left_boundary_level;
 		node->right_boundary_level = replaced->right_boundary_level;
 		vy_cache_node_delete(cache->env, replaced);
+		/* The statement was read again, protect it. */
+		vy_cache_node_promote(cache->env, node);
 	}
 	if (direction > 0 && boundary_level < node->left_boundary_level)
 		node->left_boundary_level = boundary_level;
@@ -403,9 +454,20 @@ vy_cache_add(struct vy_cache *cache, struct vy_entry curr,
 		return;
 	}
 	if (replaced != NULL) {
+		/*
+		 * The previous statement wasn't read again, it is
+		 * only reinserted to link the chain, so it keeps
+		 * its position in the LRU lists.
+		 */
 		prev_node->flags = replaced->flags;
 		prev_node->left_boundary_level = replaced->left_boundary_level;
 		prev_node->right_boundary_level = replaced->right_boundary_level;
+		if (prev_node->flags & VY_CACHE_PROTECTED) {
+			env->protected_mem_used +=
+				vy_cache_node_size(prev_node);
+		}
+		rlist_del(&prev_node->in_lru);
+		rlist_add(&replaced->in_lru, &prev_node->in_lru);
 		vy_cache_node_delete(cache->env, replaced);
 	}
 
@@ -423,9 +485,30 @@ vy_cache_get(struct vy_cache *cache, struct vy_entry key)
 		vy_cache_tree_find(&cache->cache_tree, key);
 	if (node == NULL)
 		return vy_entry_none();
+	vy_cache_node_promote(cache->env, *node);
 	return (*node)->entry;
 }
 
+bool
+vy_cache_has_interval(struct vy_cache *cache, struct vy_entry begin,
+		      struct vy_entry end)
+{
+	struct vy_cache_tree *tree = &cache->cache_tree;
+	struct vy_cache_tree_iterator itr;
+	if (begin.stmt != NULL) {
+		bool exact;
+		itr = vy_cache_tree_lower_bound(tree, begin, &exact);
+	} else {
+		itr = vy_cache_tree_iterator_first(tree);
+	}
+	struct vy_cache_node **node =
+		vy_cache_tree_iterator_get_elem(tree, &itr);
+	if (node == NULL)
+		return false;
+	return end.stmt == NULL ||
+	       vy_entry_compare((*node)->entry, end, cache->cmp_def) < 0;
+}
+
 void
 vy_cache_on_write(struct vy_cache *cache, struct vy_entry entry,
 		  struct vy_entry *deleted)
@@ -503,6 +586,26 @@ vy_cache_on_write(struct vy_cache *cache, struct vy_entry entry,
 	}
 }
 
+void
+vy_cache_invalidate(struct vy_cache *cache)
+{
+	struct vy_cache_tree *tree = &cache->cache_tree;
+	while (true) {
+		struct vy_cache_tree_iterator itr =
+			vy_cache_tree_iterator_first(tree);
+		struct vy_cache_node **node =
+			vy_cache_tree_iterator_get_elem(tree, &itr);
+		if (node == NULL)
+			break;
+		struct vy_cache_node *to_delete = *node;
+		vy_stmt_counter_acct_tuple(&cache->stat.invalidate,
+					   to_delete->entry.stmt);
+		vy_cache_tree_delete(tree, to_delete);
+		vy_cache_node_delete(cache->env, to_delete);
+	}
+	cache->version++;
+}
+
 /**
  * Get a stmt by current position
  */
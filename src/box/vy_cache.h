@@ -56,10 +56,11 @@ struct vy_cache_node {
 	struct vy_cache *cache;
 	/* Statement in cache */
 	struct vy_entry entry;
-	/* Link in LRU list */
+	/* Link in the probation or protected LRU list */
 	struct rlist in_lru;
 	/* VY_CACHE_LEFT_LINKED and/or VY_CACHE_RIGHT_LINKED, see
-	 * description of them for more information */
+	 * description of them for more information, and
+	 * VY_CACHE_PROTECTED if the node is in the protected list */
 	uint32_t flags;
 	/* Number of parts in key when the value was the first in EQ search */
 	uint8_t left_boundary_level;
@@ -113,14 +114,34 @@ vy_cache_tree_key_cmp(struct vy_cache_node *a, struct vy_entry b,
 
 /**
  * Environment of the cache
+ *
+ * The cache is managed by a segmented LRU policy. A new node
+ * gets to the probation list. A node that is accessed again
+ * while it is in the cache is moved to the protected list.
+ * Eviction starts from the tail of the probation list so that
+ * a big scan, which reads every tuple only once, can't flush
+ * tuples that are accessed repeatedly. The protected list may
+ * occupy up to VY_CACHE_PROTECTED_PCT percent of the quota:
+ * when it grows beyond the limit, its oldest nodes are moved
+ * back to the probation list.
  */
 struct vy_cache_env {
-	/** Common LRU list of read cache. The first element is the newest */
-	struct rlist cache_lru;
+	/**
+	 * LRU list of nodes that have been accessed only once.
+	 * The first element is the newest.
+	 */
+	struct rlist probation_lru;
+	/**
+	 * LRU list of nodes that have been accessed more than
+	 * once. The first element is the newest.
+	 */
+	struct rlist protected_lru;
 	/** Common mempool for vy_cache_node struct */
 	struct mempool cache_node_mempool;
 	/** Size of memory occupied by cached tuples */
 	size_t mem_used;
+	/** Size of memory occupied by protected nodes */
+	size_t protected_mem_used;
 	/** Max memory size that can be used for cache */
 	size_t mem_quota;
 };
@@ -168,6 +189,11 @@ struct vy_cache {
 	uint32_t version;
 	/* Saved pointer to common cache environment */
 	struct vy_cache_env *env;
+	/**
+	 * Max share of the cache quota that may be occupied by
+	 * statements of this cache, see index_opts::cache_share.
+	 */
+	double max_share;
 	/* Cache statistics. */
 	struct vy_cache_stat stat;
 };
@@ -182,6 +208,18 @@ void
 vy_cache_create(struct vy_cache *cache, struct vy_cache_env *env,
 		struct key_def *cmp_def, bool is_primary);
 
+/**
+ * Set the max share of the cache quota that may be occupied
+ * by statements of the given cache. When the limit is reached,
+ * new statements aren't added to the cache until some of the
+ * cached statements are evicted or invalidated.
+ */
+static inline void
+vy_cache_set_max_share(struct vy_cache *cache, double max_share)
+{
+	cache->max_share = max_share;
+}
+
 /**
  * Destroy and deallocate tuple cache.
  * @param cache - pointer to tuple cache to destroy.
@@ -206,12 +244,21 @@ vy_cache_add(struct vy_cache *cache, struct vy_entry curr,
 	     enum iterator_type order);
 
 /**
- * Find value in cache.
+ * Find value in cache. A found statement is moved to
+ * the protected LRU list.
  * @return A tuple equal to key or NULL if not found.
  */
 struct vy_entry
 vy_cache_get(struct vy_cache *cache, struct vy_entry key);
 
+/**
+ * Check if the cache stores any statements in the key interval
+ * [begin, end). A NULL statement stands for infinity.
+ */
+bool
+vy_cache_has_interval(struct vy_cache *cache, struct vy_entry begin,
+		      struct vy_entry end);
+
 /**
  * Invalidate possibly cached value due to its overwriting
  * @param cache - pointer to tuple cache.
@@ -223,6 +270,14 @@ void
 vy_cache_on_write(struct vy_cache *cache, struct vy_entry entry,
 		  struct vy_entry *deleted);
 
+/**
+ * Invalidate all cached values. Used when a range deletion
+ * is written, because it may overwrite any number of cached
+ * statements.
+ */
+void
+vy_cache_invalidate(struct vy_cache *cache);
+
 
 /**
  * Cache iterator
@@ -60,6 +60,20 @@ vy_history_append_stmt(struct vy_history *history, struct vy_entry entry)
 	return 0;
 }
 
+void
+vy_history_cut(struct vy_history *history, int64_t lsn)
+{
+	struct vy_history_node *node, *tmp;
+	rlist_foreach_entry_safe_reverse(node, &history->stmts, link, tmp) {
+		if (vy_stmt_lsn(node->entry.stmt) >= lsn)
+			break;
+		rlist_del_entry(node, link);
+		if (node->is_refable)
+			tuple_unref(node->entry.stmt);
+		mempool_free(history->pool, node);
+	}
+}
+
 void
 vy_history_cleanup(struct vy_history *history)
 {
@@ -138,6 +138,14 @@ vy_history_splice(struct vy_history *dst, struct vy_history *src)
 int
 vy_history_append_stmt(struct vy_history *history, struct vy_entry entry);
 
+/**
+ * Drop all statements older than the given LSN from a history
+ * list. Used for filtering out statements deleted by a range
+ * tombstone.
+ */
+void
+vy_history_cut(struct vy_history *history, int64_t lsn);
+
 /**
  * Release all statements stored in the given history and
  * reinitialize the history list.
@@ -86,6 +86,7 @@ enum vy_log_key {
 	VY_LOG_KEY_DROP_LSN		= 14,
 	VY_LOG_KEY_GROUP_ID		= 15,
 	VY_LOG_KEY_DUMP_COUNT		= 16,
+	VY_LOG_KEY_TOMBSTONE_LSN	= 17,
 };
 
 /** vy_log_key -> human readable name. */
@@ -107,6 +108,7 @@ static const char *vy_log_key_name[] = {
 	[VY_LOG_KEY_DROP_LSN]		= "drop_lsn",
 	[VY_LOG_KEY_GROUP_ID]		= "group_id",
 	[VY_LOG_KEY_DUMP_COUNT]		= "dump_count",
+	[VY_LOG_KEY_TOMBSTONE_LSN]	= "tombstone_lsn",
 };
 
 /** vy_log_type -> human readable name. */
@@ -129,6 +131,9 @@ static const char *vy_log_type_name[] = {
 	[VY_LOG_PREPARE_LSM]		= "prepare_lsm",
 	[VY_LOG_REBOOTSTRAP]		= "rebootstrap",
 	[VY_LOG_ABORT_REBOOTSTRAP]	= "abort_rebootstrap",
+	[VY_LOG_COMPACT]		= "compact",
+	[VY_LOG_INSERT_TOMBSTONE]	= "insert_tombstone",
+	[VY_LOG_DELETE_TOMBSTONE]	= "delete_tombstone",
 };
 
 /** Batch of vylog records that must be written in one go. */
@@ -198,9 +203,30 @@ struct vy_log {
 	 * only relevant if @tx_failed is set.
 	 */
 	struct diag tx_diag;
+	/** Number of records stored in the current log file. */
+	int64_t record_count;
+	/**
+	 * Number of records the current log file had after it was
+	 * last rotated or compacted. Used for deciding when to
+	 * compact the log, see vy_log_needs_compaction().
+	 */
+	int64_t compacted_record_count;
 };
 static struct vy_log vy_log;
 
+enum {
+	/**
+	 * Don't compact the log until it stores at least this
+	 * many records.
+	 */
+	VY_LOG_COMPACT_MIN_RECORDS = 10000,
+	/**
+	 * Compact the log when it grows this many times bigger
+	 * than it was after the last rotation or compaction.
+	 */
+	VY_LOG_COMPACT_FACTOR = 2,
+};
+
 static int
 vy_log_flusher_f(va_list va);
 
@@ -211,12 +237,15 @@ static int
 vy_recovery_process_record(struct vy_recovery *recovery,
 			   const struct vy_log_record *record);
 
-static int
+static ssize_t
 vy_log_create(const struct vclock *vclock, struct vy_recovery *recovery);
 
 int
 vy_log_rotate(const struct vclock *vclock);
 
+static void
+vy_log_compact(void);
+
 /**
  * Return the name of the vylog file that has the given signature.
  */
@@ -314,6 +343,10 @@ vy_log_record_snprint(char *buf, int size, const struct vy_log_record *record)
 		SNPRINT(total, snprintf, buf, size, "%s=%"PRIu32", ",
 			vy_log_key_name[VY_LOG_KEY_DUMP_COUNT],
 			record->dump_count);
+	if (record->tombstone_lsn > 0)
+		SNPRINT(total, snprintf, buf, size, "%s=%"PRIi64", ",
+			vy_log_key_name[VY_LOG_KEY_TOMBSTONE_LSN],
+			record->tombstone_lsn);
 	SNPRINT(total, snprintf, buf, size, "}");
 	return total;
 }
@@ -445,6 +478,11 @@ vy_log_record_encode(const struct vy_log_record *record,
 		size += mp_sizeof_uint(record->dump_count);
 		n_keys++;
 	}
+	if (record->tombstone_lsn > 0) {
+		size += mp_sizeof_uint(VY_LOG_KEY_TOMBSTONE_LSN);
+		size += mp_sizeof_uint(record->tombstone_lsn);
+		n_keys++;
+	}
 	size += mp_sizeof_map(n_keys);
 
 	/*
@@ -531,6 +569,10 @@ vy_log_record_encode(const struct vy_log_record *record,
 		pos = mp_encode_uint(pos, VY_LOG_KEY_DUMP_COUNT);
 		pos = mp_encode_uint(pos, record->dump_count);
 	}
+	if (record->tombstone_lsn > 0) {
+		pos = mp_encode_uint(pos, VY_LOG_KEY_TOMBSTONE_LSN);
+		pos = mp_encode_uint(pos, record->tombstone_lsn);
+	}
 	assert(pos == tuple + size);
 
 	/*
@@ -663,6 +705,9 @@ vy_log_record_decode(struct vy_log_record *record,
 		case VY_LOG_KEY_DUMP_COUNT:
 			record->dump_count = mp_decode_uint(&pos);
 			break;
+		case VY_LOG_KEY_TOMBSTONE_LSN:
+			record->tombstone_lsn = mp_decode_uint(&pos);
+			break;
 		default:
 			mp_next(&pos); /* unknown key, ignore */
 			break;
@@ -852,6 +897,7 @@ vy_log_tx_flush(struct vy_log_tx *tx)
 	if (wal_write_vy_log(entry) != 0)
 		goto err;
 
+	vy_log.record_count += tx_size;
 	region_truncate(&fiber()->gc, used);
 	return 0;
 err:
@@ -891,6 +937,23 @@ vy_log_flush(void)
 	return rc;
 }
 
+/**
+ * Return true if the current log file has grown big enough
+ * to be compacted, see vy_log_compact().
+ */
+static bool
+vy_log_needs_compaction(void)
+{
+	int64_t threshold = VY_LOG_COMPACT_MIN_RECORDS;
+	struct errinj *inj = errinj(ERRINJ_VY_LOG_COMPACT_THRESHOLD,
+				    ERRINJ_INT);
+	if (inj != NULL && inj->iparam >= 0)
+		threshold = inj->iparam;
+	threshold = MAX(threshold, vy_log.compacted_record_count *
+				   VY_LOG_COMPACT_FACTOR);
+	return vy_log.record_count > threshold;
+}
+
 static int
 vy_log_flusher_f(va_list va)
 {
@@ -901,12 +964,15 @@ vy_log_flusher_f(va_list va)
 		 * See vy_log_tx_commit().
 		 */
 		if (vy_log.recovery != NULL ||
-		    stailq_empty(&vy_log.pending_tx)) {
+		    (stailq_empty(&vy_log.pending_tx) &&
+		     !vy_log_needs_compaction())) {
 			fiber_cond_wait(&vy_log.flusher_cond);
 			continue;
 		}
 		latch_lock(&vy_log.latch);
 		int rc = vy_log_flush();
+		if (rc == 0 && vy_log_needs_compaction())
+			vy_log_compact();
 		latch_unlock(&vy_log.latch);
 		if (rc != 0) {
 			diag_log();
@@ -1173,6 +1239,16 @@ vy_log_begin_recovery(const struct vclock *vclock, bool force_recovery)
 
 	vy_log.next_id = recovery->max_id + 1;
 	vy_log.recovery = recovery;
+	/*
+	 * We don't know how many records the log had after it was
+	 * last compacted so estimate it as the number of objects
+	 * stored in it.
+	 */
+	vy_log.record_count = recovery->record_count;
+	vy_log.compacted_record_count = mh_size(recovery->lsm_hash) +
+					mh_size(recovery->range_hash) +
+					mh_size(recovery->run_hash) +
+					mh_size(recovery->slice_hash);
 	return recovery;
 }
 
@@ -1249,13 +1325,15 @@ vy_log_rotate(const struct vclock *vclock)
 		goto fail;
 
 	/* Do actual work from coio so as not to stall tx thread. */
-	int rc = coio_call(vy_log_rotate_f, recovery, vclock);
+	ssize_t record_count = coio_call(vy_log_rotate_f, recovery, vclock);
 	vy_recovery_delete(recovery);
-	if (rc < 0) {
+	if (record_count < 0) {
 		diag_log();
 		say_error("failed to write `%s'", vy_log_filename(signature));
 		goto fail;
 	}
+	vy_log.record_count = record_count;
+	vy_log.compacted_record_count = record_count;
 
 	/*
 	 * Success. Close the old log. The new one will be opened
@@ -1363,6 +1441,10 @@ vy_log_tx_commit(void)
 	if (rc != 0)
 		goto err;
 
+	/* Let the flusher compact the log if it's grown too big. */
+	if (vy_log_needs_compaction())
+		fiber_cond_signal(&vy_log.flusher_cond);
+
 	say_verbose("commit vylog transaction");
 	return 0;
 err:
@@ -1563,6 +1645,7 @@ vy_recovery_do_create_lsm(struct vy_recovery *recovery, int64_t id,
 	lsm->prepared = NULL;
 	rlist_create(&lsm->ranges);
 	rlist_create(&lsm->runs);
+	rlist_create(&lsm->tombstones);
 	/*
 	 * Keep newer LSM trees closer to the tail of the list
 	 * so that on log rotation we create/drop past incarnations
@@ -2150,6 +2233,108 @@ vy_recovery_delete_slice(struct vy_recovery *recovery, int64_t slice_id)
 	return 0;
 }
 
+/**
+ * Handle a VY_LOG_INSERT_TOMBSTONE log record.
+ * This function allocates a new range tombstone with LSN @lsn
+ * and adds it to the list of tombstones of the LSM tree with
+ * ID @lsm_id.
+ * Return 0 on success, -1 on failure (LSN collision or OOM).
+ */
+static int
+vy_recovery_insert_tombstone(struct vy_recovery *recovery, int64_t lsm_id,
+			     int64_t lsn, const char *begin, const char *end)
+{
+	struct vy_lsm_recovery_info *lsm;
+	lsm = vy_recovery_lookup_lsm(recovery, lsm_id);
+	if (lsm == NULL) {
+		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+			 tt_sprintf("Range tombstone %lld created for "
+				    "unregistered LSM tree %lld",
+				    (long long)lsn, (long long)lsm_id));
+		return -1;
+	}
+	/* Tombstones are logged in LSN order, look up from the tail. */
+	struct vy_tombstone_recovery_info *prev;
+	rlist_foreach_entry_reverse(prev, &lsm->tombstones, in_lsm) {
+		if (prev->lsn == lsn) {
+			diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+				 tt_sprintf("Duplicate range tombstone %lld "
+					    "in LSM tree %lld",
+					    (long long)lsn, (long long)lsm_id));
+			return -1;
+		}
+		if (prev->lsn < lsn)
+			break;
+	}
+
+	size_t size = sizeof(struct vy_tombstone_recovery_info);
+	const char *data;
+	data = begin;
+	if (data != NULL)
+		mp_next(&data);
+	size_t begin_size = data - begin;
+	size += begin_size;
+	data = end;
+	if (data != NULL)
+		mp_next(&data);
+	size_t end_size = data - end;
+	size += end_size;
+
+	struct vy_tombstone_recovery_info *tombstone = malloc(size);
+	if (tombstone == NULL) {
+		diag_set(OutOfMemory, size,
+			 "malloc", "struct vy_tombstone_recovery_info");
+		return -1;
+	}
+	tombstone->lsn = lsn;
+	if (begin != NULL) {
+		tombstone->begin = (void *)tombstone + sizeof(*tombstone);
+		memcpy(tombstone->begin, begin, begin_size);
+	} else
+		tombstone->begin = NULL;
+	if (end != NULL) {
+		tombstone->end = (void *)tombstone + sizeof(*tombstone) +
+				 begin_size;
+		memcpy(tombstone->end, end, end_size);
+	} else
+		tombstone->end = NULL;
+	/*
+	 * If the loop above ran to completion, prev points to the
+	 * list head and the tombstone is added to the head, too.
+	 */
+	rlist_add_entry(&prev->in_lsm, tombstone, in_lsm);
+	return 0;
+}
+
+/**
+ * Handle a VY_LOG_DELETE_TOMBSTONE log record.
+ * This function frees the range tombstone with LSN @lsn
+ * of the LSM tree with ID @lsm_id.
+ * Return 0 on success, -1 if the tombstone not found.
+ */
+static int
+vy_recovery_delete_tombstone(struct vy_recovery *recovery, int64_t lsm_id,
+			     int64_t lsn)
+{
+	struct vy_lsm_recovery_info *lsm;
+	lsm = vy_recovery_lookup_lsm(recovery, lsm_id);
+	if (lsm != NULL) {
+		struct vy_tombstone_recovery_info *tombstone;
+		rlist_foreach_entry(tombstone, &lsm->tombstones, in_lsm) {
+			if (tombstone->lsn == lsn) {
+				rlist_del_entry(tombstone, in_lsm);
+				free(tombstone);
+				return 0;
+			}
+		}
+	}
+	diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+		 tt_sprintf("Range tombstone %lld of LSM tree %lld "
+			    "deleted but not registered",
+			    (long long)lsn, (long long)lsm_id));
+	return -1;
+}
+
 /**
  * Mark all LSM trees created during rebootstrap as dropped so
  * that they will be purged on the next garbage collection.
@@ -2259,6 +2444,15 @@ vy_recovery_process_record(struct vy_recovery *recovery,
 		rc = vy_recovery_dump_lsm(recovery, record->lsm_id,
 					    record->dump_lsn);
 		break;
+	case VY_LOG_INSERT_TOMBSTONE:
+		rc = vy_recovery_insert_tombstone(recovery, record->lsm_id,
+				record->tombstone_lsn, record->begin,
+				record->end);
+		break;
+	case VY_LOG_DELETE_TOMBSTONE:
+		rc = vy_recovery_delete_tombstone(recovery, record->lsm_id,
+						  record->tombstone_lsn);
+		break;
 	case VY_LOG_TRUNCATE_LSM:
 		/* Not used anymore, ignore. */
 		rc = 0;
@@ -2367,20 +2561,15 @@ vy_recovery_build_index_id_hash(struct vy_recovery *recovery)
 	return 0;
 }
 
-static ssize_t
-vy_recovery_new_f(va_list ap)
+/** Allocate an empty recovery context. */
+static struct vy_recovery *
+vy_recovery_alloc(void)
 {
-	int64_t signature = va_arg(ap, int64_t);
-	int flags = va_arg(ap, int);
-	struct vy_recovery **p_recovery = va_arg(ap, struct vy_recovery **);
-
-	say_verbose("loading vylog %lld", (long long)signature);
-
 	struct vy_recovery *recovery = malloc(sizeof(*recovery));
 	if (recovery == NULL) {
 		diag_set(OutOfMemory, sizeof(*recovery),
 			 "malloc", "struct vy_recovery");
-		goto fail;
+		return NULL;
 	}
 
 	rlist_create(&recovery->lsms);
@@ -2391,6 +2580,7 @@ vy_recovery_new_f(va_list ap)
 	recovery->slice_hash = NULL;
 	recovery->max_id = -1;
 	recovery->in_rebootstrap = false;
+	recovery->record_count = 0;
 
 	recovery->index_id_hash = mh_i64ptr_new();
 	recovery->lsm_hash = mh_i64ptr_new();
@@ -2403,8 +2593,41 @@ vy_recovery_new_f(va_list ap)
 	    recovery->run_hash == NULL ||
 	    recovery->slice_hash == NULL) {
 		diag_set(OutOfMemory, 0, "mh_i64ptr_new", "mh_i64ptr_t");
-		goto fail_free;
+		vy_recovery_delete(recovery);
+		return NULL;
 	}
+	return recovery;
+}
+
+/**
+ * Handle a VY_LOG_COMPACT record: discard all objects loaded
+ * so far, because the records that follow describe all objects
+ * existing at the time of compaction.
+ */
+static struct vy_recovery *
+vy_recovery_compact(struct vy_recovery *recovery)
+{
+	struct vy_recovery *compacted = vy_recovery_alloc();
+	if (compacted == NULL)
+		return NULL;
+	compacted->max_id = recovery->max_id;
+	compacted->record_count = recovery->record_count;
+	vy_recovery_delete(recovery);
+	return compacted;
+}
+
+static ssize_t
+vy_recovery_new_f(va_list ap)
+{
+	int64_t signature = va_arg(ap, int64_t);
+	int flags = va_arg(ap, int);
+	struct vy_recovery **p_recovery = va_arg(ap, struct vy_recovery **);
+
+	say_verbose("loading vylog %lld", (long long)signature);
+
+	struct vy_recovery *recovery = vy_recovery_alloc();
+	if (recovery == NULL)
+		goto fail;
 
 	/*
 	 * We don't create a log file if there are no objects to
@@ -2428,11 +2651,22 @@ vy_recovery_new_f(va_list ap)
 			break;
 		say_verbose("load vylog record: %s",
 			    vy_log_record_str(&record));
+		recovery->record_count++;
 		if (record.type == VY_LOG_SNAPSHOT) {
 			if ((flags & VY_RECOVERY_LOAD_CHECKPOINT) != 0)
 				break;
 			continue;
 		}
+		if (record.type == VY_LOG_COMPACT) {
+			struct vy_recovery *compacted;
+			compacted = vy_recovery_compact(recovery);
+			if (compacted == NULL) {
+				rc = -1;
+				break;
+			}
+			recovery = compacted;
+			continue;
+		}
 		rc = vy_recovery_process_record(recovery, &record);
 		if (rc < 0)
 			break;
@@ -2516,6 +2750,7 @@ vy_recovery_delete(struct vy_recovery *recovery)
 	struct vy_range_recovery_info *range, *next_range;
 	struct vy_slice_recovery_info *slice, *next_slice;
 	struct vy_run_recovery_info *run, *next_run;
+	struct vy_tombstone_recovery_info *tombstone, *next_tombstone;
 
 	rlist_foreach_entry_safe(lsm, &recovery->lsms, in_recovery, next_lsm) {
 		rlist_foreach_entry_safe(range, &lsm->ranges,
@@ -2527,6 +2762,9 @@ vy_recovery_delete(struct vy_recovery *recovery)
 		}
 		rlist_foreach_entry_safe(run, &lsm->runs, in_lsm, next_run)
 			free(run);
+		rlist_foreach_entry_safe(tombstone, &lsm->tombstones,
+					 in_lsm, next_tombstone)
+			free(tombstone);
 		free(lsm->key_parts);
 		free(lsm);
 	}
@@ -2565,6 +2803,7 @@ vy_log_append_lsm(struct xlog *xlog, struct vy_lsm_recovery_info *lsm)
 	struct vy_range_recovery_info *range;
 	struct vy_slice_recovery_info *slice;
 	struct vy_run_recovery_info *run;
+	struct vy_tombstone_recovery_info *tombstone;
 	struct vy_log_record record;
 
 	vy_log_record_init(&record);
@@ -2634,6 +2873,17 @@ vy_log_append_lsm(struct xlog *xlog, struct vy_lsm_recovery_info *lsm)
 		}
 	}
 
+	rlist_foreach_entry(tombstone, &lsm->tombstones, in_lsm) {
+		vy_log_record_init(&record);
+		record.type = VY_LOG_INSERT_TOMBSTONE;
+		record.lsm_id = lsm->id;
+		record.tombstone_lsn = tombstone->lsn;
+		record.begin = tombstone->begin;
+		record.end = tombstone->end;
+		if (vy_log_append_record(xlog, &record) != 0)
+			return -1;
+	}
+
 	if (lsm->drop_lsn >= 0) {
 		vy_log_record_init(&record);
 		record.type = VY_LOG_DROP_LSM;
@@ -2645,8 +2895,11 @@ vy_log_append_lsm(struct xlog *xlog, struct vy_lsm_recovery_info *lsm)
 	return 0;
 }
 
-/** Create vylog from a recovery context. */
-static int
+/**
+ * Create vylog from a recovery context.
+ * Returns the number of written records or -1 on error.
+ */
+static ssize_t
 vy_log_create(const struct vclock *vclock, struct vy_recovery *recovery)
 {
 	say_verbose("saving vylog %lld", (long long)vclock_sum(vclock));
@@ -2657,6 +2910,7 @@ vy_log_create(const struct vclock *vclock, struct vy_recovery *recovery)
 	 */
 	struct xlog xlog;
 	xlog_clear(&xlog);
+	ssize_t record_count = 0;
 
 	struct vy_lsm_recovery_info *lsm;
 	rlist_foreach_entry(lsm, &recovery->lsms, in_recovery) {
@@ -2690,10 +2944,11 @@ vy_log_create(const struct vclock *vclock, struct vy_recovery *recovery)
 	    xlog_rename(&xlog) < 0)
 		goto err_write_xlog;
 
+	record_count = xlog.rows;
 	xlog_close(&xlog, false);
 done:
 	say_verbose("done saving vylog");
-	return 0;
+	return record_count;
 
 err_write_xlog:
 	/* Delete the unfinished xlog. */
@@ -2706,3 +2961,157 @@ err_write_xlog:
 err_create_xlog:
 	return -1;
 }
+
+/**
+ * Rewrite the current vylog file so that the records written
+ * after the snapshot marker are replaced with a VY_LOG_COMPACT
+ * record followed by records describing all objects stored in
+ * the recovery context. Records preceding the marker are copied
+ * as is, because they are needed to load the state corresponding
+ * to the last checkpoint (see VY_RECOVERY_LOAD_CHECKPOINT).
+ * Returns the number of records in the new file or -1 on error.
+ */
+static ssize_t
+vy_log_compact_f(va_list ap)
+{
+	const struct vclock *vclock = va_arg(ap, const struct vclock *);
+	struct vy_recovery *recovery = va_arg(ap, struct vy_recovery *);
+
+	say_verbose("compacting vylog %lld", (long long)vclock_sum(vclock));
+
+	struct xlog_cursor cursor;
+	if (xdir_open_cursor(&vy_log.dir, vclock_sum(vclock), &cursor) < 0)
+		goto err_open_cursor;
+
+	/*
+	 * The current file can't be overwritten in place, so
+	 * write the compacted log to a temporary file, which
+	 * then replaces the current one with rename(). If we
+	 * crash before that, the temporary file is removed on
+	 * startup as it has the '.inprogress' suffix.
+	 */
+	char filename[PATH_MAX];
+	char tmp_filename[PATH_MAX];
+	snprintf(filename, sizeof(filename), "%s",
+		 vy_log_filename(vclock_sum(vclock)));
+	snprintf(tmp_filename, sizeof(tmp_filename), "%s.compact", filename);
+
+	struct xlog xlog;
+	if (xlog_create(&xlog, tmp_filename, vy_log.dir.open_wflags,
+			&cursor.meta, &vy_log.dir.opts) != 0)
+		goto err_create_xlog;
+
+	/* Copy the checkpoint records and the snapshot marker. */
+	int rc;
+	struct xrow_header row;
+	struct vy_log_record record;
+	while ((rc = xlog_cursor_next(&cursor, &row, false)) == 0) {
+		rc = vy_log_record_decode(&record, &row);
+		if (rc == 0)
+			rc = xlog_write_row(&xlog, &row) < 0 ? -1 : 0;
+		fiber_gc();
+		if (rc != 0 || record.type == VY_LOG_SNAPSHOT)
+			break;
+	}
+	if (rc > 0) {
+		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+			 "Snapshot marker not found");
+	}
+	if (rc != 0)
+		goto err_write_xlog;
+
+	/* Write all objects stored in the log. */
+	vy_log_record_init(&record);
+	record.type = VY_LOG_COMPACT;
+	if (vy_log_append_record(&xlog, &record) != 0)
+		goto err_write_xlog;
+
+	struct vy_lsm_recovery_info *lsm;
+	rlist_foreach_entry(lsm, &recovery->lsms, in_recovery) {
+		if (vy_log_append_lsm(&xlog, lsm) != 0)
+			goto err_write_xlog;
+	}
+
+	/* Make sure the new file is on disk before replacing the old one. */
+	if (xlog_flush(&xlog) < 0 ||
+	    xlog_sync(&xlog) < 0)
+		goto err_write_xlog;
+
+	ssize_t record_count = xlog.rows;
+	snprintf(tmp_filename, sizeof(tmp_filename), "%s", xlog.filename);
+	xlog_close(&xlog, false);
+	xlog_cursor_close(&cursor, false);
+
+	if (rename(tmp_filename, filename) != 0) {
+		diag_set(SystemError, "failed to rename '%s' file",
+			 tmp_filename);
+		if (unlink(tmp_filename) < 0)
+			say_syserror("failed to delete file '%s'",
+				     tmp_filename);
+		return -1;
+	}
+	say_verbose("done compacting vylog");
+	return record_count;
+
+err_write_xlog:
+	/* Delete the unfinished xlog. */
+	if (unlink(xlog.filename) < 0)
+		say_syserror("failed to delete file '%s'",
+			     xlog.filename);
+	xlog_close(&xlog, false);
+err_create_xlog:
+	xlog_cursor_close(&cursor, false);
+err_open_cursor:
+	return -1;
+}
+
+/**
+ * Compact the current vylog file so that the time it takes to
+ * load it is proportional to the number of objects stored in
+ * it rather than to the number of records written since the
+ * last checkpoint. Must be called with the log latch held.
+ *
+ * Like rotation, compaction stalls concurrent log writers, but
+ * it is rare, because it's only done when the log doubles in
+ * size. A failure to compact the log isn't critical and so it
+ * is only logged.
+ */
+static void
+vy_log_compact(void)
+{
+	assert(latch_owner(&vy_log.latch) == fiber());
+
+	int64_t signature = vclock_sum(&vy_log.last_checkpoint);
+	int64_t old_record_count = vy_log.record_count;
+	/* Don't retry until the log doubles in size again. */
+	vy_log.compacted_record_count = old_record_count;
+
+	struct vy_recovery *recovery = vy_recovery_new_locked(signature, 0);
+	if (recovery == NULL)
+		return;
+	if (recovery->in_rebootstrap) {
+		/*
+		 * Objects created before rebootstrap are dropped
+		 * only when the log is rotated on checkpoint so we
+		 * can't compact the log until then.
+		 */
+		vy_recovery_delete(recovery);
+		return;
+	}
+	ssize_t record_count = coio_call(vy_log_compact_f,
+					 &vy_log.last_checkpoint, recovery);
+	vy_recovery_delete(recovery);
+	if (record_count < 0) {
+		diag_log();
+		say_error("failed to compact `%s'",
+			  vy_log_filename(signature));
+		return;
+	}
+	/* Make the WAL thread reopen the file on the next write. */
+	wal_rotate_vy_log();
+	vy_log.record_count = record_count;
+	vy_log.compacted_record_count = record_count;
+	say_info("compacted vylog %lld: %lld => %lld records",
+		 (long long)signature, (long long)old_record_count,
+		 (long long)record_count);
+}
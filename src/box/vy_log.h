@@ -217,6 +217,38 @@ enum vy_log_record_type {
 	 * See also VY_LOG_REBOOTSTRAP.
 	 */
 	VY_LOG_ABORT_REBOOTSTRAP	= 17,
+	/**
+	 * This record denotes the beginning of a compacted section.
+	 *
+	 * Between checkpoints, records are appended to the same file
+	 * so on a busy instance the log may grow much bigger than
+	 * the set of objects it describes. When this happens, the
+	 * file is rewritten: the records following the snapshot
+	 * marker are replaced with a record of this type followed
+	 * by records describing all objects existing at the time,
+	 * see vy_log_compact(). On recovery, everything loaded
+	 * before a record of this type is discarded.
+	 */
+	VY_LOG_COMPACT			= 18,
+	/**
+	 * Insert a range tombstone into an LSM tree.
+	 * Requires vy_log_record::lsm_id, tombstone_lsn, begin, end.
+	 *
+	 * A range tombstone deletes all statements in the LSM tree
+	 * that fall in the given key range and are older than the
+	 * tombstone. A record of this type is written when a range
+	 * deletion is committed to WAL so that the tombstone isn't
+	 * lost when the WAL file is garbage collected.
+	 */
+	VY_LOG_INSERT_TOMBSTONE		= 19,
+	/**
+	 * Delete a range tombstone.
+	 * Requires vy_log_record::lsm_id, tombstone_lsn.
+	 *
+	 * Written after all statements deleted by the tombstone
+	 * have been discarded by compaction.
+	 */
+	VY_LOG_DELETE_TOMBSTONE		= 20,
 
 	vy_log_record_type_MAX
 };
@@ -283,6 +315,8 @@ struct vy_log_record {
 	int64_t gc_lsn;
 	/** For runs: number of dumps it took to create the run. */
 	uint32_t dump_count;
+	/** For range tombstones: LSN of the range deletion. */
+	int64_t tombstone_lsn;
 	/** Link in vy_log_tx::records. */
 	struct stailq_entry in_tx;
 };
@@ -315,6 +349,8 @@ struct vy_recovery {
 	 * seen matching VY_LOG_ABORT_REBOOTSTRAP.
 	 */
 	bool in_rebootstrap;
+	/** Number of records loaded from the log. */
+	int64_t record_count;
 };
 
 /** LSM tree info stored in a recovery context. */
@@ -360,6 +396,11 @@ struct vy_lsm_recovery_info {
 	 * vy_run_recovery_info::in_lsm.
 	 */
 	struct rlist runs;
+	/**
+	 * List of all range tombstones of the LSM tree, linked by
+	 * vy_tombstone_recovery_info::in_lsm, sorted by LSN.
+	 */
+	struct rlist tombstones;
 	/**
 	 * Pointer to an LSM tree that is going to replace
 	 * this one after successful ALTER.
@@ -388,6 +429,18 @@ struct vy_range_recovery_info {
 	struct rlist slices;
 };
 
+/** Range tombstone info stored in a recovery context. */
+struct vy_tombstone_recovery_info {
+	/** Link in vy_lsm_recovery_info::tombstones. */
+	struct rlist in_lsm;
+	/** LSN of the range deletion. */
+	int64_t lsn;
+	/** Start of the deleted range, stored in MsgPack array. */
+	char *begin;
+	/** End of the deleted range, stored in MsgPack array. */
+	char *end;
+};
+
 /** Run info stored in a recovery context. */
 struct vy_run_recovery_info {
 	/** Link in vy_lsm_recovery_info::runs. */
@@ -801,6 +854,33 @@ vy_log_dump_lsm(int64_t id, int64_t dump_lsn)
 	vy_log_write(&record);
 }
 
+/** Helper to log a range tombstone insertion. */
+static inline void
+vy_log_insert_tombstone(int64_t lsm_id, int64_t lsn,
+			const char *begin, const char *end)
+{
+	struct vy_log_record record;
+	vy_log_record_init(&record);
+	record.type = VY_LOG_INSERT_TOMBSTONE;
+	record.lsm_id = lsm_id;
+	record.tombstone_lsn = lsn;
+	record.begin = begin;
+	record.end = end;
+	vy_log_write(&record);
+}
+
+/** Helper to log a range tombstone deletion. */
+static inline void
+vy_log_delete_tombstone(int64_t lsm_id, int64_t lsn)
+{
+	struct vy_log_record record;
+	vy_log_record_init(&record);
+	record.type = VY_LOG_DELETE_TOMBSTONE;
+	record.lsm_id = lsm_id;
+	record.tombstone_lsn = lsn;
+	vy_log_write(&record);
+}
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -86,6 +86,7 @@ vy_lsm_env_create(struct vy_lsm_env *env, const char *path,
 	tuple_format_ref(key_format);
 	env->upsert_thresh_cb = upsert_thresh_cb;
 	env->upsert_thresh_arg = upsert_thresh_arg;
+	env->upsert_squash_threshold = VY_UPSERT_THRESHOLD;
 	env->too_long_threshold = TIMEOUT_INFINITY;
 	env->lsm_count = 0;
 	mempool_create(&env->history_node_pool, cord_slab_cache(),
@@ -164,14 +165,31 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 		 * extended keys (i.e. keys consisting of secondary
 		 * and primary index parts). This is enough to look
 		 * up a full tuple in the primary index.
+		 *
+		 * A covering index also stores covered fields so
+		 * its statements are projections of full tuples:
+		 * fields that are neither indexed nor covered are
+		 * replaced with MP_NIL. The format doesn't define
+		 * any fields, because the projections are never
+		 * validated and must survive ALTER of the space
+		 * format, but is distinct from the key format so
+		 * that vy_stmt_is_key() doesn't take them for keys.
 		 */
-		lsm->disk_format = lsm_env->key_format;
-
 		lsm->pk_in_cmp_def = key_def_find_pk_in_cmp_def(lsm->cmp_def,
 								pk->key_def,
 								&fiber()->gc);
 		if (lsm->pk_in_cmp_def == NULL)
 			goto fail_pk_in_cmp_def;
+
+		if (index_def->opts.covers != 0) {
+			lsm->disk_format = vy_stmt_format_new(
+				lsm_env->key_format->engine,
+				NULL, 0, NULL, 0, 0, NULL);
+			if (lsm->disk_format == NULL)
+				goto fail_disk_format;
+		} else {
+			lsm->disk_format = lsm_env->key_format;
+		}
 	}
 	tuple_format_ref(lsm->disk_format);
 
@@ -192,13 +210,20 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 	lsm->dump_lsn = -1;
 	lsm->commit_lsn = -1;
 	vy_cache_create(&lsm->cache, cache_env, cmp_def, index_def->iid == 0);
+	vy_cache_set_max_share(&lsm->cache, index_def->opts.cache_share);
 	rlist_create(&lsm->sealed);
 	vy_range_tree_new(&lsm->range_tree);
 	vy_range_heap_create(&lsm->range_heap);
 	rlist_create(&lsm->runs);
+	rlist_create(&lsm->blob_runs);
 	lsm->pk = pk;
-	if (pk != NULL)
+	rlist_create(&lsm->secondaries);
+	rlist_create(&lsm->in_pk);
+	if (pk != NULL) {
 		vy_lsm_ref(pk);
+		rlist_add_tail_entry(&pk->secondaries, lsm, in_pk);
+	}
+	rlist_create(&lsm->tombstones);
 	lsm->mem_format = format;
 	tuple_format_ref(lsm->mem_format);
 	heap_node_create(&lsm->in_dump);
@@ -219,6 +244,7 @@ fail_run_hist:
 	vy_lsm_stat_destroy(&lsm->stat);
 fail_stat:
 	tuple_format_unref(lsm->disk_format);
+fail_disk_format:
 	if (lsm->pk_in_cmp_def != NULL)
 		key_def_delete(lsm->pk_in_cmp_def);
 fail_pk_in_cmp_def:
@@ -259,9 +285,16 @@ vy_lsm_delete(struct vy_lsm *lsm)
 	if (lsm->index_id == 0)
 		lsm->env->compacted_data_size -=
 			lsm->stat.disk.last_level_count.bytes;
+	assert(rlist_empty(&lsm->secondaries));
+	rlist_del_entry(lsm, in_pk);
 	if (lsm->pk != NULL)
 		vy_lsm_unref(lsm->pk);
 
+	struct vy_tombstone *tombstone, *next_tombstone;
+	rlist_foreach_entry_safe(tombstone, &lsm->tombstones, in_lsm,
+				 next_tombstone)
+		vy_tombstone_delete(tombstone);
+
 	struct vy_mem *mem, *next_mem;
 	rlist_foreach_entry_safe(mem, &lsm->sealed, in_sealed, next_mem)
 		vy_mem_delete(mem);
@@ -270,6 +303,10 @@ vy_lsm_delete(struct vy_lsm *lsm)
 	struct vy_run *run, *next_run;
 	rlist_foreach_entry_safe(run, &lsm->runs, in_lsm, next_run)
 		vy_lsm_remove_run(lsm, run);
+	rlist_foreach_entry_safe(run, &lsm->blob_runs, in_lsm, next_run) {
+		rlist_del_entry(run, in_lsm);
+		vy_run_unref(run);
+	}
 
 	vy_range_tree_iter(&lsm->range_tree, NULL, vy_range_tree_free_cb, NULL);
 	vy_range_heap_destroy(&lsm->range_heap);
@@ -607,6 +644,23 @@ vy_lsm_recover(struct vy_lsm *lsm, struct vy_recovery *recovery,
 	 */
 	lsm->dump_lsn = lsm_info->dump_lsn;
 
+	struct vy_tombstone_recovery_info *tombstone_info;
+	rlist_foreach_entry(tombstone_info, &lsm_info->tombstones, in_lsm) {
+		struct vy_tombstone *tombstone;
+		tombstone = vy_tombstone_new(tombstone_info->lsn,
+					     tombstone_info->begin,
+					     tombstone_info->end);
+		if (tombstone == NULL)
+			return -1;
+		/*
+		 * Statements deleted by the tombstone may be
+		 * replayed from WAL so they can't be purged
+		 * until the current in-memory trees are dumped.
+		 */
+		tombstone->generation = *lsm->env->p_generation;
+		vy_lsm_add_tombstone(lsm, tombstone);
+	}
+
 	int rc = 0;
 	struct vy_range_recovery_info *range_info;
 	rlist_foreach_entry(range_info, &lsm_info->ranges, in_lsm) {
@@ -617,6 +671,23 @@ vy_lsm_recover(struct vy_lsm *lsm, struct vy_recovery *recovery,
 		}
 	}
 
+	/*
+	 * A run that has no slices, but hasn't been dropped, was
+	 * kept after compaction for its blob file. Recover it as
+	 * well, see vy_lsm::blob_runs.
+	 */
+	struct vy_run_recovery_info *run_info;
+	rlist_foreach_entry(run_info, &lsm_info->runs, in_lsm) {
+		if (rc != 0)
+			break;
+		if (run_info->is_dropped || run_info->is_incomplete ||
+		    run_info->data != NULL)
+			continue;
+		if (vy_lsm_recover_run(lsm, run_info, run_env,
+				       force_recovery) == NULL)
+			rc = -1;
+	}
+
 	/*
 	 * vy_lsm_recover_run() elevates reference counter
 	 * of each recovered run. We need to drop the extra
@@ -624,15 +695,23 @@ vy_lsm_recover(struct vy_lsm *lsm, struct vy_recovery *recovery,
 	 */
 	struct vy_run *run, *next_run;
 	rlist_foreach_entry_safe(run, &lsm->runs, in_lsm, next_run) {
-		/*
-		 * In case vy_lsm_recover_range() failed, slices
-		 * are already deleted and runs are unrefed. So
-		 * we have nothing to do but finish run clean-up.
-		 */
-		if (run->refs == 1) {
-			assert(rc != 0);
-			assert(run->slice_count == 0);
+		if (run->slice_count == 0) {
 			vy_lsm_remove_run(lsm, run);
+			if (rc == 0) {
+				/*
+				 * Blob run, the LSM tree takes
+				 * over the extra reference.
+				 */
+				rlist_add_entry(&lsm->blob_runs, run, in_lsm);
+				continue;
+			}
+			/*
+			 * In case recovery failed, slices are
+			 * already deleted and runs are unrefed.
+			 * So we have nothing to do but finish
+			 * run clean-up.
+			 */
+			assert(run->refs == 1);
 		}
 		vy_run_unref(run);
 	}
@@ -640,6 +719,12 @@ vy_lsm_recover(struct vy_lsm *lsm, struct vy_recovery *recovery,
 	if (rc != 0)
 		return -1;
 
+	/* Restore references to blob files, see vy_blob.h. */
+	rlist_foreach_entry(run, &lsm->runs, in_lsm) {
+		if (vy_lsm_ref_blobs(lsm, run) != 0)
+			return -1;
+	}
+
 	/*
 	 * Account ranges to the LSM tree and check that the range tree
 	 * does not have holes or overlaps.
@@ -707,8 +792,12 @@ vy_lsm_compaction_priority(struct vy_lsm *lsm)
 	 * garbage collection (see vy_task_compaction_complete()), enabling
 	 * compaction in this case would result in rescheduling it over and
 	 * over again, which is no good.
+	 *
+	 * An LSM tree that is being bulk loaded isn't compacted
+	 * either, because its newest slices would be merged
+	 * without the older data, see vy_scheduler_build_lsm().
 	 */
-	if (lsm->is_dropped)
+	if (lsm->is_dropped || lsm->is_bulk_loading)
 		return 0;
 	return range->compaction_priority;
 }
@@ -754,8 +843,18 @@ vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run)
 	lsm->bloom_size += bloom_size;
 	lsm->page_index_size += page_index_size;
 
-	env->bloom_size += bloom_size;
-	env->page_index_size += page_index_size;
+	if (vy_run_is_partitioned(run)) {
+		/*
+		 * Page index and bloom filter partitions of such
+		 * a run are loaded on demand and accounted by
+		 * vy_run_env, only the partition directory is
+		 * always kept in memory.
+		 */
+		env->page_index_size += run->part_index_size;
+	} else {
+		env->bloom_size += bloom_size;
+		env->page_index_size += page_index_size;
+	}
 
 	/* Data size is consistent with space.bsize. */
 	if (lsm->index_id == 0)
@@ -783,8 +882,18 @@ vy_lsm_remove_run(struct vy_lsm *lsm, struct vy_run *run)
 	lsm->bloom_size -= bloom_size;
 	lsm->page_index_size -= page_index_size;
 
-	env->bloom_size -= bloom_size;
-	env->page_index_size -= page_index_size;
+	if (vy_run_is_partitioned(run)) {
+		/*
+		 * Page index and bloom filter partitions of such
+		 * a run are loaded on demand and accounted by
+		 * vy_run_env, only the partition directory is
+		 * always kept in memory.
+		 */
+		env->page_index_size -= run->part_index_size;
+	} else {
+		env->bloom_size -= bloom_size;
+		env->page_index_size -= page_index_size;
+	}
 
 	/* Data size is consistent with space.bsize. */
 	if (lsm->index_id == 0)
@@ -795,6 +904,124 @@ vy_lsm_remove_run(struct vy_lsm *lsm, struct vy_run *run)
 		env->disk_index_size -= run->count.bytes;
 }
 
+/**
+ * Look up a run whose blob file may be referenced by other runs
+ * of an LSM tree.
+ */
+static struct vy_run *
+vy_lsm_find_blob_run(struct vy_lsm *lsm, int64_t run_id)
+{
+	struct vy_run *run;
+	rlist_foreach_entry(run, &lsm->runs, in_lsm) {
+		if (run->id == run_id)
+			return run;
+	}
+	rlist_foreach_entry(run, &lsm->blob_runs, in_lsm) {
+		if (run->id == run_id)
+			return run;
+	}
+	return NULL;
+}
+
+int
+vy_lsm_ref_blobs(struct vy_lsm *lsm, struct vy_run *run)
+{
+	assert(run->blob_runs == NULL);
+	uint32_t count = run->info.blob_id_count;
+	if (count == 0)
+		return 0;
+	struct vy_run **blob_runs = malloc(count * sizeof(*blob_runs));
+	if (blob_runs == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*blob_runs),
+			 "malloc", "struct vy_run");
+		return -1;
+	}
+	int blob_run_count = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		int64_t run_id = run->info.blob_ids[i];
+		if (run_id == run->id)
+			continue;
+		struct vy_run *blob_run = vy_lsm_find_blob_run(lsm, run_id);
+		if (blob_run == NULL) {
+			diag_set(ClientError, ER_INVALID_RUN_FILE,
+				 tt_sprintf("Run %lld references blob file "
+					    "of unknown run %lld",
+					    (long long)run->id,
+					    (long long)run_id));
+			free(blob_runs);
+			return -1;
+		}
+		blob_runs[blob_run_count++] = blob_run;
+	}
+	for (int i = 0; i < blob_run_count; i++) {
+		vy_run_ref(blob_runs[i]);
+		blob_runs[i]->blob_refs++;
+	}
+	run->blob_runs = blob_runs;
+	run->blob_run_count = blob_run_count;
+	return 0;
+}
+
+void
+vy_lsm_unref_blobs(struct vy_lsm *lsm, struct vy_run *run)
+{
+	(void)lsm;
+	/*
+	 * Blob runs stay referenced by vy_run::blob_runs until
+	 * the run is deleted, because it may still be read.
+	 */
+	for (int i = 0; i < run->blob_run_count; i++) {
+		struct vy_run *blob_run = run->blob_runs[i];
+		assert(blob_run->blob_refs > 0);
+		blob_run->blob_refs--;
+	}
+}
+
+void
+vy_lsm_add_blob_run(struct vy_lsm *lsm, struct vy_run *run)
+{
+	assert(rlist_empty(&run->in_lsm));
+	vy_run_ref(run);
+	rlist_add_entry(&lsm->blob_runs, run, in_lsm);
+}
+
+void
+vy_lsm_gc_blob_runs(struct vy_lsm *lsm)
+{
+	RLIST_HEAD(unused_runs);
+	struct vy_run *run, *next_run;
+	rlist_foreach_entry(run, &lsm->blob_runs, in_lsm) {
+		if (run->blob_refs == 0)
+			rlist_add_entry(&unused_runs, run, in_unused);
+	}
+	if (rlist_empty(&unused_runs))
+		return;
+
+	vy_log_tx_begin();
+	rlist_foreach_entry(run, &unused_runs, in_unused)
+		vy_log_drop_run(run->id, VY_LOG_GC_LSN_CURRENT);
+	if (vy_log_tx_commit() < 0) {
+		/* Will retry after the next compaction. */
+		diag_log();
+		say_error("%s: failed to delete blob runs",
+			  vy_lsm_name(lsm));
+		return;
+	}
+
+	rlist_foreach_entry_safe(run, &unused_runs, in_unused, next_run) {
+		/*
+		 * Remove files of runs that were created after
+		 * the last checkpoint immediately, see also
+		 * vy_task_compaction_complete().
+		 */
+		if (run->dump_lsn > vy_log_signature())
+			vy_run_remove_files(lsm->env->path, lsm->space_id,
+					    lsm->index_id, run->id);
+		rlist_del_entry(run, in_lsm);
+		vy_run_unref(run);
+	}
+}
+
 void
 vy_lsm_add_range(struct vy_lsm *lsm, struct vy_range *range)
 {
@@ -973,7 +1200,7 @@ vy_lsm_commit_upsert(struct vy_lsm *lsm, struct vy_mem *mem,
 	 */
 	if (n_upserts == VY_UPSERT_INF) {
 		/*
-		 * If UPSERT has n_upserts > VY_UPSERT_THRESHOLD,
+		 * If UPSERT has n_upserts == VY_UPSERT_INF,
 		 * it means the mem has older UPSERTs for the same
 		 * key which already are beeing processed in the
 		 * squashing task. At the end, the squashing task
@@ -982,19 +1209,24 @@ vy_lsm_commit_upsert(struct vy_lsm *lsm, struct vy_mem *mem,
 		 */
 		return;
 	}
-	if (n_upserts == VY_UPSERT_THRESHOLD) {
+	int threshold = lsm->env->upsert_squash_threshold;
+	if (threshold > 0 && n_upserts >= threshold) {
+		if (lsm->env->upsert_thresh_cb == NULL) {
+			/* Squash callback is not installed. */
+			return;
+		}
 		/*
 		 * Start single squashing task per one-mem and
-		 * one-key continous UPSERTs sequence.
+		 * one-key continous UPSERTs sequence. The older
+		 * UPSERT could have been scheduled for squashing
+		 * after this one was prepared, in which case this
+		 * one will be merged by the same task.
 		 */
-#ifndef NDEBUG
 		older = vy_mem_older_lsn(mem, entry);
-		assert(older.stmt != NULL &&
-		       vy_stmt_type(older.stmt) == IPROTO_UPSERT &&
-		       vy_stmt_n_upserts(older.stmt) == VY_UPSERT_THRESHOLD - 1);
-#endif
-		if (lsm->env->upsert_thresh_cb == NULL) {
-			/* Squash callback is not installed. */
+		if (older.stmt != NULL &&
+		    vy_stmt_type(older.stmt) == IPROTO_UPSERT &&
+		    vy_stmt_n_upserts(older.stmt) == VY_UPSERT_INF) {
+			vy_stmt_set_n_upserts(entry.stmt, VY_UPSERT_INF);
 			return;
 		}
 
@@ -1005,6 +1237,11 @@ vy_lsm_commit_upsert(struct vy_lsm *lsm, struct vy_mem *mem,
 			lsm->env->upsert_thresh_cb(lsm, dup,
 					lsm->env->upsert_thresh_arg);
 			tuple_unref(dup.stmt);
+			/*
+			 * Mark the statement so that newer UPSERTs
+			 * for the same key don't start another task.
+			 */
+			vy_stmt_set_n_upserts(entry.stmt, VY_UPSERT_INF);
 		}
 		/*
 		 * Ignore dup == NULL, because the optimization is
@@ -1019,7 +1256,8 @@ vy_lsm_commit_upsert(struct vy_lsm *lsm, struct vy_mem *mem,
 	 */
 	if (n_upserts == 0 &&
 	    lsm->stat.memory.count.rows == lsm->mem->count.rows &&
-	    lsm->run_count == 0) {
+	    lsm->run_count == 0 &&
+	    vy_lsm_tombstone_lsn(lsm, entry.stmt, INT64_MAX) < 0) {
 		older = vy_mem_older_lsn(mem, entry);
 		assert(older.stmt == NULL ||
 		       vy_stmt_type(older.stmt) != IPROTO_UPSERT);
@@ -1102,6 +1340,225 @@ vy_lsm_rollback_stmt(struct vy_lsm *lsm, struct vy_mem *mem,
 	vy_cache_on_write(&lsm->cache, entry, NULL);
 }
 
+struct vy_tombstone *
+vy_tombstone_new(int64_t lsn, const char *begin, const char *end)
+{
+	const char *begin_end = begin;
+	mp_next(&begin_end);
+	const char *end_end = end;
+	mp_next(&end_end);
+	size_t begin_size = begin_end - begin;
+	size_t end_size = end_end - end;
+	size_t size = sizeof(struct vy_tombstone) + begin_size + end_size;
+	struct vy_tombstone *tombstone = malloc(size);
+	if (tombstone == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "struct vy_tombstone");
+		return NULL;
+	}
+	rlist_create(&tombstone->in_lsm);
+	tombstone->lsn = lsn;
+	tombstone->generation = 0;
+	tombstone->begin = (char *)(tombstone + 1);
+	memcpy(tombstone->begin, begin, begin_size);
+	tombstone->end = tombstone->begin + begin_size;
+	memcpy(tombstone->end, end, end_size);
+	return tombstone;
+}
+
+void
+vy_tombstone_delete(struct vy_tombstone *tombstone)
+{
+	assert(rlist_empty(&tombstone->in_lsm));
+	TRASH(tombstone);
+	free(tombstone);
+}
+
+void
+vy_lsm_add_tombstone(struct vy_lsm *lsm, struct vy_tombstone *tombstone)
+{
+	assert(lsm->index_id == 0);
+	assert(rlist_empty(&lsm->tombstones) ||
+	       rlist_last_entry(&lsm->tombstones, struct vy_tombstone,
+				in_lsm)->lsn < tombstone->lsn);
+	rlist_add_tail_entry(&lsm->tombstones, tombstone, in_lsm);
+	lsm->tombstone_count++;
+}
+
+void
+vy_lsm_commit_tombstone(struct vy_lsm *lsm, struct vy_tombstone *tombstone,
+			int64_t lsn)
+{
+	assert(lsm->index_id == 0);
+	assert(tombstone->lsn >= MAX_LSN);
+	assert(lsn < MAX_LSN);
+	/*
+	 * Transactions are committed in the order they were
+	 * prepared so the list remains sorted.
+	 */
+	tombstone->lsn = lsn;
+	tombstone->generation = *lsm->env->p_generation;
+	vy_log_tx_begin();
+	vy_log_insert_tombstone(lsm->id, lsn, tombstone->begin,
+				tombstone->end);
+	vy_log_tx_try_commit();
+}
+
+void
+vy_lsm_remove_tombstone(struct vy_lsm *lsm, struct vy_tombstone *tombstone)
+{
+	assert(lsm->index_id == 0);
+	assert(lsm->tombstone_count > 0);
+	rlist_del_entry(tombstone, in_lsm);
+	lsm->tombstone_count--;
+}
+
+struct vy_tombstone *
+vy_lsm_find_tombstone_by_lsn(struct vy_lsm *lsm, int64_t lsn)
+{
+	struct vy_tombstone *tombstone;
+	rlist_foreach_entry(tombstone, &lsm->tombstones, in_lsm) {
+		if (tombstone->lsn == lsn)
+			return tombstone;
+	}
+	return NULL;
+}
+
+int64_t
+vy_lsm_do_tombstone_lsn(struct vy_lsm *lsm, struct tuple *stmt,
+			int64_t vlsn)
+{
+	struct vy_lsm *pk = lsm->pk != NULL ? lsm->pk : lsm;
+	struct vy_tombstone *tombstone;
+	rlist_foreach_entry_reverse(tombstone, &pk->tombstones, in_lsm) {
+		if (tombstone->lsn > vlsn)
+			continue;
+		if (vy_stmt_pk_in_range(stmt, tombstone->begin,
+					tombstone->end, pk->cmp_def,
+					lsm->pk_in_cmp_def))
+			return tombstone->lsn;
+	}
+	return -1;
+}
+
+void
+vy_lsm_invalidate_cache(struct vy_lsm *lsm)
+{
+	assert(lsm->index_id == 0);
+	vy_cache_invalidate(&lsm->cache);
+	struct vy_lsm *secondary;
+	rlist_foreach_entry(secondary, &lsm->secondaries, in_pk)
+		vy_cache_invalidate(&secondary->cache);
+}
+
+/**
+ * Return true if the LSM tree has statements stored in
+ * in-memory trees created at or before the given generation.
+ */
+static bool
+vy_lsm_has_mem_stmts(struct vy_lsm *lsm, int64_t generation)
+{
+	if (lsm->mem->generation <= generation && lsm->mem->tree.size > 0)
+		return true;
+	struct vy_mem *mem;
+	rlist_foreach_entry(mem, &lsm->sealed, in_sealed) {
+		if (mem->generation <= generation && mem->tree.size > 0)
+			return true;
+	}
+	return false;
+}
+
+int64_t
+vy_lsm_tombstone_purge_lsn(struct vy_lsm *lsm, int64_t vlsn)
+{
+	struct vy_lsm *pk = lsm->pk != NULL ? lsm->pk : lsm;
+	int64_t purge_lsn = -1;
+	struct vy_tombstone *tombstone;
+	rlist_foreach_entry(tombstone, &pk->tombstones, in_lsm) {
+		if (tombstone->lsn >= MAX_LSN || tombstone->lsn > vlsn ||
+		    vy_lsm_has_mem_stmts(lsm, tombstone->generation))
+			break;
+		purge_lsn = tombstone->lsn;
+	}
+	return purge_lsn;
+}
+
+/**
+ * Return true if all statements deleted by a range tombstone
+ * have been purged from the given LSM tree. If @is_primary is
+ * set, only ranges intersecting the tombstone are checked.
+ */
+static bool
+vy_lsm_tombstone_is_purged(struct vy_lsm *lsm,
+			   struct vy_tombstone *tombstone, bool is_primary)
+{
+	struct vy_range *range;
+	for (range = vy_range_tree_first(&lsm->range_tree); range != NULL;
+	     range = vy_range_tree_next(&lsm->range_tree, range)) {
+		if (range->purge_lsn >= tombstone->lsn)
+			continue;
+		if (is_primary &&
+		    ((range->end.stmt != NULL &&
+		      vy_entry_compare_with_raw_key(range->end,
+						    tombstone->begin,
+						    HINT_NONE,
+						    lsm->cmp_def) < 0) ||
+		     (range->begin.stmt != NULL &&
+		      vy_entry_compare_with_raw_key(range->begin,
+						    tombstone->end,
+						    HINT_NONE,
+						    lsm->cmp_def) > 0)))
+			continue;
+		if (range->slice_count == 0 &&
+		    !vy_lsm_has_mem_stmts(lsm, tombstone->generation))
+			continue;
+		return false;
+	}
+	return true;
+}
+
+void
+vy_lsm_gc_tombstones(struct vy_lsm *lsm)
+{
+	struct vy_lsm *pk = lsm->pk != NULL ? lsm->pk : lsm;
+	if (pk->is_dropped)
+		return;
+	struct vy_lsm *secondary;
+	rlist_foreach_entry(secondary, &pk->secondaries, in_pk) {
+		/*
+		 * An index that is being built may still receive
+		 * statements read from the primary index.
+		 */
+		if (!secondary->is_dropped &&
+		    vy_lsm_is_being_constructed(secondary))
+			return;
+	}
+	struct vy_tombstone *tombstone, *next_tombstone;
+	rlist_foreach_entry_safe(tombstone, &pk->tombstones, in_lsm,
+				 next_tombstone) {
+		if (tombstone->lsn >= MAX_LSN ||
+		    !vy_lsm_tombstone_is_purged(pk, tombstone, true))
+			break;
+		bool is_purged = true;
+		rlist_foreach_entry(secondary, &pk->secondaries, in_pk) {
+			if (!secondary->is_dropped &&
+			    !vy_lsm_tombstone_is_purged(secondary, tombstone,
+							false)) {
+				is_purged = false;
+				break;
+			}
+		}
+		if (!is_purged)
+			break;
+		vy_log_tx_begin();
+		vy_log_delete_tombstone(pk->id, tombstone->lsn);
+		vy_log_tx_try_commit();
+		say_info("%s: purged range tombstone %lld",
+			 vy_lsm_name(pk), (long long)tombstone->lsn);
+		vy_lsm_remove_tombstone(pk, tombstone);
+		vy_tombstone_delete(tombstone);
+	}
+}
+
 int
 vy_lsm_find_range_intersection(struct vy_lsm *lsm,
 		const char *min_key, const char *max_key,
@@ -1179,6 +1636,7 @@ vy_lsm_split_range(struct vy_lsm *lsm, struct vy_range *range)
 				vy_range_add_slice(part, new_slice);
 		}
 		part->needs_compaction = range->needs_compaction;
+		part->purge_lsn = range->purge_lsn;
 		vy_range_update_compaction_priority(part, &lsm->opts);
 		vy_range_update_dumps_per_compaction(part);
 	}
@@ -1281,6 +1739,7 @@ vy_lsm_coalesce_range(struct vy_lsm *lsm, struct vy_range *range)
 	 * resulting range and delete the former.
 	 */
 	it = first;
+	result->purge_lsn = first->purge_lsn;
 	while (it != end) {
 		struct vy_range *next = vy_range_tree_next(&lsm->range_tree, it);
 		vy_lsm_unacct_range(lsm, it);
@@ -1290,6 +1749,7 @@ vy_lsm_coalesce_range(struct vy_lsm *lsm, struct vy_range *range)
 		vy_disk_stmt_counter_add(&result->count, &it->count);
 		if (it->needs_compaction)
 			result->needs_compaction = true;
+		result->purge_lsn = MIN(result->purge_lsn, it->purge_lsn);
 		vy_range_delete(it);
 		it = next;
 	}
@@ -1333,3 +1793,24 @@ vy_lsm_force_compaction(struct vy_lsm *lsm)
 
 	vy_range_heap_update_all(&lsm->range_heap);
 }
+
+void
+vy_lsm_check_compaction_ttl(struct vy_lsm *lsm)
+{
+	if (lsm->opts.compaction_ttl <= 0)
+		return;
+
+	struct vy_range *range;
+	struct vy_range_tree_iterator it;
+
+	vy_range_tree_ifirst(&lsm->range_tree, &it);
+	while ((range = vy_range_tree_inext(&it)) != NULL) {
+		if (vy_range_is_scheduled(range))
+			continue;
+		vy_lsm_unacct_range(lsm, range);
+		vy_range_update_compaction_priority(range, &lsm->opts);
+		vy_lsm_acct_range(lsm, range);
+	}
+
+	vy_range_heap_update_all(&lsm->range_heap);
+}
@@ -81,16 +81,28 @@ struct vy_lsm_env {
 	double too_long_threshold;
 	/**
 	 * Callback invoked when the number of upserts for
-	 * the same key exceeds VY_UPSERT_THRESHOLD.
+	 * the same key reaches upsert_squash_threshold.
 	 */
 	vy_upsert_thresh_cb upsert_thresh_cb;
 	/** Argument passed to upsert_thresh_cb. */
 	void *upsert_thresh_arg;
+	/**
+	 * Number of successive upserts for the same key that
+	 * triggers background squashing, 0 if disabled.
+	 * Never greater than VY_UPSERT_THRESHOLD.
+	 */
+	int upsert_squash_threshold;
 	/** Number of LSM trees in this environment. */
 	int lsm_count;
-	/** Size of memory used for bloom filters. */
+	/**
+	 * Size of memory used for bloom filters, not counting
+	 * partitions of partitioned runs, see vy_run_env.
+	 */
 	size_t bloom_size;
-	/** Size of memory used for page index. */
+	/**
+	 * Size of memory used for page index, not counting
+	 * partitions of partitioned runs, see vy_run_env.
+	 */
 	size_t page_index_size;
 	/**
 	 * Size of disk space used for storing data of all spaces,
@@ -139,6 +151,53 @@ vy_lsm_env_create(struct vy_lsm_env *env, const char *path,
 void
 vy_lsm_env_destroy(struct vy_lsm_env *env);
 
+/**
+ * A range tombstone deletes all statements of a space whose
+ * primary keys fall in the range [begin, end] and whose LSNs
+ * are less than the LSN of the tombstone. It is written by
+ * index.delete_range() instead of a DELETE for each key.
+ *
+ * Range tombstones are stored in the primary index LSM tree,
+ * but apply to secondary index LSM trees of the same space as
+ * well. Readers filter out statements deleted by tombstones,
+ * the write iterator replaces them with DELETEs so that they
+ * are eventually purged by compaction, after which the tombstone
+ * is deleted, see vy_lsm_gc_tombstones().
+ */
+struct vy_tombstone {
+	/** Link in vy_lsm::tombstones. */
+	struct rlist in_lsm;
+	/**
+	 * LSN of the range deletion. Set to MAX_LSN + psn
+	 * while the transaction that wrote the tombstone is
+	 * being written to WAL.
+	 */
+	int64_t lsn;
+	/**
+	 * Generation of in-memory trees that may store statements
+	 * deleted by this tombstone, see vy_lsm_tombstone_purge_lsn().
+	 */
+	int64_t generation;
+	/**
+	 * Bounds of the deleted range of primary keys, MsgPack
+	 * arrays. A partial bound matches all keys it is a prefix
+	 * of, an empty one matches any key.
+	 */
+	char *begin;
+	char *end;
+};
+
+/**
+ * Allocate a range tombstone. @begin and @end are MsgPack arrays,
+ * copied to the tombstone.
+ */
+struct vy_tombstone *
+vy_tombstone_new(int64_t lsn, const char *begin, const char *end);
+
+/** Free a range tombstone. */
+void
+vy_tombstone_delete(struct vy_tombstone *tombstone);
+
 /**
  * A struct for primary and secondary Vinyl indexes.
  * Named after the data structure used for organizing
@@ -224,6 +283,21 @@ struct vy_lsm {
 	 * by each secondary index.
 	 */
 	struct vy_lsm *pk;
+	/**
+	 * List of secondary index LSM trees referencing this
+	 * primary index LSM tree, linked by vy_lsm::in_pk.
+	 */
+	struct rlist secondaries;
+	/** Link in vy_lsm::secondaries of the primary index. */
+	struct rlist in_pk;
+	/**
+	 * List of range tombstones of the space, linked by
+	 * vy_tombstone::in_lsm, sorted by LSN in ascending order.
+	 * Only used by a primary index LSM tree.
+	 */
+	struct rlist tombstones;
+	/** Number of tombstones in the list. */
+	int tombstone_count;
 	/** LSM tree statistics. */
 	struct vy_lsm_stat stat;
 	/**
@@ -255,6 +329,15 @@ struct vy_lsm {
 	 * linked by vy_run->in_lsm.
 	 */
 	struct rlist runs;
+	/**
+	 * List of runs that were compacted, but can't be deleted
+	 * yet, because their blob files are still referenced by
+	 * other runs (see vy_run::blob_refs). They don't belong
+	 * to any range and aren't accounted in LSM tree stats.
+	 * Each of them is referenced by the LSM tree. Linked by
+	 * vy_run->in_lsm.
+	 */
+	struct rlist blob_runs;
 	/** Number of entries in all ranges. */
 	int run_count;
 	/**
@@ -301,6 +384,15 @@ struct vy_lsm {
 	int pin_count;
 	/** Set if the LSM tree is currently being dumped. */
 	bool is_dumping;
+	/**
+	 * Set while runs of a new secondary index are written
+	 * from the primary index runs in worker threads, see
+	 * vy_scheduler_build_lsm(). Until they are added to the
+	 * LSM tree, it isn't compacted and its dumps aren't
+	 * considered the last level, because it lacks older
+	 * statements.
+	 */
+	bool is_bulk_loading;
 	/** Link in vy_scheduler->dump_heap. */
 	struct heap_node in_dump;
 	/** Link in vy_scheduler->compaction_heap. */
@@ -361,6 +453,16 @@ vy_lsm_is_empty(struct vy_lsm *lsm)
 		lsm->stat.memory.count.rows == 0);
 }
 
+/**
+ * Return true if this is a secondary LSM tree that stores
+ * covered fields along with the key, see index_opts::covers.
+ */
+static inline bool
+vy_lsm_is_covering(struct vy_lsm *lsm)
+{
+	return lsm->opts.covers != 0;
+}
+
 /**
  * Return true if LSM tree is currently being built
  * (i.e. index_commit_create() hasn't been called yet).
@@ -415,11 +517,86 @@ vy_lsm_update_pk(struct vy_lsm *lsm, struct vy_lsm *pk)
 		assert(lsm->pk == NULL);
 		return;
 	}
+	rlist_del_entry(lsm, in_pk);
+	rlist_add_tail_entry(&pk->secondaries, lsm, in_pk);
 	vy_lsm_unref(lsm->pk);
 	vy_lsm_ref(pk);
 	lsm->pk = pk;
 }
 
+/**
+ * Add a range tombstone to a primary index LSM tree.
+ * The tombstone must be newer than all tombstones of
+ * the LSM tree.
+ */
+void
+vy_lsm_add_tombstone(struct vy_lsm *lsm, struct vy_tombstone *tombstone);
+
+/**
+ * Commit a range tombstone added to a primary index LSM tree
+ * on transaction prepare: assign the final LSN to it and write
+ * it to the metadata log.
+ */
+void
+vy_lsm_commit_tombstone(struct vy_lsm *lsm, struct vy_tombstone *tombstone,
+			int64_t lsn);
+
+/** Remove a range tombstone from a primary index LSM tree. */
+void
+vy_lsm_remove_tombstone(struct vy_lsm *lsm, struct vy_tombstone *tombstone);
+
+/**
+ * Look up a range tombstone of a primary index LSM tree by LSN.
+ * Return NULL if not found.
+ */
+struct vy_tombstone *
+vy_lsm_find_tombstone_by_lsn(struct vy_lsm *lsm, int64_t lsn);
+
+/** @sa vy_lsm_tombstone_lsn(). */
+int64_t
+vy_lsm_do_tombstone_lsn(struct vy_lsm *lsm, struct tuple *stmt,
+			int64_t vlsn);
+
+/**
+ * Return the LSN of the newest range tombstone visible from
+ * the read view @vlsn that deletes the key of the given statement
+ * of the LSM tree or -1 if there is no such tombstone. Statements
+ * of the key older than the returned LSN must be ignored.
+ */
+static inline int64_t
+vy_lsm_tombstone_lsn(struct vy_lsm *lsm, struct tuple *stmt, int64_t vlsn)
+{
+	struct vy_lsm *pk = lsm->pk != NULL ? lsm->pk : lsm;
+	if (likely(pk->tombstone_count == 0))
+		return -1;
+	return vy_lsm_do_tombstone_lsn(lsm, stmt, vlsn);
+}
+
+/**
+ * Drop all statements cached by the primary index LSM tree
+ * and its secondary index LSM trees. Called on range deletion.
+ */
+void
+vy_lsm_invalidate_cache(struct vy_lsm *lsm);
+
+/**
+ * Return the max LSN of range tombstones whose statements will be
+ * purged from a range of the LSM tree by major compaction started
+ * now or -1 if there are no such tombstones. A tombstone can be
+ * purged if all statements it deletes are stored on disk and it
+ * is visible from the oldest read view @vlsn.
+ */
+int64_t
+vy_lsm_tombstone_purge_lsn(struct vy_lsm *lsm, int64_t vlsn);
+
+/**
+ * Delete range tombstones of the space whose statements have been
+ * purged by compaction from all ranges of the primary and secondary
+ * index LSM trees, see vy_range::purge_lsn.
+ */
+void
+vy_lsm_gc_tombstones(struct vy_lsm *lsm);
+
 /**
  * Create a new LSM tree.
  *
@@ -478,6 +655,38 @@ vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run);
 void
 vy_lsm_remove_run(struct vy_lsm *lsm, struct vy_run *run);
 
+/**
+ * Look up runs whose blob files are referenced by the given run
+ * among runs of an LSM tree, reference them and store them in
+ * vy_run::blob_runs. Must be called before the run is added to
+ * the LSM tree. Returns -1 and sets diag on error.
+ */
+int
+vy_lsm_ref_blobs(struct vy_lsm *lsm, struct vy_run *run);
+
+/**
+ * Release blob files referenced by a run that was removed from
+ * an LSM tree. Blob runs that are not referenced any more are
+ * deleted by vy_lsm_gc_blob_runs().
+ */
+void
+vy_lsm_unref_blobs(struct vy_lsm *lsm, struct vy_run *run);
+
+/**
+ * Keep a compacted run in an LSM tree, because its blob file is
+ * still referenced by other runs, see vy_lsm::blob_runs. The run
+ * must have been removed from the LSM tree.
+ */
+void
+vy_lsm_add_blob_run(struct vy_lsm *lsm, struct vy_run *run);
+
+/**
+ * Delete runs kept for their blob files (see vy_lsm::blob_runs)
+ * that are not referenced any more.
+ */
+void
+vy_lsm_gc_blob_runs(struct vy_lsm *lsm);
+
 /**
  * Add a range to both the range tree and the range heap
  * of an LSM tree.
@@ -590,6 +799,15 @@ vy_lsm_coalesce_range(struct vy_lsm *lsm, struct vy_range *range);
 void
 vy_lsm_force_compaction(struct vy_lsm *lsm);
 
+/**
+ * Recompute compaction priorities of all ranges of an LSM tree
+ * so that ranges whose oldest run has outlived compaction_ttl
+ * get scheduled for major compaction. No-op if compaction_ttl
+ * is unset.
+ */
+void
+vy_lsm_check_compaction_ttl(struct vy_lsm *lsm);
+
 /**
  * Insert a statement into the in-memory index of an LSM tree. If
  * the region_stmt is NULL and the statement is successfully inserted
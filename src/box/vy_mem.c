@@ -201,13 +201,12 @@ vy_mem_insert_upsert(struct vy_mem *mem, struct vy_entry entry)
 		return 0;
 	uint8_t n_upserts = vy_stmt_n_upserts(older->stmt);
 	/*
-	 * Stop increment if the threshold is reached to avoid
-	 * creation of multiple squashing tasks.
+	 * Saturate the counter at the max threshold. If the older
+	 * statement is already being squashed (VY_UPSERT_INF), keep
+	 * the mark to avoid creation of multiple squashing tasks.
 	 */
-	if (n_upserts <= VY_UPSERT_THRESHOLD)
+	if (n_upserts < VY_UPSERT_THRESHOLD)
 		n_upserts++;
-	else
-		assert(n_upserts == VY_UPSERT_INF);
 	vy_stmt_set_n_upserts(entry.stmt, n_upserts);
 	return 0;
 }
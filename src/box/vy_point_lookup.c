@@ -282,6 +282,12 @@ done:
 	vy_history_splice(&history, &mem_history);
 	vy_history_splice(&history, &disk_history);
 
+	if (rc == 0) {
+		int64_t tombstone_lsn = vy_lsm_tombstone_lsn(lsm, key.stmt,
+							     (*rv)->vlsn);
+		if (tombstone_lsn >= 0)
+			vy_history_cut(&history, tombstone_lsn);
+	}
 	if (rc == 0) {
 		int upserts_applied;
 		rc = vy_history_apply(&history, lsm->cmp_def,
@@ -318,6 +324,21 @@ vy_point_lookup_mem(struct vy_lsm *lsm, const struct vy_read_view **rv,
 	goto out;
 done:
 	if (rc == 0) {
+		int64_t tombstone_lsn = vy_lsm_tombstone_lsn(lsm, key.stmt,
+							     (*rv)->vlsn);
+		if (tombstone_lsn >= 0) {
+			vy_history_cut(&history, tombstone_lsn);
+			if (rlist_empty(&history.stmts)) {
+				/*
+				 * Everything found in memory was
+				 * deleted by a range tombstone.
+				 * Pretend nothing was found so that
+				 * the caller falls back on disk.
+				 */
+				*ret = vy_entry_none();
+				goto out;
+			}
+		}
 		int upserts_applied;
 		rc = vy_history_apply(&history, lsm->cmp_def,
 				      true, &upserts_applied, ret);
@@ -227,6 +227,7 @@ vy_quota_create(struct vy_quota *q, size_t limit,
 	q->limit = limit;
 	q->used = 0;
 	q->too_long_threshold = TIMEOUT_INFINITY;
+	q->tx_wait_time_max = 0;
 	q->quota_exceeded_cb = quota_exceeded_cb;
 	q->wait_ticket = 0;
 	for (int i = 0; i < vy_quota_consumer_type_MAX; i++)
@@ -334,12 +335,15 @@ vy_quota_use(struct vy_quota *q, enum vy_quota_consumer_type type,
 	bool timed_out = fiber_yield_timeout(timeout);
 	rlist_del_entry(&wait_node, in_wait_queue);
 
+	double wait_time = ev_monotonic_now(loop()) - wait_start;
+	if (type == VY_QUOTA_CONSUMER_TX)
+		q->tx_wait_time_max = MAX(q->tx_wait_time_max, wait_time);
+
 	if (timed_out) {
 		diag_set(ClientError, ER_VY_QUOTA_TIMEOUT);
 		return -1;
 	}
 
-	double wait_time = ev_monotonic_now(loop()) - wait_start;
 	if (wait_time > q->too_long_threshold) {
 		say_warn_ratelimited("waited for %zu bytes of vinyl memory "
 				     "quota for too long: %.3f sec", size,
@@ -189,6 +189,11 @@ struct vy_quota {
 	 * value, warn about it in the log.
 	 */
 	double too_long_threshold;
+	/**
+	 * Max time a transaction waited for quota. Reset by
+	 * the regulator, which uses it for tracking stalls.
+	 */
+	double tx_wait_time_max;
 	/**
 	 * Called if the limit is hit when quota is consumed.
 	 * It is supposed to trigger memory reclaim.
@@ -42,6 +42,7 @@
 #include <small/rlist.h>
 
 #include "diag.h"
+#include "fiber.h"
 #include "iterator_type.h"
 #include "key_def.h"
 #include "trivia/util.h"
@@ -192,6 +193,7 @@ vy_range_new(int64_t id, struct vy_entry begin, struct vy_entry end,
 	if (end.stmt != NULL)
 		tuple_ref(end.stmt);
 	range->cmp_def = cmp_def;
+	range->purge_lsn = -1;
 	rlist_create(&range->slices);
 	heap_node_create(&range->heap_node);
 	return range;
@@ -280,6 +282,19 @@ vy_range_remove_slice(struct vy_range *range, struct vy_slice *slice)
  * compaction is relatively cheap, because of the level size
  * ratio.
  *
+ * With the tiered compaction strategy (INDEX_COMPACTION_TIERED) levels
+ * are computed the same way, but a level is never merged into the next
+ * one in advance to avoid a cascading compaction and the last level may
+ * store up to run_count_per_level runs. This way each statement is
+ * rewritten once per level rather than up to run_count_per_level times,
+ * which reduces write amplification at the cost of more runs to look up
+ * on read and higher space amplification.
+ *
+ * Besides, if compaction_ttl is set and the oldest run of the range was
+ * created more than compaction_ttl seconds ago, the range is scheduled
+ * for major compaction so that deleted and overwritten statements do not
+ * linger on disk forever in a range that receives no writes.
+ *
  * Given a range, this function computes the maximal level that needs
  * to be compacted and sets @compaction_priority to the number of runs
  * in this level and all preceding levels.
@@ -306,6 +321,18 @@ vy_range_update_compaction_priority(struct vy_range *range,
 		return;
 	}
 
+	struct vy_slice *oldest_slice = rlist_last_entry(&range->slices,
+						struct vy_slice, in_range);
+	if (opts->compaction_ttl > 0 &&
+	    oldest_slice->run->create_time + opts->compaction_ttl <=
+	    fiber_time()) {
+		/* The oldest run has expired, rewrite the range. */
+		range->compaction_priority = range->slice_count;
+		range->compaction_queue = range->count;
+		return;
+	}
+	bool is_tiered = opts->compaction_strategy == INDEX_COMPACTION_TIERED;
+
 	/* Total number of statements in checked runs. */
 	struct vy_disk_stmt_counter total_stmt_count;
 	vy_disk_stmt_counter_reset(&total_stmt_count);
@@ -342,8 +369,7 @@ vy_range_update_compaction_priority(struct vy_range *range,
 
 	uint64_t size;
 	struct vy_slice *slice;
-	slice = rlist_last_entry(&range->slices, struct vy_slice, in_range);
-	size = MAX(slice->count.bytes, 1);
+	size = MAX(oldest_slice->count.bytes, 1);
 	slice = rlist_first_entry(&range->slices, struct vy_slice, in_range);
 	do {
 		target_run_size = size;
@@ -370,9 +396,11 @@ vy_range_update_compaction_priority(struct vy_range *range,
 			 * estimated compacted run will end up at
 			 * this level, include the new run into
 			 * this level right away to avoid
-			 * a cascading compaction.
+			 * a cascading compaction. Tiered compaction
+			 * never does that, because it would rewrite
+			 * the lower level before it is full.
 			 */
-			if (est_new_run_size > target_run_size)
+			if (!is_tiered && est_new_run_size > target_run_size)
 				level_run_count++;
 			/*
 			 * Calculate the target run size for this
@@ -415,10 +443,13 @@ vy_range_update_compaction_priority(struct vy_range *range,
 		}
 	}
 
-	if (level_run_count > 1) {
+	if (!is_tiered && level_run_count > 1) {
 		/*
 		 * Do not store more than one run at the last level
-		 * to keep space amplification low.
+		 * to keep space amplification low. Tiered compaction
+		 * trades space amplification for write amplification
+		 * and lets the last level grow up to the configured
+		 * number of runs.
 		 */
 		range->compaction_priority = total_run_count;
 		range->compaction_queue = total_stmt_count;
@@ -469,17 +500,13 @@ vy_range_needs_split(struct vy_range *range, int64_t range_size,
 		return false;
 
 	/* Find the median key in the oldest run (approximately). */
-	struct vy_page_info *mid_page;
-	mid_page = vy_run_page_info(slice->run, slice->first_page_no +
-				    (slice->last_page_no -
-				     slice->first_page_no) / 2);
-
-	struct vy_page_info *first_page = vy_run_page_info(slice->run,
-						slice->first_page_no);
+	hint_t mid_key_hint, first_key_hint;
+	const char *mid_key = vy_slice_mid_page_key(slice, &mid_key_hint);
+	const char *first_key = vy_slice_first_page_key(slice,
+							&first_key_hint);
 
 	/* No point in splitting if a new range is going to be empty. */
-	if (key_compare(first_page->min_key, first_page->min_key_hint,
-			mid_page->min_key, mid_page->min_key_hint,
+	if (key_compare(first_key, first_key_hint, mid_key, mid_key_hint,
 			range->cmp_def) == 0)
 		return false;
 	/*
@@ -494,24 +521,22 @@ vy_range_needs_split(struct vy_range *range, int64_t range_size,
 	 * begin = [30], end = [70]
 	 * first_page_no = N, last_page_no = N + 1
 	 *
-	 * which makes mid_page_no = N and mid_page->min_key = [10].
+	 * which makes mid_page_no = N and the median key = [10].
 	 *
 	 * In such cases there's no point in splitting the range.
 	 */
 	if (slice->begin.stmt != NULL &&
-	    vy_entry_compare_with_raw_key(slice->begin, mid_page->min_key,
-					  mid_page->min_key_hint,
-					  range->cmp_def) >= 0)
+	    vy_entry_compare_with_raw_key(slice->begin, mid_key,
+					  mid_key_hint, range->cmp_def) >= 0)
 		return false;
 	/*
 	 * The median key can't be >= the end of the slice as we
 	 * take the min key of a page for the median key.
 	 */
 	assert(slice->end.stmt == NULL ||
-	       vy_entry_compare_with_raw_key(slice->end, mid_page->min_key,
-					     mid_page->min_key_hint,
-					     range->cmp_def) > 0);
-	*p_split_key = mid_page->min_key;
+	       vy_entry_compare_with_raw_key(slice->end, mid_key,
+					     mid_key_hint, range->cmp_def) > 0);
+	*p_split_key = mid_key;
 	return true;
 }
 
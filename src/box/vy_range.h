@@ -119,6 +119,12 @@ struct vy_range {
 	bool needs_compaction;
 	/** Number of times the range was compacted. */
 	int n_compactions;
+	/**
+	 * Max LSN of range tombstones whose statements have been
+	 * purged from this range by major compaction or -1, see
+	 * vy_lsm_gc_tombstones().
+	 */
+	int64_t purge_lsn;
 	/**
 	 * Number of dumps it takes to trigger major compaction in
 	 * this range, see vy_run::dump_count for more details.
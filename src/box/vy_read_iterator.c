@@ -164,6 +164,41 @@ vy_read_iterator_range_is_done(struct vy_read_iterator *itr,
 	return false;
 }
 
+/**
+ * Return true if the only source that may store statements
+ * for the current range is its run slice, i.e. the range has
+ * exactly one slice while the transaction write set, in-memory
+ * trees and the cache are empty for it.
+ */
+static bool
+vy_read_iterator_can_use_single_src(struct vy_read_iterator *itr)
+{
+	struct vy_lsm *lsm = itr->lsm;
+	struct vy_range *range = itr->curr_range;
+	return range->slice_count == 1 &&
+	       (itr->tx == NULL || write_set_empty(&itr->tx->write_set)) &&
+	       rlist_empty(&lsm->sealed) &&
+	       vy_mem_tree_size(&lsm->mem->tree) == 0 &&
+	       !vy_cache_has_interval(&lsm->cache, range->begin, range->end);
+}
+
+/**
+ * Check if the single source mode chosen by the last call to
+ * vy_read_iterator_restore() is still valid, i.e. no statements
+ * have been written to the transaction write set or the active
+ * in-memory tree since then. Changes of the range tree and the
+ * list of in-memory trees are detected with version counters.
+ * The cache is not rechecked, because skipping it doesn't affect
+ * the iterator output.
+ */
+static bool
+vy_read_iterator_single_src_is_valid(struct vy_read_iterator *itr)
+{
+	assert(itr->is_single_src);
+	return (itr->tx == NULL || write_set_empty(&itr->tx->write_set)) &&
+	       vy_mem_tree_size(&itr->lsm->mem->tree) == 0;
+}
+
 /**
  * Compare two tuples from the read iterator perspective.
  *
@@ -408,19 +443,29 @@ vy_read_iterator_advance(struct vy_read_iterator *itr)
 	if (itr->last.stmt == NULL ||
 	    itr->mem_list_version != itr->lsm->mem_list_version ||
 	    itr->range_tree_version != itr->lsm->range_tree_version ||
-	    itr->range_version != itr->curr_range->version) {
+	    itr->range_version != itr->curr_range->version ||
+	    (itr->is_single_src &&
+	     !vy_read_iterator_single_src_is_valid(itr))) {
 		vy_read_iterator_restore(itr);
 	}
 restart:
 	itr->prev_front_id = itr->front_id;
 	itr->front_id++;
 
+	bool stop = false;
+	struct vy_entry next = vy_entry_none();
+	if (itr->is_single_src) {
+		/*
+		 * Nothing to merge: all statements of the current
+		 * range are stored in a single run slice, so read
+		 * the next key directly from it.
+		 */
+		goto rescan_disk;
+	}
 	/*
 	 * Look up the next key in read sources starting
 	 * from the one that stores newest data.
 	 */
-	bool stop = false;
-	struct vy_entry next = vy_entry_none();
 	if (vy_read_iterator_scan_txw(itr, &next, &stop) != 0)
 		return -1;
 	if (stop)
@@ -478,7 +523,9 @@ rescan_disk:
 	 * source to check is the active in-memory tree.
 	 */
 	struct vy_mem_iterator *mem_itr = &itr->src[itr->mem_src].mem_iterator;
-	if (mem_itr->version != mem_itr->mem->version) {
+	if (itr->is_single_src ?
+	    !vy_read_iterator_single_src_is_valid(itr) :
+	    mem_itr->version != mem_itr->mem->version) {
 		vy_read_iterator_restore(itr);
 		goto restart;
 	}
@@ -583,6 +630,8 @@ vy_read_iterator_add_disk(struct vy_read_iterator *itr)
 				     iterator_type, itr->key,
 				     itr->read_view, lsm->cmp_def,
 				     lsm->key_def, lsm->disk_format);
+		vy_run_iterator_set_readahead(&sub_src->run_iterator,
+					      lsm->opts.readahead_pages);
 	}
 }
 
@@ -700,6 +749,8 @@ vy_read_iterator_restore(struct vy_read_iterator *itr)
 
 	itr->disk_src = itr->src_count;
 	vy_read_iterator_add_disk(itr);
+
+	itr->is_single_src = vy_read_iterator_can_use_single_src(itr);
 }
 
 /**
@@ -744,6 +795,14 @@ vy_read_iterator_next_range(struct vy_read_iterator *itr)
 	itr->src_count = itr->disk_src;
 
 	vy_read_iterator_add_disk(itr);
+	/*
+	 * The sources other than disk are empty in the single
+	 * source mode and haven't been started, so we may switch
+	 * to the merge without restoring them. Switching in the
+	 * opposite direction requires a restore though.
+	 */
+	if (itr->is_single_src)
+		itr->is_single_src = vy_read_iterator_can_use_single_src(itr);
 }
 
 /**
@@ -767,6 +826,33 @@ vy_read_iterator_apply_history(struct vy_read_iterator *itr,
 		}
 	}
 
+	struct vy_entry last = vy_history_last_stmt(&history);
+	int64_t tombstone_lsn = -1;
+	if (last.stmt != NULL) {
+		tombstone_lsn = vy_lsm_tombstone_lsn(lsm, last.stmt,
+						     (**itr->read_view).vlsn);
+	}
+	if (tombstone_lsn >= 0 &&
+	    vy_stmt_lsn(last.stmt) < tombstone_lsn) {
+		/*
+		 * All statements of the key were deleted by a range
+		 * tombstone. Return a DELETE so that the caller skips
+		 * the key but still can position after it.
+		 */
+		struct tuple *stmt = vy_stmt_dup(last.stmt);
+		vy_history_cleanup(&history);
+		if (stmt == NULL)
+			return -1;
+		vy_stmt_set_type(stmt, IPROTO_DELETE);
+		vy_stmt_set_lsn(stmt, tombstone_lsn);
+		vy_stmt_set_flags(stmt, 0);
+		ret->stmt = stmt;
+		ret->hint = last.hint;
+		return 0;
+	}
+	if (tombstone_lsn >= 0)
+		vy_history_cut(&history, tombstone_lsn);
+
 	int upserts_applied = 0;
 	int rc = vy_history_apply(&history, lsm->cmp_def,
 				  true, &upserts_applied, ret);
@@ -87,6 +87,14 @@ struct vy_read_iterator {
 	uint32_t range_version;
 	/** Range the iterator is currently positioned at. */
 	struct vy_range *curr_range;
+	/**
+	 * Set if the current range has a single run slice while
+	 * the transaction write set, in-memory trees and the cache
+	 * don't store any statements for it. In this case the
+	 * merge is skipped and statements are read directly from
+	 * the run iterator.
+	 */
+	bool is_single_src;
 	/**
 	 * Array of merge sources. Sources are sorted by age.
 	 * In particular, this means that all mutable sources
@@ -83,6 +83,36 @@ static const size_t VY_DUMP_SIZE_ACCT_MIN = 1024 * 1024;
  */
 static const int VY_RECENT_DUMP_COUNT = 100;
 
+/**
+ * Default factor the max observed write rate is multiplied by
+ * when calculating the dump watermark, see vy_regulator::dump_margin.
+ */
+static const double VY_DUMP_MARGIN_DEFAULT = 1.5;
+
+/** Max value of vy_regulator::dump_margin. */
+static const double VY_DUMP_MARGIN_MAX = 4;
+
+/** Min value of vy_regulator::rate_limit_scale. */
+static const double VY_RATE_LIMIT_SCALE_MIN = 0.1;
+
+/** Max value of vy_regulator::rate_limit_scale. */
+static const double VY_RATE_LIMIT_SCALE_MAX = 2;
+
+/**
+ * Factor the regulator multiplies or divides the dump margin
+ * and the rate limit scale by on each timer tick when a limit
+ * set by box.cfg.vinyl_max_write_stall or vinyl_max_compaction_debt
+ * is exceeded.
+ */
+static const double VY_SLO_ADJUST_FACTOR = 1.25;
+
+/**
+ * Share of the difference between the current and the default
+ * value of the dump margin or the rate limit scale recovered
+ * on each timer tick once the limits are met again.
+ */
+static const double VY_SLO_RECOVER_PCT = 10;
+
 static void
 vy_regulator_trigger_dump(struct vy_regulator *regulator)
 {
@@ -171,12 +201,13 @@ vy_regulator_update_dump_watermark(struct vy_regulator *regulator)
 	 *       write_rate      dump_bandwidth
 	 *
 	 * Be pessimistic when predicting the write rate - use the
-	 * max observed write rate multiplied by 1.5 - because it's
-	 * better to start memory dump early than delay it as long
-	 * as possible at the risk of experiencing unpredictably
-	 * long stalls.
+	 * max observed write rate multiplied by the dump margin,
+	 * which is 1.5 unless transactions stall for too long -
+	 * because it's better to start memory dump early than delay
+	 * it as long as possible at the risk of experiencing
+	 * unpredictably long stalls.
 	 */
-	size_t write_rate = regulator->write_rate_max * 3 / 2;
+	size_t write_rate = regulator->write_rate_max * regulator->dump_margin;
 	regulator->dump_watermark =
 			(double)quota->limit * regulator->dump_bandwidth /
 			(regulator->dump_bandwidth + write_rate + 1);
@@ -189,6 +220,101 @@ vy_regulator_update_dump_watermark(struct vy_regulator *regulator)
 					quota->limit / 2);
 }
 
+/**
+ * Set the disk-based rate limit to the value that lets compaction
+ * keep up with dumps scaled by vy_regulator::rate_limit_scale.
+ */
+static void
+vy_regulator_apply_rate_limit(struct vy_regulator *regulator)
+{
+	double rate = (double)regulator->disk_rate_limit *
+		      regulator->rate_limit_scale;
+	/*
+	 * We can't simply use (size_t)MIN(rate, SIZE_MAX) to cast
+	 * the rate from double to size_t here, because on a 64-bit
+	 * system SIZE_MAX equals 2^64-1, which can't be represented
+	 * as double without loss of precision and hence is rounded
+	 * up to 2^64, which in turn can't be converted back to size_t.
+	 * So we first convert the rate to uint64_t using exp2(64) to
+	 * check if it fits and only then cast the uint64_t to size_t.
+	 */
+	uint64_t rate64;
+	if (rate < exp2(64))
+		rate64 = rate;
+	else
+		rate64 = UINT64_MAX;
+	vy_quota_set_rate_limit(regulator->quota, VY_QUOTA_RESOURCE_DISK,
+				(size_t)MIN(rate64, SIZE_MAX));
+}
+
+/**
+ * Move the given value towards the target by VY_SLO_RECOVER_PCT
+ * percent of the difference between them. Snap to the target
+ * once the difference becomes negligible.
+ */
+static inline double
+vy_regulator_recover(double value, double target)
+{
+	double diff = (target - value) * VY_SLO_RECOVER_PCT / 100;
+	if (fabs(diff) < 0.001)
+		return target;
+	return value + diff;
+}
+
+/**
+ * Adjust the dump watermark and the disk-based rate limit so as
+ * to keep write stalls and compaction debt within the limits set
+ * by box.cfg.vinyl_max_write_stall and vinyl_max_compaction_debt.
+ *
+ * Transactions stall when they hit the memory limit before dump
+ * completes or when they are throttled. In the former case, we
+ * need to start dump earlier so we raise the dump margin, which
+ * lowers the watermark. In the latter case, we relax the rate
+ * limit that lets compaction keep up with dumps, but only if the
+ * compaction debt is within the limit. If the debt is too high,
+ * we tighten the rate limit to give compaction more disk bandwidth
+ * at the cost of longer stalls. Once both limits are met, the dump
+ * margin and the rate limit scale gradually return to the defaults.
+ */
+static void
+vy_regulator_update_slo(struct vy_regulator *regulator)
+{
+	struct vy_quota *quota = regulator->quota;
+	regulator->write_stall = quota->tx_wait_time_max;
+	quota->tx_wait_time_max = 0;
+	regulator->compaction_debt = regulator->compaction_debt_cb(regulator);
+
+	bool stall_exceeded = regulator->max_write_stall > 0 &&
+			regulator->write_stall > regulator->max_write_stall;
+	bool debt_exceeded = regulator->max_compaction_debt > 0 &&
+			regulator->compaction_debt >
+			regulator->max_compaction_debt;
+
+	if (stall_exceeded) {
+		regulator->dump_margin = MIN(regulator->dump_margin *
+					     VY_SLO_ADJUST_FACTOR,
+					     VY_DUMP_MARGIN_MAX);
+	} else {
+		regulator->dump_margin = vy_regulator_recover(
+			regulator->dump_margin, VY_DUMP_MARGIN_DEFAULT);
+	}
+
+	double scale = regulator->rate_limit_scale;
+	if (debt_exceeded) {
+		scale = MAX(scale / VY_SLO_ADJUST_FACTOR,
+			    VY_RATE_LIMIT_SCALE_MIN);
+	} else if (stall_exceeded) {
+		scale = MIN(scale * VY_SLO_ADJUST_FACTOR,
+			    VY_RATE_LIMIT_SCALE_MAX);
+	} else {
+		scale = vy_regulator_recover(scale, 1);
+	}
+	if (scale != regulator->rate_limit_scale) {
+		regulator->rate_limit_scale = scale;
+		vy_regulator_apply_rate_limit(regulator);
+	}
+}
+
 static void
 vy_regulator_timer_cb(ev_loop *loop, ev_timer *timer, int events)
 {
@@ -198,13 +324,15 @@ vy_regulator_timer_cb(ev_loop *loop, ev_timer *timer, int events)
 	struct vy_regulator *regulator = timer->data;
 
 	vy_regulator_update_write_rate(regulator);
+	vy_regulator_update_slo(regulator);
 	vy_regulator_update_dump_watermark(regulator);
 	vy_regulator_check_dump_watermark(regulator);
 }
 
 void
 vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
-		    vy_trigger_dump_f trigger_dump_cb)
+		    vy_trigger_dump_f trigger_dump_cb,
+		    vy_compaction_debt_f compaction_debt_cb)
 {
 	enum { KB = 1024, MB = KB * KB };
 	static int64_t dump_bandwidth_buckets[] = {
@@ -225,11 +353,15 @@ vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
 
 	regulator->quota = quota;
 	regulator->trigger_dump_cb = trigger_dump_cb;
+	regulator->compaction_debt_cb = compaction_debt_cb;
 	ev_timer_init(&regulator->timer, vy_regulator_timer_cb, 0,
 		      VY_REGULATOR_TIMER_PERIOD);
 	regulator->timer.data = regulator;
 	regulator->dump_bandwidth = VY_DUMP_BANDWIDTH_DEFAULT;
 	regulator->dump_watermark = SIZE_MAX;
+	regulator->disk_rate_limit = SIZE_MAX;
+	regulator->dump_margin = VY_DUMP_MARGIN_DEFAULT;
+	regulator->rate_limit_scale = 1;
 }
 
 void
@@ -305,6 +437,20 @@ vy_regulator_set_memory_limit(struct vy_regulator *regulator, size_t limit)
 	vy_regulator_update_dump_watermark(regulator);
 }
 
+void
+vy_regulator_set_max_write_stall(struct vy_regulator *regulator,
+				 double max_write_stall)
+{
+	regulator->max_write_stall = max_write_stall;
+}
+
+void
+vy_regulator_set_max_compaction_debt(struct vy_regulator *regulator,
+				     size_t max_compaction_debt)
+{
+	regulator->max_compaction_debt = max_compaction_debt;
+}
+
 void
 vy_regulator_reset_dump_bandwidth(struct vy_regulator *regulator, size_t max)
 {
@@ -431,22 +577,9 @@ vy_regulator_update_rate_limit(struct vy_regulator *regulator,
 
 	double rate = 0.75 * compaction_threads * recent->dump_input /
 						  recent->compaction_time;
-	/*
-	 * We can't simply use (size_t)MIN(rate, SIZE_MAX) to cast
-	 * the rate from double to size_t here, because on a 64-bit
-	 * system SIZE_MAX equals 2^64-1, which can't be represented
-	 * as double without loss of precision and hence is rounded
-	 * up to 2^64, which in turn can't be converted back to size_t.
-	 * So we first convert the rate to uint64_t using exp2(64) to
-	 * check if it fits and only then cast the uint64_t to size_t.
-	 */
-	uint64_t rate64;
-	if (rate < exp2(64))
-		rate64 = rate;
-	else
-		rate64 = UINT64_MAX;
-	vy_quota_set_rate_limit(regulator->quota, VY_QUOTA_RESOURCE_DISK,
-				(size_t)MIN(rate64, SIZE_MAX));
+	regulator->disk_rate_limit = rate < (double)SIZE_MAX ?
+				     (size_t)rate : SIZE_MAX;
+	vy_regulator_apply_rate_limit(regulator);
 
 	/*
 	 * Periodically rotate statistics for quicker adaptation
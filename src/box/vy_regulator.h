@@ -48,6 +48,9 @@ struct vy_regulator;
 typedef int
 (*vy_trigger_dump_f)(struct vy_regulator *regulator);
 
+typedef size_t
+(*vy_compaction_debt_f)(struct vy_regulator *regulator);
+
 /**
  * The regulator is supposed to keep track of vinyl memory usage
  * and dump/compaction progress and adjust transaction write rate
@@ -65,6 +68,11 @@ struct vy_regulator {
 	 * memory dump and return 0 on success, -1 on failure.
 	 */
 	vy_trigger_dump_f trigger_dump_cb;
+	/**
+	 * Called by the timer to get the amount of data awaiting
+	 * compaction, in bytes.
+	 */
+	vy_compaction_debt_f compaction_debt_cb;
 	/**
 	 * Periodic timer that updates the memory watermark
 	 * basing on accumulated statistics.
@@ -124,11 +132,52 @@ struct vy_regulator {
 	 * Used for calculating the rate limit.
 	 */
 	struct vy_scheduler_stat sched_stat_recent;
+	/**
+	 * Disk-based rate limit that lets compaction keep up with
+	 * dumps, as calculated by vy_regulator_update_rate_limit(),
+	 * before applying @rate_limit_scale.
+	 */
+	size_t disk_rate_limit;
+	/**
+	 * Max time a transaction may wait for quota, in seconds,
+	 * see box.cfg.vinyl_max_write_stall. 0 if not set.
+	 */
+	double max_write_stall;
+	/**
+	 * Max amount of data awaiting compaction, in bytes, see
+	 * box.cfg.vinyl_max_compaction_debt. 0 if not set.
+	 */
+	size_t max_compaction_debt;
+	/**
+	 * Max time a transaction waited for quota over the last
+	 * timer period, in seconds.
+	 */
+	double write_stall;
+	/**
+	 * Amount of data awaiting compaction observed by the timer
+	 * last time, in bytes.
+	 */
+	size_t compaction_debt;
+	/**
+	 * Factor the max observed write rate is multiplied by when
+	 * predicting the write rate for calculating the watermark.
+	 * Raised if transactions stall for longer than allowed by
+	 * @max_write_stall so that memory dump starts earlier.
+	 */
+	double dump_margin;
+	/**
+	 * Factor applied to @disk_rate_limit. Lowered if the debt
+	 * exceeds @max_compaction_debt to give compaction more room
+	 * and raised if transactions stall for too long while the
+	 * debt is within the limit.
+	 */
+	double rate_limit_scale;
 };
 
 void
 vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
-		    vy_trigger_dump_f trigger_dump_cb);
+		    vy_trigger_dump_f trigger_dump_cb,
+		    vy_compaction_debt_f compaction_debt_cb);
 
 void
 vy_regulator_start(struct vy_regulator *regulator);
@@ -162,6 +211,22 @@ vy_regulator_dump_complete(struct vy_regulator *regulator,
 void
 vy_regulator_set_memory_limit(struct vy_regulator *regulator, size_t limit);
 
+/**
+ * Set the max time a transaction may wait for quota,
+ * 0 disables the limit.
+ */
+void
+vy_regulator_set_max_write_stall(struct vy_regulator *regulator,
+				 double max_write_stall);
+
+/**
+ * Set the max amount of data awaiting compaction,
+ * 0 disables the limit.
+ */
+void
+vy_regulator_set_max_compaction_debt(struct vy_regulator *regulator,
+				     size_t max_compaction_debt);
+
 /**
  * Reset dump bandwidth histogram and update initial estimate.
  * Called when box.cfg.snap_io_rate_limit is updated.
@@ -31,6 +31,9 @@
 #include "vy_run.h"
 
 #include <zstd.h>
+#include <zdict.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 #include "fiber.h"
 #include "fiber_cond.h"
@@ -52,6 +55,12 @@ static const uint64_t vy_page_info_key_map = (1 << VY_PAGE_INFO_OFFSET) |
 					     (1 << VY_PAGE_INFO_MIN_KEY) |
 					     (1 << VY_PAGE_INFO_ROW_INDEX_OFFSET);
 
+static const uint64_t vy_part_info_key_map = (1 << VY_PART_INFO_OFFSET) |
+					     (1 << VY_PART_INFO_SIZE) |
+					     (1 << VY_PART_INFO_UNPACKED_SIZE) |
+					     (1 << VY_PART_INFO_PAGE_COUNT) |
+					     (1 << VY_PART_INFO_MIN_KEY);
+
 static const uint64_t vy_run_info_key_map = (1 << VY_RUN_INFO_MIN_KEY) |
 					    (1 << VY_RUN_INFO_MAX_KEY) |
 					    (1 << VY_RUN_INFO_MIN_LSN) |
@@ -69,11 +78,24 @@ const char *vy_file_suffix[] = {
 	"index" inprogress_suffix, 	/* VY_FILE_INDEX_INPROGRESS */
 	"run",				/* VY_FILE_RUN */
 	"run" inprogress_suffix, 	/* VY_FILE_RUN_INPROGRESS */
+	"blob",				/* VY_FILE_BLOB */
+	"blob" inprogress_suffix, 	/* VY_FILE_BLOB_INPROGRESS */
 };
 
 /* sync run and index files very 16 MB */
 #define VY_RUN_SYNC_INTERVAL (1 << 24)
 
+enum {
+	/**
+	 * A compression dictionary is trained on the first
+	 * statements of a run, which take up to this many times
+	 * the dictionary size, as recommended by zstd.
+	 */
+	VY_RUN_DICT_SAMPLE_RATIO = 100,
+	/** Max size of statements a dictionary is trained on. */
+	VY_RUN_DICT_SAMPLE_SIZE_MAX = 8 * 1024 * 1024,
+};
+
 /**
  * We read runs in background threads so as not to stall tx.
  * This structure represents such a thread.
@@ -111,6 +133,50 @@ struct vy_page_read_task {
 	struct vy_page *page;
 };
 
+/**
+ * A page read ahead by a run iterator. The page is read by
+ * a reader thread on behalf of a background fiber while the
+ * iterator is processing the pages preceding it.
+ */
+struct vy_page_prefetch {
+	/** Page read task. */
+	struct vy_page_read_task task;
+	/** Link in vy_run_iterator::prefetch. */
+	struct rlist in_itr;
+	/** Number of the page in the run. */
+	uint32_t page_no;
+	/**
+	 * Page index partition pinned until the read completes
+	 * or NULL if the partition is resident.
+	 */
+	struct vy_run_part *part;
+	/** Set when the read completes. */
+	bool is_done;
+	/** Set if the read failed. */
+	bool is_failed;
+	/**
+	 * Set if the iterator dropped the page before the read
+	 * completed. The background fiber frees such a page.
+	 */
+	bool is_orphan;
+	/** Signalled when the read completes. */
+	struct fiber_cond done_cond;
+};
+
+/** Cbus task for vinyl page index partition read. */
+struct vy_part_read_task {
+	/** parent */
+	struct cbus_call_msg base;
+	/** partition to read */
+	struct vy_run_part *part;
+	/** key definition (needed for decoding page min keys) */
+	struct key_def *cmp_def;
+	/** [out] page index of the partition */
+	struct vy_page_info *page_info;
+	/** [out] bloom filter of the partition */
+	struct tuple_bloom *bloom;
+};
+
 /** Destructor for env->zdctx_key thread-local variable */
 static void
 vy_free_zdctx(void *arg)
@@ -183,6 +249,12 @@ vy_run_env_create(struct vy_run_env *env, int read_threads)
 	tt_pthread_key_create(&env->zdctx_key, vy_free_zdctx);
 	mempool_create(&env->read_task_pool, cord_slab_cache(),
 		       sizeof(struct vy_page_read_task));
+	mempool_create(&env->part_read_task_pool, cord_slab_cache(),
+		       sizeof(struct vy_part_read_task));
+	mempool_create(&env->prefetch_pool, cord_slab_cache(),
+		       sizeof(struct vy_page_prefetch));
+	rlist_create(&env->part_lru);
+	env->part_cache_quota = SIZE_MAX;
 }
 
 /**
@@ -194,6 +266,8 @@ vy_run_env_destroy(struct vy_run_env *env)
 	if (env->reader_pool != NULL)
 		vy_run_env_stop_readers(env);
 	mempool_destroy(&env->read_task_pool);
+	mempool_destroy(&env->part_read_task_pool);
+	mempool_destroy(&env->prefetch_pool);
 	tt_pthread_key_delete(env->zdctx_key);
 }
 
@@ -270,6 +344,95 @@ vy_page_info_destroy(struct vy_page_info *page_info)
 		free(page_info->min_key);
 }
 
+/**
+ * Free page index array.
+ */
+static void
+vy_page_index_delete(struct vy_page_info *page_info, uint32_t page_count)
+{
+	if (page_info == NULL)
+		return;
+	for (uint32_t page_no = 0; page_no < page_count; page_no++)
+		vy_page_info_destroy(&page_info[page_no]);
+	free(page_info);
+}
+
+/**
+ * Evict page index partitions that aren't used by any iterator
+ * until the size of loaded partitions fits in the quota.
+ */
+static void
+vy_run_env_evict_parts(struct vy_run_env *env);
+
+/**
+ * Free page index and bloom filter of a loaded partition.
+ */
+static void
+vy_run_part_unload(struct vy_run_part *part)
+{
+	assert(vy_run_part_is_loaded(part));
+	assert(part->pin_count == 0);
+	if (!vy_run_part_is_resident(part)) {
+		struct vy_run_env *env = part->run->env;
+		rlist_del(&part->in_lru);
+		assert(env->part_page_index_size >= part->page_index_size);
+		assert(env->part_bloom_size >= part->bloom_size);
+		env->part_page_index_size -= part->page_index_size;
+		env->part_bloom_size -= part->bloom_size;
+	}
+	vy_page_index_delete(part->page_info, part->page_count);
+	part->page_info = NULL;
+	if (part->bloom != NULL) {
+		tuple_bloom_delete(part->bloom);
+		part->bloom = NULL;
+	}
+}
+
+/**
+ * Pin a loaded page index partition so that it can't be evicted.
+ */
+static void
+vy_run_part_pin(struct vy_run_part *part)
+{
+	assert(vy_run_part_is_loaded(part));
+	assert(!vy_run_part_is_resident(part));
+	if (part->pin_count++ == 0)
+		rlist_del(&part->in_lru);
+}
+
+/**
+ * Unpin a page index partition. If the partition isn't used any
+ * more, it is moved to the LRU list and may be evicted.
+ */
+static void
+vy_run_part_unpin(struct vy_run_part *part)
+{
+	assert(part->pin_count > 0);
+	if (--part->pin_count > 0)
+		return;
+	struct vy_run_env *env = part->run->env;
+	rlist_add_tail_entry(&env->part_lru, part, in_lru);
+	vy_run_env_evict_parts(env);
+}
+
+static void
+vy_run_env_evict_parts(struct vy_run_env *env)
+{
+	while (env->part_page_index_size + env->part_bloom_size >
+	       env->part_cache_quota && !rlist_empty(&env->part_lru)) {
+		struct vy_run_part *part = rlist_first_entry(&env->part_lru,
+						struct vy_run_part, in_lru);
+		vy_run_part_unload(part);
+	}
+}
+
+void
+vy_run_env_set_part_cache_quota(struct vy_run_env *env, size_t quota)
+{
+	env->part_cache_quota = quota;
+	vy_run_env_evict_parts(env);
+}
+
 struct vy_run *
 vy_run_new(struct vy_run_env *env, int64_t id)
 {
@@ -283,32 +446,67 @@ vy_run_new(struct vy_run_env *env, int64_t id)
 	run->id = id;
 	run->dump_lsn = -1;
 	run->fd = -1;
+	run->blob_fd = -1;
 	run->refs = 1;
 	rlist_create(&run->in_lsm);
 	rlist_create(&run->in_unused);
 	return run;
 }
 
+/**
+ * Allocate page index partitions for a run.
+ */
+static int
+vy_run_alloc_parts(struct vy_run *run, uint32_t part_count)
+{
+	assert(run->parts == NULL);
+	run->parts = calloc(part_count, sizeof(*run->parts));
+	if (run->parts == NULL) {
+		diag_set(OutOfMemory, part_count * sizeof(*run->parts),
+			 "malloc", "struct vy_run_part");
+		return -1;
+	}
+	run->part_count = part_count;
+	for (uint32_t i = 0; i < part_count; i++) {
+		struct vy_run_part *part = &run->parts[i];
+		part->run = run;
+		rlist_create(&part->in_lru);
+	}
+	return 0;
+}
+
 static void
 vy_run_clear(struct vy_run *run)
 {
-	if (run->page_info != NULL) {
-		uint32_t page_no;
-		for (page_no = 0; page_no < run->info.page_count; ++page_no)
-			vy_page_info_destroy(run->page_info + page_no);
-		free(run->page_info);
+	for (uint32_t i = 0; i < run->part_count; i++) {
+		struct vy_run_part *part = &run->parts[i];
+		if (vy_run_part_is_loaded(part))
+			vy_run_part_unload(part);
+		free(part->min_key);
 	}
-	run->page_info = NULL;
+	free(run->parts);
+	run->parts = NULL;
+	run->part_count = 0;
 	run->page_index_size = 0;
+	run->bloom_size = 0;
+	run->part_index_size = 0;
 	run->info.page_count = 0;
-	if (run->info.bloom != NULL) {
-		tuple_bloom_delete(run->info.bloom);
-		run->info.bloom = NULL;
-	}
+	run->info.part_count = 0;
 	free(run->info.min_key);
 	run->info.min_key = NULL;
 	free(run->info.max_key);
 	run->info.max_key = NULL;
+	free(run->info.blob_ids);
+	run->info.blob_ids = NULL;
+	run->info.blob_id_count = 0;
+	free(run->info.dict);
+	run->info.dict = NULL;
+	run->info.dict_size = 0;
+	ZSTD_freeDDict(run->zddict);
+	run->zddict = NULL;
+	if (run->blob_fd >= 0 && close(run->blob_fd) < 0)
+		say_syserror("close failed");
+	run->blob_fd = -1;
 }
 
 void
@@ -317,6 +515,9 @@ vy_run_delete(struct vy_run *run)
 	assert(run->refs == 0);
 	if (run->fd >= 0 && close(run->fd) < 0)
 		say_syserror("close failed");
+	for (int i = 0; i < run->blob_run_count; i++)
+		vy_run_unref(run->blob_runs[i]);
+	free(run->blob_runs);
 	vy_run_clear(run);
 	TRASH(run);
 	free(run);
@@ -325,9 +526,92 @@ vy_run_delete(struct vy_run *run)
 size_t
 vy_run_bloom_size(struct vy_run *run)
 {
-	return run->info.bloom == NULL ? 0 : tuple_bloom_size(run->info.bloom);
+	return run->bloom_size;
+}
+
+/**
+ * Return the number of the page index partition a page belongs to.
+ */
+static uint32_t
+vy_run_page_part_no(struct vy_run *run, uint32_t page_no)
+{
+	assert(page_no < run->info.page_count);
+	assert(run->part_count > 0);
+	uint32_t begin = 0;
+	uint32_t end = run->part_count;
+	while (end - begin > 1) {
+		uint32_t mid = begin + (end - begin) / 2;
+		if (run->parts[mid].first_page_no <= page_no)
+			begin = mid;
+		else
+			end = mid;
+	}
+	return begin;
 }
 
+/**
+ * Binary search in a page index array. Returns the number of the
+ * lowest page with min_key >= key if @is_lower_bound is set, with
+ * min_key > key otherwise, or @page_count if there's no such page.
+ * *equal_key is set to true if a page with min_key equal to the key
+ * is encountered.
+ */
+static uint32_t
+vy_page_info_find_bound(const struct vy_page_info *page_info,
+			uint32_t page_count, struct vy_entry key,
+			struct key_def *cmp_def, bool is_lower_bound,
+			bool *equal_key)
+{
+	/* Initially the range is set with virtual positions */
+	int32_t range[2] = { -1, page_count };
+	while (range[1] - range[0] > 1) {
+		int32_t mid = range[0] + (range[1] - range[0]) / 2;
+		const struct vy_page_info *info = &page_info[mid];
+		int cmp = vy_entry_compare_with_raw_key(key, info->min_key,
+							info->min_key_hint,
+							cmp_def);
+		if (is_lower_bound)
+			range[cmp <= 0] = mid;
+		else
+			range[cmp < 0] = mid;
+		*equal_key = *equal_key || cmp == 0;
+	}
+	return range[1];
+}
+
+/**
+ * Same as vy_page_info_find_bound(), but looks up the partition
+ * directory of a run rather than a page index.
+ */
+static uint32_t
+vy_run_find_part(struct vy_run *run, struct vy_entry key,
+		 struct key_def *cmp_def, bool is_lower_bound,
+		 bool *equal_key)
+{
+	int32_t range[2] = { -1, run->part_count };
+	while (range[1] - range[0] > 1) {
+		int32_t mid = range[0] + (range[1] - range[0]) / 2;
+		const struct vy_run_part *part = &run->parts[mid];
+		int cmp = vy_entry_compare_with_raw_key(key, part->min_key,
+							part->min_key_hint,
+							cmp_def);
+		if (is_lower_bound)
+			range[cmp <= 0] = mid;
+		else
+			range[cmp < 0] = mid;
+		*equal_key = *equal_key || cmp == 0;
+	}
+	return range[1];
+}
+
+/**
+ * Callback used by vy_page_index_find_page() to get the page
+ * index of a partition, loading it if necessary.
+ */
+typedef int
+(*vy_page_index_load_f)(void *arg, uint32_t part_no,
+			struct vy_page_info **page_info);
+
 /**
  * Find a page from which the iteration of a given key must be started.
  * LE and LT: the found page definitely contains the position
@@ -341,15 +625,20 @@ vy_run_bloom_size(struct vy_run *run)
  * @param key - key to find
  * @param key_def - key_def for comparison
  * @param itype - iterator type (see above)
- * @param equal_key: *equal_key is set to true if there is a page
+ * @param load_part - callback to get page index of a partition
+ * @param arg - argument passed to @load_part
+ * @param[out] page_no - offset of the page in page index OR
+ *  run->info.page_count if there no pages fulfilling the conditions.
+ * @param[out] equal_key - *equal_key is set to true if there is a page
  *  with min_key equal to the given key.
- * @return offset of the page in page index OR run->info.page_count if
- *  there no pages fulfilling the conditions.
+ * @retval 0 success
+ * @retval -1 failed to load page index partition
  */
-static uint32_t
+static NODISCARD int
 vy_page_index_find_page(struct vy_run *run, struct vy_entry key,
 			struct key_def *cmp_def, enum iterator_type itype,
-			bool *equal_key)
+			vy_page_index_load_f load_part, void *arg,
+			uint32_t *page_no, bool *equal_key)
 {
 	if (itype == ITER_EQ)
 		itype = ITER_GE; /* One day it'll become obsolete */
@@ -369,46 +658,58 @@ vy_page_index_find_page(struct vy_run *run, struct vy_entry key,
 	 * min_key:         [1   1   2   2   2   2   2   3   3   3]
 	 * we want to find: [    LT  GE              LE  GT       ]
 	 * For LT and GE it's a classical lower_bound search.
-	 * Let's set up a range with left page's min_key < key and
-	 *  right page's min >= key; binary cut the range until it
-	 *  becomes of length 1 and then LT pos = left bound of the range
-	 *  and GE pos = right bound of the range.
 	 * For LE and GT it's a classical upper_bound search.
-	 * Let's set up a range with left page's min_key <= key and
-	 *  right page's min > key; binary cut the range until it
-	 *  becomes of length 1 and then LE pos = left bound of the range
-	 *  and GT pos = right bound of the range.
+	 * LT and LE positions are the ones preceding the GE and GT
+	 * positions, respectively.
 	 */
 	bool is_lower_bound = itype == ITER_LT || itype == ITER_GE;
 
 	assert(run->info.page_count > 0);
-	/* Initially the range is set with virtual positions */
-	int32_t range[2] = { -1, run->info.page_count };
-	assert(run->info.page_count > 0);
-	do {
-		int32_t mid = range[0] + (range[1] - range[0]) / 2;
-		struct vy_page_info *info = vy_run_page_info(run, mid);
-		int cmp = vy_entry_compare_with_raw_key(key, info->min_key,
-							info->min_key_hint,
-							cmp_def);
-		if (is_lower_bound)
-			range[cmp <= 0] = mid;
-		else
-			range[cmp < 0] = mid;
-		*equal_key = *equal_key || cmp == 0;
-	} while (range[1] - range[0] > 1);
-	if (range[0] < 0)
-		range[0] = run->info.page_count;
-	uint32_t page = range[dir > 0];
-
-	/**
-	 * Since page search uses only min_key of pages,
-	 *  for GE, GT and EQ the previous page can contain
-	 *  the point where iteration must be started.
+	/*
+	 * Look up the partition directory first. Since the min key
+	 * of a partition is the min key of its first page, the bound
+	 * is either in the partition preceding the bound partition
+	 * or is the first page of the bound partition.
 	 */
-	if (page > 0 && dir > 0)
-		return page - 1;
-	return page;
+	uint32_t bound = 0;
+	uint32_t part_no = vy_run_find_part(run, key, cmp_def,
+					    is_lower_bound, equal_key);
+	if (part_no > 0) {
+		struct vy_run_part *part = &run->parts[--part_no];
+		struct vy_page_info *page_info;
+		if (load_part(arg, part_no, &page_info) != 0)
+			return -1;
+		bound = part->first_page_no +
+			vy_page_info_find_bound(page_info, part->page_count,
+						key, cmp_def, is_lower_bound,
+						equal_key);
+	}
+	if (dir > 0) {
+		/**
+		 * Since page search uses only min_key of pages,
+		 *  for GE, GT and EQ the previous page can contain
+		 *  the point where iteration must be started.
+		 */
+		*page_no = bound > 0 ? bound - 1 : 0;
+	} else {
+		*page_no = bound > 0 ? bound - 1 : run->info.page_count;
+	}
+	return 0;
+}
+
+/**
+ * Page index loader for vy_page_index_find_page() that may be
+ * used only with runs that aren't partitioned.
+ */
+static int
+vy_run_resident_part_cb(void *arg, uint32_t part_no,
+			struct vy_page_info **page_info)
+{
+	struct vy_run *run = arg;
+	struct vy_run_part *part = &run->parts[part_no];
+	assert(vy_run_part_is_resident(part));
+	*page_info = part->page_info;
+	return 0;
 }
 
 struct vy_slice *
@@ -441,25 +742,63 @@ vy_slice_new(int64_t id, struct vy_run *run, struct vy_entry begin,
 	}
 	/** Lookup the first and the last pages spanned by the slice. */
 	bool unused;
-	if (slice->begin.stmt == NULL) {
-		slice->first_page_no = 0;
-	} else {
-		slice->first_page_no =
-			vy_page_index_find_page(run, slice->begin, cmp_def,
-						ITER_GE, &unused);
-		assert(slice->first_page_no < run->info.page_count);
-	}
-	if (slice->end.stmt == NULL) {
-		slice->last_page_no = run->info.page_count - 1;
+	if (vy_run_is_partitioned(run)) {
+		/*
+		 * We can't load page index partitions here, because
+		 * this function must not yield, so we have to use
+		 * the partition directory and round the slice up to
+		 * partition boundaries. Slice users take care of the
+		 * exact boundaries.
+		 */
+		uint32_t first_part = 0;
+		uint32_t last_part = run->part_count - 1;
+		if (slice->begin.stmt != NULL) {
+			first_part = vy_run_find_part(run, slice->begin,
+						      cmp_def, true, &unused);
+			if (first_part > 0)
+				first_part--;
+		}
+		if (slice->end.stmt != NULL) {
+			last_part = vy_run_find_part(run, slice->end,
+						     cmp_def, true, &unused);
+			if (last_part == 0) {
+				/* It's an empty slice */
+				return slice;
+			}
+			last_part--;
+		}
+		assert(last_part >= first_part);
+		struct vy_run_part *part = &run->parts[last_part];
+		slice->first_page_no = run->parts[first_part].first_page_no;
+		slice->last_page_no = part->first_page_no +
+				      part->page_count - 1;
 	} else {
-		slice->last_page_no =
-			vy_page_index_find_page(run, slice->end, cmp_def,
-						ITER_LT, &unused);
-		if (slice->last_page_no == run->info.page_count) {
-			/* It's an empty slice */
+		if (slice->begin.stmt == NULL) {
 			slice->first_page_no = 0;
-			slice->last_page_no = 0;
-			return slice;
+		} else {
+			if (vy_page_index_find_page(run, slice->begin,
+						    cmp_def, ITER_GE,
+						    vy_run_resident_part_cb,
+						    run, &slice->first_page_no,
+						    &unused) != 0)
+				unreachable();
+			assert(slice->first_page_no < run->info.page_count);
+		}
+		if (slice->end.stmt == NULL) {
+			slice->last_page_no = run->info.page_count - 1;
+		} else {
+			if (vy_page_index_find_page(run, slice->end,
+						    cmp_def, ITER_LT,
+						    vy_run_resident_part_cb,
+						    run, &slice->last_page_no,
+						    &unused) != 0)
+				unreachable();
+			if (slice->last_page_no == run->info.page_count) {
+				/* It's an empty slice */
+				slice->first_page_no = 0;
+				slice->last_page_no = 0;
+				return slice;
+			}
 		}
 	}
 	assert(slice->last_page_no >= slice->first_page_no);
@@ -476,6 +815,76 @@ vy_slice_new(int64_t id, struct vy_run *run, struct vy_entry begin,
 	return slice;
 }
 
+/**
+ * Return the min key of a page and its hint. The page must belong
+ * to a resident partition or be the first page of a partition.
+ */
+static const char *
+vy_run_page_min_key(struct vy_run *run, uint32_t page_no, hint_t *hint)
+{
+	struct vy_run_part *part = &run->parts[vy_run_page_part_no(run,
+								   page_no)];
+	if (vy_run_part_is_resident(part)) {
+		struct vy_page_info *info;
+		info = &part->page_info[page_no - part->first_page_no];
+		*hint = info->min_key_hint;
+		return info->min_key;
+	}
+	assert(page_no == part->first_page_no);
+	*hint = part->min_key_hint;
+	return part->min_key;
+}
+
+const char *
+vy_slice_first_page_key(struct vy_slice *slice, hint_t *hint)
+{
+	/*
+	 * A slice of a partitioned run always starts at
+	 * a partition boundary, see vy_slice_new().
+	 */
+	return vy_run_page_min_key(slice->run, slice->first_page_no, hint);
+}
+
+const char *
+vy_slice_mid_page_key(struct vy_slice *slice, hint_t *hint)
+{
+	struct vy_run *run = slice->run;
+	uint32_t page_no = slice->first_page_no +
+			   (slice->last_page_no - slice->first_page_no) / 2;
+	if (vy_run_is_partitioned(run)) {
+		/*
+		 * Round the page down to the partition boundary unless
+		 * it is the slice beginning, in which case take the
+		 * boundary of the next partition, if any, so as not to
+		 * end up with an empty range after split.
+		 */
+		uint32_t part_no = vy_run_page_part_no(run, page_no);
+		page_no = run->parts[part_no].first_page_no;
+		if (page_no == slice->first_page_no &&
+		    part_no + 1 < run->part_count &&
+		    run->parts[part_no + 1].first_page_no <=
+		    slice->last_page_no)
+			page_no = run->parts[part_no + 1].first_page_no;
+	}
+	return vy_run_page_min_key(run, page_no, hint);
+}
+
+const char *
+vy_slice_page_key(struct vy_slice *slice, uint32_t num, uint32_t den,
+		  hint_t *hint)
+{
+	assert(num < den);
+	struct vy_run *run = slice->run;
+	uint32_t page_count = slice->last_page_no - slice->first_page_no + 1;
+	uint32_t page_no = slice->first_page_no +
+			   (uint64_t)page_count * num / den;
+	if (vy_run_is_partitioned(run)) {
+		uint32_t part_no = vy_run_page_part_no(run, page_no);
+		page_no = run->parts[part_no].first_page_no;
+	}
+	return vy_run_page_min_key(run, page_no, hint);
+}
+
 void
 vy_slice_delete(struct vy_slice *slice)
 {
@@ -622,18 +1031,60 @@ vy_stmt_stat_decode(struct vy_stmt_stat *stat, const char **data)
 	}
 }
 
+/**
+ * Decode ids of runs whose blob files are referenced by a run.
+ */
+static int
+vy_run_info_decode_blobs(struct vy_run_info *run_info, const char **data)
+{
+	uint32_t count = mp_decode_array(data);
+	int64_t *ids = malloc(count * sizeof(*ids));
+	if (ids == NULL && count > 0) {
+		diag_set(OutOfMemory, count * sizeof(*ids),
+			 "malloc", "blob ids");
+		return -1;
+	}
+	for (uint32_t i = 0; i < count; i++)
+		ids[i] = mp_decode_uint(data);
+	free(run_info->blob_ids);
+	run_info->blob_ids = ids;
+	run_info->blob_id_count = count;
+	return 0;
+}
+
+/**
+ * Decode the compression dictionary of a run.
+ */
+static int
+vy_run_info_decode_dict(struct vy_run_info *run_info, const char **data)
+{
+	uint32_t size;
+	const char *dict = mp_decode_bin(data, &size);
+	char *copy = malloc(size);
+	if (copy == NULL && size > 0) {
+		diag_set(OutOfMemory, size, "malloc", "zstd dictionary");
+		return -1;
+	}
+	memcpy(copy, dict, size);
+	free(run_info->dict);
+	run_info->dict = copy;
+	run_info->dict_size = size;
+	return 0;
+}
+
 /**
  * Decode the run metadata from xrow.
  *
  * @param xrow xrow to decode
  * @param[out] run_info the run information
+ * @param[out] bloom the run bloom filter or NULL
  * @param filename File name for error reporting.
  *
  * @retval  0 success
  * @retval -1 error (check diag)
  */
-int
-vy_run_info_decode(struct vy_run_info *run_info,
+static int
+vy_run_info_decode(struct vy_run_info *run_info, struct tuple_bloom **bloom,
 		   const struct xrow_header *xrow,
 		   const char *filename)
 {
@@ -641,6 +1092,7 @@ vy_run_info_decode(struct vy_run_info *run_info,
 	/* decode run */
 	const char *pos = xrow->body->iov_base;
 	memset(run_info, 0, sizeof(*run_info));
+	*bloom = NULL;
 	uint64_t key_map = vy_run_info_key_map;
 	uint32_t map_size = mp_decode_map(&pos);
 	uint32_t map_item;
@@ -674,18 +1126,33 @@ vy_run_info_decode(struct vy_run_info *run_info,
 			run_info->page_count = mp_decode_uint(&pos);
 			break;
 		case VY_RUN_INFO_BLOOM_LEGACY:
-			run_info->bloom = tuple_bloom_decode_legacy(&pos);
-			if (run_info->bloom == NULL)
+			if (*bloom != NULL)
+				tuple_bloom_delete(*bloom);
+			*bloom = tuple_bloom_decode_legacy(&pos);
+			if (*bloom == NULL)
 				return -1;
 			break;
 		case VY_RUN_INFO_BLOOM:
-			run_info->bloom = tuple_bloom_decode(&pos);
-			if (run_info->bloom == NULL)
+			if (*bloom != NULL)
+				tuple_bloom_delete(*bloom);
+			*bloom = tuple_bloom_decode(&pos);
+			if (*bloom == NULL)
 				return -1;
 			break;
 		case VY_RUN_INFO_STMT_STAT:
 			vy_stmt_stat_decode(&run_info->stmt_stat, &pos);
 			break;
+		case VY_RUN_INFO_PART_COUNT:
+			run_info->part_count = mp_decode_uint(&pos);
+			break;
+		case VY_RUN_INFO_BLOBS:
+			if (vy_run_info_decode_blobs(run_info, &pos) != 0)
+				return -1;
+			break;
+		case VY_RUN_INFO_DICT:
+			if (vy_run_info_decode_dict(run_info, &pos) != 0)
+				return -1;
+			break;
 		default:
 			mp_next(&pos); /* unknown key, ignore */
 			break;
@@ -702,6 +1169,152 @@ vy_run_info_decode(struct vy_run_info *run_info,
 	return 0;
 }
 
+/**
+ * Decode page index partition information stored in the index
+ * file from xrow.
+ *
+ * @param[out] part Partition information.
+ * @param xrow      Xrow to decode.
+ * @param cmp_def   Definition of keys stored in the partition.
+ * @param filename  Filename for error reporting.
+ *
+ * @retval  0 Success.
+ * @retval -1 Error.
+ */
+static int
+vy_part_info_decode(struct vy_run_part *part, const struct xrow_header *xrow,
+		    struct key_def *cmp_def, const char *filename)
+{
+	assert(xrow->type == VY_INDEX_PART_INFO);
+	const char *pos = xrow->body->iov_base;
+	uint64_t key_map = vy_part_info_key_map;
+	uint32_t map_size = mp_decode_map(&pos);
+	uint32_t map_item;
+	const char *key_beg;
+	uint32_t part_count;
+	for (map_item = 0; map_item < map_size; ++map_item) {
+		uint32_t key = mp_decode_uint(&pos);
+		key_map &= ~(1ULL << key);
+		switch (key) {
+		case VY_PART_INFO_OFFSET:
+			part->offset = mp_decode_uint(&pos);
+			break;
+		case VY_PART_INFO_SIZE:
+			part->size = mp_decode_uint(&pos);
+			break;
+		case VY_PART_INFO_UNPACKED_SIZE:
+			part->unpacked_size = mp_decode_uint(&pos);
+			break;
+		case VY_PART_INFO_PAGE_COUNT:
+			part->page_count = mp_decode_uint(&pos);
+			break;
+		case VY_PART_INFO_MIN_KEY:
+			key_beg = pos;
+			mp_next(&pos);
+			free(part->min_key);
+			part->min_key = vy_key_dup(key_beg);
+			if (part->min_key == NULL)
+				return -1;
+			part_count = mp_decode_array(&key_beg);
+			part->min_key_hint = key_hint(key_beg, part_count,
+						      cmp_def);
+			break;
+		case VY_PART_INFO_ROW_COUNT:
+			part->count.rows = mp_decode_uint(&pos);
+			break;
+		case VY_PART_INFO_BYTES:
+			part->count.bytes = mp_decode_uint(&pos);
+			break;
+		case VY_PART_INFO_BYTES_COMPRESSED:
+			part->count.bytes_compressed = mp_decode_uint(&pos);
+			break;
+		case VY_PART_INFO_INDEX_SIZE:
+			part->page_index_size = mp_decode_uint(&pos);
+			break;
+		case VY_PART_INFO_BLOOM_SIZE:
+			part->bloom_size = mp_decode_uint(&pos);
+			break;
+		default:
+			mp_next(&pos); /* unknown key, ignore */
+			break;
+		}
+	}
+	if (key_map) {
+		enum vy_part_info_key key = bit_ctz_u64(key_map);
+		diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
+			 tt_sprintf("Can't decode partition info: "
+				    "missing mandatory key %s",
+				    vy_part_info_key_name(key)));
+		return -1;
+	}
+	if (part->size == 0 || part->page_count == 0) {
+		diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
+			 "Can't decode partition info: empty partition");
+		return -1;
+	}
+	part->count.pages = part->page_count;
+	return 0;
+}
+
+/**
+ * Decode the header of a page index partition stored in the run
+ * file, which precedes page information, from xrow.
+ *
+ * @param part       Partition the header belongs to.
+ * @param xrow       Xrow to decode.
+ * @param[out] bloom The partition bloom filter or NULL.
+ *
+ * @retval  0 Success.
+ * @retval -1 Error.
+ */
+static int
+vy_part_header_decode(const struct vy_run_part *part,
+		      const struct xrow_header *xrow,
+		      struct tuple_bloom **bloom)
+{
+	if (xrow->type != VY_INDEX_PART_INFO) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Wrong partition header type "
+				    "(expected %d, got %u)",
+				    VY_INDEX_PART_INFO, (unsigned)xrow->type));
+		return -1;
+	}
+	const char *pos = xrow->body->iov_base;
+	uint32_t page_count = 0;
+	uint32_t map_size = mp_decode_map(&pos);
+	for (uint32_t map_item = 0; map_item < map_size; ++map_item) {
+		uint32_t key = mp_decode_uint(&pos);
+		switch (key) {
+		case VY_PART_INFO_PAGE_COUNT:
+			page_count = mp_decode_uint(&pos);
+			break;
+		case VY_PART_INFO_BLOOM:
+			if (bloom == NULL) {
+				mp_next(&pos);
+				break;
+			}
+			if (*bloom != NULL)
+				tuple_bloom_delete(*bloom);
+			*bloom = tuple_bloom_decode(&pos);
+			if (*bloom == NULL)
+				return -1;
+			break;
+		default:
+			mp_next(&pos); /* unknown key, ignore */
+			break;
+		}
+	}
+	if (page_count != part->page_count) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Wrong partition page count "
+				    "(expected %u, got %u)",
+				    (unsigned)part->page_count,
+				    (unsigned)page_count));
+		return -1;
+	}
+	return 0;
+}
+
 static struct vy_page *
 vy_page_new(const struct vy_page_info *page_info)
 {
@@ -822,12 +1435,56 @@ vy_page_find_key(struct vy_page *page, struct vy_entry key,
 	return end;
 }
 
+static void
+vy_page_prefetch_delete(struct vy_page_prefetch *prefetch)
+{
+	assert(prefetch->is_done);
+	struct vy_run *run = prefetch->task.run;
+	struct vy_run_env *env = run->env;
+	if (prefetch->task.page != NULL)
+		vy_page_delete(prefetch->task.page);
+	if (prefetch->part != NULL)
+		vy_run_part_unpin(prefetch->part);
+	vy_run_unref(run);
+	fiber_cond_destroy(&prefetch->done_cond);
+	mempool_free(&env->prefetch_pool, prefetch);
+}
+
+/**
+ * Remove a page from the prefetch list of a run iterator.
+ * If the page is still being read, it will be freed by the
+ * background fiber when the read completes.
+ */
+static void
+vy_run_iterator_drop_prefetch(struct vy_run_iterator *itr,
+			      struct vy_page_prefetch *prefetch)
+{
+	assert(itr->prefetch_count > 0);
+	rlist_del_entry(prefetch, in_itr);
+	itr->prefetch_count--;
+	if (prefetch->is_done)
+		vy_page_prefetch_delete(prefetch);
+	else
+		prefetch->is_orphan = true;
+}
+
+/** Drop all pages read ahead by a run iterator. */
+static void
+vy_run_iterator_drop_readahead(struct vy_run_iterator *itr)
+{
+	struct vy_page_prefetch *prefetch, *tmp;
+	rlist_foreach_entry_safe(prefetch, &itr->prefetch, in_itr, tmp)
+		vy_run_iterator_drop_prefetch(itr, prefetch);
+	assert(itr->prefetch_count == 0);
+}
+
 /**
  * End iteration and free cached data.
  */
 static void
 vy_run_iterator_stop(struct vy_run_iterator *itr)
 {
+	vy_run_iterator_drop_readahead(itr);
 	if (itr->curr.stmt != NULL) {
 		tuple_unref(itr->curr.stmt);
 		itr->curr = vy_entry_none();
@@ -838,6 +1495,10 @@ vy_run_iterator_stop(struct vy_run_iterator *itr)
 			vy_page_delete(itr->prev_page);
 		itr->curr_page = itr->prev_page = NULL;
 	}
+	if (itr->curr_part != NULL) {
+		vy_run_part_unpin(itr->curr_part);
+		itr->curr_part = NULL;
+	}
 }
 
 static int
@@ -924,7 +1585,8 @@ vy_page_read(struct vy_page *page, const struct vy_page_info *page_info,
 	const char *data_end = data + readen;
 	char *rows = page->data;
 	char *rows_end = rows + page_info->unpacked_size;
-	if (xlog_tx_decode(data, data_end, rows, rows_end, zdctx) != 0)
+	if (xlog_tx_decode(data, data_end, rows, rows_end,
+			   zdctx, run->zddict) != 0)
 		goto error;
 
 	struct xrow_header xrow;
@@ -996,14 +1658,406 @@ vy_page_read_cb(struct cbus_call_msg *base)
 }
 
 /**
- * Read a page from disk given its number.
- * The function caches two most recently read pages.
+ * Read a page index partition from the run file.
+ *
+ * @param part          Partition to read.
+ * @param cmp_def       Definition of keys stored in the run.
+ * @param zdctx         Decompression context.
+ * @param[out] page_info Page index of the partition.
+ * @param[out] bloom    Bloom filter of the partition. May be NULL
+ *                      if the bloom filter isn't needed.
+ *
+ * @retval 0 on success
+ * @retval -1 on error, check diag
+ */
+static int
+vy_run_part_read(struct vy_run_part *part, struct key_def *cmp_def,
+		 ZSTD_DStream *zdctx, struct vy_page_info **page_info,
+		 struct tuple_bloom **bloom)
+{
+	struct vy_run *run = part->run;
+	struct vy_page_info *pages = NULL;
+	if (bloom != NULL)
+		*bloom = NULL;
+
+	/* read xlog tx from xlog file */
+	size_t region_svp = region_used(&fiber()->gc);
+	char *data = (char *)region_alloc(&fiber()->gc, part->size);
+	char *rows = (char *)region_alloc(&fiber()->gc, part->unpacked_size);
+	if (data == NULL || rows == NULL) {
+		diag_set(OutOfMemory, part->size + part->unpacked_size,
+			 "region gc", "page index partition");
+		goto error;
+	}
+	ssize_t readen = fio_pread(run->fd, data, part->size, part->offset);
+	ERROR_INJECT(ERRINJ_VYRUN_DATA_READ, {
+		readen = -1;
+		errno = EIO;});
+	if (readen < 0) {
+		diag_set(SystemError, "failed to read from file");
+		goto error;
+	}
+	if (readen != (ssize_t)part->size) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 "Unexpected end of file");
+		goto error;
+	}
+
+	/* decode xlog tx */
+	const char *rows_end = rows + part->unpacked_size;
+	if (xlog_tx_decode(data, data + readen, rows, (char *)rows_end,
+			   zdctx, run->zddict) != 0)
+		goto error;
+
+	pages = calloc(part->page_count, sizeof(*pages));
+	if (pages == NULL) {
+		diag_set(OutOfMemory, part->page_count * sizeof(*pages),
+			 "malloc", "struct vy_page_info");
+		goto error;
+	}
+	const char *pos = rows;
+	struct xrow_header xrow;
+	if (xrow_header_decode(&xrow, &pos, rows_end, false) != 0 ||
+	    vy_part_header_decode(part, &xrow, bloom) != 0)
+		goto error;
+	for (uint32_t page_no = 0; page_no < part->page_count; page_no++) {
+		if (pos >= rows_end) {
+			diag_set(ClientError, ER_INVALID_RUN_FILE,
+				 "Unexpected end of page index partition");
+			goto error;
+		}
+		if (xrow_header_decode(&xrow, &pos, rows_end, false) != 0)
+			goto error;
+		if (xrow.type != VY_INDEX_PAGE_INFO) {
+			diag_set(ClientError, ER_INVALID_RUN_FILE,
+				 tt_sprintf("Wrong xrow type "
+					    "(expected %d, got %u)",
+					    VY_INDEX_PAGE_INFO,
+					    (unsigned)xrow.type));
+			goto error;
+		}
+		if (vy_page_info_decode(&pages[page_no], &xrow, cmp_def,
+					vy_run_filename(run)) != 0)
+			goto error;
+	}
+	region_truncate(&fiber()->gc, region_svp);
+	*page_info = pages;
+	return 0;
+error:
+	region_truncate(&fiber()->gc, region_svp);
+	vy_page_index_delete(pages, part->page_count);
+	if (bloom != NULL && *bloom != NULL) {
+		tuple_bloom_delete(*bloom);
+		*bloom = NULL;
+	}
+	diag_log();
+	say_error("error reading %s@%llu:%u", vy_run_filename(run),
+		  (unsigned long long)part->offset, (unsigned)part->size);
+	return -1;
+}
+
+/**
+ * vinyl partition read task callback
+ */
+static int
+vy_part_read_cb(struct cbus_call_msg *base)
+{
+	struct vy_part_read_task *task = (struct vy_part_read_task *)base;
+	ZSTD_DStream *zdctx = vy_env_get_zdctx(task->part->run->env);
+	if (zdctx == NULL)
+		return -1;
+	return vy_run_part_read(task->part, task->cmp_def, zdctx,
+				&task->page_info, &task->bloom);
+}
+
+/**
+ * Load a page index partition unless it's already loaded and
+ * pin it. Loading is done by a reader thread so the function
+ * may yield.
+ *
+ * @retval 0 success
+ * @retval -1 read or memory error
+ */
+static NODISCARD int
+vy_run_part_load(struct vy_run_part *part, struct key_def *cmp_def)
+{
+	if (vy_run_part_is_loaded(part)) {
+		vy_run_part_pin(part);
+		return 0;
+	}
+	struct vy_run_env *env = part->run->env;
+	struct vy_part_read_task *task =
+		mempool_alloc(&env->part_read_task_pool);
+	if (task == NULL) {
+		diag_set(OutOfMemory, sizeof(*task),
+			 "mempool", "vy_part_read_task");
+		return -1;
+	}
+	task->part = part;
+	task->cmp_def = cmp_def;
+	task->page_info = NULL;
+	task->bloom = NULL;
+
+	int rc = vy_run_env_coio_call(env, &task->base, vy_part_read_cb);
+
+	struct vy_page_info *page_info = task->page_info;
+	struct tuple_bloom *bloom = task->bloom;
+	mempool_free(&env->part_read_task_pool, task);
+
+	if (rc != 0 || vy_run_part_is_loaded(part)) {
+		/*
+		 * Either the read failed or the partition was loaded
+		 * by another fiber while we were waiting for the reader
+		 * thread. Anyway, the result isn't needed.
+		 */
+		vy_page_index_delete(page_info, part->page_count);
+		if (bloom != NULL)
+			tuple_bloom_delete(bloom);
+		if (rc != 0)
+			return -1;
+	} else {
+		part->page_info = page_info;
+		part->bloom = bloom;
+		env->part_page_index_size += part->page_index_size;
+		env->part_bloom_size += part->bloom_size;
+	}
+	vy_run_part_pin(part);
+	vy_run_env_evict_parts(env);
+	return 0;
+}
+
+/**
+ * Pin a page index partition to be used by a run iterator,
+ * loading it if necessary, and unpin the partition used by
+ * the iterator before.
+ *
+ * @retval 0 success
+ * @retval -1 read or memory error
+ */
+static NODISCARD int
+vy_run_iterator_pin_part(struct vy_run_iterator *itr, uint32_t part_no)
+{
+	struct vy_run_part *part = &itr->slice->run->parts[part_no];
+	if (vy_run_part_is_resident(part) || itr->curr_part == part)
+		return 0;
+	if (vy_run_part_load(part, itr->cmp_def) != 0)
+		return -1;
+	if (itr->curr_part != NULL)
+		vy_run_part_unpin(itr->curr_part);
+	itr->curr_part = part;
+	return 0;
+}
+
+/**
+ * Page index loader for vy_page_index_find_page() used by
+ * run iterator.
+ */
+static int
+vy_run_iterator_load_part_cb(void *arg, uint32_t part_no,
+			     struct vy_page_info **page_info)
+{
+	struct vy_run_iterator *itr = arg;
+	if (vy_run_iterator_pin_part(itr, part_no) != 0)
+		return -1;
+	*page_info = itr->slice->run->parts[part_no].page_info;
+	return 0;
+}
+
+/**
+ * Get information about a page given its number, loading
+ * the page index partition if necessary. The returned pointer
+ * stays valid until the iterator pins another partition.
+ *
+ * @retval 0 success
+ * @retval -1 read or memory error
+ */
+static NODISCARD int
+vy_run_iterator_page_info(struct vy_run_iterator *itr, uint32_t page_no,
+			  struct vy_page_info **page_info)
+{
+	struct vy_run *run = itr->slice->run;
+	struct vy_run_part *part = itr->curr_part;
+	if (part == NULL || page_no < part->first_page_no ||
+	    page_no >= part->first_page_no + part->page_count) {
+		uint32_t part_no = vy_run_page_part_no(run, page_no);
+		if (vy_run_iterator_pin_part(itr, part_no) != 0)
+			return -1;
+		part = &run->parts[part_no];
+	}
+	assert(vy_run_part_is_loaded(part));
+	*page_info = &part->page_info[page_no - part->first_page_no];
+	return 0;
+}
+
+/** Background fiber reading a page ahead of a run iterator. */
+static int
+vy_page_prefetch_f(va_list ap)
+{
+	struct vy_page_prefetch *prefetch = va_arg(ap, struct vy_page_prefetch *);
+	struct vy_run_env *env = prefetch->task.run->env;
+	if (vy_run_env_coio_call(env, &prefetch->task.base,
+				 vy_page_read_cb) != 0)
+		prefetch->is_failed = true;
+	prefetch->is_done = true;
+	if (prefetch->is_orphan)
+		vy_page_prefetch_delete(prefetch);
+	else
+		fiber_cond_broadcast(&prefetch->done_cond);
+	return 0;
+}
+
+/**
+ * Start reading a page ahead of a run iterator. The page index
+ * partition the page belongs to must be loaded, because we don't
+ * want to read page index partitions in background.
+ *
+ * Returns NULL if readahead can't proceed.
+ */
+static struct vy_page_prefetch *
+vy_page_prefetch_new(struct vy_run_iterator *itr, uint32_t page_no)
+{
+	struct vy_run *run = itr->slice->run;
+	struct vy_run_env *env = run->env;
+	struct vy_run_part *part = &run->parts[vy_run_page_part_no(run,
+								   page_no)];
+	if (!vy_run_part_is_loaded(part))
+		return NULL;
+	struct vy_page_info *page_info =
+		&part->page_info[page_no - part->first_page_no];
+
+	struct vy_page_prefetch *prefetch = mempool_alloc(&env->prefetch_pool);
+	if (prefetch == NULL)
+		return NULL;
+	struct vy_page *page = vy_page_new(page_info);
+	if (page == NULL) {
+		mempool_free(&env->prefetch_pool, prefetch);
+		return NULL;
+	}
+	struct fiber *fiber = fiber_new("vinyl.readahead", vy_page_prefetch_f);
+	if (fiber == NULL) {
+		vy_page_delete(page);
+		mempool_free(&env->prefetch_pool, prefetch);
+		return NULL;
+	}
+	page->page_no = page_no;
+	prefetch->task.run = run;
+	prefetch->task.page_info = page_info;
+	prefetch->task.page = page;
+	prefetch->task.key = vy_entry_none();
+	prefetch->task.iterator_type = ITER_GE;
+	prefetch->task.cmp_def = itr->cmp_def;
+	prefetch->task.format = itr->format;
+	prefetch->task.pos_in_page = 0;
+	prefetch->task.equal_found = false;
+	prefetch->page_no = page_no;
+	prefetch->part = NULL;
+	if (!vy_run_part_is_resident(part)) {
+		vy_run_part_pin(part);
+		prefetch->part = part;
+	}
+	vy_run_ref(run);
+	prefetch->is_done = false;
+	prefetch->is_failed = false;
+	prefetch->is_orphan = false;
+	fiber_cond_create(&prefetch->done_cond);
+	fiber_start(fiber, prefetch);
+	return prefetch;
+}
+
+/**
+ * Read ahead pages following the given one in the iteration
+ * direction so that there are up to itr->readahead pages in
+ * the prefetch list. Readahead is best effort: if a page can't
+ * be read ahead, it will be read on demand.
+ */
+static void
+vy_run_iterator_readahead(struct vy_run_iterator *itr, uint32_t page_no)
+{
+	struct vy_slice *slice = itr->slice;
+	/* Don't bother during local recovery, reads are blocking. */
+	if (slice->run->env->reader_pool == NULL)
+		return;
+	int dir = iterator_direction(itr->iterator_type);
+	int64_t next_page_no = (int64_t)page_no + dir;
+	if (!rlist_empty(&itr->prefetch)) {
+		struct vy_page_prefetch *last = rlist_last_entry(&itr->prefetch,
+					struct vy_page_prefetch, in_itr);
+		next_page_no = (int64_t)last->page_no + dir;
+	}
+	while (itr->prefetch_count < itr->readahead &&
+	       next_page_no >= slice->first_page_no &&
+	       next_page_no <= slice->last_page_no) {
+		struct vy_page_prefetch *prefetch;
+		prefetch = vy_page_prefetch_new(itr, next_page_no);
+		if (prefetch == NULL)
+			break;
+		rlist_add_tail_entry(&itr->prefetch, prefetch, in_itr);
+		itr->prefetch_count++;
+		itr->stat->readahead.pages++;
+		next_page_no += dir;
+	}
+}
+
+/**
+ * Take a page from the prefetch list of a run iterator, waiting
+ * for the read to complete if necessary. Pages preceding the
+ * requested one in the iteration order are dropped, because the
+ * iterator isn't going to need them. If the page isn't in the
+ * list or failed to load, @result is set to NULL.
+ *
+ * @retval 0 success
+ * @retval -1 the fiber was cancelled while waiting
+ */
+static NODISCARD int
+vy_run_iterator_take_prefetched(struct vy_run_iterator *itr,
+				uint32_t page_no, struct vy_page **result)
+{
+	*result = NULL;
+	int dir = iterator_direction(itr->iterator_type);
+	struct vy_page_prefetch *prefetch, *tmp;
+	rlist_foreach_entry_safe(prefetch, &itr->prefetch, in_itr, tmp) {
+		if (dir * ((int64_t)prefetch->page_no - page_no) >= 0)
+			break;
+		vy_run_iterator_drop_prefetch(itr, prefetch);
+	}
+	if (rlist_empty(&itr->prefetch))
+		return 0;
+	prefetch = rlist_first_entry(&itr->prefetch,
+				     struct vy_page_prefetch, in_itr);
+	if (prefetch->page_no != page_no)
+		return 0;
+	while (!prefetch->is_done) {
+		if (fiber_cond_wait(&prefetch->done_cond) != 0)
+			return -1;
+	}
+	if (!prefetch->is_failed) {
+		/*
+		 * Update read statistics. Note, the page index
+		 * partition is pinned by the prefetch entry so
+		 * page_info is still valid.
+		 */
+		struct vy_page_info *page_info = prefetch->task.page_info;
+		itr->stat->read.rows += page_info->row_count;
+		itr->stat->read.bytes += page_info->unpacked_size;
+		itr->stat->read.bytes_compressed += page_info->size;
+		itr->stat->read.pages++;
+		itr->stat->readahead.used++;
+		*result = prefetch->task.page;
+		prefetch->task.page = NULL;
+	}
+	vy_run_iterator_drop_prefetch(itr, prefetch);
+	return 0;
+}
+
+/**
+ * Read a page from disk given its number. Optionally, look up
+ * a key in the page, see vy_page_find_key().
  *
  * @retval 0 success
  * @retval -1 critical error
  */
 static NODISCARD int
-vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
+vy_run_iterator_read_page(struct vy_run_iterator *itr, uint32_t page_no,
 			  struct vy_entry key, enum iterator_type iterator_type,
 			  struct vy_page **result, uint32_t *pos_in_page,
 			  bool *equal_found)
@@ -1011,28 +2065,11 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 	struct vy_slice *slice = itr->slice;
 	struct vy_run_env *env = slice->run->env;
 
-	/* Check cache */
-	struct vy_page *page = NULL;
-	if (itr->curr_page != NULL &&
-	    itr->curr_page->page_no == page_no) {
-		page = itr->curr_page;
-	} else if (itr->prev_page != NULL &&
-		   itr->prev_page->page_no == page_no) {
-		SWAP(itr->prev_page, itr->curr_page);
-		page = itr->curr_page;
-	}
-	if (page != NULL) {
-		if (key.stmt != NULL)
-			*pos_in_page = vy_page_find_key(page, key, itr->cmp_def,
-							itr->format, iterator_type,
-							equal_found);
-		*result = page;
-		return 0;
-	}
-
 	/* Allocate buffers */
-	struct vy_page_info *page_info = vy_run_page_info(slice->run, page_no);
-	page = vy_page_new(page_info);
+	struct vy_page_info *page_info;
+	if (vy_run_iterator_page_info(itr, page_no, &page_info) != 0)
+		return -1;
+	struct vy_page *page = vy_page_new(page_info);
 	if (page == NULL)
 		return -1;
 
@@ -1064,19 +2101,89 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		vy_page_delete(page);
 		return -1;
 	}
+	page->page_no = page_no;
+
+	/*
+	 * Update read statistics. Note, the page index partition
+	 * is pinned by the iterator so page_info is still valid.
+	 */
+	itr->stat->read.rows += page_info->row_count;
+	itr->stat->read.bytes += page_info->unpacked_size;
+	itr->stat->read.bytes_compressed += page_info->size;
+	itr->stat->read.pages++;
+
+	*result = page;
+	return 0;
+}
+
+/**
+ * Load a page given its number.
+ * The function caches two most recently read pages.
+ *
+ * If the page follows the last page loaded by the iterator in
+ * the iteration order, the function also starts reading ahead
+ * the next pages, see vy_run_iterator_readahead().
+ *
+ * @retval 0 success
+ * @retval -1 critical error
+ */
+static NODISCARD int
+vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
+			  struct vy_entry key, enum iterator_type iterator_type,
+			  struct vy_page **result, uint32_t *pos_in_page,
+			  bool *equal_found)
+{
+	/* Check cache */
+	struct vy_page *page = NULL;
+	if (itr->curr_page != NULL &&
+	    itr->curr_page->page_no == page_no) {
+		page = itr->curr_page;
+	} else if (itr->prev_page != NULL &&
+		   itr->prev_page->page_no == page_no) {
+		SWAP(itr->prev_page, itr->curr_page);
+		page = itr->curr_page;
+	}
+	if (page != NULL) {
+		if (key.stmt != NULL)
+			*pos_in_page = vy_page_find_key(page, key, itr->cmp_def,
+							itr->format, iterator_type,
+							equal_found);
+		*result = page;
+		return 0;
+	}
+
+	/* Check if the iterator reads pages one after another. */
+	bool is_sequential = false;
+	if (itr->readahead > 0) {
+		int dir = iterator_direction(itr->iterator_type);
+		is_sequential = itr->curr_page != NULL &&
+			(int64_t)itr->curr_page->page_no + dir == page_no;
+		if (!is_sequential)
+			vy_run_iterator_drop_readahead(itr);
+	}
+
+	/* Check pages read ahead */
+	if (vy_run_iterator_take_prefetched(itr, page_no, &page) != 0)
+		return -1;
+	if (page != NULL) {
+		if (key.stmt != NULL)
+			*pos_in_page = vy_page_find_key(page, key, itr->cmp_def,
+							itr->format, iterator_type,
+							equal_found);
+	} else if (vy_run_iterator_read_page(itr, page_no, key, iterator_type,
+					     &page, pos_in_page,
+					     equal_found) != 0) {
+		return -1;
+	}
 
 	/* Update cache */
 	if (itr->prev_page != NULL)
 		vy_page_delete(itr->prev_page);
 	itr->prev_page = itr->curr_page;
 	itr->curr_page = page;
-	page->page_no = page_no;
 
-	/* Update read statistics. */
-	itr->stat->read.rows += page_info->row_count;
-	itr->stat->read.bytes += page_info->unpacked_size;
-	itr->stat->read.bytes_compressed += page_info->size;
-	itr->stat->read.pages++;
+	if (is_sequential)
+		vy_run_iterator_readahead(itr, page_no);
 
 	*result = page;
 	return 0;
@@ -1125,9 +2232,11 @@ vy_run_iterator_search(struct vy_run_iterator *itr,
 		       enum iterator_type iterator_type, struct vy_entry key,
 		       struct vy_run_iterator_pos *pos, bool *equal_key)
 {
-	pos->page_no = vy_page_index_find_page(itr->slice->run, key,
-					       itr->cmp_def, iterator_type,
-					       equal_key);
+	if (vy_page_index_find_page(itr->slice->run, key, itr->cmp_def,
+				    iterator_type,
+				    vy_run_iterator_load_part_cb, itr,
+				    &pos->page_no, equal_key) != 0)
+		return -1;
 	if (pos->page_no == itr->slice->run->info.page_count)
 		return 1;
 	bool equal_in_page;
@@ -1151,6 +2260,7 @@ vy_run_iterator_search(struct vy_run_iterator *itr,
  * wide position.
  * @retval 0 success, set *pos to new value
  * @retval 1 EOF
+ * @retval -1 failed to load page index partition
  * Affects: curr_loaded_page
  */
 static NODISCARD int
@@ -1159,6 +2269,7 @@ vy_run_iterator_next_pos(struct vy_run_iterator *itr,
 			 struct vy_run_iterator_pos *pos)
 {
 	struct vy_run *run = itr->slice->run;
+	struct vy_page_info *page_info;
 	*pos = itr->curr_pos;
 	if (iterator_type == ITER_LE || iterator_type == ITER_LT) {
 		assert(pos->page_no <= run->info.page_count);
@@ -1168,8 +2279,9 @@ vy_run_iterator_next_pos(struct vy_run_iterator *itr,
 			if (pos->page_no == 0)
 				return 1;
 			pos->page_no--;
-			struct vy_page_info *page_info =
-				vy_run_page_info(run, pos->page_no);
+			if (vy_run_iterator_page_info(itr, pos->page_no,
+						      &page_info) != 0)
+				return -1;
 			assert(page_info->row_count > 0);
 			pos->pos_in_page = page_info->row_count - 1;
 		}
@@ -1177,8 +2289,9 @@ vy_run_iterator_next_pos(struct vy_run_iterator *itr,
 		assert(iterator_type == ITER_GE || iterator_type == ITER_GT ||
 		       iterator_type == ITER_EQ);
 		assert(pos->page_no < run->info.page_count);
-		struct vy_page_info *page_info =
-			vy_run_page_info(run, pos->page_no);
+		if (vy_run_iterator_page_info(itr, pos->page_no,
+					      &page_info) != 0)
+			return -1;
 		assert(page_info->row_count > 0);
 		pos->pos_in_page++;
 		if (pos->pos_in_page >= page_info->row_count) {
@@ -1212,10 +2325,14 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr, struct vy_entry *ret)
 	assert(itr->curr.stmt != NULL);
 	assert(itr->curr_pos.page_no < slice->run->info.page_count);
 
+	int rc;
 	while (vy_stmt_lsn(itr->curr.stmt) > (**itr->read_view).vlsn ||
 	       vy_stmt_flags(itr->curr.stmt) & VY_STMT_SKIP_READ) {
-		if (vy_run_iterator_next_pos(itr, itr->iterator_type,
-					     &itr->curr_pos) != 0) {
+		rc = vy_run_iterator_next_pos(itr, itr->iterator_type,
+					      &itr->curr_pos);
+		if (rc < 0)
+			return -1;
+		if (rc > 0) {
 			vy_run_iterator_stop(itr);
 			return 0;
 		}
@@ -1231,8 +2348,8 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr, struct vy_entry *ret)
 	}
 	if (itr->iterator_type == ITER_LE || itr->iterator_type == ITER_LT) {
 		struct vy_run_iterator_pos test_pos;
-		while (vy_run_iterator_next_pos(itr, itr->iterator_type,
-						&test_pos) == 0) {
+		while ((rc = vy_run_iterator_next_pos(itr, itr->iterator_type,
+						      &test_pos)) == 0) {
 			struct vy_entry test;
 			if (vy_run_iterator_read(itr, test_pos, &test) != 0)
 				return -1;
@@ -1246,6 +2363,8 @@ vy_run_iterator_find_lsn(struct vy_run_iterator *itr, struct vy_entry *ret)
 			itr->curr = test;
 			itr->curr_pos = test_pos;
 		}
+		if (rc < 0)
+			return -1;
 	}
 	/* Check if the result is within the slice boundaries. */
 	if (itr->iterator_type == ITER_LE || itr->iterator_type == ITER_LT) {
@@ -1330,6 +2449,45 @@ vy_run_iterator_do_seek(struct vy_run_iterator *itr,
 	}
 }
 
+/**
+ * Find the bloom filter that should be checked for the key
+ * of an EQ iterator. The bloom filter is set to NULL if the
+ * key is known to be present in the run.
+ *
+ * @retval 0 success
+ * @retval -1 failed to load page index partition
+ */
+static NODISCARD int
+vy_run_iterator_find_bloom(struct vy_run_iterator *itr,
+			   struct tuple_bloom **bloom)
+{
+	struct vy_run *run = itr->slice->run;
+	*bloom = NULL;
+	if (!vy_run_is_partitioned(run)) {
+		*bloom = run->parts[0].bloom;
+		return 0;
+	}
+	/*
+	 * Statements matching the key can only be stored in the
+	 * partition preceding the first partition with min key
+	 * greater than or equal to the key. If the min key of
+	 * a partition is equal to the key, the key is definitely
+	 * present in the run and there's no need to check the
+	 * bloom filter.
+	 */
+	bool equal_key = false;
+	uint32_t part_no = vy_run_find_part(run, itr->key, itr->cmp_def,
+					    true, &equal_key);
+	if (equal_key)
+		return 0;
+	if (part_no > 0)
+		part_no--;
+	if (vy_run_iterator_pin_part(itr, part_no) != 0)
+		return -1;
+	*bloom = run->parts[part_no].bloom;
+	return 0;
+}
+
 /**
  * Position the iterator to the first statement satisfying
  * the iterator search criteria and following the given key
@@ -1341,7 +2499,6 @@ vy_run_iterator_seek(struct vy_run_iterator *itr, struct vy_entry last,
 {
 	struct key_def *cmp_def = itr->cmp_def;
 	struct vy_slice *slice = itr->slice;
-	struct tuple_bloom *bloom = slice->run->info.bloom;
 	struct vy_entry key = itr->key;
 	enum iterator_type iterator_type = itr->iterator_type;
 
@@ -1350,11 +2507,18 @@ vy_run_iterator_seek(struct vy_run_iterator *itr, struct vy_entry last,
 
 	/* Check the bloom filter on the first iteration. */
 	bool check_bloom = (itr->iterator_type == ITER_EQ &&
-			    itr->curr.stmt == NULL && bloom != NULL);
-	if (check_bloom && !vy_bloom_maybe_has(bloom, itr->key, itr->key_def)) {
-		vy_run_iterator_stop(itr);
-		itr->stat->bloom_hit++;
-		return 0;
+			    itr->curr.stmt == NULL &&
+			    vy_run_bloom_size(slice->run) > 0);
+	if (check_bloom) {
+		struct tuple_bloom *bloom;
+		if (vy_run_iterator_find_bloom(itr, &bloom) != 0)
+			return -1;
+		if (bloom != NULL &&
+		    !vy_bloom_maybe_has(bloom, itr->key, itr->key_def)) {
+			vy_run_iterator_stop(itr);
+			itr->stat->bloom_hit++;
+			return 0;
+		}
 	}
 
 	/*
@@ -1482,6 +2646,10 @@ vy_run_iterator_open(struct vy_run_iterator *itr,
 	itr->curr_pos.page_no = slice->run->info.page_count;
 	itr->curr_page = NULL;
 	itr->prev_page = NULL;
+	itr->curr_part = NULL;
+	itr->readahead = 0;
+	rlist_create(&itr->prefetch);
+	itr->prefetch_count = 0;
 	itr->search_started = false;
 
 	/*
@@ -1518,8 +2686,11 @@ vy_run_iterator_next_key(struct vy_run_iterator *itr, struct vy_entry *ret)
 	do {
 		if (next.stmt != NULL)
 			tuple_unref(next.stmt);
-		if (vy_run_iterator_next_pos(itr, itr->iterator_type,
-					     &itr->curr_pos) != 0) {
+		int rc = vy_run_iterator_next_pos(itr, itr->iterator_type,
+						  &itr->curr_pos);
+		if (rc < 0)
+			return -1;
+		if (rc > 0) {
 			vy_run_iterator_stop(itr);
 			return 0;
 		}
@@ -1554,8 +2725,12 @@ vy_run_iterator_next_lsn(struct vy_run_iterator *itr, struct vy_entry *ret)
 	assert(itr->curr_pos.page_no < itr->slice->run->info.page_count);
 
 	struct vy_run_iterator_pos next_pos;
+	int rc;
 next:
-	if (vy_run_iterator_next_pos(itr, ITER_GE, &next_pos) != 0) {
+	rc = vy_run_iterator_next_pos(itr, ITER_GE, &next_pos);
+	if (rc < 0)
+		return -1;
+	if (rc > 0) {
 		vy_run_iterator_stop(itr);
 		return 0;
 	}
@@ -1580,6 +2755,40 @@ next:
 	return 0;
 }
 
+/** vy_blob_fd_f callback used by the run iterator. */
+static int
+vy_run_iterator_blob_fd_cb(void *arg, int64_t run_id)
+{
+	struct vy_run *run = arg;
+	int fd = vy_run_blob_fd(run, run_id);
+	if (fd < 0) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Blob file of run %lld not found",
+				    (long long)run_id));
+	}
+	return fd;
+}
+
+/**
+ * Append a statement read from a run to a key history.
+ * If the statement has references to values stored in blob
+ * files, resolve them first, see vy_blob.h.
+ */
+static NODISCARD int
+vy_run_iterator_append(struct vy_run_iterator *itr,
+		       struct vy_history *history, struct vy_entry entry)
+{
+	if ((vy_stmt_flags(entry.stmt) & VY_STMT_BLOB) == 0)
+		return vy_history_append_stmt(history, entry);
+	entry.stmt = vy_blob_resolve(entry.stmt, vy_run_iterator_blob_fd_cb,
+				     itr->slice->run);
+	if (entry.stmt == NULL)
+		return -1;
+	int rc = vy_history_append_stmt(history, entry);
+	tuple_unref(entry.stmt);
+	return rc;
+}
+
 NODISCARD int
 vy_run_iterator_next(struct vy_run_iterator *itr,
 		     struct vy_history *history)
@@ -1589,7 +2798,7 @@ vy_run_iterator_next(struct vy_run_iterator *itr,
 	if (vy_run_iterator_next_key(itr, &entry) != 0)
 		return -1;
 	while (entry.stmt != NULL) {
-		if (vy_history_append_stmt(history, entry) != 0)
+		if (vy_run_iterator_append(itr, history, entry) != 0)
 			return -1;
 		if (vy_history_is_terminal(history))
 			break;
@@ -1621,7 +2830,7 @@ vy_run_iterator_skip(struct vy_run_iterator *itr, struct vy_entry last,
 		return -1;
 
 	while (entry.stmt != NULL) {
-		if (vy_history_append_stmt(history, entry) != 0)
+		if (vy_run_iterator_append(itr, history, entry) != 0)
 			return -1;
 		if (vy_history_is_terminal(history))
 			break;
@@ -1641,18 +2850,214 @@ vy_run_iterator_close(struct vy_run_iterator *itr)
 
 /* }}} vy_run_iterator API implementation */
 
-/** Account a page to run statistics. */
+/** Account a page to run and partition statistics. */
 static void
-vy_run_acct_page(struct vy_run *run, struct vy_page_info *page)
+vy_run_acct_page(struct vy_run *run, struct vy_run_part *part,
+		 struct vy_page_info *page)
 {
 	const char *min_key_end = page->min_key;
 	mp_next(&min_key_end);
-	run->page_index_size += sizeof(struct vy_page_info);
-	run->page_index_size += min_key_end - page->min_key;
+	size_t page_index_size = sizeof(struct vy_page_info) +
+				 (min_key_end - page->min_key);
+	run->page_index_size += page_index_size;
 	run->count.rows += page->row_count;
 	run->count.bytes += page->unpacked_size;
 	run->count.bytes_compressed += page->size;
 	run->count.pages++;
+	part->page_index_size += page_index_size;
+	part->count.rows += page->row_count;
+	part->count.bytes += page->unpacked_size;
+	part->count.bytes_compressed += page->size;
+	part->count.pages++;
+}
+
+/** Account a page index partition directory entry to run statistics. */
+static void
+vy_run_acct_part_info(struct vy_run *run, struct vy_run_part *part)
+{
+	const char *min_key_end = part->min_key;
+	mp_next(&min_key_end);
+	run->part_index_size += sizeof(struct vy_run_part) +
+				(min_key_end - part->min_key);
+	run->bloom_size += part->bloom_size;
+}
+
+/**
+ * Load the page index and the bloom filter of a run that isn't
+ * partitioned from the index file.
+ */
+static int
+vy_run_recover_page_index(struct vy_run *run, struct xlog_cursor *cursor,
+			  struct tuple_bloom *bloom, struct key_def *cmp_def,
+			  const char *path)
+{
+	assert(run->part_count == 1);
+	struct vy_run_part *part = &run->parts[0];
+	part->bloom = bloom;
+	part->bloom_size = bloom != NULL ? tuple_bloom_size(bloom) : 0;
+	run->bloom_size = part->bloom_size;
+
+	/* Allocate buffer for page info. */
+	part->page_info = calloc(run->info.page_count,
+				 sizeof(struct vy_page_info));
+	if (part->page_info == NULL) {
+		diag_set(OutOfMemory,
+			 run->info.page_count * sizeof(struct vy_page_info),
+			 "malloc", "struct vy_page_info");
+		return -1;
+	}
+
+	struct xrow_header xrow;
+	for (uint32_t page_no = 0; page_no < run->info.page_count; page_no++) {
+		int rc = xlog_cursor_next_row(cursor, &xrow);
+		if (rc != 0) {
+			if (rc > 0) {
+				/** To few pages in file */
+				diag_set(ClientError, ER_INVALID_INDEX_FILE,
+					 path, "Unexpected end of file");
+			}
+			return -1;
+		}
+		if (xrow.type != VY_INDEX_PAGE_INFO) {
+			diag_set(ClientError, ER_INVALID_INDEX_FILE, path,
+				 tt_sprintf("Wrong xrow type "
+					    "(expected %d, got %u)",
+					    VY_INDEX_PAGE_INFO,
+					    (unsigned)xrow.type));
+			return -1;
+		}
+		struct vy_page_info *page = part->page_info + page_no;
+		/*
+		 * Account the page to the partition before decoding
+		 * so that it's freed on failure.
+		 */
+		part->page_count++;
+		if (vy_page_info_decode(page, &xrow, cmp_def, path) < 0)
+			return -1;
+		vy_run_acct_page(run, part, page);
+	}
+	part->min_key = vy_key_dup(part->page_info[0].min_key);
+	if (part->min_key == NULL)
+		return -1;
+	part->min_key_hint = part->page_info[0].min_key_hint;
+	return 0;
+}
+
+/**
+ * Load the directory of page index partitions of a partitioned
+ * run from the index file.
+ */
+static int
+vy_run_recover_part_index(struct vy_run *run, struct xlog_cursor *cursor,
+			  struct key_def *cmp_def, const char *path)
+{
+	uint32_t page_count = 0;
+	struct xrow_header xrow;
+	for (uint32_t part_no = 0; part_no < run->part_count; part_no++) {
+		int rc = xlog_cursor_next_row(cursor, &xrow);
+		if (rc != 0) {
+			if (rc > 0) {
+				diag_set(ClientError, ER_INVALID_INDEX_FILE,
+					 path, "Unexpected end of file");
+			}
+			return -1;
+		}
+		if (xrow.type != VY_INDEX_PART_INFO) {
+			diag_set(ClientError, ER_INVALID_INDEX_FILE, path,
+				 tt_sprintf("Wrong xrow type "
+					    "(expected %d, got %u)",
+					    VY_INDEX_PART_INFO,
+					    (unsigned)xrow.type));
+			return -1;
+		}
+		struct vy_run_part *part = &run->parts[part_no];
+		if (vy_part_info_decode(part, &xrow, cmp_def, path) != 0)
+			return -1;
+		part->first_page_no = page_count;
+		page_count += part->page_count;
+		vy_run_acct_part_info(run, part);
+		vy_disk_stmt_counter_add(&run->count, &part->count);
+		run->page_index_size += part->page_index_size;
+	}
+	if (page_count != run->info.page_count) {
+		diag_set(ClientError, ER_INVALID_INDEX_FILE, path,
+			 tt_sprintf("Wrong page count (expected %u, got %u)",
+				    (unsigned)run->info.page_count,
+				    (unsigned)page_count));
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Set the run creation time to the modification time of the run
+ * file, which is never modified after it has been written.
+ */
+static void
+vy_run_recover_create_time(struct vy_run *run)
+{
+	struct stat st;
+	if (fstat(run->fd, &st) == 0)
+		run->create_time = st.st_mtime;
+	else
+		run->create_time = fiber_time();
+}
+
+/**
+ * Digest the compression dictionary of a run, if any.
+ */
+static int
+vy_run_create_ddict(struct vy_run *run)
+{
+	assert(run->zddict == NULL);
+	if (run->info.dict_size == 0)
+		return 0;
+	run->zddict = ZSTD_createDDict(run->info.dict, run->info.dict_size);
+	if (run->zddict == NULL) {
+		diag_set(OutOfMemory, run->info.dict_size,
+			 "ZSTD_createDDict", "zstd dictionary");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Open the blob file written along with a run, if any.
+ */
+static int
+vy_run_open_blob(struct vy_run *run, const char *dir,
+		 uint32_t space_id, uint32_t iid)
+{
+	assert(run->blob_fd < 0);
+	uint32_t i;
+	for (i = 0; i < run->info.blob_id_count; i++) {
+		if (run->info.blob_ids[i] == run->id)
+			break;
+	}
+	if (i == run->info.blob_id_count)
+		return 0; /* no blob file */
+	char path[PATH_MAX];
+	vy_run_snprint_path(path, sizeof(path), dir,
+			    space_id, iid, run->id, VY_FILE_BLOB);
+	run->blob_fd = open(path, O_RDONLY);
+	if (run->blob_fd < 0) {
+		diag_set(SystemError, "failed to open '%s' file", path);
+		return -1;
+	}
+	return 0;
+}
+
+int
+vy_run_blob_fd(struct vy_run *run, int64_t run_id)
+{
+	if (run->id == run_id && run->blob_fd >= 0)
+		return run->blob_fd;
+	for (int i = 0; i < run->blob_run_count; i++) {
+		struct vy_run *blob_run = run->blob_runs[i];
+		if (blob_run->id == run_id && blob_run->blob_fd >= 0)
+			return blob_run->blob_fd;
+	}
+	return -1;
 }
 
 int
@@ -1704,57 +3109,48 @@ vy_run_recover(struct vy_run *run, const char *dir,
 		goto fail_close;
 	}
 
-	if (vy_run_info_decode(&run->info, &xrow, path) != 0)
-		goto fail_close;
-
-	/* Allocate buffer for page info. */
-	run->page_info = calloc(run->info.page_count,
-				      sizeof(struct vy_page_info));
-	if (run->page_info == NULL) {
-		diag_set(OutOfMemory,
-			 run->info.page_count * sizeof(struct vy_page_info),
-			 "malloc", "struct vy_page_info");
+	struct tuple_bloom *bloom;
+	if (vy_run_info_decode(&run->info, &bloom, &xrow, path) != 0) {
+		if (bloom != NULL)
+			tuple_bloom_delete(bloom);
 		goto fail_close;
 	}
 
-	for (uint32_t page_no = 0; page_no < run->info.page_count; page_no++) {
-		int rc = xlog_cursor_next_row(&cursor, &xrow);
-		if (rc != 0) {
-			if (rc > 0) {
-				/** To few pages in file */
-				diag_set(ClientError, ER_INVALID_INDEX_FILE,
-					 path, "Unexpected end of file");
-			}
-			/*
-			 * Limit the count of pages to
-			 * successfully created pages.
-			 */
-			run->info.page_count = page_no;
-			goto fail_close;
-		}
-		if (xrow.type != VY_INDEX_PAGE_INFO) {
-			diag_set(ClientError, ER_INVALID_INDEX_FILE,
-				 tt_sprintf("Wrong xrow type "
-					    "(expected %d, got %u)",
-					    VY_INDEX_PAGE_INFO,
-					    (unsigned)xrow.type));
+	if (vy_run_is_partitioned(run)) {
+		/*
+		 * The page index and the bloom filter are stored in
+		 * the run file and loaded on demand.
+		 */
+		if (bloom != NULL)
+			tuple_bloom_delete(bloom);
+		if (vy_run_alloc_parts(run, run->info.part_count) != 0 ||
+		    vy_run_recover_part_index(run, &cursor,
+					      cmp_def, path) != 0)
 			goto fail_close;
-		}
-		struct vy_page_info *page = run->page_info + page_no;
-		if (vy_page_info_decode(page, &xrow, cmp_def, path) < 0) {
-			/**
-			 * Limit the count of pages to successfully
-			 * created pages
-			 */
-			run->info.page_count = page_no;
+	} else if (run->info.page_count > 0) {
+		if (vy_run_alloc_parts(run, 1) != 0) {
+			if (bloom != NULL)
+				tuple_bloom_delete(bloom);
 			goto fail_close;
 		}
-		vy_run_acct_page(run, page);
+		if (vy_run_recover_page_index(run, &cursor, bloom,
+					      cmp_def, path) != 0)
+			goto fail_close;
+	} else if (bloom != NULL) {
+		tuple_bloom_delete(bloom);
 	}
 
 	/* We don't need to keep metadata file open any longer. */
 	xlog_cursor_close(&cursor, false);
 
+	if (vy_run_create_ddict(run) != 0)
+		goto fail;
+	if (vy_run_open_blob(run, dir, space_id, iid) != 0) {
+		vy_run_snprint_path(path, sizeof(path), dir, space_id,
+				    iid, run->id, VY_FILE_BLOB);
+		goto fail;
+	}
+
 	/* Prepare data file for reading. */
 	vy_run_snprint_path(path, sizeof(path), dir,
 			    space_id, iid, run->id, VY_FILE_RUN);
@@ -1768,6 +3164,7 @@ vy_run_recover(struct vy_run *run, const char *dir,
 	}
 	run->fd = cursor.fd;
 	xlog_cursor_close(&cursor, true);
+	vy_run_recover_create_time(run);
 	return 0;
 
 fail_close:
@@ -1783,14 +3180,14 @@ fail:
 static int
 vy_run_dump_stmt(struct vy_entry entry, struct xlog *data_xlog,
 		 struct vy_page_info *info, struct key_def *key_def,
-		 bool is_primary)
+		 bool is_primary, uint64_t covers)
 {
 	struct xrow_header xrow;
 	int rc = (is_primary ?
 		  vy_stmt_encode_primary(entry.stmt, key_def, 0, &xrow) :
 		  vy_stmt_encode_secondary(entry.stmt, key_def,
 					   vy_entry_multikey_idx(entry, key_def),
-					   &xrow));
+					   covers, &xrow));
 	if (rc != 0)
 		return -1;
 
@@ -1840,21 +3237,22 @@ vy_row_index_encode(const uint32_t *row_index, uint32_t row_count,
 }
 
 /**
- * Helper to extend run page info array
+ * Helper to extend the page info array of a page index partition.
  */
 static inline int
-vy_run_alloc_page_info(struct vy_run *run, uint32_t *page_info_capacity)
+vy_run_part_alloc_page_info(struct vy_run_part *part,
+			    uint32_t *page_info_capacity)
 {
 	uint32_t cap = *page_info_capacity > 0 ?
 		       *page_info_capacity * 2 : 16;
-	struct vy_page_info *page_info = realloc(run->page_info,
+	struct vy_page_info *page_info = realloc(part->page_info,
 					cap * sizeof(*page_info));
 	if (page_info == NULL) {
 		diag_set(OutOfMemory, cap * sizeof(*page_info),
 			 "realloc", "struct vy_page_info");
 		return -1;
 	}
-	run->page_info = page_info;
+	part->page_info = page_info;
 	*page_info_capacity = cap;
 	return 0;
 }
@@ -1932,6 +3330,130 @@ vy_page_info_encode(const struct vy_page_info *page_info,
 
 /** vy_page_info }}} */
 
+/** {{{ vy_run_part */
+
+/**
+ * Encode a page index partition directory entry as xrow.
+ * Allocates using region_alloc.
+ *
+ * @param part partition to encode
+ * @param[out] xrow xrow to fill
+ *
+ * @retval  0 success
+ * @retval -1 error, check diag
+ */
+static int
+vy_part_info_encode(const struct vy_run_part *part, struct xrow_header *xrow)
+{
+	const char *tmp = part->min_key;
+	assert(mp_typeof(*tmp) == MP_ARRAY);
+	mp_next(&tmp);
+	uint32_t min_key_size = tmp - part->min_key;
+
+	size_t size = mp_sizeof_map(10) +
+		mp_sizeof_uint(VY_PART_INFO_OFFSET) +
+		mp_sizeof_uint(part->offset) +
+		mp_sizeof_uint(VY_PART_INFO_SIZE) +
+		mp_sizeof_uint(part->size) +
+		mp_sizeof_uint(VY_PART_INFO_UNPACKED_SIZE) +
+		mp_sizeof_uint(part->unpacked_size) +
+		mp_sizeof_uint(VY_PART_INFO_PAGE_COUNT) +
+		mp_sizeof_uint(part->page_count) +
+		mp_sizeof_uint(VY_PART_INFO_MIN_KEY) + min_key_size +
+		mp_sizeof_uint(VY_PART_INFO_ROW_COUNT) +
+		mp_sizeof_uint(part->count.rows) +
+		mp_sizeof_uint(VY_PART_INFO_BYTES) +
+		mp_sizeof_uint(part->count.bytes) +
+		mp_sizeof_uint(VY_PART_INFO_BYTES_COMPRESSED) +
+		mp_sizeof_uint(part->count.bytes_compressed) +
+		mp_sizeof_uint(VY_PART_INFO_INDEX_SIZE) +
+		mp_sizeof_uint(part->page_index_size) +
+		mp_sizeof_uint(VY_PART_INFO_BLOOM_SIZE) +
+		mp_sizeof_uint(part->bloom_size);
+
+	char *pos = region_alloc(&fiber()->gc, size);
+	if (pos == NULL) {
+		diag_set(OutOfMemory, size, "region", "partition encode");
+		return -1;
+	}
+	memset(xrow, 0, sizeof(*xrow));
+	xrow->body->iov_base = pos;
+	pos = mp_encode_map(pos, 10);
+	pos = mp_encode_uint(pos, VY_PART_INFO_OFFSET);
+	pos = mp_encode_uint(pos, part->offset);
+	pos = mp_encode_uint(pos, VY_PART_INFO_SIZE);
+	pos = mp_encode_uint(pos, part->size);
+	pos = mp_encode_uint(pos, VY_PART_INFO_UNPACKED_SIZE);
+	pos = mp_encode_uint(pos, part->unpacked_size);
+	pos = mp_encode_uint(pos, VY_PART_INFO_PAGE_COUNT);
+	pos = mp_encode_uint(pos, part->page_count);
+	pos = mp_encode_uint(pos, VY_PART_INFO_MIN_KEY);
+	memcpy(pos, part->min_key, min_key_size);
+	pos += min_key_size;
+	pos = mp_encode_uint(pos, VY_PART_INFO_ROW_COUNT);
+	pos = mp_encode_uint(pos, part->count.rows);
+	pos = mp_encode_uint(pos, VY_PART_INFO_BYTES);
+	pos = mp_encode_uint(pos, part->count.bytes);
+	pos = mp_encode_uint(pos, VY_PART_INFO_BYTES_COMPRESSED);
+	pos = mp_encode_uint(pos, part->count.bytes_compressed);
+	pos = mp_encode_uint(pos, VY_PART_INFO_INDEX_SIZE);
+	pos = mp_encode_uint(pos, part->page_index_size);
+	pos = mp_encode_uint(pos, VY_PART_INFO_BLOOM_SIZE);
+	pos = mp_encode_uint(pos, part->bloom_size);
+	xrow->body->iov_len = (void *)pos - xrow->body->iov_base;
+	xrow->bodycnt = 1;
+	xrow->type = VY_INDEX_PART_INFO;
+	return 0;
+}
+
+/**
+ * Encode the header of a page index partition stored in the run
+ * file as xrow. Allocates using region_alloc.
+ *
+ * @param part partition to encode
+ * @param bloom partition bloom filter or NULL
+ * @param[out] xrow xrow to fill
+ *
+ * @retval  0 success
+ * @retval -1 error, check diag
+ */
+static int
+vy_part_header_encode(const struct vy_run_part *part,
+		      const struct tuple_bloom *bloom,
+		      struct xrow_header *xrow)
+{
+	uint32_t key_count = 1;
+	size_t size = mp_sizeof_uint(VY_PART_INFO_PAGE_COUNT) +
+		      mp_sizeof_uint(part->page_count);
+	if (bloom != NULL) {
+		key_count++;
+		size += mp_sizeof_uint(VY_PART_INFO_BLOOM) +
+			tuple_bloom_size(bloom);
+	}
+	size += mp_sizeof_map(key_count);
+
+	char *pos = region_alloc(&fiber()->gc, size);
+	if (pos == NULL) {
+		diag_set(OutOfMemory, size, "region", "partition encode");
+		return -1;
+	}
+	memset(xrow, 0, sizeof(*xrow));
+	xrow->body->iov_base = pos;
+	pos = mp_encode_map(pos, key_count);
+	pos = mp_encode_uint(pos, VY_PART_INFO_PAGE_COUNT);
+	pos = mp_encode_uint(pos, part->page_count);
+	if (bloom != NULL) {
+		pos = mp_encode_uint(pos, VY_PART_INFO_BLOOM);
+		pos = tuple_bloom_encode(bloom, pos);
+	}
+	xrow->body->iov_len = (void *)pos - xrow->body->iov_base;
+	xrow->bodycnt = 1;
+	xrow->type = VY_INDEX_PART_INFO;
+	return 0;
+}
+
+/** vy_run_part }}} */
+
 /** {{{ vy_run_info */
 
 /** Return the size of encoded statement statistics. */
@@ -1970,6 +3492,7 @@ vy_stmt_stat_encode(const struct vy_stmt_stat *stat, char *buf)
  * Allocates using region alloc
  *
  * @param run_info the run information
+ * @param bloom the run bloom filter or NULL
  * @param xrow xrow to fill.
  *
  * @retval  0 success
@@ -1977,6 +3500,7 @@ vy_stmt_stat_encode(const struct vy_stmt_stat *stat, char *buf)
  */
 static int
 vy_run_info_encode(const struct vy_run_info *run_info,
+		   const struct tuple_bloom *bloom,
 		   struct xrow_header *xrow)
 {
 	const char *tmp;
@@ -1988,7 +3512,13 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	size_t max_key_size = tmp - run_info->max_key;
 
 	uint32_t key_count = 6;
-	if (run_info->bloom != NULL)
+	if (bloom != NULL)
+		key_count++;
+	if (run_info->part_count > 0)
+		key_count++;
+	if (run_info->blob_id_count > 0)
+		key_count++;
+	if (run_info->dict_size > 0)
 		key_count++;
 
 	size_t size = mp_sizeof_map(key_count);
@@ -2000,11 +3530,23 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 		mp_sizeof_uint(run_info->max_lsn);
 	size += mp_sizeof_uint(VY_RUN_INFO_PAGE_COUNT) +
 		mp_sizeof_uint(run_info->page_count);
-	if (run_info->bloom != NULL)
+	if (bloom != NULL)
 		size += mp_sizeof_uint(VY_RUN_INFO_BLOOM) +
-			tuple_bloom_size(run_info->bloom);
+			tuple_bloom_size(bloom);
+	if (run_info->part_count > 0)
+		size += mp_sizeof_uint(VY_RUN_INFO_PART_COUNT) +
+			mp_sizeof_uint(run_info->part_count);
 	size += mp_sizeof_uint(VY_RUN_INFO_STMT_STAT) +
 		vy_stmt_stat_sizeof(&run_info->stmt_stat);
+	if (run_info->blob_id_count > 0) {
+		size += mp_sizeof_uint(VY_RUN_INFO_BLOBS) +
+			mp_sizeof_array(run_info->blob_id_count);
+		for (uint32_t i = 0; i < run_info->blob_id_count; i++)
+			size += mp_sizeof_uint(run_info->blob_ids[i]);
+	}
+	if (run_info->dict_size > 0)
+		size += mp_sizeof_uint(VY_RUN_INFO_DICT) +
+			mp_sizeof_bin(run_info->dict_size);
 
 	char *pos = region_alloc(&fiber()->gc, size);
 	if (pos == NULL) {
@@ -2027,12 +3569,26 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	pos = mp_encode_uint(pos, run_info->max_lsn);
 	pos = mp_encode_uint(pos, VY_RUN_INFO_PAGE_COUNT);
 	pos = mp_encode_uint(pos, run_info->page_count);
-	if (run_info->bloom != NULL) {
+	if (bloom != NULL) {
 		pos = mp_encode_uint(pos, VY_RUN_INFO_BLOOM);
-		pos = tuple_bloom_encode(run_info->bloom, pos);
+		pos = tuple_bloom_encode(bloom, pos);
+	}
+	if (run_info->part_count > 0) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_PART_COUNT);
+		pos = mp_encode_uint(pos, run_info->part_count);
 	}
 	pos = mp_encode_uint(pos, VY_RUN_INFO_STMT_STAT);
 	pos = vy_stmt_stat_encode(&run_info->stmt_stat, pos);
+	if (run_info->blob_id_count > 0) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_BLOBS);
+		pos = mp_encode_array(pos, run_info->blob_id_count);
+		for (uint32_t i = 0; i < run_info->blob_id_count; i++)
+			pos = mp_encode_uint(pos, run_info->blob_ids[i]);
+	}
+	if (run_info->dict_size > 0) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_DICT);
+		pos = mp_encode_bin(pos, run_info->dict, run_info->dict_size);
+	}
 	xrow->body->iov_len = (void *)pos - xrow->body->iov_base;
 	xrow->bodycnt = 1;
 	xrow->type = VY_INDEX_RUN_INFO;
@@ -2069,17 +3625,38 @@ vy_run_write_index(struct vy_run *run, const char *dirpath,
 	size_t mem_used = region_used(region);
 
 	struct xrow_header xrow;
-	if (vy_run_info_encode(&run->info, &xrow) != 0 ||
-	    xlog_write_row(&index_xlog, &xrow) < 0)
-		goto fail_rollback;
-
-	for (uint32_t page_no = 0; page_no < run->info.page_count; ++page_no) {
-		struct vy_page_info *page_info = vy_run_page_info(run, page_no);
-		if (vy_page_info_encode(page_info, &xrow) < 0) {
+	if (vy_run_is_partitioned(run)) {
+		/*
+		 * Page index and bloom filter partitions are stored
+		 * in the run file so we only need to write the
+		 * partition directory here.
+		 */
+		if (vy_run_info_encode(&run->info, NULL, &xrow) != 0 ||
+		    xlog_write_row(&index_xlog, &xrow) < 0)
 			goto fail_rollback;
+		for (uint32_t part_no = 0; part_no < run->part_count;
+		     ++part_no) {
+			struct vy_run_part *part = &run->parts[part_no];
+			if (vy_part_info_encode(part, &xrow) != 0 ||
+			    xlog_write_row(&index_xlog, &xrow) < 0)
+				goto fail_rollback;
 		}
-		if (xlog_write_row(&index_xlog, &xrow) < 0)
+	} else {
+		struct vy_run_part *part = run->part_count > 0 ?
+					   &run->parts[0] : NULL;
+		struct tuple_bloom *bloom = part != NULL ? part->bloom : NULL;
+		if (vy_run_info_encode(&run->info, bloom, &xrow) != 0 ||
+		    xlog_write_row(&index_xlog, &xrow) < 0)
 			goto fail_rollback;
+		for (uint32_t page_no = 0; page_no < run->info.page_count;
+		     ++page_no) {
+			struct vy_page_info *page_info = &part->page_info[page_no];
+			if (vy_page_info_encode(page_info, &xrow) < 0) {
+				goto fail_rollback;
+			}
+			if (xlog_write_row(&index_xlog, &xrow) < 0)
+				goto fail_rollback;
+		}
 	}
 
 	region_truncate(region, mem_used);
@@ -2112,7 +3689,9 @@ int
 vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		     const char *dirpath, uint32_t space_id, uint32_t iid,
 		     struct key_def *cmp_def, struct key_def *key_def,
-		     uint64_t page_size, double bloom_fpr, bool no_compression)
+		     uint64_t page_size, uint32_t blob_threshold,
+		     uint64_t covers, double bloom_fpr,
+		     int compression_level, uint32_t dict_size)
 {
 	memset(writer, 0, sizeof(*writer));
 	writer->run = run;
@@ -2122,8 +3701,12 @@ vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 	writer->cmp_def = cmp_def;
 	writer->key_def = key_def;
 	writer->page_size = page_size;
+	/* Secondary index runs store only keys. */
+	writer->blob_threshold = iid == 0 ? blob_threshold : 0;
+	writer->covers = iid > 0 ? covers : 0;
 	writer->bloom_fpr = bloom_fpr;
-	writer->no_compression = no_compression;
+	writer->compression_level = compression_level;
+	writer->dict_size = compression_level > 0 ? dict_size : 0;
 	if (bloom_fpr < 1) {
 		writer->bloom = tuple_bloom_builder_new(key_def->part_count);
 		if (writer->bloom == NULL)
@@ -2132,9 +3715,14 @@ vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 	xlog_clear(&writer->data_xlog);
 	ibuf_create(&writer->row_index_buf, &cord()->slabc,
 		    4096 * sizeof(uint32_t));
+	char path[PATH_MAX];
+	vy_run_snprint_path(path, sizeof(path), dirpath,
+			    space_id, iid, run->id, VY_FILE_BLOB);
+	vy_blob_writer_create(&writer->blob, path, run->id);
 	run->info.min_lsn = INT64_MAX;
 	run->info.max_lsn = -1;
-	assert(run->page_info == NULL);
+	run->create_time = fiber_time();
+	assert(run->parts == NULL);
 	return 0;
 }
 
@@ -2159,12 +3747,118 @@ vy_run_writer_create_xlog(struct vy_run_writer *writer)
 	struct xlog_opts opts = xlog_opts_default;
 	opts.rate_limit = writer->run->env->snap_io_rate_limit;
 	opts.sync_interval = VY_RUN_SYNC_INTERVAL;
-	opts.no_compression = writer->no_compression;
+	opts.no_compression = writer->compression_level == 0;
+	opts.compression_level = writer->compression_level;
+	opts.zcdict = writer->zcdict;
 	if (xlog_create(&writer->data_xlog, path, 0, &meta, &opts) != 0)
 		return -1;
 	return 0;
 }
 
+/**
+ * Append a new page index partition to a run being written.
+ * @param writer Run writer.
+ *
+ * @retval NULL Memory error.
+ * @retval Pointer to the new partition.
+ */
+static struct vy_run_part *
+vy_run_writer_add_part(struct vy_run_writer *writer)
+{
+	struct vy_run *run = writer->run;
+	if (run->part_count >= writer->part_capacity) {
+		uint32_t cap = writer->part_capacity > 0 ?
+			       writer->part_capacity * 2 : 4;
+		struct vy_run_part *parts = realloc(run->parts,
+						    cap * sizeof(*parts));
+		if (parts == NULL) {
+			diag_set(OutOfMemory, cap * sizeof(*parts),
+				 "realloc", "struct vy_run_part");
+			return NULL;
+		}
+		run->parts = parts;
+		writer->part_capacity = cap;
+		/* List links are invalidated by realloc. */
+		for (uint32_t i = 0; i < run->part_count; i++)
+			rlist_create(&run->parts[i].in_lru);
+	}
+	struct vy_run_part *part = &run->parts[run->part_count++];
+	memset(part, 0, sizeof(*part));
+	part->run = run;
+	part->first_page_no = run->info.page_count;
+	rlist_create(&part->in_lru);
+	writer->page_info_capacity = 0;
+	return part;
+}
+
+/**
+ * Write the page index and the bloom filter of a complete page
+ * index partition to the run file and free them.
+ * @param writer Run writer.
+ * @param part Partition to write.
+ *
+ * @retval -1 Memory or IO error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_write_part(struct vy_run_writer *writer,
+			 struct vy_run_part *part)
+{
+	assert(part->page_count > 0);
+	assert(ibuf_used(&writer->row_index_buf) == 0);
+	int rc = -1;
+	struct tuple_bloom *bloom = NULL;
+	if (writer->bloom != NULL) {
+		bloom = tuple_bloom_new(writer->bloom, writer->bloom_fpr);
+		if (bloom == NULL)
+			return -1;
+		part->bloom_size = tuple_bloom_size(bloom);
+		/* Start a new bloom filter for the next partition. */
+		tuple_bloom_builder_delete(writer->bloom);
+		writer->bloom = tuple_bloom_builder_new(
+					writer->key_def->part_count);
+		if (writer->bloom == NULL)
+			goto out;
+	}
+	part->offset = writer->data_xlog.offset;
+	xlog_tx_begin(&writer->data_xlog);
+
+	struct xrow_header xrow;
+	ssize_t written;
+	if (vy_part_header_encode(part, bloom, &xrow) != 0)
+		goto rollback;
+	written = xlog_write_row(&writer->data_xlog, &xrow);
+	if (written < 0)
+		goto rollback;
+	part->unpacked_size = written;
+	for (uint32_t page_no = 0; page_no < part->page_count; page_no++) {
+		if (vy_page_info_encode(&part->page_info[page_no], &xrow) != 0)
+			goto rollback;
+		written = xlog_write_row(&writer->data_xlog, &xrow);
+		if (written < 0)
+			goto rollback;
+		part->unpacked_size += written;
+	}
+	written = xlog_tx_commit(&writer->data_xlog);
+	if (written == 0)
+		written = xlog_flush(&writer->data_xlog);
+	if (written < 0)
+		goto out;
+	part->size = written;
+	vy_run_acct_part_info(writer->run, part);
+	vy_page_index_delete(part->page_info, part->page_count);
+	part->page_info = NULL;
+	writer->page_info_capacity = 0;
+	rc = 0;
+out:
+	if (bloom != NULL)
+		tuple_bloom_delete(bloom);
+	return rc;
+rollback:
+	xlog_tx_rollback(&writer->data_xlog);
+	goto out;
+}
+
 /**
  * Start a new page with a min_key stored in @a first_entry.
  * @param writer Run writer.
@@ -2178,8 +3872,20 @@ vy_run_writer_start_page(struct vy_run_writer *writer,
 			 struct vy_entry first_entry)
 {
 	struct vy_run *run = writer->run;
-	if (run->info.page_count >= writer->page_info_capacity &&
-	    vy_run_alloc_page_info(run, &writer->page_info_capacity) != 0)
+	struct vy_run_part *part = run->part_count > 0 ?
+			&run->parts[run->part_count - 1] : NULL;
+	if (part != NULL && part->page_count >= VY_RUN_PART_PAGE_COUNT) {
+		if (vy_run_writer_write_part(writer, part) != 0)
+			return -1;
+		part = NULL;
+	}
+	if (part == NULL) {
+		part = vy_run_writer_add_part(writer);
+		if (part == NULL)
+			return -1;
+	}
+	if (part->page_count >= writer->page_info_capacity &&
+	    vy_run_part_alloc_page_info(part, &writer->page_info_capacity) != 0)
 		return -1;
 	const char *key = vy_stmt_is_key(first_entry.stmt) ?
 			  tuple_data(first_entry.stmt) :
@@ -2195,10 +3901,18 @@ vy_run_writer_start_page(struct vy_run_writer *writer,
 		if (run->info.min_key == NULL)
 			return -1;
 	}
-	struct vy_page_info *page = run->page_info + run->info.page_count;
+	if (part->page_count == 0) {
+		assert(part->min_key == NULL);
+		part->min_key = vy_key_dup(key);
+		if (part->min_key == NULL)
+			return -1;
+	}
+	struct vy_page_info *page = part->page_info + part->page_count;
 	if (vy_page_info_create(page, writer->data_xlog.offset,
 				key, writer->cmp_def) != 0)
 		return -1;
+	if (part->page_count == 0)
+		part->min_key_hint = page->min_key_hint;
 	xlog_tx_begin(&writer->data_xlog);
 	return 0;
 }
@@ -2222,7 +3936,8 @@ vy_run_writer_write_to_page(struct vy_run_writer *writer, struct vy_entry entry)
 	writer->last = entry;
 	vy_stmt_ref_if_possible(entry.stmt);
 	struct vy_run *run = writer->run;
-	struct vy_page_info *page = run->page_info + run->info.page_count;
+	struct vy_run_part *part = &run->parts[run->part_count - 1];
+	struct vy_page_info *page = part->page_info + part->page_count;
 	uint32_t *offset = (uint32_t *)ibuf_alloc(&writer->row_index_buf,
 						  sizeof(uint32_t));
 	if (offset == NULL) {
@@ -2231,7 +3946,8 @@ vy_run_writer_write_to_page(struct vy_run_writer *writer, struct vy_entry entry)
 	}
 	*offset = page->unpacked_size;
 	if (vy_run_dump_stmt(entry, &writer->data_xlog, page,
-			     writer->cmp_def, writer->iid == 0) != 0)
+			     writer->cmp_def, writer->iid == 0,
+			     writer->covers) != 0)
 		return -1;
 	int64_t lsn = vy_stmt_lsn(entry.stmt);
 	run->info.min_lsn = MIN(run->info.min_lsn, lsn);
@@ -2250,7 +3966,8 @@ static int
 vy_run_writer_end_page(struct vy_run_writer *writer)
 {
 	struct vy_run *run = writer->run;
-	struct vy_page_info *page = run->page_info + run->info.page_count;
+	struct vy_run_part *part = &run->parts[run->part_count - 1];
+	struct vy_page_info *page = part->page_info + part->page_count;
 
 	assert(page->row_count > 0);
 	assert(ibuf_used(&writer->row_index_buf) ==
@@ -2272,30 +3989,190 @@ vy_run_writer_end_page(struct vy_run_writer *writer)
 	if (written < 0)
 		return -1;
 	page->size = written;
+	part->page_count++;
 	run->info.page_count++;
-	vy_run_acct_page(run, page);
+	vy_run_acct_page(run, part, page);
 	ibuf_reset(&writer->row_index_buf);
 	return 0;
 }
 
-int
-vy_run_writer_append_stmt(struct vy_run_writer *writer, struct vy_entry entry)
+/**
+ * Write a statement to the run file.
+ * @param writer Run writer.
+ * @param entry Statement to write.
+ *
+ * @retval -1 Memory or IO error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_write_stmt(struct vy_run_writer *writer, struct vy_entry entry)
 {
-	int rc = -1;
-	size_t region_svp = region_used(&fiber()->gc);
 	if (!xlog_is_open(&writer->data_xlog) &&
 	    vy_run_writer_create_xlog(writer) != 0)
-		goto out;
+		return -1;
 	if (ibuf_used(&writer->row_index_buf) == 0 &&
 	    vy_run_writer_start_page(writer, entry) != 0)
-		goto out;
+		return -1;
 	if (vy_run_writer_write_to_page(writer, entry) != 0)
-		goto out;
+		return -1;
 	if (obuf_size(&writer->data_xlog.obuf) >= writer->page_size &&
 	    vy_run_writer_end_page(writer) != 0)
+		return -1;
+	return 0;
+}
+
+/**
+ * Train a compression dictionary on the statements buffered
+ * by a run writer. If there isn't enough data to train the
+ * dictionary on, the run is compressed without a dictionary.
+ * @param writer Run writer.
+ * @param dict_size Max size of the dictionary.
+ *
+ * @retval -1 Memory error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_train_dict(struct vy_run_writer *writer, uint32_t dict_size)
+{
+	int rc = -1;
+	uint32_t count = writer->sample_count;
+	char *samples = malloc(writer->sample_size);
+	size_t *sample_sizes = malloc(count * sizeof(*sample_sizes));
+	char *dict = malloc(dict_size);
+	if (samples == NULL || sample_sizes == NULL || dict == NULL) {
+		diag_set(OutOfMemory, writer->sample_size, "malloc",
+			 "zstd dictionary samples");
 		goto out;
+	}
+	char *pos = samples;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t size;
+		const char *data = tuple_data_range(writer->samples[i].stmt,
+						    &size);
+		memcpy(pos, data, size);
+		pos += size;
+		sample_sizes[i] = size;
+	}
+	size_t size = ZDICT_trainFromBuffer(dict, dict_size, samples,
+					    sample_sizes, count);
+	if (ZDICT_isError(size)) {
+		say_verbose("failed to train zstd dictionary for run %lld: %s",
+			    (long long)writer->run->id,
+			    ZDICT_getErrorName(size));
+		rc = 0;
+		goto out;
+	}
+	writer->zcdict = ZSTD_createCDict(dict, size,
+					  writer->compression_level);
+	if (writer->zcdict == NULL) {
+		diag_set(OutOfMemory, size, "ZSTD_createCDict",
+			 "zstd dictionary");
+		goto out;
+	}
+	struct vy_run *run = writer->run;
+	assert(run->info.dict == NULL);
+	run->info.dict = dict;
+	run->info.dict_size = size;
+	dict = NULL;
 	rc = 0;
 out:
+	free(samples);
+	free(sample_sizes);
+	free(dict);
+	return rc;
+}
+
+/**
+ * Train the compression dictionary and write the statements
+ * buffered for training to the run file.
+ * @param writer Run writer.
+ *
+ * @retval -1 Memory or IO error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_flush_samples(struct vy_run_writer *writer)
+{
+	uint32_t dict_size = writer->dict_size;
+	assert(dict_size > 0);
+	writer->dict_size = 0;
+	if (writer->sample_count > 0 &&
+	    vy_run_writer_train_dict(writer, dict_size) != 0)
+		return -1;
+	for (uint32_t i = 0; i < writer->sample_count; i++) {
+		struct vy_entry *sample = &writer->samples[i];
+		if (vy_run_writer_write_stmt(writer, *sample) != 0)
+			return -1;
+		tuple_unref(sample->stmt);
+		*sample = vy_entry_none();
+	}
+	return 0;
+}
+
+/**
+ * Buffer a statement for training the compression dictionary.
+ * Once enough statements have been buffered, train the dictionary
+ * and write them to the run file.
+ * @param writer Run writer.
+ * @param entry Statement to buffer.
+ *
+ * @retval -1 Memory or IO error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_add_sample(struct vy_run_writer *writer, struct vy_entry entry)
+{
+	if (writer->sample_count == writer->sample_capacity) {
+		uint32_t capacity = MAX(writer->sample_capacity * 2, 64);
+		struct vy_entry *samples = realloc(writer->samples,
+					capacity * sizeof(*samples));
+		if (samples == NULL) {
+			diag_set(OutOfMemory, capacity * sizeof(*samples),
+				 "realloc", "struct vy_entry");
+			return -1;
+		}
+		writer->samples = samples;
+		writer->sample_capacity = capacity;
+	}
+	if (vy_stmt_is_refable(entry.stmt)) {
+		tuple_ref(entry.stmt);
+	} else {
+		entry.stmt = vy_stmt_dup(entry.stmt);
+		if (entry.stmt == NULL)
+			return -1;
+	}
+	writer->samples[writer->sample_count++] = entry;
+	writer->sample_size += entry.stmt->bsize;
+	size_t sample_size_max = MIN((size_t)writer->dict_size *
+				     VY_RUN_DICT_SAMPLE_RATIO,
+				     (size_t)VY_RUN_DICT_SAMPLE_SIZE_MAX);
+	if (writer->sample_size < sample_size_max)
+		return 0;
+	return vy_run_writer_flush_samples(writer);
+}
+
+int
+vy_run_writer_append_stmt(struct vy_run_writer *writer, struct vy_entry entry)
+{
+	int rc = -1;
+	size_t region_svp = region_used(&fiber()->gc);
+	struct tuple *stmt = entry.stmt;
+	enum iproto_type type = vy_stmt_type(stmt);
+	if (writer->iid == 0 &&
+	    (type == IPROTO_REPLACE || type == IPROTO_INSERT)) {
+		/* Key fields aren't touched so the hint is still valid. */
+		entry.stmt = vy_blob_writer_separate(&writer->blob, stmt,
+						     writer->blob_threshold);
+		if (entry.stmt == NULL)
+			goto out;
+	}
+	if (writer->dict_size > 0)
+		rc = vy_run_writer_add_sample(writer, entry);
+	else
+		rc = vy_run_writer_write_stmt(writer, entry);
+out:
+	if (entry.stmt != NULL && entry.stmt != stmt)
+		tuple_unref(entry.stmt);
 	region_truncate(&fiber()->gc, region_svp);
 	return rc;
 }
@@ -2316,6 +4193,13 @@ vy_run_writer_destroy(struct vy_run_writer *writer, bool reuse_fd)
 	if (writer->bloom != NULL)
 		tuple_bloom_builder_delete(writer->bloom);
 	ibuf_destroy(&writer->row_index_buf);
+	vy_blob_writer_destroy(&writer->blob);
+	for (uint32_t i = 0; i < writer->sample_count; i++) {
+		if (writer->samples[i].stmt != NULL)
+			tuple_unref(writer->samples[i].stmt);
+	}
+	free(writer->samples);
+	ZSTD_freeCDict(writer->zcdict);
 }
 
 int
@@ -2324,6 +4208,10 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 	int rc = -1;
 	size_t region_svp = region_used(&fiber()->gc);
 
+	if (writer->dict_size > 0 &&
+	    vy_run_writer_flush_samples(writer) != 0)
+		goto out;
+
 	if (ibuf_used(&writer->row_index_buf) != 0 &&
 	    vy_run_writer_end_page(writer) != 0)
 		goto out;
@@ -2350,6 +4238,18 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 	if (run->info.max_key == NULL)
 		goto out;
 
+	if (run->part_count > 1) {
+		/*
+		 * The run doesn't fit in one page index partition.
+		 * Store the last partition in the run file, like
+		 * all the others, so that it can be loaded on demand.
+		 */
+		struct vy_run_part *part = &run->parts[run->part_count - 1];
+		if (vy_run_writer_write_part(writer, part) != 0)
+			goto out;
+		run->info.part_count = run->part_count;
+	}
+
 	ERROR_INJECT(ERRINJ_VY_RUN_FILE_RENAME, {
 		diag_set(ClientError, ER_INJECTION, "vinyl run file rename");
 		goto out;
@@ -2360,17 +4260,32 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 	    xlog_rename(&writer->data_xlog) < 0)
 		goto out;
 
-	if (writer->bloom != NULL) {
-		run->info.bloom = tuple_bloom_new(writer->bloom,
-						  writer->bloom_fpr);
-		if (run->info.bloom == NULL)
+	/* Do the same for the blob file, if any. */
+	if (vy_blob_writer_commit(&writer->blob) != 0)
+		goto out;
+	assert(run->info.blob_ids == NULL);
+	run->info.blob_ids = writer->blob.ids;
+	run->info.blob_id_count = writer->blob.id_count;
+	writer->blob.ids = NULL;
+
+	if (!vy_run_is_partitioned(run) && writer->bloom != NULL) {
+		struct vy_run_part *part = &run->parts[0];
+		part->bloom = tuple_bloom_new(writer->bloom,
+					      writer->bloom_fpr);
+		if (part->bloom == NULL)
 			goto out;
+		part->bloom_size = tuple_bloom_size(part->bloom);
+		run->bloom_size = part->bloom_size;
 	}
 	if (vy_run_write_index(run, writer->dirpath,
 			       writer->space_id, writer->iid) != 0)
 		goto out;
+	if (vy_run_create_ddict(run) != 0)
+		goto out;
 
 	run->fd = writer->data_xlog.fd;
+	run->blob_fd = writer->blob.fd;
+	writer->blob.fd = -1;
 	vy_run_writer_destroy(writer, true);
 	rc = 0;
 out:
@@ -2390,8 +4305,7 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		     struct key_def *cmp_def, struct key_def *key_def,
 		     struct tuple_format *format, const struct index_opts *opts)
 {
-	assert(run->info.bloom == NULL);
-	assert(run->page_info == NULL);
+	assert(run->parts == NULL);
 	struct region *region = &fiber()->gc;
 	size_t mem_used = region_used(region);
 
@@ -2413,6 +4327,14 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 	struct tuple *prev_tuple = NULL;
 	char *page_min_key = NULL;
 
+	/*
+	 * The blob writer is only used for collecting ids of
+	 * referenced blob files, no values are moved with the
+	 * threshold set to 0.
+	 */
+	struct vy_blob_writer blob;
+	vy_blob_writer_create(&blob, path, run->id);
+
 	struct tuple_bloom_builder *bloom_builder = NULL;
 	if (opts->bloom_fpr < 1) {
 		bloom_builder = tuple_bloom_builder_new(key_def->part_count);
@@ -2426,15 +4348,27 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		page_offset = next_page_offset;
 		next_page_offset = xlog_cursor_pos(&cursor);
 
-		if (run->info.page_count == page_info_capacity &&
-		    vy_run_alloc_page_info(run, &page_info_capacity) != 0)
+		if (run->parts == NULL && vy_run_alloc_parts(run, 1) != 0)
+			goto close_err;
+		struct vy_run_part *part = &run->parts[0];
+		if (part->page_count == page_info_capacity &&
+		    vy_run_part_alloc_page_info(part, &page_info_capacity) != 0)
 			goto close_err;
 		uint32_t page_row_count = 0;
 		uint64_t page_row_index_offset = 0;
 		uint64_t row_offset = xlog_cursor_tx_pos(&cursor);
 
 		struct xrow_header xrow;
+		bool is_part_info = false;
 		while ((rc = xlog_cursor_next_row(&cursor, &xrow)) == 0) {
+			if (xrow.type == VY_INDEX_PART_INFO) {
+				/*
+				 * Page index partition stored in the run
+				 * file. It is rebuilt from scratch.
+				 */
+				is_part_info = true;
+				break;
+			}
 			if (xrow.type == VY_RUN_ROW_INDEX) {
 				page_row_index_offset = row_offset;
 				row_offset = xlog_cursor_tx_pos(&cursor);
@@ -2444,6 +4378,11 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 			struct tuple *tuple = vy_stmt_decode(&xrow, format);
 			if (tuple == NULL)
 				goto close_err;
+			if ((vy_stmt_flags(tuple) & VY_STMT_BLOB) != 0 &&
+			    vy_blob_writer_separate(&blob, tuple, 0) == NULL) {
+				tuple_unref(tuple);
+				goto close_err;
+			}
 			if (bloom_builder != NULL) {
 				struct vy_entry entry = {tuple, HINT_NONE};
 				if (vy_bloom_builder_add(bloom_builder, entry,
@@ -2476,8 +4415,10 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 				min_lsn = xrow.lsn;
 			row_offset = xlog_cursor_tx_pos(&cursor);
 		}
+		if (is_part_info)
+			continue;
 		struct vy_page_info *info;
-		info = run->page_info + run->info.page_count;
+		info = part->page_info + part->page_count;
 		if (vy_page_info_create(info, page_offset,
 					page_min_key, cmp_def) != 0)
 			goto close_err;
@@ -2485,8 +4426,17 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		info->size = next_page_offset - page_offset;
 		info->unpacked_size = xlog_cursor_tx_pos(&cursor);
 		info->row_index_offset = page_row_index_offset;
+		if (part->page_count == 0) {
+			part->min_key = vy_key_dup(page_min_key);
+			if (part->min_key == NULL) {
+				vy_page_info_destroy(info);
+				goto close_err;
+			}
+			part->min_key_hint = info->min_key_hint;
+		}
+		++part->page_count;
 		++run->info.page_count;
-		vy_run_acct_page(run, info);
+		vy_run_acct_page(run, part, info);
 
 		free(page_min_key);
 		page_min_key = NULL;
@@ -2499,6 +4449,11 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 	}
 	run->info.max_lsn = max_lsn;
 	run->info.min_lsn = min_lsn;
+	run->info.blob_ids = blob.ids;
+	run->info.blob_id_count = blob.id_count;
+	blob.ids = NULL;
+	if (vy_run_open_blob(run, dir, space_id, iid) != 0)
+		goto close_err;
 
 	if (prev_tuple != NULL) {
 		tuple_unref(prev_tuple);
@@ -2507,12 +4462,15 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 	region_truncate(region, mem_used);
 	run->fd = cursor.fd;
 	xlog_cursor_close(&cursor, true);
+	vy_run_recover_create_time(run);
 
-	if (bloom_builder != NULL) {
-		run->info.bloom = tuple_bloom_new(bloom_builder,
-						  opts->bloom_fpr);
-		if (run->info.bloom == NULL)
+	if (bloom_builder != NULL && run->parts != NULL) {
+		struct vy_run_part *part = &run->parts[0];
+		part->bloom = tuple_bloom_new(bloom_builder, opts->bloom_fpr);
+		if (part->bloom == NULL)
 			goto close_err;
+		part->bloom_size = tuple_bloom_size(part->bloom);
+		run->bloom_size = part->bloom_size;
 		tuple_bloom_builder_delete(bloom_builder);
 		bloom_builder = NULL;
 	}
@@ -2527,8 +4485,10 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 	}
 	if (vy_run_write_index(run, dir, space_id, iid) != 0)
 		goto close_err;
+	vy_blob_writer_destroy(&blob);
 	return 0;
 close_err:
+	vy_blob_writer_destroy(&blob);
 	vy_run_clear(run);
 	region_truncate(region, mem_used);
 	if (prev_tuple != NULL)
@@ -2565,6 +4525,53 @@ vy_run_remove_files(const char *dir, uint32_t space_id,
 	return ret;
 }
 
+/**
+ * Free the page index partition loaded by a slice stream.
+ */
+static void
+vy_slice_stream_unload_part(struct vy_slice_stream *stream)
+{
+	if (stream->part_page_info == NULL)
+		return;
+	struct vy_run *run = stream->slice->run;
+	vy_page_index_delete(stream->part_page_info,
+			     run->parts[stream->part_no].page_count);
+	stream->part_page_info = NULL;
+}
+
+/**
+ * Page index loader for vy_page_index_find_page() used by slice
+ * stream. Since the stream is used from a worker thread, it can't
+ * use page index partitions loaded by tx, so it reads partitions
+ * of a partitioned run on its own, keeping only the last one.
+ */
+static int
+vy_slice_stream_load_part_cb(void *arg, uint32_t part_no,
+			     struct vy_page_info **page_info)
+{
+	struct vy_slice_stream *stream = arg;
+	struct vy_run *run = stream->slice->run;
+	struct vy_run_part *part = &run->parts[part_no];
+	if (vy_run_part_is_resident(part)) {
+		*page_info = part->page_info;
+		return 0;
+	}
+	if (stream->part_page_info == NULL || stream->part_no != part_no) {
+		ZSTD_DStream *zdctx = vy_env_get_zdctx(run->env);
+		if (zdctx == NULL)
+			return -1;
+		struct vy_page_info *pages;
+		if (vy_run_part_read(part, stream->cmp_def, zdctx,
+				     &pages, NULL) != 0)
+			return -1;
+		vy_slice_stream_unload_part(stream);
+		stream->part_no = part_no;
+		stream->part_page_info = pages;
+	}
+	*page_info = stream->part_page_info;
+	return 0;
+}
+
 /**
  * Read a page with stream->page_no from the run and save it in stream->page.
  * Support function of slice stream.
@@ -2581,7 +4588,11 @@ vy_slice_stream_read_page(struct vy_slice_stream *stream)
 	if (zdctx == NULL)
 		return -1;
 
-	struct vy_page_info *page_info = vy_run_page_info(run, stream->page_no);
+	uint32_t part_no = vy_run_page_part_no(run, stream->page_no);
+	struct vy_page_info *page_info;
+	if (vy_slice_stream_load_part_cb(stream, part_no, &page_info) != 0)
+		return -1;
+	page_info += stream->page_no - run->parts[part_no].first_page_no;
 	stream->page = vy_page_new(page_info);
 	if (stream->page == NULL)
 		return -1;
@@ -2613,10 +4624,19 @@ vy_slice_stream_search(struct vy_stmt_stream *virt_stream)
 		return 0;
 	}
 
+	/*
+	 * Slices of a partitioned run are rounded to partition
+	 * boundaries so we need to look up the first page.
+	 */
+	bool unused;
+	if (vy_page_index_find_page(stream->slice->run, stream->slice->begin,
+				    stream->cmp_def, ITER_GE,
+				    vy_slice_stream_load_part_cb, stream,
+				    &stream->page_no, &unused) != 0)
+		return -1;
 	if (vy_slice_stream_read_page(stream) != 0)
 		return -1;
 
-	bool unused;
 	stream->pos_in_page = vy_page_find_key(stream->page,
 					       stream->slice->begin,
 					       stream->cmp_def,
@@ -2663,7 +4683,7 @@ vy_slice_stream_next(struct vy_stmt_stream *virt_stream, struct vy_entry *ret)
 
 	/* Check that the tuple is not out of slice bounds = */
 	if (stream->slice->end.stmt != NULL &&
-	    stream->page_no >= stream->slice->last_page_no &&
+	    stream->page_no >= stream->check_end_page_no &&
 	    vy_entry_compare(entry, stream->slice->end, stream->cmp_def) >= 0) {
 		tuple_unref(entry.stmt);
 		return 0;
@@ -2679,9 +4699,7 @@ vy_slice_stream_next(struct vy_stmt_stream *virt_stream, struct vy_entry *ret)
 	stream->pos_in_page++;
 
 	/* Check whether the position is out of page */
-	struct vy_page_info *page_info = vy_run_page_info(stream->slice->run,
-							  stream->page_no);
-	if (stream->pos_in_page >= page_info->row_count) {
+	if (stream->pos_in_page >= stream->page->row_count) {
 		/**
 		 * Out of page. Free page, move the position to the next page
 		 * and * nullify page pointer to read it on the next iteration.
@@ -2711,6 +4729,7 @@ vy_slice_stream_stop(struct vy_stmt_stream *virt_stream)
 		tuple_unref(stream->entry.stmt);
 		stream->entry = vy_entry_none();
 	}
+	vy_slice_stream_unload_part(stream);
 }
 
 static void
@@ -2738,6 +4757,20 @@ vy_slice_stream_open(struct vy_slice_stream *stream, struct vy_slice *slice,
 	stream->pos_in_page = 0; /* We'll find it later */
 	stream->page = NULL;
 	stream->entry = vy_entry_none();
+	stream->part_no = 0;
+	stream->part_page_info = NULL;
+	/*
+	 * The last page of a slice of a partitioned run is rounded
+	 * to the partition boundary so the slice end may be in any
+	 * page of the last partition.
+	 */
+	stream->check_end_page_no = slice->last_page_no;
+	if (vy_run_is_partitioned(slice->run)) {
+		struct vy_run *run = slice->run;
+		uint32_t part_no = vy_run_page_part_no(run,
+						       slice->last_page_no);
+		stream->check_end_page_no = run->parts[part_no].first_page_no;
+	}
 
 	stream->slice = slice;
 	stream->cmp_def = cmp_def;
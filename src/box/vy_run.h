@@ -40,6 +40,7 @@
 #include "vy_stmt_stream.h"
 #include "vy_read_view.h"
 #include "vy_stat.h"
+#include "vy_blob.h"
 #include "index_def.h"
 #include "xlog.h"
 
@@ -69,6 +70,22 @@ struct vy_run_env {
 	 * processing the next read request.
 	 */
 	int next_reader;
+	/** Mempool for struct vy_part_read_task */
+	struct mempool part_read_task_pool;
+	/** Mempool for struct vy_page_prefetch */
+	struct mempool prefetch_pool;
+	/**
+	 * Page index partitions that are loaded, but not used
+	 * by any iterator, in LRU order. Evicted when the size
+	 * of loaded partitions exceeds the quota.
+	 */
+	struct rlist part_lru;
+	/** Max size of memory used for loaded partitions. */
+	size_t part_cache_quota;
+	/** Size of memory used for page index of loaded partitions. */
+	size_t part_page_index_size;
+	/** Size of memory used for bloom filters of loaded partitions. */
+	size_t part_bloom_size;
 };
 
 /**
@@ -85,10 +102,30 @@ struct vy_run_info {
 	int64_t max_lsn;
 	/** Number of pages in the run. */
 	uint32_t page_count;
-	/** Bloom filter of all tuples in run */
-	struct tuple_bloom *bloom;
+	/**
+	 * Number of page index partitions stored in the run
+	 * file or 0 if the page index and the bloom filter are
+	 * stored in the index file.
+	 */
+	uint32_t part_count;
 	/** Statement statistics. */
 	struct vy_stmt_stat stmt_stat;
+	/**
+	 * IDs of runs whose blob files are referenced by
+	 * statements stored in the run, see vy_blob.h.
+	 * Includes the id of the run itself if it has
+	 * a blob file.
+	 */
+	int64_t *blob_ids;
+	/** Number of entries in the blob_ids array. */
+	uint32_t blob_id_count;
+	/**
+	 * Zstd dictionary pages of the run are compressed with
+	 * or NULL if the run doesn't use a dictionary.
+	 */
+	char *dict;
+	/** Size of the dictionary. */
+	uint32_t dict_size;
 };
 
 /**
@@ -111,6 +148,75 @@ struct vy_page_info {
 	uint32_t row_index_offset;
 };
 
+/**
+ * A partition of a run page index.
+ *
+ * A big run may have a page index and a bloom filter that take
+ * too much memory to be kept loaded all the time. So the writer
+ * splits them into partitions, VY_RUN_PART_PAGE_COUNT pages
+ * each, and stores each partition in the run file right after
+ * its last page, while the index file only stores a directory
+ * of partitions. Partitions are loaded on demand and evicted
+ * in LRU order when they aren't used by any iterator.
+ *
+ * A small run (and a run written by an older version) stores
+ * its page index and bloom filter in the index file. Such a run
+ * has a single resident partition that is loaded on recovery
+ * and stays in memory until the run is deleted.
+ */
+struct vy_run_part {
+	/** Run this partition belongs to. */
+	struct vy_run *run;
+	/**
+	 * Offset and size of the partition in the run file.
+	 * Both are 0 for a resident partition.
+	 */
+	uint64_t offset;
+	uint32_t size;
+	/** Size of the partition in memory, i.e. unpacked. */
+	uint32_t unpacked_size;
+	/** Number of the first page in the partition. */
+	uint32_t first_page_no;
+	/** Number of pages in the partition. */
+	uint32_t page_count;
+	/** Min key of the first page in the partition. */
+	char *min_key;
+	/** Comparison hint of the min key. */
+	hint_t min_key_hint;
+	/** Number of statements stored in the partition pages. */
+	struct vy_disk_stmt_counter count;
+	/** Size of memory used for storing the partition page index. */
+	size_t page_index_size;
+	/** Size of memory used for storing the partition bloom filter. */
+	size_t bloom_size;
+	/** Page index, NULL if the partition isn't loaded. */
+	struct vy_page_info *page_info;
+	/** Bloom filter of all tuples in the partition. */
+	struct tuple_bloom *bloom;
+	/**
+	 * Number of iterators using this partition. A partition
+	 * can't be evicted while it is pinned.
+	 */
+	int pin_count;
+	/** Link in vy_run_env::part_lru. */
+	struct rlist in_lru;
+};
+
+/** Number of pages in a page index partition. */
+enum { VY_RUN_PART_PAGE_COUNT = 64 };
+
+static inline bool
+vy_run_part_is_resident(struct vy_run_part *part)
+{
+	return part->size == 0;
+}
+
+static inline bool
+vy_run_part_is_loaded(struct vy_run_part *part)
+{
+	return part->page_info != NULL;
+}
+
 /**
  * Logical unit of vinyl index - a sorted file with data.
  */
@@ -119,16 +225,48 @@ struct vy_run {
 	struct vy_run_env *env;
 	/** Info about the run stored in the index file. */
 	struct vy_run_info info;
-	/** Info about the run pages stored in the index file. */
-	struct vy_page_info *page_info;
+	/** Page index partitions, see struct vy_run_part. */
+	struct vy_run_part *parts;
+	/** Number of page index partitions. */
+	uint32_t part_count;
 	/** Run data file. */
 	int fd;
+	/** Blob file written along with the run or -1. */
+	int blob_fd;
+	/**
+	 * Digested vy_run_info::dict used for decompressing
+	 * pages or NULL if the run doesn't use a dictionary.
+	 */
+	ZSTD_DDict *zddict;
+	/**
+	 * Runs whose blob files are referenced by statements
+	 * stored in this run, except the run itself. Each of
+	 * them is referenced (vy_run::refs) so that its blob
+	 * file stays open while this run is in use. Set by
+	 * vy_lsm_ref_blobs().
+	 */
+	struct vy_run **blob_runs;
+	/** Number of entries in the blob_runs array. */
+	int blob_run_count;
+	/**
+	 * Number of runs of the LSM tree referencing the blob
+	 * file of this run. A run can't be deleted until this
+	 * counter drops to 0, see vy_lsm::blob_runs.
+	 */
+	int blob_refs;
 	/** Unique ID of this run. */
 	int64_t id;
 	/** Number of statements in this run. */
 	struct vy_disk_stmt_counter count;
 	/** Size of memory used for storing page index. */
 	size_t page_index_size;
+	/** Size of memory used for storing bloom filter. */
+	size_t bloom_size;
+	/**
+	 * Size of memory used for storing the directory of page
+	 * index partitions (0 if the run isn't partitioned).
+	 */
+	size_t part_index_size;
 	/** Max LSN stored on disk. */
 	int64_t dump_lsn;
 	/**
@@ -146,6 +284,12 @@ struct vy_run {
 	 * it last time.
 	 */
 	uint32_t dump_count;
+	/**
+	 * Time when the run was written, in seconds since Epoch.
+	 * On recovery, it is taken from the run file modification
+	 * time, because run files are never modified once written.
+	 */
+	double create_time;
 	/**
 	 * Run reference counter, the run is deleted once it hits 0.
 	 * A new run is created with the reference counter set to 1.
@@ -279,6 +423,20 @@ struct vy_run_iterator {
 	 */
 	struct vy_page *curr_page;
 	struct vy_page *prev_page;
+	/** Page index partition pinned by the iterator or NULL. */
+	struct vy_run_part *curr_part;
+	/**
+	 * Max number of pages to read ahead once the iterator
+	 * detects sequential access. 0 disables readahead.
+	 */
+	uint32_t readahead;
+	/**
+	 * Pages being read ahead, linked by vy_page_prefetch::in_itr,
+	 * in the iteration order.
+	 */
+	struct rlist prefetch;
+	/** Number of entries in the prefetch list. */
+	uint32_t prefetch_count;
 	/** Is false until first .._get or .._next_.. method is called */
 	bool search_started;
 };
@@ -330,23 +488,33 @@ vy_run_env_destroy(struct vy_run_env *env);
 void
 vy_run_env_enable_coio(struct vy_run_env *env);
 
+/**
+ * Set the max size of memory that may be used for storing loaded
+ * page index partitions. Evicts partitions if necessary.
+ */
+void
+vy_run_env_set_part_cache_quota(struct vy_run_env *env, size_t quota);
+
 /**
  * Return the size of a run bloom filter.
  */
 size_t
 vy_run_bloom_size(struct vy_run *run);
 
-static inline struct vy_page_info *
-vy_run_page_info(struct vy_run *run, uint32_t pos)
+static inline bool
+vy_run_is_empty(struct vy_run *run)
 {
-	assert(pos < run->info.page_count);
-	return &run->page_info[pos];
+	return run->info.page_count == 0;
 }
 
+/**
+ * Return true if the run page index is split into partitions
+ * that are loaded on demand, see struct vy_run_part.
+ */
 static inline bool
-vy_run_is_empty(struct vy_run *run)
+vy_run_is_partitioned(struct vy_run *run)
 {
-	return run->info.page_count == 0;
+	return run->info.part_count > 0;
 }
 
 struct vy_run *
@@ -370,6 +538,13 @@ vy_run_unref(struct vy_run *run)
 		vy_run_delete(run);
 }
 
+/**
+ * Return the descriptor of the blob file written along with
+ * the run with the given id if it is referenced by @run or -1.
+ */
+int
+vy_run_blob_fd(struct vy_run *run, int64_t run_id);
+
 /**
  * Load run from disk
  * @param run - run to laod
@@ -407,6 +582,8 @@ enum vy_file_type {
 	VY_FILE_INDEX_INPROGRESS,
 	VY_FILE_RUN,
 	VY_FILE_RUN_INPROGRESS,
+	VY_FILE_BLOB,
+	VY_FILE_BLOB_INPROGRESS,
 	vy_file_MAX,
 };
 
@@ -498,6 +675,37 @@ vy_slice_wait_pinned(struct vy_slice *slice)
 		fiber_cond_wait(&slice->pin_cond);
 }
 
+/**
+ * Return the min key of the first page spanned by a slice.
+ * The slice must not be empty.
+ */
+const char *
+vy_slice_first_page_key(struct vy_slice *slice, hint_t *hint);
+
+/**
+ * Return the min key of a page approximately in the middle of
+ * a slice. The slice must not be empty.
+ *
+ * This function never loads page index partitions, so for a
+ * partitioned run the key is chosen among partition boundaries.
+ */
+const char *
+vy_slice_mid_page_key(struct vy_slice *slice, hint_t *hint);
+
+/**
+ * Return the min key of the page located @num/@den of the way
+ * through a slice. Used for splitting a slice into several key
+ * sub-ranges. The slice must not be empty and @num must be less
+ * than @den.
+ *
+ * For a partitioned run the page is rounded down to the nearest
+ * partition boundary so the key may be less than the slice
+ * beginning and may coincide for different @num.
+ */
+const char *
+vy_slice_page_key(struct vy_slice *slice, uint32_t num, uint32_t den,
+		  hint_t *hint);
+
 /**
  * Cut a sub-slice of @slice starting at @begin and ending at @end.
  * Return 0 on success, -1 on OOM.
@@ -524,6 +732,17 @@ vy_run_iterator_open(struct vy_run_iterator *itr,
 		     struct key_def *cmp_def, struct key_def *key_def,
 		     struct tuple_format *format);
 
+/**
+ * Let a run iterator read up to @pages pages ahead in background
+ * once it notices that it loads pages one after another.
+ * Readahead is disabled by default.
+ */
+static inline void
+vy_run_iterator_set_readahead(struct vy_run_iterator *itr, uint32_t pages)
+{
+	itr->readahead = pages;
+}
+
 /**
  * Advance a run iterator to the next key.
  * The key history is returned in @history (empty if EOF).
@@ -562,6 +781,20 @@ struct vy_slice_stream {
 	struct vy_page *page;
 	/** The last tuple returned to user */
 	struct vy_entry entry;
+	/**
+	 * The stream is used from a worker thread so it can't
+	 * share page index partitions with tx. Instead, it loads
+	 * partitions of a partitioned run on its own. This is
+	 * the partition the current page belongs to.
+	 */
+	uint32_t part_no;
+	/** Page index of the partition loaded by the stream. */
+	struct vy_page_info *part_page_info;
+	/**
+	 * Statements need to be checked against the slice end
+	 * only starting from this page.
+	 */
+	uint32_t check_end_page_no;
 
 	/** Members needed for memory allocation and disk access */
 	/** Slice to stream */
@@ -609,16 +842,49 @@ struct vy_run_writer {
 	 */
 	uint64_t page_size;
 	/**
-	 * Current page info capacity. Can grow with page number.
+	 * Values of non-indexed fields that are at least this
+	 * many bytes long are stored in the blob file.
+	 * 0 disables key-value separation.
+	 */
+	uint32_t blob_threshold;
+	/** Writer of the blob file. */
+	struct vy_blob_writer blob;
+	/**
+	 * Column mask of fields stored along with the key in
+	 * a secondary index run. 0 if only keys are stored.
+	 */
+	uint64_t covers;
+	/**
+	 * Current page info capacity of the last page index
+	 * partition. Can grow with page number.
 	 */
 	uint32_t page_info_capacity;
-	/** Don't use compression while writing xlog files. */
-	bool no_compression;
+	/** Current capacity of the run page index partition array. */
+	uint32_t part_capacity;
+	/** Zstd compression level or 0 if compression is disabled. */
+	int compression_level;
+	/**
+	 * Max size of the compression dictionary to train on
+	 * the run data. Reset to 0 once the dictionary has been
+	 * trained. While it is set, appended statements are
+	 * buffered in the samples array instead of being written.
+	 */
+	uint32_t dict_size;
+	/** Statements buffered for training the dictionary. */
+	struct vy_entry *samples;
+	/** Number of entries in the samples array. */
+	uint32_t sample_count;
+	/** Capacity of the samples array. */
+	uint32_t sample_capacity;
+	/** Total size of buffered statements. */
+	size_t sample_size;
+	/** Digested compression dictionary or NULL. */
+	ZSTD_CDict *zcdict;
 	/** Xlog to write data. */
 	struct xlog data_xlog;
 	/** Bloom filter false positive rate. */
 	double bloom_fpr;
-	/** Bloom filter. */
+	/** Bloom filter of the last page index partition. */
 	struct tuple_bloom_builder *bloom;
 	/** Buffer of a current page row offsets. */
 	struct ibuf row_index_buf;
@@ -629,12 +895,21 @@ struct vy_run_writer {
 	struct vy_entry last;
 };
 
-/** Create a run writer to fill a run with statements. */
+/**
+ * Create a run writer to fill a run with statements.
+ * Compression is disabled if @a compression_level is 0.
+ * If @a dict_size is greater than 0, pages are compressed with
+ * a zstd dictionary of up to this size trained on the run data.
+ * @a covers is the column mask of fields stored along with
+ * the key in a secondary index run, see index_opts::covers.
+ */
 int
 vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		     const char *dirpath, uint32_t space_id, uint32_t iid,
 		     struct key_def *cmp_def, struct key_def *key_def,
-		     uint64_t page_size, double bloom_fpr, bool no_compression);
+		     uint64_t page_size, uint32_t blob_threshold,
+		     uint64_t covers, double bloom_fpr, int compression_level,
+		     uint32_t dict_size);
 
 /**
  * Write a specified statement into a run.
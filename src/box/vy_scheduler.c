@@ -36,6 +36,8 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <msgpuck/msgpuck.h>
+#include <qsort_arg.h>
 #include <small/rlist.h>
 #include <tarantool_ev.h>
 
@@ -51,6 +53,7 @@
 #include "space.h"
 #include "schema.h"
 #include "xrow.h"
+#include "vy_blob.h"
 #include "vy_lsm.h"
 #include "vy_log.h"
 #include "vy_mem.h"
@@ -62,6 +65,18 @@
 /* Min and max values for vy_scheduler::timeout. */
 #define VY_SCHEDULER_TIMEOUT_MIN	1
 #define VY_SCHEDULER_TIMEOUT_MAX	60
+/**
+ * How often the scheduler rechecks compaction priorities of LSM
+ * trees that have compaction_ttl set, in seconds. Ranges that
+ * receive writes are rechecked on each dump anyway so this only
+ * matters for ranges that are not written to.
+ */
+#define VY_SCHEDULER_TTL_CHECK_INTERVAL	60
+/**
+ * Max size of statements an index build task sorts in memory
+ * at once, see vy_scheduler_build_lsm().
+ */
+#define VY_BUILD_MAX_CHUNK_SIZE		(128 * 1024 * 1024)
 
 static int vy_worker_f(va_list);
 static int vy_scheduler_f(va_list);
@@ -204,6 +219,10 @@ struct vy_task {
 	 */
 	double bloom_fpr;
 	int64_t page_size;
+	uint32_t blob_threshold;
+	uint64_t covers;
+	int compression_level;
+	uint32_t compression_dict_size;
 	/**
 	 * Deferred DELETE handler passed to the write iterator.
 	 * It sends deferred DELETE statements generated during
@@ -217,8 +236,92 @@ struct vy_task {
 	 * and not yet processed.
 	 */
 	int deferred_delete_in_progress;
+	/**
+	 * Compaction of a big range may be split in several parts
+	 * by key, each of which is executed by a separate worker
+	 * thread and writes its own run, see vy_task_compaction_split().
+	 * This array stores all parts of such a task, starting with
+	 * the task itself. The other parts (subtasks) are executed
+	 * in parallel with the task and completed along with it.
+	 * Upon completion, the range is split by the part boundaries.
+	 */
+	struct vy_task **parts;
+	/** Number of elements in @parts, 0 if not split. */
+	int part_count;
+	/** Task this subtask belongs to or NULL if not a subtask. */
+	struct vy_task *parent;
+	/** Key sub-range compacted by this part of a split task. */
+	struct vy_entry begin, end;
+	/**
+	 * Slices of compacted runs cut by the part boundaries,
+	 * linked by vy_slice::in_range. Fed to the write iterator.
+	 */
+	struct rlist cut_slices;
+	/**
+	 * Number of parts of this task that are still being
+	 * executed by worker threads. The task is queued for
+	 * completion when it drops to 0.
+	 */
+	int in_progress;
 	/** Link in vy_scheduler::processed_tasks. */
 	struct stailq_entry in_processed;
+	/**
+	 * Condition signaled when the task is executed if it is
+	 * completed by a fiber waiting for it rather than by the
+	 * scheduler, see vy_scheduler_build_lsm().
+	 */
+	struct fiber_cond *done_cond;
+	/**
+	 * Index build task reads primary index statements visible
+	 * in @build_rv from @cut_slices. Copies of the primary key
+	 * definition and the format the statements are read with
+	 * are stored in @src_cmp_def and @src_format. Tuples are
+	 * validated against and stored in @build_format.
+	 */
+	struct key_def *src_cmp_def;
+	struct tuple_format *src_format;
+	struct tuple_format *build_format;
+	struct vy_read_view build_rv;
+	/** List of read views passed to the write iterator. */
+	struct rlist build_read_views;
+	/**
+	 * Runs written by an index build task. Statements are
+	 * sorted in chunks of up to @chunk_size bytes, each of
+	 * which is written to the next run, except the last run
+	 * takes the rest if the number of runs is underestimated.
+	 */
+	struct vy_run **build_runs;
+	int build_run_count;
+	size_t chunk_size;
+	/**
+	 * Snapshot of committed range tombstones of the space
+	 * passed to the write iterator, sorted by LSN in descending
+	 * order, see vy_task_snapshot_tombstones(). The bounds are
+	 * stored in the same memory block after the array.
+	 */
+	struct vy_write_tombstone *tombstones;
+	int tombstone_count;
+	/**
+	 * Copies of the primary key definition and of the primary
+	 * key parts in @cmp_def, used for matching statements
+	 * against @tombstones. Set only for secondary indexes.
+	 */
+	struct key_def *pk_def;
+	struct key_def *pk_in_cmp_def;
+	/**
+	 * Max LSN of range tombstones whose statements are purged
+	 * by this compaction task or -1, see vy_range::purge_lsn.
+	 */
+	int64_t purge_lsn;
+	/** Set if the index built by the task is unique. */
+	bool is_unique;
+	/**
+	 * Keys that are duplicated in the new unique index,
+	 * stored as MsgPack arrays one after another.
+	 */
+	char *dup_keys;
+	size_t dup_keys_size;
+	size_t dup_keys_capacity;
 };
 
 static const struct vy_deferred_delete_handler_iface
@@ -261,6 +364,12 @@ vy_task_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	vy_lsm_ref(lsm);
 	diag_create(&task->diag);
 	task->deferred_delete_handler.iface = &vy_task_deferred_delete_iface;
+	task->begin = vy_entry_none();
+	task->end = vy_entry_none();
+	rlist_create(&task->cut_slices);
+	rlist_create(&task->build_read_views);
+	task->purge_lsn = -1;
+	task->in_progress = 1;
 	return task;
 }
 
@@ -270,6 +379,29 @@ vy_task_delete(struct vy_task *task)
 {
 	assert(task->deferred_delete_batch == NULL);
 	assert(task->deferred_delete_in_progress == 0);
+	for (int i = 1; i < task->part_count; i++)
+		vy_task_delete(task->parts[i]);
+	free(task->parts);
+	struct vy_slice *slice, *next_slice;
+	rlist_foreach_entry_safe(slice, &task->cut_slices, in_range, next_slice)
+		vy_slice_delete(slice);
+	if (task->begin.stmt != NULL)
+		tuple_unref(task->begin.stmt);
+	if (task->end.stmt != NULL)
+		tuple_unref(task->end.stmt);
+	if (task->src_cmp_def != NULL)
+		key_def_delete(task->src_cmp_def);
+	if (task->src_format != NULL)
+		tuple_format_unref(task->src_format);
+	if (task->build_format != NULL)
+		tuple_format_unref(task->build_format);
+	free(task->build_runs);
+	free(task->dup_keys);
+	free(task->tombstones);
+	if (task->pk_def != NULL)
+		key_def_delete(task->pk_def);
+	if (task->pk_in_cmp_def != NULL)
+		key_def_delete(task->pk_in_cmp_def);
 	key_def_delete(task->cmp_def);
 	key_def_delete(task->key_def);
 	vy_lsm_unref(task->lsm);
@@ -277,6 +409,82 @@ vy_task_delete(struct vy_task *task)
 	free(task);
 }
 
+/**
+ * Take a snapshot of committed range tombstones of the space
+ * the task's LSM tree belongs to so that the write iterator can
+ * apply them in a worker thread, see vy_write_iterator_set_tombstones().
+ */
+static int
+vy_task_snapshot_tombstones(struct vy_task *task)
+{
+	struct vy_lsm *lsm = task->lsm;
+	struct vy_lsm *pk = lsm->pk != NULL ? lsm->pk : lsm;
+	if (pk->tombstone_count == 0)
+		return 0;
+	int count = 0;
+	size_t size = 0;
+	struct vy_tombstone *tombstone;
+	rlist_foreach_entry(tombstone, &pk->tombstones, in_lsm) {
+		if (tombstone->lsn >= MAX_LSN)
+			break;
+		count++;
+		size += tombstone->end - tombstone->begin;
+		const char *end = tombstone->end;
+		mp_next(&end);
+		size += end - tombstone->end;
+	}
+	if (count == 0)
+		return 0;
+	if (lsm->index_id > 0) {
+		task->pk_def = key_def_dup(pk->cmp_def);
+		if (task->pk_def == NULL)
+			return -1;
+		task->pk_in_cmp_def = key_def_dup(lsm->pk_in_cmp_def);
+		if (task->pk_in_cmp_def == NULL)
+			return -1;
+	}
+	size += count * sizeof(*task->tombstones);
+	task->tombstones = malloc(size);
+	if (task->tombstones == NULL) {
+		diag_set(OutOfMemory, size, "malloc",
+			 "struct vy_write_tombstone");
+		return -1;
+	}
+	task->tombstone_count = count;
+	char *data = (char *)(task->tombstones + count);
+	rlist_foreach_entry(tombstone, &pk->tombstones, in_lsm) {
+		if (--count < 0)
+			break;
+		const char *end = tombstone->end;
+		mp_next(&end);
+		size_t bounds_size = end - tombstone->begin;
+		memcpy(data, tombstone->begin, bounds_size);
+		/* Descending order. */
+		struct vy_write_tombstone *t = &task->tombstones[count];
+		t->lsn = tombstone->lsn;
+		t->begin = data;
+		t->end = data + (tombstone->end - tombstone->begin);
+		data += bounds_size;
+	}
+	return 0;
+}
+
+/**
+ * Pass the tombstones snapshot of a task to its write iterator.
+ * Parts of a split compaction task share the parent's snapshot.
+ */
+static void
+vy_task_set_tombstones(struct vy_task *task)
+{
+	struct vy_task *owner = task->parent != NULL ? task->parent : task;
+	if (owner->tombstone_count == 0)
+		return;
+	vy_write_iterator_set_tombstones(task->wi, owner->tombstones,
+			owner->tombstone_count,
+			owner->pk_def != NULL ? owner->pk_def : owner->cmp_def,
+			owner->pk_in_cmp_def);
+}
+
 static bool
 vy_dump_heap_less(struct vy_lsm *i1, struct vy_lsm *i2)
 {
@@ -378,6 +586,7 @@ vy_worker_pool_create(struct vy_worker_pool *pool, const char *name, int size)
 	pool->size = size;
 	pool->workers = NULL;
 	stailq_create(&pool->idle_workers);
+	fiber_cond_create(&pool->idle_cond);
 }
 
 static void
@@ -385,6 +594,7 @@ vy_worker_pool_destroy(struct vy_worker_pool *pool)
 {
 	if (pool->workers != NULL)
 		vy_worker_pool_stop(pool);
+	fiber_cond_destroy(&pool->idle_cond);
 }
 
 /**
@@ -419,6 +629,7 @@ vy_worker_pool_put(struct vy_worker *worker)
 {
 	struct vy_worker_pool *pool = worker->pool;
 	stailq_add_entry(&pool->idle_workers, worker, in_idle);
+	fiber_cond_signal(&pool->idle_cond);
 }
 
 void
@@ -428,6 +639,7 @@ vy_scheduler_create(struct vy_scheduler *scheduler, int write_threads,
 {
 	memset(scheduler, 0, sizeof(*scheduler));
 
+	scheduler->max_subcompactions = 1;
 	scheduler->dump_complete_cb = dump_complete_cb;
 	scheduler->read_views = read_views;
 	scheduler->run_env = run_env;
@@ -1049,6 +1261,18 @@ vy_task_deferred_delete_iface = {
 	.destroy = vy_task_deferred_delete_destroy,
 };
 
+/**
+ * Return the zstd level to compress runs of an LSM tree with
+ * or 0 if compression is disabled.
+ */
+static int
+vy_lsm_compression_level(struct vy_lsm *lsm)
+{
+	if (lsm->opts.compression == INDEX_COMPRESSION_NONE)
+		return 0;
+	return lsm->opts.compression_level;
+}
+
 static int
 vy_task_write_run(struct vy_task *task, bool no_compression)
 {
@@ -1066,8 +1290,10 @@ vy_task_write_run(struct vy_task *task, bool no_compression)
 	if (vy_run_writer_create(&writer, task->new_run, lsm->env->path,
 				 lsm->space_id, lsm->index_id,
 				 task->cmp_def, task->key_def,
-				 task->page_size, task->bloom_fpr,
-				 no_compression) != 0)
+				 task->page_size, task->blob_threshold,
+				 task->covers, task->bloom_fpr,
+				 no_compression ? 0 : task->compression_level,
+				 task->compression_dict_size) != 0)
 		goto fail;
 
 	if (wi->iface->start(wi) != 0)
@@ -1239,6 +1465,7 @@ delete_mems:
 	}
 	lsm->dump_lsn = MAX(lsm->dump_lsn, dump_lsn);
 	vy_lsm_acct_dump(lsm, dump_time, &dump_input, &dump_output);
+	vy_lsm_gc_tombstones(lsm);
 	/*
 	 * Indexes of the same space share a memory level so we
 	 * account dump input only when the primary index is dumped.
@@ -1381,11 +1608,15 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	 * dump so we don't pass a deferred DELETE handler.
 	 */
 	struct vy_stmt_stream *wi;
-	bool is_last_level = (lsm->run_count == 0);
+	bool is_last_level = (lsm->run_count == 0 && !lsm->is_bulk_loading);
 	wi = vy_write_iterator_new(task->cmp_def, lsm->index_id == 0,
 				   is_last_level, scheduler->read_views, NULL);
 	if (wi == NULL)
 		goto err_wi;
+	task->wi = wi;
+	if (vy_task_snapshot_tombstones(task) != 0)
+		goto err_wi_sub;
+	vy_task_set_tombstones(task);
 	rlist_foreach_entry(mem, &lsm->sealed, in_sealed) {
 		if (mem->generation > scheduler->dump_generation)
 			continue;
@@ -1394,9 +1625,12 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	}
 
 	task->new_run = new_run;
-	task->wi = wi;
 	task->bloom_fpr = lsm->opts.bloom_fpr;
 	task->page_size = lsm->opts.page_size;
+	task->blob_threshold = lsm->opts.blob_threshold;
+	task->covers = lsm->opts.covers;
+	task->compression_level = vy_lsm_compression_level(lsm);
+	task->compression_dict_size = lsm->opts.compression_dict_size;
 
 	lsm->is_dumping = true;
 	vy_scheduler_update_lsm(scheduler, lsm);
@@ -1438,6 +1672,272 @@ vy_task_compaction_execute(struct vy_task *task)
 	return vy_task_write_run(task, false);
 }
 
+/**
+ * Close write iterators of all parts of a compaction task and
+ * delete slices cut for them.
+ */
+static void
+vy_task_compaction_close(struct vy_task *task)
+{
+	int part_count = MAX(task->part_count, 1);
+	for (int i = 0; i < part_count; i++) {
+		struct vy_task *part = i == 0 ? task : task->parts[i];
+		/* The iterator has been cleaned up in worker. */
+		if (part->wi != NULL) {
+			part->wi->iface->close(part->wi);
+			part->wi = NULL;
+		}
+		struct vy_slice *slice, *next_slice;
+		rlist_foreach_entry_safe(slice, &part->cut_slices,
+					 in_range, next_slice)
+			vy_slice_delete(slice);
+		rlist_create(&part->cut_slices);
+	}
+}
+
+/**
+ * Complete a compaction task that was split in several parts.
+ * Since each part has written its own run, which spans only
+ * the key sub-range of the part, the compacted range is split
+ * in the same sub-ranges. Slices that were added to the range
+ * by dumps completed while the task was in progress as well as
+ * slices that weren't compacted are cut by the part boundaries,
+ * like on range split.
+ */
+static int
+vy_task_compaction_complete_split(struct vy_task *task)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+	struct vy_range *range = task->range;
+	double compaction_time = ev_monotonic_now(loop()) - task->start_time;
+	struct vy_disk_stmt_counter compaction_output;
+	struct vy_disk_stmt_counter compaction_input;
+	struct vy_slice *first_slice = task->first_slice;
+	struct vy_slice *last_slice = task->last_slice;
+	struct vy_slice *slice, *new_slice;
+	struct vy_range **new_ranges = NULL;
+	struct vy_range *new_range;
+	struct vy_task *part;
+	struct vy_run *run;
+	int i;
+
+	/*
+	 * Cut slices pin compacted runs so we must delete them
+	 * before looking for unused runs.
+	 */
+	vy_task_compaction_close(task);
+
+	if (lsm->is_dropped) {
+		for (i = 0; i < task->part_count; i++)
+			vy_run_unref(task->parts[i]->new_run);
+		goto out;
+	}
+
+	new_ranges = calloc(task->part_count, sizeof(*new_ranges));
+	if (new_ranges == NULL) {
+		diag_set(OutOfMemory, task->part_count * sizeof(*new_ranges),
+			 "malloc", "struct vy_range *");
+		return -1;
+	}
+
+	/*
+	 * Allocate a range for each part. Replace compacted slices
+	 * with the slice of the run written by the part and cut the
+	 * rest of the old range's slices by the part boundaries.
+	 *
+	 * vy_range_add_slice() adds a slice to the list head, so to
+	 * preserve the order of the slices list, we have to iterate
+	 * backward.
+	 */
+	vy_disk_stmt_counter_reset(&compaction_output);
+	for (i = 0; i < task->part_count; i++) {
+		part = task->parts[i];
+		new_range = vy_range_new(vy_log_next_id(), part->begin,
+					 part->end, lsm->cmp_def);
+		if (new_range == NULL)
+			goto fail;
+		new_ranges[i] = new_range;
+		bool is_compacted = false;
+		rlist_foreach_entry_reverse(slice, &range->slices, in_range) {
+			if (slice == last_slice)
+				is_compacted = true;
+			if (is_compacted) {
+				if (slice != first_slice)
+					continue;
+				is_compacted = false;
+				run = part->new_run;
+				if (vy_run_is_empty(run))
+					continue;
+				new_slice = vy_slice_new(vy_log_next_id(), run,
+							 vy_entry_none(),
+							 vy_entry_none(),
+							 lsm->cmp_def);
+				if (new_slice == NULL)
+					goto fail;
+			} else if (vy_slice_cut(slice, vy_log_next_id(),
+						new_range->begin, new_range->end,
+						lsm->cmp_def, &new_slice) != 0) {
+				goto fail;
+			}
+			if (new_slice != NULL)
+				vy_range_add_slice(new_range, new_slice);
+		}
+		vy_disk_stmt_counter_add(&compaction_output,
+					 &part->new_run->count);
+	}
+
+	/*
+	 * Pin blob files referenced by the new runs,
+	 * see vy_task_compaction_complete().
+	 */
+	for (i = 0; i < task->part_count; i++) {
+		run = task->parts[i]->new_run;
+		if (!vy_run_is_empty(run) && vy_lsm_ref_blobs(lsm, run) != 0)
+			goto fail;
+	}
+
+	/*
+	 * Build the list of runs that became unused
+	 * as a result of compaction.
+	 */
+	RLIST_HEAD(unused_runs);
+	RLIST_HEAD(blob_runs);
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		slice->run->compacted_slice_count++;
+		if (slice == last_slice)
+			break;
+	}
+	vy_disk_stmt_counter_reset(&compaction_input);
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		run = slice->run;
+		if (run->compacted_slice_count == run->slice_count) {
+			if (run->blob_refs > 0)
+				rlist_add_entry(&blob_runs, run, in_unused);
+			else
+				rlist_add_entry(&unused_runs, run, in_unused);
+		}
+		slice->run->compacted_slice_count = 0;
+		vy_disk_stmt_counter_add(&compaction_input, &slice->count);
+		if (slice == last_slice)
+			break;
+	}
+
+	/*
+	 * Log change in metadata.
+	 */
+	vy_log_tx_begin();
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		vy_log_delete_slice(slice->id);
+	vy_log_delete_range(range->id);
+	rlist_foreach_entry(run, &unused_runs, in_unused)
+		vy_log_drop_run(run->id, VY_LOG_GC_LSN_CURRENT);
+	for (i = 0; i < task->part_count; i++) {
+		run = task->parts[i]->new_run;
+		if (!vy_run_is_empty(run))
+			vy_log_create_run(lsm->id, run->id, run->dump_lsn,
+					  run->dump_count);
+	}
+	for (i = 0; i < task->part_count; i++) {
+		new_range = new_ranges[i];
+		vy_log_insert_range(lsm->id, new_range->id,
+				    tuple_data_or_null(new_range->begin.stmt),
+				    tuple_data_or_null(new_range->end.stmt));
+		rlist_foreach_entry(slice, &new_range->slices, in_range)
+			vy_log_insert_slice(new_range->id, slice->run->id,
+					    slice->id,
+					    tuple_data_or_null(slice->begin.stmt),
+					    tuple_data_or_null(slice->end.stmt));
+	}
+	if (vy_log_tx_commit() < 0)
+		goto fail;
+
+	/*
+	 * Remove compacted run files that were created after
+	 * the last checkpoint immediately to save disk space,
+	 * see vy_task_compaction_complete().
+	 */
+	rlist_foreach_entry(run, &unused_runs, in_unused) {
+		if (run->dump_lsn > vy_log_signature())
+			vy_run_remove_files(lsm->env->path, lsm->space_id,
+					    lsm->index_id, run->id);
+	}
+
+	/*
+	 * Account new runs that are not empty, discard the rest.
+	 */
+	for (i = 0; i < task->part_count; i++) {
+		run = task->parts[i]->new_run;
+		if (!vy_run_is_empty(run)) {
+			vy_lsm_add_run(lsm, run);
+			/* Drop the reference held by the task. */
+			vy_run_unref(run);
+		} else
+			vy_run_discard(run);
+	}
+
+	/*
+	 * Replace the old range in the LSM tree. Note, the range
+	 * was removed from the heap when the task was scheduled.
+	 */
+	vy_lsm_unacct_range(lsm, range);
+	vy_range_heap_insert(&lsm->range_heap, range);
+	vy_lsm_remove_range(lsm, range);
+	for (i = 0; i < task->part_count; i++) {
+		new_range = new_ranges[i];
+		new_range->n_compactions = range->n_compactions + 1;
+		new_range->purge_lsn = MAX(range->purge_lsn, task->purge_lsn);
+		vy_range_update_compaction_priority(new_range, &lsm->opts);
+		vy_range_update_dumps_per_compaction(new_range);
+		vy_lsm_add_range(lsm, new_range);
+		vy_lsm_acct_range(lsm, new_range);
+	}
+	lsm->range_tree_version++;
+	vy_lsm_acct_compaction(lsm, compaction_time,
+			       &compaction_input, &compaction_output);
+	scheduler->stat.compaction_input += compaction_input.bytes;
+	scheduler->stat.compaction_output += compaction_output.bytes;
+	scheduler->stat.compaction_time += compaction_time;
+
+	/*
+	 * Unaccount unused runs and delete the old range.
+	 */
+	rlist_foreach_entry(run, &unused_runs, in_unused) {
+		vy_lsm_remove_run(lsm, run);
+		vy_lsm_unref_blobs(lsm, run);
+	}
+	rlist_foreach_entry(run, &blob_runs, in_unused) {
+		vy_lsm_remove_run(lsm, run);
+		vy_lsm_unref_blobs(lsm, run);
+		vy_lsm_add_blob_run(lsm, run);
+	}
+
+	say_info("%s: completed compacting range %s, split in %d parts",
+		 vy_lsm_name(lsm), vy_range_str(range), task->part_count);
+
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		vy_slice_wait_pinned(slice);
+	vy_range_delete(range);
+	free(new_ranges);
+	vy_lsm_gc_blob_runs(lsm);
+	vy_lsm_gc_tombstones(lsm);
+	vy_scheduler_update_lsm(scheduler, lsm);
+	return 0;
+out:
+	assert(heap_node_is_stray(&range->heap_node));
+	vy_range_heap_insert(&lsm->range_heap, range);
+	vy_scheduler_update_lsm(scheduler, lsm);
+	return 0;
+fail:
+	for (i = 0; i < task->part_count; i++) {
+		vy_lsm_unref_blobs(lsm, task->parts[i]->new_run);
+		if (new_ranges[i] != NULL)
+			vy_range_delete(new_ranges[i]);
+	}
+	free(new_ranges);
+	return -1;
+}
+
 static int
 vy_task_compaction_complete(struct vy_task *task)
 {
@@ -1453,6 +1953,9 @@ vy_task_compaction_complete(struct vy_task *task)
 	struct vy_slice *slice, *next_slice, *new_slice = NULL;
 	struct vy_run *run;
 
+	if (task->part_count > 0)
+		return vy_task_compaction_complete_split(task);
+
 	/*
 	 * The LSM tree could have been dropped while we were writing the new
 	 * run. In this case we should discard the run without committing to
@@ -1477,13 +1980,24 @@ vy_task_compaction_complete(struct vy_task *task)
 					 lsm->cmp_def);
 		if (new_slice == NULL)
 			return -1;
+		/*
+		 * Pin blob files the new run refers to so that they
+		 * aren't deleted along with compacted runs below.
+		 */
+		if (vy_lsm_ref_blobs(lsm, new_run) != 0) {
+			vy_slice_delete(new_slice);
+			return -1;
+		}
 	}
 
 	/*
 	 * Build the list of runs that became unused
-	 * as a result of compaction.
+	 * as a result of compaction. Runs whose blob
+	 * files are still referenced are kept until
+	 * the references are gone, see vy_blob.h.
 	 */
 	RLIST_HEAD(unused_runs);
+	RLIST_HEAD(blob_runs);
 	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
 		slice->run->compacted_slice_count++;
 		if (slice == last_slice)
@@ -1491,8 +2005,12 @@ vy_task_compaction_complete(struct vy_task *task)
 	}
 	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
 		run = slice->run;
-		if (run->compacted_slice_count == run->slice_count)
-			rlist_add_entry(&unused_runs, run, in_unused);
+		if (run->compacted_slice_count == run->slice_count) {
+			if (run->blob_refs > 0)
+				rlist_add_entry(&blob_runs, run, in_unused);
+			else
+				rlist_add_entry(&unused_runs, run, in_unused);
+		}
 		slice->run->compacted_slice_count = 0;
 		if (slice == last_slice)
 			break;
@@ -1517,8 +2035,10 @@ vy_task_compaction_complete(struct vy_task *task)
 				    tuple_data_or_null(new_slice->end.stmt));
 	}
 	if (vy_log_tx_commit() < 0) {
-		if (new_slice != NULL)
+		if (new_slice != NULL) {
+			vy_lsm_unref_blobs(lsm, new_run);
 			vy_slice_delete(new_slice);
+		}
 		return -1;
 	}
 
@@ -1572,6 +2092,7 @@ vy_task_compaction_complete(struct vy_task *task)
 			break;
 	}
 	range->n_compactions++;
+	range->purge_lsn = MAX(range->purge_lsn, task->purge_lsn);
 	vy_range_update_compaction_priority(range, &lsm->opts);
 	vy_range_update_dumps_per_compaction(range);
 	vy_lsm_acct_range(lsm, range);
@@ -1584,13 +2105,22 @@ vy_task_compaction_complete(struct vy_task *task)
 	/*
 	 * Unaccount unused runs and delete compacted slices.
 	 */
-	rlist_foreach_entry(run, &unused_runs, in_unused)
+	rlist_foreach_entry(run, &unused_runs, in_unused) {
 		vy_lsm_remove_run(lsm, run);
+		vy_lsm_unref_blobs(lsm, run);
+	}
+	rlist_foreach_entry(run, &blob_runs, in_unused) {
+		vy_lsm_remove_run(lsm, run);
+		vy_lsm_unref_blobs(lsm, run);
+		vy_lsm_add_blob_run(lsm, run);
+	}
 	rlist_foreach_entry_safe(slice, &compacted_slices,
 				 in_range, next_slice) {
 		vy_slice_wait_pinned(slice);
 		vy_slice_delete(slice);
 	}
+	vy_lsm_gc_blob_runs(lsm);
+	vy_lsm_gc_tombstones(lsm);
 out:
 	/* The iterator has been cleaned up in worker. */
 	task->wi->iface->close(task->wi);
@@ -1611,69 +2141,234 @@ vy_task_compaction_abort(struct vy_task *task)
 	struct vy_lsm *lsm = task->lsm;
 	struct vy_range *range = task->range;
 
-	/* The iterator has been cleaned up in worker. */
-	task->wi->iface->close(task->wi);
+	vy_task_compaction_close(task);
 
 	struct error *e = diag_last_error(&task->diag);
 	error_log(e);
 	say_error("%s: failed to compact range %s",
 		  vy_lsm_name(lsm), vy_range_str(range));
 
-	vy_run_discard(task->new_run);
+	int part_count = MAX(task->part_count, 1);
+	for (int i = 0; i < part_count; i++) {
+		struct vy_task *part = i == 0 ? task : task->parts[i];
+		vy_run_discard(part->new_run);
+	}
 
 	assert(heap_node_is_stray(&range->heap_node));
 	vy_range_heap_insert(&lsm->range_heap, range);
 	vy_scheduler_update_lsm(scheduler, lsm);
 }
 
+/**
+ * Split a compaction task in several parts by key so that they
+ * can be executed in parallel by idle worker threads.
+ *
+ * A task is split only if the size of compacted slices is at
+ * least twice as big as range_size. The number of parts is chosen
+ * so that each of them is about range_size, but it is limited by
+ * vy_scheduler::max_subcompactions and the number of idle workers.
+ * Part boundaries are taken from the page index of the biggest
+ * compacted slice.
+ *
+ * Since each part writes its own run, the range is split by part
+ * boundaries on task completion. This way a big range is split
+ * right away instead of waiting for it to be compacted, see
+ * vy_range_needs_split().
+ *
+ * Returns 0 on success (the task may be left intact), -1 on
+ * memory allocation or vylog error.
+ */
 static int
-vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
-		       struct vy_lsm *lsm, struct vy_task **p_task)
+vy_task_compaction_split(struct vy_task *task,
+			 const struct vy_disk_stmt_counter *input)
 {
-	static struct vy_task_ops compaction_ops = {
-		.execute = vy_task_compaction_execute,
-		.complete = vy_task_compaction_complete,
-		.abort = vy_task_compaction_abort,
-	};
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+	struct vy_range *range = task->range;
 
-	struct vy_range *range = vy_range_heap_top(&lsm->range_heap);
-	assert(range != NULL);
-	assert(range->compaction_priority > 1);
+	int64_t max_part_count = input->bytes / vy_lsm_range_size(lsm);
+	max_part_count = MIN(max_part_count, scheduler->max_subcompactions);
+	if (max_part_count < 2 ||
+	    stailq_empty(&scheduler->compaction_pool.idle_workers))
+		return 0;
 
-	if (vy_lsm_split_range(lsm, range) ||
-	    vy_lsm_coalesce_range(lsm, range)) {
-		vy_scheduler_update_lsm(scheduler, lsm);
+	/* Take part boundaries from the biggest compacted slice. */
+	struct vy_slice *slice, *src_slice = NULL;
+	for (slice = task->first_slice; ;
+	     slice = rlist_next_entry(slice, in_range)) {
+		if (src_slice == NULL ||
+		    slice->count.bytes > src_slice->count.bytes)
+			src_slice = slice;
+		if (slice == task->last_slice)
+			break;
+	}
+	max_part_count = MIN(max_part_count, src_slice->count.pages);
+	if (max_part_count < 2)
+		return 0;
+
+	task->parts = calloc(max_part_count, sizeof(*task->parts));
+	if (task->parts == NULL) {
+		diag_set(OutOfMemory, max_part_count * sizeof(*task->parts),
+			 "malloc", "struct vy_task *");
+		return -1;
+	}
+	task->parts[0] = task;
+	task->part_count = 1;
+
+	struct vy_entry prev_key = range->begin;
+	for (int i = 1; i < max_part_count; i++) {
+		hint_t hint;
+		const char *key = vy_slice_page_key(src_slice, i,
+						    max_part_count, &hint);
+		if (prev_key.stmt != NULL &&
+		    vy_entry_compare_with_raw_key(prev_key, key, hint,
+						  lsm->cmp_def) >= 0)
+			continue;
+		if (range->end.stmt != NULL &&
+		    vy_entry_compare_with_raw_key(range->end, key, hint,
+						  lsm->cmp_def) <= 0)
+			break;
+		struct vy_worker *worker;
+		worker = vy_worker_pool_get(&scheduler->compaction_pool);
+		if (worker == NULL)
+			break;
+		struct vy_task *part = vy_task_new(scheduler, worker, lsm,
+						   task->ops);
+		if (part == NULL) {
+			vy_worker_pool_put(worker);
+			return -1;
+		}
+		task->parts[task->part_count++] = part;
+		part->parent = task;
+		part->range = range;
+		part->first_slice = task->first_slice;
+		part->last_slice = task->last_slice;
+		part->bloom_fpr = task->bloom_fpr;
+		part->page_size = task->page_size;
+		part->blob_threshold = task->blob_threshold;
+		part->covers = task->covers;
+		part->compression_level = task->compression_level;
+		part->compression_dict_size = task->compression_dict_size;
+		part->begin = vy_entry_key_from_msgpack(lsm->env->key_format,
+							lsm->cmp_def, key);
+		if (part->begin.stmt == NULL)
+			return -1;
+		part->new_run = vy_run_prepare(scheduler->run_env, lsm);
+		if (part->new_run == NULL)
+			return -1;
+		part->new_run->dump_lsn = task->new_run->dump_lsn;
+		part->new_run->dump_count = task->new_run->dump_count;
+		prev_key = part->begin;
+	}
+	if (task->part_count < 2) {
+		free(task->parts);
+		task->parts = NULL;
+		task->part_count = 0;
 		return 0;
 	}
 
-	struct vy_task *task = vy_task_new(scheduler, worker, lsm,
-					   &compaction_ops);
-	if (task == NULL)
-		goto err_task;
+	task->begin = range->begin;
+	if (task->begin.stmt != NULL)
+		tuple_ref(task->begin.stmt);
+	for (int i = 0; i < task->part_count; i++) {
+		struct vy_task *part = task->parts[i];
+		part->end = i + 1 < task->part_count ?
+			    task->parts[i + 1]->begin : range->end;
+		if (part->end.stmt != NULL)
+			tuple_ref(part->end.stmt);
+	}
+	task->in_progress = task->part_count;
 
-	struct vy_run *new_run = vy_run_prepare(scheduler->run_env, lsm);
-	if (new_run == NULL)
-		goto err_run;
+	say_info("%s: split compaction of range %s in %d parts",
+		 vy_lsm_name(lsm), vy_range_str(range), task->part_count);
+	return 0;
+}
 
-	struct vy_stmt_stream *wi;
-	bool is_last_level = (range->compaction_priority == range->slice_count);
-	wi = vy_write_iterator_new(task->cmp_def, lsm->index_id == 0,
-				   is_last_level, scheduler->read_views,
+/**
+ * Create the write iterator for a compaction task or its part.
+ * If the task is split, compacted slices are cut by the part
+ * boundaries.
+ */
+static int
+vy_task_compaction_create_wi(struct vy_task *task, bool is_last_level)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+	bool is_split = task->parent != NULL || task->part_count > 0;
+
+	struct vy_stmt_stream *wi;
+	wi = vy_write_iterator_new(task->cmp_def, lsm->index_id == 0,
+				   is_last_level, scheduler->read_views,
 				   lsm->index_id > 0 ? NULL :
 				   &task->deferred_delete_handler);
 	if (wi == NULL)
-		goto err_wi;
+		return -1;
+	task->wi = wi;
+	vy_task_set_tombstones(task);
+
+	struct vy_slice *slice, *cut_slice;
+	for (slice = task->first_slice; ;
+	     slice = rlist_next_entry(slice, in_range)) {
+		if (!is_split) {
+			cut_slice = slice;
+		} else {
+			if (vy_slice_cut(slice, slice->id, task->begin,
+					 task->end, lsm->cmp_def,
+					 &cut_slice) != 0)
+				return -1;
+			if (cut_slice != NULL)
+				rlist_add_tail_entry(&task->cut_slices,
+						     cut_slice, in_range);
+		}
+		if (cut_slice != NULL &&
+		    vy_write_iterator_new_slice(wi, cut_slice,
+						lsm->disk_format) != 0)
+			return -1;
+		if (slice == task->last_slice)
+			break;
+	}
+	return 0;
+}
+
+static int
+vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
+		       struct vy_lsm *lsm, struct vy_task **p_task)
+{
+	static struct vy_task_ops compaction_ops = {
+		.execute = vy_task_compaction_execute,
+		.complete = vy_task_compaction_complete,
+		.abort = vy_task_compaction_abort,
+	};
+
+	struct vy_range *range = vy_range_heap_top(&lsm->range_heap);
+	assert(range != NULL);
+	assert(range->compaction_priority > 1);
+
+	if (vy_lsm_split_range(lsm, range) ||
+	    vy_lsm_coalesce_range(lsm, range)) {
+		vy_scheduler_update_lsm(scheduler, lsm);
+		return 0;
+	}
+
+	struct vy_task *task = vy_task_new(scheduler, worker, lsm,
+					   &compaction_ops);
+	if (task == NULL)
+		goto err_task;
+
+	struct vy_run *new_run = vy_run_prepare(scheduler->run_env, lsm);
+	if (new_run == NULL)
+		goto err_run;
 
 	struct vy_slice *slice;
+	struct vy_disk_stmt_counter input;
+	vy_disk_stmt_counter_reset(&input);
 	int32_t dump_count = 0;
 	int n = range->compaction_priority;
 	rlist_foreach_entry(slice, &range->slices, in_range) {
-		if (vy_write_iterator_new_slice(wi, slice,
-						lsm->disk_format) != 0)
-			goto err_wi_sub;
 		new_run->dump_lsn = MAX(new_run->dump_lsn,
 					slice->run->dump_lsn);
 		dump_count += slice->run->dump_count;
+		vy_disk_stmt_counter_add(&input, &slice->count);
 		/* Remember the slices we are compacting. */
 		if (task->first_slice == NULL)
 			task->first_slice = slice;
@@ -1696,13 +2391,43 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	else
 		new_run->dump_count = dump_count;
 
-	range->needs_compaction = false;
-
 	task->range = range;
 	task->new_run = new_run;
-	task->wi = wi;
 	task->bloom_fpr = lsm->opts.bloom_fpr;
 	task->page_size = lsm->opts.page_size;
+	task->blob_threshold = lsm->opts.blob_threshold;
+	task->covers = lsm->opts.covers;
+	task->compression_level = vy_lsm_compression_level(lsm);
+	task->compression_dict_size = lsm->opts.compression_dict_size;
+
+	if (vy_task_compaction_split(task, &input) != 0)
+		goto err_split;
+
+	bool is_last_level = (range->compaction_priority == range->slice_count);
+	if (vy_task_snapshot_tombstones(task) != 0)
+		goto err_wi;
+	if (is_last_level && task->tombstone_count > 0) {
+		/*
+		 * Major compaction purges statements deleted by
+		 * range tombstones unless they are visible from
+		 * the oldest open read view.
+		 */
+		int64_t vlsn = INT64_MAX;
+		if (!rlist_empty(scheduler->read_views)) {
+			vlsn = rlist_first_entry(scheduler->read_views,
+						 struct vy_read_view,
+						 in_read_views)->vlsn;
+		}
+		task->purge_lsn = vy_lsm_tombstone_purge_lsn(lsm, vlsn);
+	}
+	int part_count = MAX(task->part_count, 1);
+	for (int i = 0; i < part_count; i++) {
+		struct vy_task *part = i == 0 ? task : task->parts[i];
+		if (vy_task_compaction_create_wi(part, is_last_level) != 0)
+			goto err_wi;
+	}
+
+	range->needs_compaction = false;
 
 	/*
 	 * Remove the range we are going to compact from the heap
@@ -1717,9 +2442,15 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	*p_task = task;
 	return 0;
 
-err_wi_sub:
-	task->wi->iface->close(wi);
 err_wi:
+	vy_task_compaction_close(task);
+err_split:
+	for (int i = 1; i < task->part_count; i++) {
+		struct vy_task *part = task->parts[i];
+		if (part->new_run != NULL)
+			vy_run_discard(part->new_run);
+		vy_worker_pool_put(part->worker);
+	}
 	vy_run_discard(new_run);
 err_run:
 	vy_task_delete(task);
@@ -1730,6 +2461,918 @@ err_task:
 	return -1;
 }
 
+/**
+ * Remember a key that is duplicated in the new unique index
+ * so that it is checked in tx. Keys with nulls are skipped,
+ * because they may repeat in a nullable index. @is_dup is set
+ * if the key has already been remembered so that a key repeated
+ * more than twice is remembered only once.
+ */
+static int
+vy_task_build_add_dup_key(struct vy_task *task, const char *key,
+			  uint32_t size, bool *is_dup)
+{
+	if (*is_dup)
+		return 0;
+	if (task->key_def->is_nullable) {
+		const char *pos = key;
+		uint32_t part_count = mp_decode_array(&pos);
+		for (uint32_t i = 0; i < part_count; i++) {
+			if (mp_typeof(*pos) == MP_NIL)
+				return 0;
+			mp_next(&pos);
+		}
+	}
+	size_t needed = task->dup_keys_size + size;
+	if (needed > task->dup_keys_capacity) {
+		size_t capacity = MAX(task->dup_keys_capacity * 2, 4096);
+		while (capacity < needed)
+			capacity *= 2;
+		char *keys = realloc(task->dup_keys, capacity);
+		if (keys == NULL) {
+			diag_set(OutOfMemory, capacity,
+				 "realloc", "duplicate keys");
+			return -1;
+		}
+		task->dup_keys = keys;
+		task->dup_keys_capacity = capacity;
+	}
+	memcpy(task->dup_keys + task->dup_keys_size, key, size);
+	task->dup_keys_size += size;
+	*is_dup = true;
+	return 0;
+}
+
+/**
+ * Extract the key of the new index from a statement. Unlike
+ * tuple_extract_key(), it also handles statements read from
+ * the runs of the new index, which are extended keys.
+ * The key is allocated on the fiber region.
+ */
+static const char *
+vy_task_build_extract_key(struct vy_task *task, struct vy_entry entry,
+			  uint32_t *size)
+{
+	struct key_def *key_def = task->key_def;
+	if (!vy_stmt_is_key(entry.stmt)) {
+		return tuple_extract_key(entry.stmt, key_def,
+					 vy_entry_multikey_idx(entry, key_def),
+					 size);
+	}
+	const char *parts = tuple_data(entry.stmt);
+	mp_decode_array(&parts);
+	const char *parts_end = parts;
+	for (uint32_t i = 0; i < key_def->part_count; i++)
+		mp_next(&parts_end);
+	*size = mp_sizeof_array(key_def->part_count) + (parts_end - parts);
+	char *key = region_alloc(&fiber()->gc, *size);
+	if (key == NULL) {
+		diag_set(OutOfMemory, *size, "region", "key");
+		return NULL;
+	}
+	char *pos = mp_encode_array(key, key_def->part_count);
+	memcpy(pos, parts, parts_end - parts);
+	return key;
+}
+
+/**
+ * Check if two adjacent statements of the new unique index
+ * have the same key and remember the key if so.
+ */
+static int
+vy_task_build_check_dup(struct vy_task *task, struct vy_entry prev,
+			struct vy_entry entry, bool *is_dup)
+{
+	if (vy_entry_compare(prev, entry, task->key_def) != 0) {
+		*is_dup = false;
+		return 0;
+	}
+	if (*is_dup)
+		return 0;
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t size;
+	const char *key = vy_task_build_extract_key(task, entry, &size);
+	int rc = -1;
+	if (key != NULL)
+		rc = vy_task_build_add_dup_key(task, key, size, is_dup);
+	region_truncate(region, region_svp);
+	return rc;
+}
+
+static int
+vy_task_build_cmp(const void *a, const void *b, void *arg)
+{
+	return vy_entry_compare(*(const struct vy_entry *)a,
+				*(const struct vy_entry *)b,
+				(struct key_def *)arg);
+}
+
+/**
+ * Sort a chunk of statements of the new index and write them
+ * to a run. Duplicated keys of a unique index are remembered.
+ */
+static int
+vy_task_build_write_chunk(struct vy_task *task, struct vy_run *run,
+			  struct vy_entry *entries, size_t count)
+{
+	enum { YIELD_LOOPS = 32 };
+
+	struct vy_lsm *lsm = task->lsm;
+
+	ERROR_INJECT(ERRINJ_VY_RUN_WRITE,
+		     {diag_set(ClientError, ER_INJECTION,
+			       "vinyl index build"); return -1;});
+	ERROR_INJECT_SLEEP(ERRINJ_VY_RUN_WRITE_DELAY);
+
+	qsort_arg(entries, count, sizeof(*entries),
+		  vy_task_build_cmp, task->cmp_def);
+
+	struct vy_run_writer writer;
+	if (vy_run_writer_create(&writer, run, lsm->env->path,
+				 lsm->space_id, lsm->index_id,
+				 task->cmp_def, task->key_def,
+				 task->page_size, 0, task->covers,
+				 task->bloom_fpr, task->compression_level,
+				 task->compression_dict_size) != 0)
+		return -1;
+
+	bool is_dup = false;
+	struct vy_entry prev = vy_entry_none();
+	for (size_t i = 0; i < count; i++) {
+		struct vy_entry entry = entries[i];
+		/*
+		 * A multikey index may have the same key extracted
+		 * from the same tuple more than once.
+		 */
+		if (prev.stmt != NULL &&
+		    vy_entry_compare(prev, entry, task->cmp_def) == 0)
+			continue;
+		if (task->is_unique && prev.stmt != NULL &&
+		    vy_task_build_check_dup(task, prev, entry, &is_dup) != 0)
+			goto fail;
+		if (vy_run_writer_append_stmt(&writer, entry) != 0)
+			goto fail;
+		prev = entry;
+		if ((i + 1) % YIELD_LOOPS == 0)
+			fiber_sleep(0);
+		if (fiber_is_cancelled()) {
+			diag_set(FiberIsCancelled);
+			goto fail;
+		}
+	}
+	if (vy_run_writer_commit(&writer) != 0)
+		goto fail;
+	return 0;
+fail:
+	vy_run_writer_abort(&writer);
+	return -1;
+}
+
+/**
+ * Callback passed to vy_blob_resolve() by an index build task.
+ * Looks up a blob file among the files referenced by the runs
+ * of the primary index the task reads.
+ */
+static int
+vy_task_build_blob_fd_cb(void *arg, int64_t run_id)
+{
+	struct vy_task *task = arg;
+	struct vy_slice *slice;
+	rlist_foreach_entry(slice, &task->cut_slices, in_range) {
+		int fd = vy_run_blob_fd(slice->run, run_id);
+		if (fd >= 0)
+			return fd;
+	}
+	diag_set(ClientError, ER_INVALID_RUN_FILE,
+		 tt_sprintf("Blob file of run %lld not found",
+			    (long long)run_id));
+	return -1;
+}
+
+/**
+ * Convert a statement read from the primary index to a tuple
+ * of the new index. Returns NULL without setting diag if the
+ * tuple isn't visible in the build read view or is filtered
+ * out by the new index.
+ */
+static struct tuple *
+vy_task_build_new_stmt(struct vy_task *task, struct tuple *src_stmt,
+		       bool *is_failed)
+{
+	*is_failed = false;
+	int64_t lsn = vy_stmt_lsn(src_stmt);
+	if (lsn > task->build_rv.vlsn ||
+	    vy_stmt_type(src_stmt) == IPROTO_DELETE)
+		return NULL;
+	assert(vy_stmt_type(src_stmt) == IPROTO_REPLACE ||
+	       vy_stmt_type(src_stmt) == IPROTO_INSERT);
+	struct tuple *resolved = NULL;
+	if ((vy_stmt_flags(src_stmt) & VY_STMT_BLOB) != 0) {
+		resolved = vy_blob_resolve(src_stmt, vy_task_build_blob_fd_cb,
+					   task);
+		if (resolved == NULL)
+			goto fail;
+		src_stmt = resolved;
+	}
+	struct tuple *stmt = NULL;
+	if (tuple_validate(task->build_format, src_stmt) == 0) {
+		uint32_t size;
+		const char *data = tuple_data_range(src_stmt, &size);
+		stmt = vy_stmt_new_replace(task->build_format,
+					   data, data + size);
+	}
+	if (resolved != NULL)
+		tuple_unref(resolved);
+	if (stmt == NULL)
+		goto fail;
+	vy_stmt_set_lsn(stmt, lsn);
+	if (index_filter_tuple(&task->lsm->base, stmt) == NULL) {
+		tuple_unref(stmt);
+		return NULL;
+	}
+	return stmt;
+fail:
+	*is_failed = true;
+	return NULL;
+}
+
+/**
+ * Read tuples of the primary index, sort them by the key of
+ * the new index in memory and write them to the new runs,
+ * chunk by chunk.
+ */
+static int
+vy_task_build_execute(struct vy_task *task)
+{
+	enum { YIELD_LOOPS = 32 };
+
+	struct vy_stmt_stream *wi = task->wi;
+	struct tuple **stmts = NULL;
+	struct vy_entry *entries = NULL;
+	size_t stmt_count = 0, stmt_capacity = 0;
+	size_t entry_count = 0, entry_capacity = 0;
+	size_t chunk_size = 0;
+	int run_idx = 0;
+	int loops = 0;
+
+	if (wi->iface->start(wi) != 0)
+		return -1;
+	int rc;
+	struct vy_entry src = vy_entry_none();
+	while ((rc = wi->iface->next(wi, &src)) == 0 && src.stmt != NULL) {
+		bool is_failed;
+		struct tuple *stmt = vy_task_build_new_stmt(task, src.stmt,
+							    &is_failed);
+		if (is_failed) {
+			rc = -1;
+			break;
+		}
+		if (stmt == NULL)
+			continue;
+		if (stmt_count == stmt_capacity) {
+			stmt_capacity = MAX(stmt_capacity * 2, 1024);
+			struct tuple **new_stmts = realloc(stmts,
+					stmt_capacity * sizeof(*stmts));
+			if (new_stmts == NULL) {
+				diag_set(OutOfMemory,
+					 stmt_capacity * sizeof(*stmts),
+					 "realloc", "struct tuple *");
+				tuple_unref(stmt);
+				rc = -1;
+				break;
+			}
+			stmts = new_stmts;
+		}
+		stmts[stmt_count++] = stmt;
+		chunk_size += tuple_size(stmt);
+		struct vy_entry entry;
+		vy_stmt_foreach_entry(entry, stmt, task->cmp_def) {
+			if (entry_count == entry_capacity) {
+				entry_capacity = MAX(entry_capacity * 2, 1024);
+				struct vy_entry *new_entries = realloc(entries,
+					entry_capacity * sizeof(*entries));
+				if (new_entries == NULL) {
+					diag_set(OutOfMemory, entry_capacity *
+						 sizeof(*entries), "realloc",
+						 "struct vy_entry");
+					rc = -1;
+					break;
+				}
+				entries = new_entries;
+			}
+			entries[entry_count++] = entry;
+			chunk_size += sizeof(entry);
+		}
+		if (rc != 0)
+			break;
+		if (chunk_size >= task->chunk_size &&
+		    run_idx < task->build_run_count - 1) {
+			rc = vy_task_build_write_chunk(task,
+					task->build_runs[run_idx++],
+					entries, entry_count);
+			if (rc != 0)
+				break;
+			for (size_t i = 0; i < stmt_count; i++)
+				tuple_unref(stmts[i]);
+			stmt_count = entry_count = chunk_size = 0;
+		}
+		if (++loops % YIELD_LOOPS == 0)
+			fiber_sleep(0);
+		if (fiber_is_cancelled()) {
+			diag_set(FiberIsCancelled);
+			rc = -1;
+			break;
+		}
+	}
+	wi->iface->stop(wi);
+
+	if (rc == 0 && entry_count > 0) {
+		rc = vy_task_build_write_chunk(task,
+				task->build_runs[run_idx++],
+				entries, entry_count);
+	}
+	for (size_t i = 0; i < stmt_count; i++)
+		tuple_unref(stmts[i]);
+	free(stmts);
+	free(entries);
+	return rc;
+}
+
+/**
+ * Merge the runs written by index build tasks and look for
+ * keys that are duplicated in the new unique index.
+ */
+static int
+vy_task_build_check_execute(struct vy_task *task)
+{
+	enum { YIELD_LOOPS = 32 };
+
+	struct vy_stmt_stream *wi = task->wi;
+	struct region *region = &fiber()->gc;
+	char *prev_key = NULL;
+	size_t prev_key_capacity = 0;
+	bool is_dup = false;
+	int loops = 0;
+
+	if (wi->iface->start(wi) != 0)
+		return -1;
+	int rc;
+	struct vy_entry entry = vy_entry_none();
+	while ((rc = wi->iface->next(wi, &entry)) == 0 && entry.stmt != NULL) {
+		/*
+		 * The statement returned by the write iterator is
+		 * valid only until the next one is returned so we
+		 * compare keys rather than statements.
+		 */
+		size_t region_svp = region_used(region);
+		uint32_t size;
+		const char *key = vy_task_build_extract_key(task, entry,
+							    &size);
+		if (key == NULL) {
+			rc = -1;
+			break;
+		}
+		if (prev_key != NULL &&
+		    key_compare(prev_key, HINT_NONE, key, HINT_NONE,
+				task->key_def) == 0) {
+			rc = vy_task_build_add_dup_key(task, key, size,
+						       &is_dup);
+		} else {
+			is_dup = false;
+			if (size > prev_key_capacity) {
+				char *buf = realloc(prev_key, size);
+				if (buf == NULL) {
+					diag_set(OutOfMemory, size,
+						 "realloc", "key");
+					rc = -1;
+				} else {
+					prev_key = buf;
+					prev_key_capacity = size;
+				}
+			}
+			if (rc == 0)
+				memcpy(prev_key, key, size);
+		}
+		region_truncate(region, region_svp);
+		if (rc != 0)
+			break;
+		if (++loops % YIELD_LOOPS == 0)
+			fiber_sleep(0);
+		if (fiber_is_cancelled()) {
+			diag_set(FiberIsCancelled);
+			rc = -1;
+			break;
+		}
+	}
+	wi->iface->stop(wi);
+	free(prev_key);
+	return rc;
+}
+
+/**
+ * Create a task building a secondary index from the primary
+ * index ranges [@begin_range, @end_range). If @is_unique is set,
+ * the task remembers keys duplicated in the new index. The runs
+ * the task is going to write are prepared by
+ * vy_task_build_prepare_runs().
+ */
+static struct vy_task *
+vy_task_build_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
+		  struct vy_lsm *lsm, struct tuple_format *format,
+		  int64_t vlsn, bool is_unique, struct vy_range *begin_range,
+		  struct vy_range *end_range)
+{
+	static struct vy_task_ops build_ops = {
+		.execute = vy_task_build_execute,
+	};
+	struct vy_lsm *pk = lsm->pk;
+	struct vy_task *task = vy_task_new(scheduler, worker, lsm, &build_ops);
+	if (task == NULL)
+		return NULL;
+
+	task->bloom_fpr = lsm->opts.bloom_fpr;
+	task->page_size = lsm->opts.page_size;
+	task->covers = lsm->opts.covers;
+	task->compression_level = vy_lsm_compression_level(lsm);
+	task->compression_dict_size = lsm->opts.compression_dict_size;
+	task->is_unique = is_unique;
+	task->chunk_size = MIN(vy_lsm_range_size(lsm), VY_BUILD_MAX_CHUNK_SIZE);
+	task->build_rv.vlsn = vlsn;
+	rlist_add_entry(&task->build_read_views, &task->build_rv,
+			in_read_views);
+	task->build_format = format;
+	tuple_format_ref(format);
+	task->src_format = pk->disk_format;
+	tuple_format_ref(pk->disk_format);
+	task->src_cmp_def = key_def_dup(pk->cmp_def);
+	if (task->src_cmp_def == NULL)
+		goto err;
+	/*
+	 * Only the newest statement visible in the read view is
+	 * needed for each key so the write iterator is told that
+	 * it reads the last level.
+	 */
+	task->wi = vy_write_iterator_new(task->src_cmp_def, true, true,
+					 &task->build_read_views, NULL);
+	if (task->wi == NULL)
+		goto err;
+
+	struct vy_range *range;
+	for (range = begin_range; range != end_range;
+	     range = vy_range_tree_next(&pk->range_tree, range)) {
+		struct vy_slice *slice, *copy;
+		rlist_foreach_entry(slice, &range->slices, in_range) {
+			copy = vy_slice_new(slice->id, slice->run, slice->begin,
+					    slice->end, pk->cmp_def);
+			if (copy == NULL)
+				goto err;
+			rlist_add_tail_entry(&task->cut_slices, copy, in_range);
+			if (vy_write_iterator_new_slice(task->wi, copy,
+							task->src_format) != 0)
+				goto err;
+		}
+	}
+	return task;
+err:
+	if (task->wi != NULL)
+		task->wi->iface->close(task->wi);
+	vy_task_delete(task);
+	return NULL;
+}
+
+/**
+ * Prepare runs for an index build task. Since we don't know
+ * how many statements the task is going to write, we estimate
+ * the number of runs by the size of the primary index slices
+ * the task reads. Unused runs are discarded on completion.
+ */
+static int
+vy_task_build_prepare_runs(struct vy_task *task)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+	int64_t size = 0;
+	struct vy_slice *slice;
+	rlist_foreach_entry(slice, &task->cut_slices, in_range) {
+		size += slice->count.bytes +
+			slice->count.rows * sizeof(struct vy_entry);
+	}
+	int run_count = size / task->chunk_size + 2;
+	task->build_runs = calloc(run_count, sizeof(*task->build_runs));
+	if (task->build_runs == NULL) {
+		diag_set(OutOfMemory, run_count * sizeof(*task->build_runs),
+			 "malloc", "struct vy_run *");
+		return -1;
+	}
+	for (int i = 0; i < run_count; i++) {
+		struct vy_run *run = vy_run_new(scheduler->run_env,
+						vy_log_next_id());
+		if (run == NULL)
+			goto fail;
+		run->dump_lsn = task->build_rv.vlsn;
+		run->dump_count = 1;
+		task->build_runs[task->build_run_count++] = run;
+	}
+	vy_log_tx_begin();
+	for (int i = 0; i < run_count; i++)
+		vy_log_prepare_run(lsm->id, task->build_runs[i]->id);
+	if (vy_log_tx_commit() < 0)
+		goto fail;
+	return 0;
+fail:
+	for (int i = 0; i < task->build_run_count; i++)
+		vy_run_unref(task->build_runs[i]);
+	task->build_run_count = 0;
+	return -1;
+}
+
+/**
+ * Create a task that merges the runs written by index build
+ * tasks and looks for duplicates in the new unique index.
+ */
+static struct vy_task *
+vy_task_build_check_new(struct vy_scheduler *scheduler,
+			struct vy_worker *worker, struct vy_lsm *lsm,
+			struct vy_run **runs, int run_count)
+{
+	static struct vy_task_ops build_check_ops = {
+		.execute = vy_task_build_check_execute,
+	};
+	struct vy_task *task = vy_task_new(scheduler, worker, lsm,
+					   &build_check_ops);
+	if (task == NULL)
+		return NULL;
+	task->is_unique = true;
+	task->wi = vy_write_iterator_new(task->cmp_def, false, true,
+					 &task->build_read_views, NULL);
+	if (task->wi == NULL)
+		goto err;
+	for (int i = 0; i < run_count; i++) {
+		struct vy_slice *slice = vy_slice_new(vy_log_next_id(), runs[i],
+						      vy_entry_none(),
+						      vy_entry_none(),
+						      lsm->cmp_def);
+		if (slice == NULL)
+			goto err;
+		rlist_add_tail_entry(&task->cut_slices, slice, in_range);
+		if (vy_write_iterator_new_slice(task->wi, slice,
+						lsm->disk_format) != 0)
+			goto err;
+	}
+	return task;
+err:
+	if (task->wi != NULL)
+		task->wi->iface->close(task->wi);
+	vy_task_delete(task);
+	return NULL;
+}
+
+/**
+ * Add runs written by index build tasks to the new LSM tree.
+ */
+static int
+vy_task_build_commit(struct vy_lsm *lsm, struct vy_run **runs,
+		     int run_count, int64_t vlsn)
+{
+	struct vy_range *range, *begin_range, *end_range;
+	struct vy_slice *slice, *next_slice;
+	int i;
+
+	/*
+	 * The LSM tree isn't compacted while it is bulk loaded
+	 * so its ranges can't change under us. For each run we
+	 * create a slice per intersected range and remember the
+	 * range in @new_ranges.
+	 */
+	assert(lsm->is_bulk_loading);
+	int max_slice_count = run_count * lsm->range_count;
+	struct vy_slice **new_slices = calloc(max_slice_count,
+					      sizeof(*new_slices) +
+					      sizeof(struct vy_range *));
+	if (new_slices == NULL) {
+		diag_set(OutOfMemory, max_slice_count * (sizeof(*new_slices) +
+			 sizeof(struct vy_range *)), "malloc",
+			 "struct vy_slice *");
+		return -1;
+	}
+	struct vy_range **new_ranges = (void *)(new_slices + max_slice_count);
+	int slice_count = 0;
+	for (i = 0; i < run_count; i++) {
+		struct vy_run *run = runs[i];
+		if (vy_lsm_find_range_intersection(lsm, run->info.min_key,
+						   run->info.max_key,
+						   &begin_range,
+						   &end_range) != 0)
+			goto fail;
+		for (range = begin_range; range != end_range;
+		     range = vy_range_tree_next(&lsm->range_tree, range)) {
+			slice = vy_slice_new(vy_log_next_id(), run,
+					     range->begin, range->end,
+					     lsm->cmp_def);
+			if (slice == NULL)
+				goto fail;
+			assert(slice_count < max_slice_count);
+			new_slices[slice_count] = slice;
+			new_ranges[slice_count] = range;
+			slice_count++;
+		}
+	}
+
+	vy_log_tx_begin();
+	for (i = 0; i < run_count; i++) {
+		vy_log_create_run(lsm->id, runs[i]->id, vlsn,
+				  runs[i]->dump_count);
+	}
+	for (i = 0; i < slice_count; i++) {
+		slice = new_slices[i];
+		vy_log_insert_slice(new_ranges[i]->id, slice->run->id,
+				    slice->id,
+				    tuple_data_or_null(slice->begin.stmt),
+				    tuple_data_or_null(slice->end.stmt));
+	}
+	vy_log_dump_lsm(lsm->id, vlsn);
+	if (vy_log_tx_commit() < 0)
+		goto fail;
+
+	/*
+	 * Add new slices to ranges. The runs store statements
+	 * older than those dumped while the index was being
+	 * built so the slices are inserted after newer slices
+	 * to keep the list sorted by LSN, as on recovery, see
+	 * vy_recovery_insert_slice().
+	 */
+	for (i = 0; i < run_count; i++)
+		vy_lsm_add_run(lsm, runs[i]);
+	for (i = 0; i < slice_count; i++) {
+		slice = new_slices[i];
+		range = new_ranges[i];
+		vy_lsm_unacct_range(lsm, range);
+		rlist_foreach_entry(next_slice, &range->slices, in_range) {
+			if (next_slice->run->dump_lsn < vlsn)
+				break;
+		}
+		vy_range_add_slice_before(range, slice, next_slice);
+		vy_range_update_compaction_priority(range, &lsm->opts);
+		vy_range_update_dumps_per_compaction(range);
+		vy_lsm_acct_range(lsm, range);
+	}
+	vy_range_heap_update_all(&lsm->range_heap);
+	lsm->dump_lsn = MAX(lsm->dump_lsn, vlsn);
+	free(new_slices);
+	return 0;
+fail:
+	for (i = 0; i < slice_count; i++)
+		vy_slice_delete(new_slices[i]);
+	free(new_slices);
+	return -1;
+}
+
+/** Pass keys found duplicated by an index build task to @check_key. */
+static int
+vy_task_build_check_dup_keys(struct vy_task *task,
+			     vy_scheduler_check_key_f check_key, void *arg)
+{
+	const char *key = task->dup_keys;
+	const char *end = task->dup_keys + task->dup_keys_size;
+	while (key < end) {
+		if (check_key(arg, key) != 0)
+			return -1;
+		mp_next(&key);
+	}
+	return 0;
+}
+
+int
+vy_scheduler_build_lsm(struct vy_scheduler *scheduler, struct vy_lsm *lsm,
+		       struct tuple_format *format, int64_t vlsn,
+		       vy_scheduler_check_key_f check_key, void *arg)
+{
+	struct vy_lsm *pk = lsm->pk;
+	struct vy_worker_pool *pool = &scheduler->compaction_pool;
+	struct vy_worker **workers = NULL;
+	struct vy_worker *worker;
+	struct vy_task *task = NULL, *part, *check_task = NULL;
+	struct vy_run **runs = NULL;
+	struct vy_range *begin_range, *end_range;
+	struct vy_mem *mem;
+	bool is_started = false, is_committed = false;
+	int worker_count = 0, run_count = 0;
+	int i, j, rc = -1;
+
+	struct fiber_cond done_cond;
+	fiber_cond_create(&done_cond);
+	lsm->is_bulk_loading = true;
+
+	/*
+	 * Dump the primary index so that all statements visible
+	 * in the read view are stored on disk.
+	 */
+	bool need_dump = pk->mem->tree.size > 0;
+	rlist_foreach_entry(mem, &pk->sealed, in_sealed) {
+		if (mem->tree.size > 0)
+			need_dump = true;
+	}
+	if (need_dump && vy_scheduler_dump(scheduler) != 0)
+		goto out;
+
+	/*
+	 * Wait for an idle compaction worker and take as many more
+	 * as there are ranges in the primary index, but no more
+	 * than max_subcompactions.
+	 */
+	int max_worker_count = MIN(scheduler->max_subcompactions,
+				   pk->range_count);
+	max_worker_count = MAX(max_worker_count, 1);
+	workers = calloc(max_worker_count, sizeof(*workers));
+	if (workers == NULL) {
+		diag_set(OutOfMemory, max_worker_count * sizeof(*workers),
+			 "malloc", "struct vy_worker *");
+		goto out;
+	}
+	while ((worker = vy_worker_pool_get(pool)) == NULL)
+		fiber_cond_wait(&pool->idle_cond);
+	workers[worker_count++] = worker;
+	while (worker_count < max_worker_count &&
+	       (worker = vy_worker_pool_get(pool)) != NULL)
+		workers[worker_count++] = worker;
+
+	/*
+	 * Split the primary index ranges between the workers so
+	 * that each of them reads about the same amount of data.
+	 * Since a range may have been split or coalesced while we
+	 * were waiting, a worker may be left without ranges.
+	 */
+	int64_t total_size = 0, size = 0;
+	for (begin_range = vy_range_tree_first(&pk->range_tree);
+	     begin_range != NULL;
+	     begin_range = vy_range_tree_next(&pk->range_tree, begin_range))
+		total_size += begin_range->count.bytes;
+	begin_range = vy_range_tree_first(&pk->range_tree);
+	for (i = 0; i < worker_count && begin_range != NULL; i++) {
+		end_range = begin_range;
+		do {
+			size += end_range->count.bytes;
+			end_range = vy_range_tree_next(&pk->range_tree,
+						       end_range);
+		} while (end_range != NULL && (i == worker_count - 1 ||
+			 size < total_size * (i + 1) / worker_count));
+		part = vy_task_build_new(scheduler, workers[i], lsm, format,
+					 vlsn, check_key != NULL,
+					 begin_range, end_range);
+		if (part == NULL)
+			goto out;
+		workers[i] = NULL;
+		part->done_cond = &done_cond;
+		if (task == NULL) {
+			task = part;
+			task->parts = calloc(worker_count,
+					     sizeof(*task->parts));
+			if (task->parts == NULL) {
+				diag_set(OutOfMemory, worker_count *
+					 sizeof(*task->parts), "malloc",
+					 "struct vy_task *");
+				goto out;
+			}
+			task->parts[task->part_count++] = task;
+		} else {
+			part->parent = task;
+			task->parts[task->part_count++] = part;
+		}
+		begin_range = end_range;
+	}
+	for (i = 0; i < task->part_count; i++) {
+		if (vy_task_build_prepare_runs(task->parts[i]) != 0)
+			goto out;
+	}
+
+	say_info("%s: building index from %s using %d threads",
+		 vy_lsm_name(lsm), vy_lsm_name(pk), task->part_count);
+
+	/* Execute the tasks and wait for them to complete. */
+	task->in_progress = task->part_count;
+	for (i = 0; i < task->part_count; i++) {
+		part = task->parts[i];
+		cmsg_init(&part->cmsg, vy_task_execute_route);
+		cpipe_push(&part->worker->worker_pipe, &part->cmsg);
+	}
+	is_started = true;
+	while (task->in_progress > 0)
+		fiber_cond_wait(&done_cond);
+	for (i = 0; i < task->part_count; i++) {
+		part = task->parts[i];
+		if (part->is_failed) {
+			diag_move(&part->diag, diag_get());
+			goto out;
+		}
+		run_count += part->build_run_count;
+	}
+
+	/* Collect the runs that were written. */
+	runs = calloc(MAX(run_count, 1), sizeof(*runs));
+	if (runs == NULL) {
+		diag_set(OutOfMemory, run_count * sizeof(*runs),
+			 "malloc", "struct vy_run *");
+		goto out;
+	}
+	run_count = 0;
+	for (i = 0; i < task->part_count; i++) {
+		part = task->parts[i];
+		for (j = 0; j < part->build_run_count; j++) {
+			if (!vy_run_is_empty(part->build_runs[j]))
+				runs[run_count++] = part->build_runs[j];
+		}
+	}
+
+	/*
+	 * Tasks look for duplicates in the new unique index only
+	 * among statements that are written to the same run. If
+	 * there is more than one run, merge them to find the rest.
+	 */
+	if (task->is_unique && run_count > 1) {
+		check_task = vy_task_build_check_new(scheduler, task->worker,
+						     lsm, runs, run_count);
+		if (check_task == NULL)
+			goto out;
+		check_task->done_cond = &done_cond;
+		cmsg_init(&check_task->cmsg, vy_task_execute_route);
+		cpipe_push(&task->worker->worker_pipe, &check_task->cmsg);
+		while (check_task->in_progress > 0)
+			fiber_cond_wait(&done_cond);
+		if (check_task->is_failed) {
+			diag_move(&check_task->diag, diag_get());
+			goto out;
+		}
+	}
+
+	if (run_count > 0 &&
+	    vy_task_build_commit(lsm, runs, run_count, vlsn) != 0)
+		goto out;
+	is_committed = true;
+	lsm->is_bulk_loading = false;
+	vy_scheduler_update_lsm(scheduler, lsm);
+
+	/*
+	 * Keys that were duplicated in the read view may have been
+	 * overwritten since then so let the caller check them.
+	 */
+	if (check_task != NULL) {
+		if (vy_task_build_check_dup_keys(check_task, check_key,
+						 arg) != 0)
+			goto out;
+	} else {
+		for (i = 0; i < task->part_count; i++) {
+			if (vy_task_build_check_dup_keys(task->parts[i],
+							 check_key, arg) != 0)
+				goto out;
+		}
+	}
+	rc = 0;
+out:
+	if (lsm->is_bulk_loading) {
+		lsm->is_bulk_loading = false;
+		vy_scheduler_update_lsm(scheduler, lsm);
+	}
+	if (check_task != NULL) {
+		check_task->wi->iface->close(check_task->wi);
+		vy_task_delete(check_task);
+	}
+	for (i = 0; task != NULL && i < task->part_count; i++) {
+		part = task->parts[i];
+		part->wi->iface->close(part->wi);
+		/*
+		 * Workers of started tasks are put back to the pool
+		 * on completion, except for the worker of the parent
+		 * task, which is reused for the check task.
+		 */
+		if (!is_started || part == task)
+			vy_worker_pool_put(part->worker);
+		for (j = 0; j < part->build_run_count; j++) {
+			struct vy_run *run = part->build_runs[j];
+			if (is_committed && !vy_run_is_empty(run))
+				vy_run_unref(run);
+			else
+				vy_run_discard(run);
+		}
+	}
+	if (task != NULL) {
+		if (task->parts == NULL) {
+			/* Failed to allocate the parts array. */
+			task->wi->iface->close(task->wi);
+			vy_worker_pool_put(task->worker);
+		}
+		vy_task_delete(task);
+	}
+	for (i = 0; i < worker_count; i++) {
+		if (workers[i] != NULL)
+			vy_worker_pool_put(workers[i]);
+	}
+	free(workers);
+	free(runs);
+	fiber_cond_destroy(&done_cond);
+	return rc;
+}
+
 /**
  * Fiber function that actually executes a vinyl task.
  * After finishing a task, it sends it back to tx.
@@ -1789,11 +3432,37 @@ vy_task_execute_f(struct cmsg *cmsg)
  * task from a worker thread. It adds the task to the processed
  * task queue and wakes up the scheduler so that it can complete
  * it.
+ *
+ * If the task is a part of a split compaction task, the worker
+ * is put back to the pool right away while the parent task is
+ * queued for completion only after all its parts are done.
  */
 static void
 vy_task_complete_f(struct cmsg *cmsg)
 {
 	struct vy_task *task = container_of(cmsg, struct vy_task, cmsg);
+	if (task->done_cond != NULL) {
+		/*
+		 * The task is completed by the waiting fiber, which
+		 * reuses the worker of the parent task, see
+		 * vy_scheduler_build_lsm().
+		 */
+		if (task->parent != NULL) {
+			vy_worker_pool_put(task->worker);
+			task = task->parent;
+		}
+		assert(task->in_progress > 0);
+		if (--task->in_progress == 0)
+			fiber_cond_signal(task->done_cond);
+		return;
+	}
+	if (task->parent != NULL) {
+		vy_worker_pool_put(task->worker);
+		task = task->parent;
+	}
+	assert(task->in_progress > 0);
+	if (--task->in_progress > 0)
+		return;
 	stailq_add_tail_entry(&task->scheduler->processed_tasks,
 			      task, in_processed);
 	fiber_cond_signal(&task->scheduler->scheduler_cond);
@@ -1962,6 +3631,13 @@ vy_task_complete(struct vy_task *task)
 	scheduler->stat.tasks_inprogress--;
 
 	struct diag *diag = &task->diag;
+	for (int i = 1; i < task->part_count && !task->is_failed; i++) {
+		struct vy_task *part = task->parts[i];
+		if (part->is_failed) {
+			task->is_failed = true;
+			diag_move(&part->diag, diag);
+		}
+	}
 	if (task->is_failed) {
 		assert(!diag_is_empty(diag));
 		goto fail; /* ->execute fialed */
@@ -1987,10 +3663,26 @@ fail:
 	return -1;
 }
 
+/**
+ * Schedule major compaction of ranges whose oldest run has
+ * outlived the compaction_ttl index option.
+ */
+static void
+vy_scheduler_check_compaction_ttl(struct vy_scheduler *scheduler)
+{
+	struct vy_lsm *lsm;
+	struct heap_iterator it;
+	vy_compaction_heap_iterator_init(&scheduler->compaction_heap, &it);
+	while ((lsm = vy_compaction_heap_iterator_next(&it)) != NULL)
+		vy_lsm_check_compaction_ttl(lsm);
+	vy_compaction_heap_update_all(&scheduler->compaction_heap);
+}
+
 static int
 vy_scheduler_f(va_list va)
 {
 	struct vy_scheduler *scheduler = va_arg(va, struct vy_scheduler *);
+	double last_ttl_check = fiber_clock();
 
 	while (scheduler->scheduler_fiber != NULL) {
 		struct stailq processed_tasks;
@@ -2030,19 +3722,31 @@ vy_scheduler_f(va_list va)
 		/* Throttle for a while if a task failed. */
 		if (tasks_failed > 0)
 			goto error;
+		/* Check if any ranges need compaction due to TTL. */
+		if (fiber_clock() - last_ttl_check >=
+		    VY_SCHEDULER_TTL_CHECK_INTERVAL) {
+			vy_scheduler_check_compaction_ttl(scheduler);
+			last_ttl_check = fiber_clock();
+		}
 		/* Get a task to schedule. */
 		if (vy_schedule(scheduler, &task) != 0)
 			goto error;
 		/* Nothing to do or all workers are busy. */
 		if (task == NULL) {
 			/* Wait for changes. */
-			fiber_cond_wait(&scheduler->scheduler_cond);
+			fiber_cond_wait_timeout(&scheduler->scheduler_cond,
+						VY_SCHEDULER_TTL_CHECK_INTERVAL);
 			continue;
 		}
 
 		/* Queue the task for execution. */
 		cmsg_init(&task->cmsg, vy_task_execute_route);
 		cpipe_push(&task->worker->worker_pipe, &task->cmsg);
+		for (int i = 1; i < task->part_count; i++) {
+			struct vy_task *part = task->parts[i];
+			cmsg_init(&part->cmsg, vy_task_execute_route);
+			cpipe_push(&part->worker->worker_pipe, &part->cmsg);
+		}
 
 		fiber_reschedule();
 		continue;
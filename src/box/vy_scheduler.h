@@ -48,6 +48,7 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct fiber;
+struct tuple_format;
 struct vy_lsm;
 struct vy_run_env;
 struct vy_worker;
@@ -57,6 +58,15 @@ typedef void
 (*vy_scheduler_dump_complete_f)(struct vy_scheduler *scheduler,
 				int64_t dump_generation, double dump_duration);
 
+/**
+ * Callback invoked by vy_scheduler_build_lsm() for each key
+ * that may be duplicated in a new unique index. It is passed
+ * a MsgPack array of the index key parts. Should return -1
+ * and set diag if the key is duplicated.
+ */
+typedef int
+(*vy_scheduler_check_key_f)(void *arg, const char *key);
+
 struct vy_worker_pool {
 	/** Name of the pool. Used for naming threads. */
 	const char *name;
@@ -66,6 +76,8 @@ struct vy_worker_pool {
 	struct vy_worker *workers;
 	/** List of workers that are currently idle. */
 	struct stailq idle_workers;
+	/** Signaled when a worker is put back to the pool. */
+	struct fiber_cond idle_cond;
 };
 
 struct vy_scheduler {
@@ -98,6 +110,13 @@ struct vy_scheduler {
 	double timeout;
 	/** Set if the scheduler is throttled due to errors. */
 	bool is_throttled;
+	/**
+	 * Max number of worker threads a single compaction task
+	 * can use, see box.cfg.vinyl_max_subcompactions. If it is
+	 * greater than 1, compaction of a big range is split in
+	 * several parts by key that are executed in parallel.
+	 */
+	int max_subcompactions;
 	/** Set if checkpoint is in progress. */
 	bool checkpoint_in_progress;
 	/**
@@ -213,6 +232,32 @@ vy_scheduler_trigger_dump(struct vy_scheduler *scheduler);
 int
 vy_scheduler_dump(struct vy_scheduler *scheduler);
 
+/**
+ * Build a new secondary index from the runs of the primary
+ * index in worker threads.
+ *
+ * The in-memory trees of the primary index are dumped first.
+ * Then its ranges are split between up to max_subcompactions
+ * idle compaction workers. Each of them reads tuples visible
+ * at @vlsn, validates them against @format, sorts them by the
+ * new index key in memory in chunks of about range_size and
+ * writes each chunk to a run of the new index. The runs are
+ * added to the LSM tree with dump LSN equal to @vlsn so that
+ * statements inserted into the space after @vlsn, which are
+ * forwarded to the LSM tree by the caller, take precedence.
+ *
+ * If @check_key isn't NULL, keys that are found duplicated in
+ * the new index at @vlsn are passed to it after the runs are
+ * added to the LSM tree, because they may have been overwritten
+ * since then.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+vy_scheduler_build_lsm(struct vy_scheduler *scheduler, struct vy_lsm *lsm,
+		       struct tuple_format *format, int64_t vlsn,
+		       vy_scheduler_check_key_f check_key, void *arg);
+
 /**
  * Force major compaction of an LSM tree.
  */
@@ -101,6 +101,17 @@ struct vy_run_iterator_stat {
 	 * of disk reads.
 	 */
 	struct vy_disk_stmt_counter read;
+	/** Read-ahead statistics. */
+	struct {
+		/** Number of pages read ahead. */
+		int64_t pages;
+		/**
+		 * Number of pages read ahead that were then used
+		 * by the iterator. The rest were dropped, because
+		 * the iterator stopped or changed the position.
+		 */
+		int64_t used;
+	} readahead;
 };
 
 /** TX write set iterator statistics. */
@@ -127,6 +138,11 @@ struct vy_lsm_stat {
 	struct {
 		/** How many upsert chains have been squashed. */
 		int64_t squashed;
+		/**
+		 * How many upsert chains have been scheduled for
+		 * squashing in the background.
+		 */
+		int64_t scheduled;
 		/** How many upserts have been applied on read. */
 		int64_t applied;
 	} upsert;
@@ -45,6 +45,7 @@
 #include "tuple_format.h"
 #include "xrow.h"
 #include "fiber.h"
+#include "column_mask.h"
 
 /**
  * Statement metadata keys.
@@ -683,9 +684,62 @@ vy_stmt_encode_primary(struct tuple *value, struct key_def *key_def,
 	return 0;
 }
 
+/**
+ * Project a tuple onto the fields stored in a covering secondary
+ * index: fields that are neither indexed nor covered are replaced
+ * with MP_NIL, trailing ones are dropped. The projection keeps
+ * field numbers so it can be compared with full tuples using the
+ * same cmp_def. Returns the projection allocated on the fiber
+ * region or NULL on memory allocation error.
+ */
+static const char *
+vy_stmt_project(struct tuple *value, struct key_def *cmp_def,
+		uint64_t covers, uint32_t *size)
+{
+	uint64_t column_mask = covers | cmp_def->column_mask;
+	const char *data = tuple_data(value);
+	uint32_t field_count = mp_decode_array(&data);
+	const char *field = data;
+	uint32_t projected_count = 0;
+	size_t projected_size = 0;
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field_end = field;
+		mp_next(&field_end);
+		if (column_mask_fieldno_is_set(column_mask, i)) {
+			projected_size += field_end - field +
+				(i - projected_count) * mp_sizeof_nil();
+			projected_count = i + 1;
+		}
+		field = field_end;
+	}
+	projected_size += mp_sizeof_array(projected_count);
+	char *buf = region_alloc(&fiber()->gc, projected_size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, projected_size, "region", "projection");
+		return NULL;
+	}
+	char *pos = mp_encode_array(buf, projected_count);
+	field = data;
+	for (uint32_t i = 0; i < projected_count; i++) {
+		const char *field_end = field;
+		mp_next(&field_end);
+		if (column_mask_fieldno_is_set(column_mask, i)) {
+			memcpy(pos, field, field_end - field);
+			pos += field_end - field;
+		} else {
+			pos = mp_encode_nil(pos);
+		}
+		field = field_end;
+	}
+	assert(pos == buf + projected_size);
+	*size = projected_size;
+	return buf;
+}
+
 int
 vy_stmt_encode_secondary(struct tuple *value, struct key_def *cmp_def,
-			 int multikey_idx, struct xrow_header *xrow)
+			 int multikey_idx, uint64_t covers,
+			 struct xrow_header *xrow)
 {
 	memset(xrow, 0, sizeof(*xrow));
 	enum iproto_type type = vy_stmt_type(value);
@@ -696,10 +750,16 @@ vy_stmt_encode_secondary(struct tuple *value, struct key_def *cmp_def,
 	memset(&request, 0, sizeof(request));
 	request.type = type;
 	uint32_t size;
-	const char *extracted = vy_stmt_is_key(value) ?
-				tuple_data_range(value, &size) :
-				tuple_extract_key(value, cmp_def,
-						  multikey_idx, &size);
+	const char *extracted;
+	if (vy_stmt_is_key(value)) {
+		extracted = tuple_data_range(value, &size);
+	} else if (covers != 0 && type != IPROTO_DELETE) {
+		assert(multikey_idx == MULTIKEY_NONE);
+		extracted = vy_stmt_project(value, cmp_def, covers, &size);
+	} else {
+		extracted = tuple_extract_key(value, cmp_def,
+					      multikey_idx, &size);
+	}
 	if (extracted == NULL)
 		return -1;
 	if (type == IPROTO_REPLACE || type == IPROTO_INSERT) {
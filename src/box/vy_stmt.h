@@ -58,7 +58,13 @@ struct iovec;
 #define MAX_LSN (INT64_MAX / 2)
 
 enum {
+	/**
+	 * Default and max number of successive UPSERTs for the same
+	 * key after which they are squashed in the background, see
+	 * box.cfg.vinyl_upsert_squash_threshold.
+	 */
 	VY_UPSERT_THRESHOLD = 128,
+	/** Marks an UPSERT chain that is being squashed. */
 	VY_UPSERT_INF,
 };
 static_assert(VY_UPSERT_THRESHOLD <= UINT8_MAX, "n_upserts max value");
@@ -136,11 +142,20 @@ enum {
 	 * compaction. It is never written to disk.
 	 */
 	VY_STMT_UPDATE			= 1 << 2,
+	/**
+	 * This flag is set for REPLACE and INSERT statements
+	 * stored in a primary index run that had some of their
+	 * fields moved to a blob file. Such fields are replaced
+	 * with references to the blob file, see vy_blob.h.
+	 * A statement with references resolved doesn't have
+	 * this flag.
+	 */
+	VY_STMT_BLOB			= 1 << 3,
 	/**
 	 * Bit mask of all statement flags.
 	 */
 	VY_STMT_FLAGS_ALL = (VY_STMT_DEFERRED_DELETE | VY_STMT_SKIP_READ |
-			     VY_STMT_UPDATE),
+			     VY_STMT_UPDATE | VY_STMT_BLOB),
 };
 
 /**
@@ -426,6 +441,45 @@ vy_stmt_compare_with_raw_key(struct tuple *stmt, hint_t stmt_hint,
 	return key_compare(tuple_data(stmt), stmt_hint, key, key_hint, key_def);
 }
 
+/**
+ * Compare the primary key of a vinyl statement with a raw key
+ * (msgpack array). @pk_def is the primary key definition. For
+ * a statement of a secondary index, @pk_in_cmp_def must be set
+ * to the definition of the primary key parts in the secondary
+ * key, see vy_lsm::pk_in_cmp_def. Comparison hints aren't used.
+ */
+static inline int
+vy_stmt_compare_pk_with_raw_key(struct tuple *stmt, const char *key,
+				struct key_def *pk_def,
+				struct key_def *pk_in_cmp_def)
+{
+	if (pk_in_cmp_def != NULL && vy_stmt_is_key(stmt)) {
+		uint32_t part_count = mp_decode_array(&key);
+		return tuple_compare_with_key(stmt, HINT_NONE, key,
+					      part_count, HINT_NONE,
+					      pk_in_cmp_def);
+	}
+	return vy_stmt_compare_with_raw_key(stmt, HINT_NONE, key,
+					    HINT_NONE, pk_def);
+}
+
+/**
+ * Check if the primary key of a vinyl statement falls in
+ * the range [begin, end] (msgpack arrays). A partial bound
+ * matches all keys it is a prefix of, an empty one matches
+ * any key. See vy_stmt_compare_pk_with_raw_key() for the
+ * meaning of @pk_def and @pk_in_cmp_def.
+ */
+static inline bool
+vy_stmt_pk_in_range(struct tuple *stmt, const char *begin, const char *end,
+		    struct key_def *pk_def, struct key_def *pk_in_cmp_def)
+{
+	return vy_stmt_compare_pk_with_raw_key(stmt, begin, pk_def,
+					       pk_in_cmp_def) >= 0 &&
+	       vy_stmt_compare_pk_with_raw_key(stmt, end, pk_def,
+					       pk_in_cmp_def) <= 0;
+}
+
 /**
  * Create a key statement from raw MessagePack data.
  * @param format     Format of an index.
@@ -659,6 +713,8 @@ vy_stmt_encode_primary(struct tuple *value, struct key_def *key_def,
  * @param value statement to encode
  * @param key_def key definition
  * @param multikey_idx multikey index hint
+ * @param covers column mask of fields covered by the index,
+ * stored along with the key in REPLACE statements
  * @param xrow[out] xrow to fill
  *
  * @retval 0 if OK
@@ -666,7 +722,8 @@ vy_stmt_encode_primary(struct tuple *value, struct key_def *key_def,
  */
 int
 vy_stmt_encode_secondary(struct tuple *value, struct key_def *cmp_def,
-			 int multikey_idx, struct xrow_header *xrow);
+			 int multikey_idx, uint64_t covers,
+			 struct xrow_header *xrow);
 
 /**
  * Reconstruct vinyl tuple info and data from xrow
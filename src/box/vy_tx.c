@@ -329,6 +329,8 @@ vy_tx_create(struct vy_tx_manager *xm, struct vy_tx *tx)
 	tx->is_applier_session = false;
 	tx->read_view = (struct vy_read_view *)xm->p_global_read_view;
 	vy_tx_read_set_new(&tx->read_set);
+	tx->tombstone = NULL;
+	tx->tombstone_lsm = NULL;
 	tx->psn = 0;
 	rlist_create(&tx->on_destroy);
 	rlist_create(&tx->in_writers);
@@ -348,6 +350,11 @@ vy_tx_destroy(struct vy_tx *tx)
 
 	vy_tx_read_set_iter(&tx->read_set, NULL, vy_tx_read_set_free_cb, NULL);
 	rlist_del_entry(tx, in_writers);
+
+	if (tx->tombstone != NULL)
+		vy_tombstone_delete(tx->tombstone);
+	if (tx->tombstone_lsm != NULL)
+		vy_lsm_unref(tx->tombstone_lsm);
 }
 
 /** Mark a transaction as aborted and account it in stats. */
@@ -363,7 +370,7 @@ vy_tx_abort(struct vy_tx *tx)
 static bool
 vy_tx_is_ro(struct vy_tx *tx)
 {
-	return write_set_empty(&tx->write_set);
+	return write_set_empty(&tx->write_set) && tx->tombstone == NULL;
 }
 
 /** Return true if the transaction is in read view. */
@@ -422,6 +429,93 @@ vy_tx_abort_readers(struct vy_tx *tx, struct txv *v)
 	}
 }
 
+/**
+ * Return the next transaction that has read a key deleted by
+ * the range tombstone written by transaction @tx, starting from
+ * read interval @interval of the primary index, or NULL. On
+ * return @interval points to the interval that follows the one
+ * the transaction was found by.
+ *
+ * Only the primary index read set is checked: a transaction that
+ * reads a tuple from a secondary index tracks its full key in the
+ * primary index, and deleting tuples can't affect anything else
+ * it has read.
+ *
+ * Bounds that are equal up to the length of the shorter one are
+ * treated as intersecting, which may result in a false conflict,
+ * but never in a missed one.
+ */
+static struct vy_tx *
+vy_tx_range_conflict_next(struct vy_tx *tx,
+			  struct vy_read_interval **interval)
+{
+	struct vy_lsm *pk = tx->tombstone_lsm;
+	struct vy_tombstone *tombstone = tx->tombstone;
+	struct key_def *cmp_def = pk->cmp_def;
+	struct vy_read_interval *curr = *interval;
+	for (; curr != NULL;
+	     curr = vy_lsm_read_set_next(&pk->read_set, curr)) {
+		/*
+		 * Intervals are sorted by the left bound so all
+		 * intervals that follow start after the range.
+		 */
+		if (vy_entry_compare_with_raw_key(curr->left, tombstone->end,
+						  HINT_NONE, cmp_def) > 0) {
+			curr = NULL;
+			break;
+		}
+		if (curr->tx == tx || curr->tx->state != VINYL_TX_READY)
+			continue;
+		if (vy_entry_compare_with_raw_key(curr->right,
+						  tombstone->begin,
+						  HINT_NONE, cmp_def) >= 0)
+			break;
+	}
+	if (curr == NULL) {
+		*interval = NULL;
+		return NULL;
+	}
+	*interval = vy_lsm_read_set_next(&pk->read_set, curr);
+	return curr->tx;
+}
+
+/**
+ * Send to read view all transactions that have read keys
+ * deleted by the range tombstone written by transaction @tx.
+ */
+static int
+vy_tx_send_range_readers_to_read_view(struct vy_tx *tx)
+{
+	struct vy_lsm *pk = tx->tombstone_lsm;
+	struct vy_read_interval *interval =
+		vy_lsm_read_set_first(&pk->read_set);
+	struct vy_tx *reader;
+	while ((reader = vy_tx_range_conflict_next(tx, &interval)) != NULL) {
+		if (vy_tx_is_in_read_view(reader))
+			continue;
+		struct vy_read_view *rv = vy_tx_manager_read_view(tx->xm);
+		if (rv == NULL)
+			return -1;
+		reader->read_view = rv;
+	}
+	return 0;
+}
+
+/**
+ * Abort all transactions that have read keys deleted by
+ * the range tombstone written by transaction @tx.
+ */
+static void
+vy_tx_abort_range_readers(struct vy_tx *tx)
+{
+	struct vy_lsm *pk = tx->tombstone_lsm;
+	struct vy_read_interval *interval =
+		vy_lsm_read_set_first(&pk->read_set);
+	struct vy_tx *reader;
+	while ((reader = vy_tx_range_conflict_next(tx, &interval)) != NULL)
+		vy_tx_abort(reader);
+}
+
 struct vy_tx *
 vy_tx_begin(struct vy_tx_manager *xm)
 {
@@ -637,12 +731,15 @@ vy_tx_handle_deferred_delete(struct vy_tx *tx, struct txv *v)
 				 * only occur if it's a REPLACE that
 				 * happens not to update the secondary
 				 * index key parts. It's safe to skip it,
-				 * see vy_tx_set_entry().
+				 * see vy_tx_set_entry(), unless the index
+				 * is covering, in which case the REPLACE
+				 * overwrites the old covered fields.
 				 */
 				assert(vy_stmt_type(stmt) == IPROTO_REPLACE);
 				assert(vy_stmt_type(other->entry.stmt) ==
 								IPROTO_REPLACE);
-				other->is_nop = true;
+				if (!vy_lsm_is_covering(lsm))
+					other->is_nop = true;
 				continue;
 			}
 			struct txv *delete_txv = txv_new(tx, lsm, entry);
@@ -697,6 +794,20 @@ vy_tx_prepare(struct vy_tx *tx)
 			return -1;
 	}
 
+	if (tx->tombstone != NULL) {
+		struct vy_lsm *pk = tx->tombstone_lsm;
+		if (vy_tx_send_range_readers_to_read_view(tx) != 0)
+			return -1;
+		/*
+		 * Make the tombstone visible to readers, like
+		 * a prepared statement, and drop cached tuples
+		 * it may delete.
+		 */
+		tx->tombstone->lsn = MAX_LSN + tx->psn;
+		vy_lsm_add_tombstone(pk, tx->tombstone);
+		vy_lsm_invalidate_cache(pk);
+	}
+
 	/*
 	 * Flush transactional changes to the LSM tree.
 	 * Sic: the loop below must not yield after recovery.
@@ -821,6 +932,12 @@ vy_tx_commit(struct vy_tx *tx, int64_t lsn)
 			vy_mem_unpin(v->mem);
 	}
 
+	if (tx->tombstone != NULL) {
+		/* The tombstone is owned by the LSM tree now. */
+		vy_lsm_commit_tombstone(tx->tombstone_lsm, tx->tombstone, lsn);
+		tx->tombstone = NULL;
+	}
+
 	/* Update read views of dependant transactions. */
 	if (tx->read_view != &xm->global_read_view)
 		tx->read_view->vlsn = lsn;
@@ -874,6 +991,14 @@ vy_tx_rollback_after_prepare(struct vy_tx *tx)
 	while ((v = write_set_inext(&it)) != NULL) {
 		vy_tx_abort_readers(tx, v);
 	}
+
+	struct vy_tombstone *tombstone = tx->tombstone;
+	if (tombstone != NULL && !rlist_empty(&tombstone->in_lsm)) {
+		struct vy_lsm *pk = tx->tombstone_lsm;
+		vy_lsm_remove_tombstone(pk, tombstone);
+		vy_lsm_invalidate_cache(pk);
+		vy_tx_abort_range_readers(tx);
+	}
 }
 
 void
@@ -908,7 +1033,15 @@ vy_tx_begin_statement(struct vy_tx *tx, struct space *space, void **savepoint)
 		assert(stailq_empty(&tx->log));
 		rlist_add_entry(&tx->xm->writers, tx, in_writers);
 	}
-	*savepoint = stailq_last(&tx->log);
+	/*
+	 * A transaction that has written a range tombstone can't
+	 * have other statements so we use the tombstone to mark
+	 * savepoints taken after the range deletion.
+	 */
+	if (tx->tombstone != NULL)
+		*savepoint = tx->tombstone;
+	else
+		*savepoint = stailq_last(&tx->log);
 	return 0;
 }
 
@@ -920,6 +1053,19 @@ vy_tx_rollback_statement(struct vy_tx *tx, void *svp)
 		return;
 
 	assert(tx->state == VINYL_TX_READY);
+	if (tx->tombstone != NULL) {
+		assert(stailq_empty(&tx->log));
+		if (svp == tx->tombstone)
+			return;
+		/* Rollback the range deletion. */
+		vy_tombstone_delete(tx->tombstone);
+		tx->tombstone = NULL;
+		vy_lsm_unref(tx->tombstone_lsm);
+		tx->tombstone_lsm = NULL;
+		rlist_del_entry(tx, in_writers);
+		tx->last_stmt_space = NULL;
+		return;
+	}
 	struct stailq_entry *last = svp;
 	struct stailq tail;
 	stailq_cut_tail(&tx->log, last, &tail);
@@ -1112,7 +1258,7 @@ vy_tx_set_entry(struct vy_tx *tx, struct vy_lsm *lsm, struct vy_entry entry)
 		v->is_first_insert = true;
 
 	if (lsm->index_id > 0 && old != NULL && !old->is_nop &&
-	    !vy_lsm_is_being_constructed(lsm)) {
+	    !vy_lsm_is_being_constructed(lsm) && !vy_lsm_is_covering(lsm)) {
 		/*
 		 * In a secondary index write set, DELETE statement purges
 		 * exactly one older statement so REPLACE + DELETE is no-op.
@@ -1134,6 +1280,11 @@ vy_tx_set_entry(struct vy_tx *tx, struct vy_lsm *lsm, struct vy_entry entry)
 		 * vinyl_space_build_index() as featuring bumped lsn).
 		 * Finally, we'll get missing tuple in secondary index after
 		 * it is built.
+		 *
+		 * A covering index stores covered fields along with the
+		 * key so REPLACE statements for the same key aren't
+		 * equivalent there, and a REPLACE may overwrite an older
+		 * one, so we never apply this optimization to it.
 		 */
 		enum iproto_type type = vy_stmt_type(entry.stmt);
 		enum iproto_type old_type = vy_stmt_type(old->entry.stmt);
@@ -1152,6 +1303,11 @@ vy_tx_set_entry(struct vy_tx *tx, struct vy_lsm *lsm, struct vy_entry entry)
 int
 vy_tx_set(struct vy_tx *tx, struct vy_lsm *lsm, struct tuple *stmt)
 {
+	if (tx->tombstone != NULL) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "range deletion in a multi-statement transaction");
+		return -1;
+	}
 	struct vy_entry entry;
 	vy_stmt_foreach_entry(entry, stmt, lsm->cmp_def) {
 		if (vy_tx_set_entry(tx, lsm, entry) != 0)
@@ -1160,6 +1316,29 @@ vy_tx_set(struct vy_tx *tx, struct vy_lsm *lsm, struct tuple *stmt)
 	return 0;
 }
 
+int
+vy_tx_delete_range(struct vy_tx *tx, struct vy_lsm *pk,
+		   const char *begin, const char *end)
+{
+	assert(pk->index_id == 0);
+	if (tx->state == VINYL_TX_ABORT) {
+		diag_set(ClientError, ER_TRANSACTION_CONFLICT);
+		return -1;
+	}
+	if (!write_set_empty(&tx->write_set) || tx->tombstone != NULL) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "range deletion in a multi-statement transaction");
+		return -1;
+	}
+	/* The LSN is assigned on prepare. */
+	tx->tombstone = vy_tombstone_new(INT64_MAX, begin, end);
+	if (tx->tombstone == NULL)
+		return -1;
+	tx->tombstone_lsm = pk;
+	vy_lsm_ref(pk);
+	return 0;
+}
+
 void
 vy_tx_manager_abort_writers_for_ddl(struct vy_tx_manager *xm,
 				    struct space *space, bool *need_wal_sync)
@@ -1180,6 +1359,7 @@ vy_tx_manager_abort_writers_for_ddl(struct vy_tx_manager *xm,
 		if (tx->state != VINYL_TX_READY)
 			continue;
 		if (tx->last_stmt_space == space ||
+		    tx->tombstone_lsm == lsm ||
 		    write_set_search_key(&tx->write_set, lsm,
 					 lsm->env->empty_key) != NULL)
 			vy_tx_abort(tx);
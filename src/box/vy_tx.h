@@ -193,6 +193,14 @@ struct vy_tx {
 	 * intervals.
 	 */
 	vy_tx_read_set_t read_set;
+	/**
+	 * Range tombstone written by this transaction or NULL,
+	 * see vy_tx_delete_range(). Owned by the transaction until
+	 * it is committed, after which it is handed over to the
+	 * primary index LSM tree @tombstone_lsm (referenced).
+	 */
+	struct vy_tombstone *tombstone;
+	struct vy_lsm *tombstone_lsm;
 	/**
 	 * Prepare sequence number or -1 if the transaction
 	 * is not prepared.
@@ -421,6 +429,22 @@ vy_tx_track_point(struct vy_tx *tx, struct vy_lsm *lsm, struct vy_entry entry);
 int
 vy_tx_set(struct vy_tx *tx, struct vy_lsm *lsm, struct tuple *stmt);
 
+/**
+ * Delete all tuples whose primary keys are within [begin, end]
+ * by writing a range tombstone, see struct vy_tombstone.
+ * A range deletion must be the only statement of its transaction.
+ * @param tx           Transaction.
+ * @param pk           Primary index LSM tree.
+ * @param begin        Lower bound, MsgPack array.
+ * @param end          Upper bound, MsgPack array.
+ *
+ * @retval  0 Success
+ * @retval -1 Error.
+ */
+int
+vy_tx_delete_range(struct vy_tx *tx, struct vy_lsm *pk,
+		   const char *begin, const char *end);
+
 /**
  * Iterator over the write set of a transaction.
  */
@@ -32,6 +32,8 @@
 #include "vy_mem.h"
 #include "vy_run.h"
 #include "vy_upsert.h"
+#include "diag.h"
+#include "errcode.h"
 #include "fiber.h"
 
 #define HEAP_FORWARD_DECLARATION
@@ -58,6 +60,8 @@ struct vy_write_src {
 	 * key, regardless of LSN.
 	 */
 	bool is_end_of_key;
+	/** Slice this source iterates over or NULL if it's not a run. */
+	struct vy_slice *slice;
 	/** An iterator over the source */
 	union {
 		struct vy_slice_stream slice_stream;
@@ -181,6 +185,14 @@ struct vy_write_iterator {
 	 * key and its tuple format is different.
 	 */
 	bool is_primary;
+	/** Range tombstones sorted by LSN in descending order. */
+	const struct vy_write_tombstone *tombstones;
+	/** Length of the @tombstones array. */
+	int tombstone_count;
+	/** Primary key definition used by @tombstones. */
+	struct key_def *pk_def;
+	/** Primary key parts in @cmp_def for a secondary index. */
+	struct key_def *pk_in_cmp_def;
 	/** Deferred DELETE handler. */
 	struct vy_deferred_delete_handler *deferred_delete_handler;
 	/**
@@ -271,6 +283,7 @@ vy_write_iterator_new_src(struct vy_write_iterator *stream)
 	heap_node_create(&res->heap_node);
 	res->entry = vy_entry_none();
 	res->is_end_of_key = false;
+	res->slice = NULL;
 	rlist_add(&stream->src_list, &res->in_src_list);
 	return res;
 }
@@ -394,6 +407,20 @@ vy_write_iterator_new(struct key_def *cmp_def, bool is_primary,
 	return &stream->base;
 }
 
+void
+vy_write_iterator_set_tombstones(struct vy_stmt_stream *vstream,
+				 const struct vy_write_tombstone *tombstones,
+				 int count, struct key_def *pk_def,
+				 struct key_def *pk_in_cmp_def)
+{
+	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
+	assert(stream->is_primary == (pk_in_cmp_def == NULL));
+	stream->tombstones = tombstones;
+	stream->tombstone_count = count;
+	stream->pk_def = pk_def;
+	stream->pk_in_cmp_def = pk_in_cmp_def;
+}
+
 /**
  * Start the search. Must be called after *new* methods and
  * before *next* method.
@@ -499,6 +526,7 @@ vy_write_iterator_new_slice(struct vy_stmt_stream *vstream,
 		return -1;
 	vy_slice_stream_open(&src->slice_stream, slice, stream->cmp_def,
 			     disk_format);
+	src->slice = slice;
 	return 0;
 }
 
@@ -598,6 +626,48 @@ vy_write_iterator_pop_read_view_stmt(struct vy_write_iterator *stream)
 	return stream->last;
 }
 
+/**
+ * Callback passed to vy_blob_resolve() by the write iterator.
+ * Looks up a blob file among the files referenced by the runs
+ * being compacted.
+ */
+static int
+vy_write_iterator_blob_fd_cb(void *arg, int64_t run_id)
+{
+	struct vy_write_iterator *stream = arg;
+	struct vy_write_src *src;
+	rlist_foreach_entry(src, &stream->src_list, in_src_list) {
+		if (src->slice == NULL)
+			continue;
+		int fd = vy_run_blob_fd(src->slice->run, run_id);
+		if (fd >= 0)
+			return fd;
+	}
+	diag_set(ClientError, ER_INVALID_RUN_FILE,
+		 tt_sprintf("Blob file of run %lld not found",
+			    (long long)run_id));
+	return -1;
+}
+
+/**
+ * An UPSERT can't be applied to a statement that stores some of
+ * its fields in blob files neither can a deferred DELETE be
+ * generated for it so resolve such a statement first, see
+ * vy_blob.h. The returned entry must be released with
+ * vy_stmt_unref_if_possible() if it differs from the given one.
+ */
+static struct vy_entry
+vy_write_iterator_resolve_blobs(struct vy_write_iterator *stream,
+				struct vy_entry entry)
+{
+	if (entry.stmt == NULL ||
+	    (vy_stmt_flags(entry.stmt) & VY_STMT_BLOB) == 0)
+		return entry;
+	entry.stmt = vy_blob_resolve(entry.stmt,
+				     vy_write_iterator_blob_fd_cb, stream);
+	return entry;
+}
+
 /**
  * Generate a DELETE statement for the given tuple if its
  * deletion from secondary indexes was deferred.
@@ -628,10 +698,24 @@ vy_write_iterator_deferred_delete(struct vy_write_iterator *stream,
 	if (stream->deferred_delete.stmt != NULL) {
 		struct vy_deferred_delete_handler *handler =
 				stream->deferred_delete_handler;
-		if (handler != NULL && vy_stmt_type(stmt) != IPROTO_DELETE &&
-		    handler->iface->process(handler, stmt,
-					    stream->deferred_delete.stmt) != 0)
-			return -1;
+		if (handler != NULL && vy_stmt_type(stmt) != IPROTO_DELETE) {
+			/*
+			 * A field stored in a blob file may be indexed
+			 * by a secondary index created after the field
+			 * was moved so the DELETE must be generated
+			 * from the resolved tuple.
+			 */
+			struct vy_entry old = vy_write_iterator_resolve_blobs(
+							stream, entry);
+			if (old.stmt == NULL)
+				return -1;
+			int rc = handler->iface->process(handler, old.stmt,
+						stream->deferred_delete.stmt);
+			if (old.stmt != stmt)
+				vy_stmt_unref_if_possible(old.stmt);
+			if (rc != 0)
+				return -1;
+		}
 		vy_stmt_unref_if_possible(stream->deferred_delete.stmt);
 		stream->deferred_delete = vy_entry_none();
 	}
@@ -650,6 +734,150 @@ vy_write_iterator_deferred_delete(struct vy_write_iterator *stream,
 	return 0;
 }
 
+/**
+ * Position of the write iterator in the list of read views
+ * while building the history of a key.
+ */
+struct vy_write_history_state {
+	/** Index of the current read view. */
+	int rv_i;
+	/** LSN of the current read view. */
+	int64_t rv_lsn;
+	/** LSN of the previous (older) read view. */
+	int64_t merge_until_lsn;
+};
+
+/**
+ * Add a statement to the history of the current key.
+ * Apply optimizations 1 and 2 (@sa vy_write_iterator.h).
+ *
+ * @param stream Write iterator.
+ * @param entry Statement to add.
+ * @param state Current read view state, updated by this function.
+ * @param[in,out] count Count of statements saved in the history.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+static NODISCARD int
+vy_write_iterator_add_to_history(struct vy_write_iterator *stream,
+				 struct vy_entry entry,
+				 struct vy_write_history_state *state,
+				 int *count)
+{
+	if (vy_stmt_lsn(entry.stmt) > state->rv_lsn) {
+		/*
+		 * Skip statements invisible to the current read
+		 * view but older than the previous read view,
+		 * which is already fully built.
+		 */
+		return 0;
+	}
+	while (vy_stmt_lsn(entry.stmt) <= state->merge_until_lsn) {
+		/*
+		 * Skip read views which see the same
+		 * version of the key, until the statement
+		 * is between merge_until_lsn and rv_lsn.
+		 */
+		state->rv_i++;
+		state->rv_lsn = state->merge_until_lsn;
+		state->merge_until_lsn =
+			vy_write_iterator_get_vlsn(stream, state->rv_i + 1);
+	}
+
+	/*
+	 * Optimization 1: skip last level delete.
+	 * @sa vy_write_iterator for details about this
+	 * and other optimizations.
+	 */
+	if (vy_stmt_type(entry.stmt) == IPROTO_DELETE &&
+	    stream->is_last_level && state->merge_until_lsn < 0) {
+		state->rv_lsn = -1; /* Force skip */
+		return 0;
+	}
+
+	if (vy_write_iterator_push_rv(stream, entry, state->rv_i) != 0)
+		return -1;
+	++*count;
+
+	/*
+	 * Optimization 2: skip statements overwritten
+	 * by a REPLACE or DELETE.
+	 */
+	if (vy_stmt_type(entry.stmt) == IPROTO_REPLACE ||
+	    vy_stmt_type(entry.stmt) == IPROTO_INSERT ||
+	    vy_stmt_type(entry.stmt) == IPROTO_DELETE) {
+		state->rv_i++;
+		state->rv_lsn = state->merge_until_lsn;
+		state->merge_until_lsn =
+			vy_write_iterator_get_vlsn(stream, state->rv_i + 1);
+	}
+	return 0;
+}
+
+/**
+ * Add a DELETE to the history of the current key for each range
+ * tombstone that covers the key and is newer than the given
+ * statement so that the statement is squashed or purged as if
+ * it were deleted explicitly.
+ *
+ * @param stream Write iterator.
+ * @param entry Statement to be added to the history next.
+ * @param[in,out] tombstone_i Index of the next tombstone to check.
+ * @param state Current read view state, updated by this function.
+ * @param[in,out] count Count of statements saved in the history.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+static NODISCARD int
+vy_write_iterator_apply_tombstones(struct vy_write_iterator *stream,
+				   struct vy_entry entry, int *tombstone_i,
+				   struct vy_write_history_state *state,
+				   int *count)
+{
+	int64_t lsn = vy_stmt_lsn(entry.stmt);
+	for (; *tombstone_i < stream->tombstone_count; ++*tombstone_i) {
+		const struct vy_write_tombstone *tombstone =
+				&stream->tombstones[*tombstone_i];
+		if (tombstone->lsn <= lsn)
+			break;
+		if (!vy_stmt_pk_in_range(entry.stmt, tombstone->begin,
+					 tombstone->end, stream->pk_def,
+					 stream->pk_in_cmp_def))
+			continue;
+		struct tuple *stmt;
+		if (vy_stmt_is_key(entry.stmt)) {
+			stmt = vy_stmt_dup(entry.stmt);
+		} else {
+			struct vy_stmt_env *env = tuple_format(entry.stmt)->engine;
+			stmt = vy_stmt_extract_key(entry.stmt, stream->cmp_def,
+					env->key_format,
+					vy_entry_multikey_idx(entry,
+							      stream->cmp_def));
+		}
+		if (stmt == NULL)
+			return -1;
+		vy_stmt_set_type(stmt, IPROTO_DELETE);
+		vy_stmt_set_lsn(stmt, tombstone->lsn);
+		vy_stmt_set_flags(stmt, 0);
+		struct vy_entry delete_entry;
+		delete_entry.stmt = stmt;
+		delete_entry.hint = entry.hint;
+		int rc = 0;
+		if (stream->is_primary)
+			rc = vy_write_iterator_deferred_delete(stream,
+							       delete_entry);
+		if (rc == 0)
+			rc = vy_write_iterator_add_to_history(stream,
+						delete_entry, state, count);
+		vy_stmt_unref_if_possible(stmt);
+		if (rc != 0)
+			return -1;
+	}
+	return 0;
+}
+
 /**
  * Build the history of the current key.
  * Apply optimizations 1 and 2 (@sa vy_write_iterator.h).
@@ -701,13 +929,15 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 	}
 	vy_stmt_ref_if_possible(src->entry.stmt);
 	/*
-	 * For each pair (merge_until_lsn, current_rv_lsn] build
+	 * For each pair (merge_until_lsn, rv_lsn] build
 	 * a history in the corresponding read view.
-	 * current_rv_i - index of the current read view.
 	 */
-	int current_rv_i = 0;
-	int64_t current_rv_lsn = vy_write_iterator_get_vlsn(stream, 0);
-	int64_t merge_until_lsn = vy_write_iterator_get_vlsn(stream, 1);
+	struct vy_write_history_state rv_state;
+	rv_state.rv_i = 0;
+	rv_state.rv_lsn = vy_write_iterator_get_vlsn(stream, 0);
+	rv_state.merge_until_lsn = vy_write_iterator_get_vlsn(stream, 1);
+	/* Index of the next range tombstone to apply. */
+	int tombstone_i = 0;
 
 	while (true) {
 		*is_first_insert = vy_stmt_type(src->entry.stmt) == IPROTO_INSERT;
@@ -722,6 +952,14 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 			*is_first_insert = true;
 		}
 
+		if (stream->tombstone_count > 0) {
+			rc = vy_write_iterator_apply_tombstones(stream,
+					src->entry, &tombstone_i, &rv_state,
+					count);
+			if (rc != 0)
+				break;
+		}
+
 		/*
 		 * Even if the deferred DELETE handler is unset, as it is
 		 * the case for dump, we still have to preserve the oldest
@@ -739,59 +977,11 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 				break;
 		}
 
-		if (vy_stmt_lsn(src->entry.stmt) > current_rv_lsn) {
-			/*
-			 * Skip statements invisible to the current read
-			 * view but older than the previous read view,
-			 * which is already fully built.
-			 */
-			goto next_lsn;
-		}
-		while (vy_stmt_lsn(src->entry.stmt) <= merge_until_lsn) {
-			/*
-			 * Skip read views which see the same
-			 * version of the key, until src->entry is
-			 * between merge_until_lsn and
-			 * current_rv_lsn.
-			 */
-			current_rv_i++;
-			current_rv_lsn = merge_until_lsn;
-			merge_until_lsn =
-				vy_write_iterator_get_vlsn(stream,
-							   current_rv_i + 1);
-		}
-
-		/*
-		 * Optimization 1: skip last level delete.
-		 * @sa vy_write_iterator for details about this
-		 * and other optimizations.
-		 */
-		if (vy_stmt_type(src->entry.stmt) == IPROTO_DELETE &&
-		    stream->is_last_level && merge_until_lsn < 0) {
-			current_rv_lsn = -1; /* Force skip */
-			goto next_lsn;
-		}
-
-		rc = vy_write_iterator_push_rv(stream, src->entry,
-					       current_rv_i);
+		rc = vy_write_iterator_add_to_history(stream, src->entry,
+						      &rv_state, count);
 		if (rc != 0)
 			break;
-		++*count;
 
-		/*
-		 * Optimization 2: skip statements overwritten
-		 * by a REPLACE or DELETE.
-		 */
-		if (vy_stmt_type(src->entry.stmt) == IPROTO_REPLACE ||
-		    vy_stmt_type(src->entry.stmt) == IPROTO_INSERT ||
-		    vy_stmt_type(src->entry.stmt) == IPROTO_DELETE) {
-			current_rv_i++;
-			current_rv_lsn = merge_until_lsn;
-			merge_until_lsn =
-				vy_write_iterator_get_vlsn(stream,
-							   current_rv_i + 1);
-		}
-next_lsn:
 		rc = vy_write_iterator_merge_step(stream);
 		if (rc != 0)
 			break;
@@ -875,9 +1065,15 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct vy_entry prev,
 	     vy_stmt_type(prev.stmt) != IPROTO_UPSERT))) {
 		assert(!stream->is_last_level || prev.stmt == NULL ||
 		       vy_stmt_type(prev.stmt) != IPROTO_UPSERT);
+		struct vy_entry base = vy_write_iterator_resolve_blobs(stream,
+									prev);
+		if (prev.stmt != NULL && base.stmt == NULL)
+			return -1;
 		struct vy_entry applied;
-		applied = vy_entry_apply_upsert(h->entry, prev,
+		applied = vy_entry_apply_upsert(h->entry, base,
 						stream->cmp_def, false);
+		if (base.stmt != prev.stmt)
+			vy_stmt_unref_if_possible(base.stmt);
 		if (applied.stmt == NULL)
 			return -1;
 		vy_stmt_unref_if_possible(h->entry.stmt);
@@ -886,6 +1082,16 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct vy_entry prev,
 	/* Squash the rest of UPSERTs. */
 	struct vy_write_history *result = h;
 	h = h->next;
+	if (h != NULL) {
+		struct vy_entry base = vy_write_iterator_resolve_blobs(stream,
+							result->entry);
+		if (base.stmt == NULL)
+			return -1;
+		if (base.stmt != result->entry.stmt) {
+			vy_stmt_unref_if_possible(result->entry.stmt);
+			result->entry = base;
+		}
+	}
 	while (h != NULL) {
 		assert(h->entry.stmt != NULL &&
 		       vy_stmt_type(h->entry.stmt) == IPROTO_UPSERT);
@@ -252,6 +252,38 @@ vy_write_iterator_new(struct key_def *cmp_def, bool is_primary,
 		      bool is_last_level, struct rlist *read_views,
 		      struct vy_deferred_delete_handler *handler);
 
+/**
+ * Range tombstone passed to the write iterator, see struct
+ * vy_tombstone. Statements of the primary key range [begin, end]
+ * older than @lsn are considered deleted.
+ */
+struct vy_write_tombstone {
+	/** LSN of the range deletion. */
+	int64_t lsn;
+	/** Lower bound of the deleted range, msgpack array. */
+	const char *begin;
+	/** Upper bound of the deleted range, msgpack array. */
+	const char *end;
+};
+
+/**
+ * Make the write iterator apply range tombstones. For each key
+ * covered by a tombstone the iterator behaves as if there were
+ * a DELETE with the tombstone LSN so that the deleted statements
+ * are squashed as usual and purged by major compaction.
+ * @param tombstones - array of tombstones sorted by LSN in
+ * descending order. Must stay valid while the iterator is used.
+ * @param count - number of entries in @tombstones.
+ * @param pk_def - primary key definition tombstone bounds refer to.
+ * @param pk_in_cmp_def - primary key parts in @cmp_def if this
+ * iterator is for a secondary index, NULL otherwise.
+ */
+void
+vy_write_iterator_set_tombstones(struct vy_stmt_stream *stream,
+				 const struct vy_write_tombstone *tombstones,
+				 int count, struct key_def *pk_def,
+				 struct key_def *pk_in_cmp_def);
+
 /**
  * Add a mem as a source to the iterator.
  * @return 0 on success, -1 on error (diag is set).
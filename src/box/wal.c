@@ -31,16 +31,20 @@
 #include "wal.h"
 
 #include "fiber.h"
+#include "fiber_cond.h"
 #include "fio.h"
 #include "errinj.h"
 #include "error.h"
 #include "exception.h"
+#include "histogram.h"
+#include "info/info.h"
 
 #include "xlog.h"
 #include "xrow.h"
 #include "vy_log.h"
 #include "cbus.h"
 #include "coio_task.h"
+#include "coio_file.h"
 #include "replication.h"
 
 enum {
@@ -53,6 +57,13 @@ enum {
 	 * latency. 1 MB seems to be a well balanced choice.
 	 */
 	WAL_FALLOCATE_LEN = 1024 * 1024,
+	/**
+	 * Number of bytes per entry of the sparse index of a WAL
+	 * file, see xlog_opts::index_step. A reader starting from
+	 * an arbitrary vclock has to scan at most that many bytes
+	 * before reaching the first row it needs.
+	 */
+	WAL_INDEX_STEP = 1024 * 1024,
 };
 
 const char *wal_mode_STRS[WAL_MODE_MAX] = {
@@ -61,6 +72,11 @@ const char *wal_mode_STRS[WAL_MODE_MAX] = {
 	[WAL_FSYNC]	= "fsync",
 };
 
+const char *wal_compression_strs[wal_compression_MAX] = {
+	[WAL_COMPRESSION_NONE]	= "none",
+	[WAL_COMPRESSION_ZSTD]	= "zstd",
+};
+
 int wal_dir_lock = -1;
 
 static int
@@ -83,6 +99,22 @@ wal_write_none(struct journal *, struct journal_entry *);
  * members used mainly in tx thread go first, wal thread members
  * following.
  */
+/**
+ * A spare WAL file. Allocating disk space for a WAL file while
+ * writing to it may stall the WAL thread, so the WAL thread can
+ * keep a few empty files with disk space preallocated for them
+ * in advance and use them on rotation. Files freed by garbage
+ * collection are recycled for this purpose.
+ */
+struct wal_spare {
+	/** Descriptor of the file or -1 if it isn't ready. */
+	int fd;
+	/** Size of disk space preallocated for the file. */
+	size_t allocated;
+	/** Set while the file is being prepared. */
+	bool is_busy;
+};
+
 struct wal_writer
 {
 	struct journal base;
@@ -116,6 +148,11 @@ struct wal_writer
 	struct xdir wal_dir;
 	/** 'wal' thread doing the writes. */
 	struct cord cord;
+	/**
+	 * Set when new messages arrive at the 'wal' endpoint, see
+	 * wal_writer_fetch_cb().
+	 */
+	bool has_input;
 	/**
 	 * Return pipe from 'wal' to tx'. This is a
 	 * priority pipe and DOES NOT support yield.
@@ -158,6 +195,60 @@ struct wal_writer
 	bool checkpoint_triggered;
 	/** The current WAL file. */
 	struct xlog current_wal;
+	/**
+	 * Batches that have been written to the current WAL, but
+	 * haven't been synced yet. Used only if wal_mode is 'fsync'.
+	 * The WAL thread doesn't wait for fdatasync() to complete
+	 * before writing the next batch. Instead, it appends the
+	 * written batch to this queue, and the sync fiber sends it
+	 * back to tx once the data hits the disk, see wal_fsync_f().
+	 */
+	struct stailq sync_queue;
+	/** Fiber syncing the current WAL, see wal_fsync_f(). */
+	struct fiber *sync_fiber;
+	/** Signalled when a batch is added to the sync queue. */
+	struct fiber_cond sync_cond;
+	/** Signalled when the sync fiber is done with a sync. */
+	struct fiber_cond synced_cond;
+	/** Set while the sync fiber is executing fdatasync(). */
+	bool sync_in_progress;
+	/** A setting from instance configuration - wal_commit_delay */
+	double commit_delay;
+	/** Another one - wal_commit_min_size */
+	int64_t commit_min_size;
+	/**
+	 * Batches received from tx, but not written yet. Normally,
+	 * a batch is written as soon as it arrives, but with group
+	 * commit enabled the WAL thread may wait for more batches
+	 * to write them all at once, see wal_write_to_disk().
+	 */
+	struct stailq group;
+	/** Sum of approx_len of batches in the group. */
+	size_t group_len;
+	/** Time when the first batch was added to the group. */
+	double group_start;
+	/** Time by which the group must be written. */
+	double group_deadline;
+	/**
+	 * Moving average of the time it takes to sync a batch
+	 * in 'fsync' mode. Used for tuning the group commit
+	 * delay, see wal_group_delay().
+	 */
+	double sync_time;
+	/** Number of batches written to disk. */
+	int64_t batch_count;
+	/** Sizes of written batches, in bytes. */
+	struct histogram *batch_size_hist;
+	/** Time written batches waited for group commit, in usec. */
+	struct histogram *batch_wait_hist;
+	/** A setting from instance configuration - wal_spare_files */
+	int spare_files;
+	/** Spare WAL files, see wal_spare_f(). */
+	struct wal_spare spares[WAL_SPARE_FILES_MAX];
+	/** Fiber preparing spare WAL files. */
+	struct fiber *spare_fiber;
+	/** Signalled when a spare WAL file may need preparing. */
+	struct fiber_cond spare_cond;
 	/**
 	 * Used if there was a WAL I/O error and we need to
 	 * keep adding all incoming requests to the rollback
@@ -185,6 +276,16 @@ struct wal_msg {
 	struct stailq rollback;
 	/** vclock after the batch processed. */
 	struct vclock vclock;
+	/** Link in wal_writer::sync_queue. */
+	struct stailq_entry in_sync_queue;
+	/** Link in wal_writer::group or wal_msg::group. */
+	struct stailq_entry in_group;
+	/**
+	 * Batches merged into this one by group commit. Their
+	 * requests were moved to this batch, so they are only
+	 * sent back to tx to be freed.
+	 */
+	struct stailq group;
 };
 
 /**
@@ -213,11 +314,22 @@ wal_dir(void)
 static void
 wal_write_to_disk(struct cmsg *msg);
 
+static double
+wal_group_delay(struct wal_writer *writer);
+
+static void
+wal_write_group(struct wal_writer *writer);
+
 static void
 tx_complete_batch(struct cmsg *msg);
 
+/*
+ * Note, the first hop doesn't have a pipe, because a batch may
+ * need to be synced before it is sent back to tx. It's done
+ * explicitly with wal_msg_complete().
+ */
 static struct cmsg_hop wal_request_route[] = {
-	{wal_write_to_disk, &wal_writer_singleton.tx_prio_pipe},
+	{wal_write_to_disk, NULL},
 	{tx_complete_batch, NULL},
 };
 
@@ -228,6 +340,7 @@ wal_msg_create(struct wal_msg *batch)
 	batch->approx_len = 0;
 	stailq_create(&batch->commit);
 	stailq_create(&batch->rollback);
+	stailq_create(&batch->group);
 	vclock_create(&batch->vclock);
 }
 
@@ -237,6 +350,31 @@ wal_msg(struct cmsg *msg)
 	return msg->route == wal_request_route ? (struct wal_msg *) msg : NULL;
 }
 
+/** Send a batch processed by the WAL thread back to tx. */
+static void
+wal_msg_complete(struct wal_writer *writer, struct wal_msg *batch)
+{
+	assert(batch->base.hop->f == wal_write_to_disk);
+	batch->base.hop++;
+	cpipe_push(&writer->tx_prio_pipe, &batch->base);
+}
+
+/**
+ * Wait until all batches written so far are synced and sent
+ * back to tx. Must be called before closing the current WAL,
+ * because it may still be used by the sync fiber, and before
+ * replying to a tx request that expects all preceding writes
+ * to be complete.
+ */
+static void
+wal_wait_synced(struct wal_writer *writer)
+{
+	if (stailq_empty(&writer->sync_queue) && !writer->sync_in_progress)
+		return;
+	while (!stailq_empty(&writer->sync_queue) || writer->sync_in_progress)
+		fiber_cond_wait(&writer->synced_cond);
+}
+
 /** Write a request to a log in a single transaction. */
 static ssize_t
 xlog_write_entry(struct xlog *l, struct journal_entry *entry)
@@ -374,6 +512,9 @@ tx_complete_batch(struct cmsg *msg)
 	/* Update the tx vclock to the latest written by wal. */
 	vclock_copy(&replicaset.vclock, &batch->vclock);
 	tx_schedule_queue(&batch->commit);
+	struct wal_msg *merged, *next;
+	stailq_foreach_entry_safe(merged, next, &batch->group, in_group)
+		mempool_free(&writer->msg_pool, merged);
 	mempool_free(&writer->msg_pool, container_of(msg, struct wal_msg, base));
 }
 
@@ -411,13 +552,35 @@ tx_notify_checkpoint(struct cmsg *msg)
  * encapsulate the details just in case we may use
  * more writers in the future.
  */
-static void
+static int
 wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 		  const char *wal_dirname, int64_t wal_max_size,
 		  const struct tt_uuid *instance_uuid,
 		  wal_on_garbage_collection_f on_garbage_collection,
 		  wal_on_checkpoint_threshold_f on_checkpoint_threshold)
 {
+	static const int64_t batch_size_buckets[] = {
+		256, 1024, 4096, 16384, 65536, 262144, 1048576,
+		4194304, 1073741824,
+	};
+	static const int64_t batch_wait_buckets[] = {
+		0, 10, 100, 1000, 10000, 100000, 1000000, 1000000000,
+	};
+	writer->batch_size_hist = histogram_new(batch_size_buckets,
+						lengthof(batch_size_buckets));
+	writer->batch_wait_hist = histogram_new(batch_wait_buckets,
+						lengthof(batch_wait_buckets));
+	if (writer->batch_size_hist == NULL ||
+	    writer->batch_wait_hist == NULL) {
+		if (writer->batch_size_hist != NULL)
+			histogram_delete(writer->batch_size_hist);
+		if (writer->batch_wait_hist != NULL)
+			histogram_delete(writer->batch_wait_hist);
+		diag_set(OutOfMemory, sizeof(struct histogram), "malloc",
+			 "struct histogram");
+		return -1;
+	}
+
 	writer->wal_mode = wal_mode;
 	writer->wal_max_size = wal_max_size;
 
@@ -429,14 +592,38 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 
 	struct xlog_opts opts = xlog_opts_default;
 	opts.sync_is_async = true;
+	opts.index_step = WAL_INDEX_STEP;
 	xdir_create(&writer->wal_dir, wal_dirname, XLOG, instance_uuid, &opts);
 	xlog_clear(&writer->current_wal);
-	if (wal_mode == WAL_FSYNC)
-		writer->wal_dir.open_wflags |= O_SYNC;
 
 	stailq_create(&writer->rollback);
 	writer->is_in_rollback = false;
 
+	stailq_create(&writer->sync_queue);
+	writer->sync_fiber = NULL;
+	fiber_cond_create(&writer->sync_cond);
+	fiber_cond_create(&writer->synced_cond);
+	writer->sync_in_progress = false;
+	writer->has_input = false;
+
+	writer->commit_delay = 0;
+	writer->commit_min_size = 0;
+	stailq_create(&writer->group);
+	writer->group_len = 0;
+	writer->group_start = 0;
+	writer->group_deadline = 0;
+	writer->sync_time = 0;
+	writer->batch_count = 0;
+
+	writer->spare_files = 0;
+	for (int i = 0; i < WAL_SPARE_FILES_MAX; i++) {
+		writer->spares[i].fd = -1;
+		writer->spares[i].allocated = 0;
+		writer->spares[i].is_busy = false;
+	}
+	writer->spare_fiber = NULL;
+	fiber_cond_create(&writer->spare_cond);
+
 	writer->checkpoint_wal_size = 0;
 	writer->checkpoint_threshold = INT64_MAX;
 	writer->checkpoint_triggered = false;
@@ -450,6 +637,7 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 
 	mempool_create(&writer->msg_pool, &cord()->slabc,
 		       sizeof(struct wal_msg));
+	return 0;
 }
 
 /** Destroy a WAL writer structure. */
@@ -457,6 +645,8 @@ static void
 wal_writer_destroy(struct wal_writer *writer)
 {
 	xdir_destroy(&writer->wal_dir);
+	histogram_delete(writer->batch_size_hist);
+	histogram_delete(writer->batch_wait_hist);
 }
 
 /** WAL writer thread routine. */
@@ -540,9 +730,10 @@ wal_init(enum wal_mode wal_mode, const char *wal_dirname,
 {
 	/* Initialize the state. */
 	struct wal_writer *writer = &wal_writer_singleton;
-	wal_writer_create(writer, wal_mode, wal_dirname, wal_max_size,
-			  instance_uuid, on_garbage_collection,
-			  on_checkpoint_threshold);
+	if (wal_writer_create(writer, wal_mode, wal_dirname, wal_max_size,
+			      instance_uuid, on_garbage_collection,
+			      on_checkpoint_threshold) != 0)
+		return -1;
 
 	/* Start WAL thread. */
 	if (cord_costart(&writer->cord, "wal", wal_writer_f, NULL) != 0)
@@ -604,11 +795,13 @@ wal_sync_f(struct cbus_call_msg *data)
 {
 	struct wal_vclock_msg *msg = (struct wal_vclock_msg *) data;
 	struct wal_writer *writer = &wal_writer_singleton;
+	wal_write_group(writer);
 	if (writer->is_in_rollback) {
 		/* We're rolling back a failed write. */
 		diag_set(ClientError, ER_CASCADE_ROLLBACK);
 		return -1;
 	}
+	wal_wait_synced(writer);
 	vclock_copy(&msg->vclock, &writer->vclock);
 	return 0;
 }
@@ -647,6 +840,7 @@ wal_begin_checkpoint_f(struct cbus_call_msg *data)
 {
 	struct wal_checkpoint *msg = (struct wal_checkpoint *) data;
 	struct wal_writer *writer = &wal_writer_singleton;
+	wal_write_group(writer);
 	if (writer->is_in_rollback) {
 		/*
 		 * We're rolling back a failed write and so
@@ -656,6 +850,7 @@ wal_begin_checkpoint_f(struct cbus_call_msg *data)
 		diag_set(ClientError, ER_CASCADE_ROLLBACK);
 		return -1;
 	}
+	wal_wait_synced(writer);
 	/*
 	 * Avoid closing the current WAL if it has no rows (empty).
 	 */
@@ -777,12 +972,301 @@ wal_set_queue_max_size(int64_t size)
 	journal_queue_set_max_size(size);
 }
 
+struct wal_set_commit_delay_msg {
+	struct cbus_call_msg base;
+	double delay;
+	int64_t min_size;
+};
+
+static int
+wal_set_commit_delay_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_commit_delay_msg *msg;
+	msg = (struct wal_set_commit_delay_msg *)data;
+	if (msg->delay >= 0)
+		writer->commit_delay = msg->delay;
+	if (msg->min_size >= 0)
+		writer->commit_min_size = msg->min_size;
+	/*
+	 * Don't make the batches waiting for group commit wait
+	 * longer than they would with the new settings.
+	 */
+	if (!stailq_empty(&writer->group)) {
+		writer->group_deadline = MIN(writer->group_deadline,
+					     writer->group_start +
+					     wal_group_delay(writer));
+	}
+	return 0;
+}
+
+/**
+ * Pass group commit settings to the WAL thread. A negative
+ * value means that the setting isn't changed.
+ */
+static void
+wal_set_commit_delay_impl(double delay, int64_t min_size)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_commit_delay_msg msg;
+	msg.delay = delay;
+	msg.min_size = min_size;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_set_commit_delay_f, NULL,
+		  TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+void
+wal_set_commit_delay(double delay)
+{
+	assert(delay >= 0);
+	wal_set_commit_delay_impl(delay, -1);
+}
+
+void
+wal_set_commit_min_size(int64_t size)
+{
+	assert(size >= 0);
+	wal_set_commit_delay_impl(-1, size);
+}
+
+/** Format the name of the spare WAL file with the given index. */
+static void
+wal_spare_filename(struct wal_writer *writer, int i, char *buf, int size)
+{
+	snprintf(buf, size, "%s/spare%d%s.inprogress",
+		 writer->wal_dir.dirname, i, writer->wal_dir.filename_ext);
+}
+
+/** Close a spare WAL file and remove it in background. */
+static void
+wal_remove_spare(struct wal_writer *writer, int i)
+{
+	struct wal_spare *spare = &writer->spares[i];
+	assert(!spare->is_busy);
+	if (spare->fd >= 0) {
+		close(spare->fd);
+		spare->fd = -1;
+	}
+	char filename[PATH_MAX];
+	wal_spare_filename(writer, i, filename, sizeof(filename));
+	eio_unlink(filename, 0, NULL, NULL);
+}
+
+struct wal_set_spare_files_msg {
+	struct cbus_call_msg base;
+	int count;
+};
+
+static int
+wal_set_spare_files_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_spare_files_msg *msg;
+	msg = (struct wal_set_spare_files_msg *)data;
+	writer->spare_files = msg->count;
+	/*
+	 * Remove the files that are not needed anymore, including
+	 * those left from a previous run. A file that is being
+	 * prepared is removed by the spare fiber.
+	 */
+	for (int i = msg->count; i < WAL_SPARE_FILES_MAX; i++) {
+		if (!writer->spares[i].is_busy)
+			wal_remove_spare(writer, i);
+	}
+	fiber_cond_signal(&writer->spare_cond);
+	return 0;
+}
+
+void
+wal_set_spare_files(int count)
+{
+	assert(count >= 0 && count <= WAL_SPARE_FILES_MAX);
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_spare_files_msg msg;
+	msg.count = count;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_set_spare_files_f, NULL,
+		  TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+struct wal_set_direct_io_msg {
+	struct cbus_call_msg base;
+	bool direct_io;
+};
+
+static int
+wal_set_direct_io_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_direct_io_msg *msg;
+	msg = (struct wal_set_direct_io_msg *)data;
+	writer->wal_dir.opts.direct_io = msg->direct_io;
+	return 0;
+}
+
+void
+wal_set_direct_io(bool direct_io)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_direct_io_msg msg;
+	msg.direct_io = direct_io;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_set_direct_io_f, NULL,
+		  TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+struct wal_set_compression_msg {
+	struct cbus_call_msg base;
+	enum wal_compression compression;
+	int level;
+};
+
+static int
+wal_set_compression_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_compression_msg *msg;
+	msg = (struct wal_set_compression_msg *)data;
+	writer->wal_dir.opts.no_compression =
+		msg->compression == WAL_COMPRESSION_NONE;
+	writer->wal_dir.opts.compression_level = msg->level;
+	return 0;
+}
+
+void
+wal_set_compression(enum wal_compression compression, int level)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_compression_msg msg;
+	msg.compression = compression;
+	msg.level = level;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_set_compression_f, NULL,
+		  TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+enum {
+	/** Size of a buffer for a histogram string. */
+	WAL_STAT_HIST_BUF_SIZE = 512,
+};
+
+struct wal_stat_msg {
+	struct cbus_call_msg base;
+	double commit_delay;
+	double sync_time;
+	int64_t batch_count;
+	char batch_size[WAL_STAT_HIST_BUF_SIZE];
+	char batch_wait[WAL_STAT_HIST_BUF_SIZE];
+};
+
+static int
+wal_stat_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_stat_msg *msg = (struct wal_stat_msg *)data;
+	msg->commit_delay = wal_group_delay(writer);
+	msg->sync_time = writer->sync_time;
+	msg->batch_count = writer->batch_count;
+	histogram_snprint(msg->batch_size, sizeof(msg->batch_size),
+			  writer->batch_size_hist);
+	histogram_snprint(msg->batch_wait, sizeof(msg->batch_wait),
+			  writer->batch_wait_hist);
+	return 0;
+}
+
+void
+wal_stat(struct info_handler *h)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_stat_msg msg;
+	msg.commit_delay = 0;
+	msg.sync_time = 0;
+	msg.batch_count = 0;
+	msg.batch_size[0] = '\0';
+	msg.batch_wait[0] = '\0';
+	if (writer->wal_mode != WAL_NONE) {
+		bool cancellable = fiber_set_cancellable(false);
+		cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+			  &msg.base, wal_stat_f, NULL, TIMEOUT_INFINITY);
+		fiber_set_cancellable(cancellable);
+	}
+	info_begin(h);
+	info_append_double(h, "commit_delay", msg.commit_delay);
+	info_append_double(h, "sync_time", msg.sync_time);
+	info_append_int(h, "batch_count", msg.batch_count);
+	info_append_str(h, "batch_size", msg.batch_size);
+	info_append_str(h, "batch_wait", msg.batch_wait);
+	info_end(h);
+}
+
+static int
+wal_reset_stat_f(struct cbus_call_msg *data)
+{
+	(void)data;
+	struct wal_writer *writer = &wal_writer_singleton;
+	histogram_reset(writer->batch_size_hist);
+	histogram_reset(writer->batch_wait_hist);
+	writer->batch_count = 0;
+	return 0;
+}
+
+void
+wal_reset_stat(void)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct cbus_call_msg msg;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe, &msg,
+		  wal_reset_stat_f, NULL, TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
 struct wal_gc_msg
 {
 	struct cbus_call_msg base;
 	const struct vclock *vclock;
 };
 
+/**
+ * Turn WAL files whose signature is less than specified into
+ * spare files instead of deleting them, as long as there are
+ * free slots for spare files.
+ */
+static void
+wal_recycle_xlogs(struct wal_writer *writer, int64_t signature)
+{
+	for (int i = 0; i < writer->spare_files; i++) {
+		struct wal_spare *spare = &writer->spares[i];
+		if (spare->fd >= 0 || spare->is_busy)
+			continue;
+		char filename[PATH_MAX];
+		wal_spare_filename(writer, i, filename, sizeof(filename));
+		if (xdir_recycle_xlog(&writer->wal_dir, signature,
+				      filename) != 0)
+			break;
+		fiber_cond_signal(&writer->spare_cond);
+	}
+}
+
 static int
 wal_collect_garbage_f(struct cbus_call_msg *data)
 {
@@ -804,9 +1288,11 @@ wal_collect_garbage_f(struct cbus_call_msg *data)
 		 */
 		vclock = vclockset_psearch(&writer->wal_dir.index, vclock);
 	}
-	if (vclock != NULL)
+	if (vclock != NULL) {
+		wal_recycle_xlogs(writer, vclock_sum(vclock));
 		xdir_collect_garbage(&writer->wal_dir, vclock_sum(vclock),
 				     XDIR_GC_ASYNC);
+	}
 
 	return 0;
 }
@@ -828,6 +1314,59 @@ wal_collect_garbage(const struct vclock *vclock)
 static void
 wal_notify_watchers(struct wal_writer *writer, unsigned events);
 
+/**
+ * Create a new WAL file. Use a spare file if there's one ready,
+ * and wake up the spare fiber to prepare a replacement.
+ */
+static int
+wal_create_xlog(struct wal_writer *writer)
+{
+	fiber_cond_signal(&writer->spare_cond);
+	for (int i = 0; i < writer->spare_files; i++) {
+		struct wal_spare *spare = &writer->spares[i];
+		if (spare->fd < 0)
+			continue;
+		char filename[PATH_MAX];
+		wal_spare_filename(writer, i, filename, sizeof(filename));
+		int fd = spare->fd;
+		spare->fd = -1;
+		if (xdir_create_xlog_from_spare(&writer->wal_dir,
+						&writer->current_wal,
+						&writer->vclock, filename,
+						fd, spare->allocated) == 0)
+			return 0;
+		diag_log();
+		break;
+	}
+	return xdir_create_xlog(&writer->wal_dir, &writer->current_wal,
+				&writer->vclock);
+}
+
+/**
+ * Remove spare WAL files that are ready to free the disk space
+ * reserved for them. Returns the number of removed files.
+ */
+static int
+wal_drop_spares(struct wal_writer *writer)
+{
+	int count = 0;
+	for (int i = 0; i < WAL_SPARE_FILES_MAX; i++) {
+		struct wal_spare *spare = &writer->spares[i];
+		if (spare->fd < 0)
+			continue;
+		close(spare->fd);
+		spare->fd = -1;
+		char filename[PATH_MAX];
+		wal_spare_filename(writer, i, filename, sizeof(filename));
+		if (unlink(filename) != 0)
+			say_syserror("error while removing %s", filename);
+		else
+			say_info("removed %s", filename);
+		count++;
+	}
+	return count;
+}
+
 /**
  * If there is no current WAL, try to open it, and close the
  * previous WAL. We close the previous WAL only after opening
@@ -851,6 +1390,7 @@ wal_opt_rotate(struct wal_writer *writer)
 	 */
 	if (xlog_is_open(&writer->current_wal) &&
 	    writer->current_wal.offset >= writer->wal_max_size) {
+		wal_wait_synced(writer);
 		/*
 		 * We can not handle xlog_close()
 		 * failure in any reasonable way.
@@ -862,8 +1402,7 @@ wal_opt_rotate(struct wal_writer *writer)
 	if (xlog_is_open(&writer->current_wal))
 		return 0;
 
-	if (xdir_create_xlog(&writer->wal_dir, &writer->current_wal,
-			     &writer->vclock) != 0)
+	if (wal_create_xlog(writer) != 0)
 		return -1;
 	/*
 	 * Keep track of the new WAL vclock. Required for garbage
@@ -916,6 +1455,9 @@ retry:
 	}
 	if (errno != ENOSPC)
 		goto error;
+	/* Spare WAL files are the first to go. */
+	if (wal_drop_spares(writer) > 0)
+		goto retry;
 	if (!xdir_has_garbage(&writer->wal_dir, gc_lsn))
 		goto error;
 
@@ -1031,11 +1573,10 @@ wal_assign_lsn(struct vclock *vclock_diff, struct vclock *base,
 		(*row)->tsn = tsn;
 }
 
+/** Write a batch to the current WAL and send it back to tx. */
 static void
-wal_write_to_disk(struct cmsg *msg)
+wal_write_batch(struct wal_writer *writer, struct wal_msg *wal_msg)
 {
-	struct wal_writer *writer = &wal_writer_singleton;
-	struct wal_msg *wal_msg = (struct wal_msg *) msg;
 	int err_code = JOURNAL_ENTRY_ERR_UNKNOWN;
 	struct stailq_entry *last_committed = NULL;
 	struct journal_entry *entry;
@@ -1100,6 +1641,9 @@ wal_write_to_disk(struct cmsg *msg)
 
 	struct xlog *l = &writer->current_wal;
 
+	/* All rows written so far are covered by the writer vclock. */
+	xlog_add_index_entry(l, &writer->vclock);
+
 	/*
 	 * Iterate over requests (transactions)
 	 */
@@ -1187,8 +1731,246 @@ done:
 		assert(err_code == JOURNAL_ENTRY_ERR_UNKNOWN);
 	}
 	fiber_gc();
+	if (writer->wal_mode == WAL_FSYNC &&
+	    (last_committed != NULL || !stailq_empty(&writer->sync_queue) ||
+	     writer->sync_in_progress)) {
+		/*
+		 * Don't wait for the batch to be synced, proceed
+		 * to the next one while the sync fiber is doing
+		 * fdatasync(). Batches must be completed in order
+		 * so even if nothing was written, the batch must
+		 * wait for the preceding ones.
+		 */
+		stailq_add_tail_entry(&writer->sync_queue, wal_msg,
+				      in_sync_queue);
+		fiber_cond_signal(&writer->sync_cond);
+		return;
+	}
 	wal_notify_watchers(writer, WAL_EVENT_WRITE);
 	ERROR_INJECT_SLEEP(ERRINJ_RELAY_FASTER_THAN_TX);
+	wal_msg_complete(writer, wal_msg);
+}
+
+/**
+ * Sync fiber of the WAL thread, used if wal_mode is 'fsync'.
+ * Syncs the current WAL in a coio thread so that the WAL thread
+ * can write the next batch while the previous one is being
+ * synced. Batches are sent back to tx in the order they were
+ * written as soon as the data they wrote is on disk.
+ */
+static int
+wal_fsync_f(va_list ap)
+{
+	(void)ap;
+	struct wal_writer *writer = &wal_writer_singleton;
+	while (true) {
+		if (stailq_empty(&writer->sync_queue)) {
+			if (fiber_is_cancelled())
+				break;
+			fiber_cond_wait(&writer->sync_cond);
+			continue;
+		}
+		/*
+		 * A single fdatasync() covers all batches written
+		 * so far. Batches written while it's in progress
+		 * will be synced on the next iteration.
+		 */
+		struct stailq queue;
+		stailq_create(&queue);
+		stailq_concat(&queue, &writer->sync_queue);
+		writer->sync_in_progress = true;
+		double sync_start = ev_monotonic_time();
+		struct xlog *l = &writer->current_wal;
+		if (xlog_is_open(l) && coio_fdatasync(l->fd) != 0) {
+			/*
+			 * The rows have already been written to
+			 * the WAL and may have been sent to
+			 * replicas by relays, which read the file
+			 * up to its end, so they can't be rolled
+			 * back. After a failed fdatasync() we don't
+			 * know what got to the disk, either, so the
+			 * only safe thing to do is to stop and let
+			 * recovery sort it out.
+			 */
+			panic_syserror("%s: fdatasync() failed", l->filename);
+		}
+		writer->sync_in_progress = false;
+		double sync_time = ev_monotonic_time() - sync_start;
+		writer->sync_time = 0.9 * writer->sync_time + 0.1 * sync_time;
+		wal_notify_watchers(writer, WAL_EVENT_WRITE);
+		ERROR_INJECT_SLEEP(ERRINJ_RELAY_FASTER_THAN_TX);
+		struct wal_msg *batch, *next;
+		stailq_foreach_entry_safe(batch, next, &queue, in_sync_queue)
+			wal_msg_complete(writer, batch);
+		fiber_cond_broadcast(&writer->synced_cond);
+	}
+	return 0;
+}
+
+/**
+ * Return how long the WAL thread may wait for more batches to
+ * join the group before writing it. In 'fsync' mode the delay
+ * configured by the user is capped by the observed fdatasync()
+ * time: each batch joining the group saves a sync, but waiting
+ * longer than a sync takes only adds latency. In other modes
+ * a write() is too cheap to serve as a bound so the configured
+ * delay is used as is.
+ */
+static double
+wal_group_delay(struct wal_writer *writer)
+{
+	if (writer->wal_mode == WAL_FSYNC)
+		return MIN(writer->commit_delay, writer->sync_time);
+	return writer->commit_delay;
+}
+
+/**
+ * Write all batches accumulated in the group. The batches are
+ * merged into the first one so that they all are written with
+ * one write() and synced with one fdatasync().
+ */
+static void
+wal_write_group(struct wal_writer *writer)
+{
+	if (stailq_empty(&writer->group))
+		return;
+	struct wal_msg *batch = stailq_shift_entry(&writer->group,
+						   struct wal_msg, in_group);
+	struct wal_msg *msg;
+	stailq_foreach_entry(msg, &writer->group, in_group) {
+		stailq_concat(&batch->commit, &msg->commit);
+		batch->approx_len += msg->approx_len;
+	}
+	stailq_concat(&batch->group, &writer->group);
+	writer->group_len = 0;
+
+	double wait = ev_monotonic_now(loop()) - writer->group_start;
+	histogram_collect(writer->batch_size_hist, batch->approx_len);
+	histogram_collect(writer->batch_wait_hist, wait * 1e6);
+	writer->batch_count++;
+	wal_write_batch(writer, batch);
+}
+
+/**
+ * Handle a batch received from tx. The batch is written right
+ * away unless group commit is enabled (wal_commit_delay > 0),
+ * in which case it's added to the group that is written either
+ * when it's big enough or when the delay expires, see
+ * wal_writer_loop().
+ */
+static void
+wal_write_to_disk(struct cmsg *msg)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_msg *batch = (struct wal_msg *) msg;
+	double now = ev_monotonic_now(loop());
+	if (stailq_empty(&writer->group)) {
+		writer->group_start = now;
+		writer->group_deadline = now + wal_group_delay(writer);
+	}
+	stailq_add_tail_entry(&writer->group, batch, in_group);
+	writer->group_len += batch->approx_len;
+	if (writer->group_deadline <= now ||
+	    writer->group_len >= (size_t)writer->commit_min_size)
+		wal_write_group(writer);
+}
+
+/**
+ * Called when new messages arrive at the 'wal' endpoint. Wakes
+ * up the writer fiber like fiber_schedule_cb(), but also sets
+ * a flag so that the wakeup isn't lost if the fiber is waiting
+ * for something else in a message handler at the moment, e.g.
+ * in wal_wait_synced().
+ */
+static void
+wal_writer_fetch_cb(ev_loop *loop, struct ev_watcher *watcher, int events)
+{
+	wal_writer_singleton.has_input = true;
+	fiber_schedule_cb(loop, watcher, events);
+}
+
+/**
+ * Process messages sent to the WAL thread. Unlike cbus_loop(),
+ * writes the pending group once its delay expires.
+ */
+static void
+wal_writer_loop(struct wal_writer *writer, struct cbus_endpoint *endpoint)
+{
+	while (true) {
+		writer->has_input = false;
+		cbus_process(endpoint);
+		if (fiber_is_cancelled())
+			break;
+		/* More messages arrived while we were processing. */
+		if (writer->has_input)
+			continue;
+		if (stailq_empty(&writer->group)) {
+			fiber_yield();
+			continue;
+		}
+		double timeout = writer->group_deadline -
+				 ev_monotonic_now(loop());
+		if (timeout <= 0 || fiber_yield_timeout(timeout))
+			wal_write_group(writer);
+	}
+	/* Don't lose the transactions waiting for group commit. */
+	wal_write_group(writer);
+}
+
+static ssize_t
+wal_create_spare_cb(va_list ap)
+{
+	const char *filename = va_arg(ap, const char *);
+	size_t len = va_arg(ap, size_t);
+	size_t *allocated = va_arg(ap, size_t *);
+	int *fd = va_arg(ap, int *);
+	*fd = xlog_create_spare(filename, len, allocated);
+	return *fd >= 0 ? 0 : -1;
+}
+
+/**
+ * Spare fiber of the WAL thread. Prepares spare WAL files, see
+ * struct wal_spare, in a coio thread so as not to stall writes.
+ * Sleeps when all spare files are ready or when it failed to
+ * prepare one until the next rotation or garbage collection.
+ */
+static int
+wal_spare_f(va_list ap)
+{
+	(void)ap;
+	struct wal_writer *writer = &wal_writer_singleton;
+	while (!fiber_is_cancelled()) {
+		int i;
+		for (i = 0; i < writer->spare_files; i++) {
+			if (writer->spares[i].fd < 0)
+				break;
+		}
+		if (i == writer->spare_files) {
+			fiber_cond_wait(&writer->spare_cond);
+			continue;
+		}
+		struct wal_spare *spare = &writer->spares[i];
+		char filename[PATH_MAX];
+		wal_spare_filename(writer, i, filename, sizeof(filename));
+		int fd;
+		size_t allocated;
+		spare->is_busy = true;
+		int rc = coio_call(wal_create_spare_cb, filename,
+				   (size_t)writer->wal_max_size,
+				   &allocated, &fd);
+		spare->is_busy = false;
+		if (rc != 0) {
+			diag_log();
+			fiber_cond_wait(&writer->spare_cond);
+			continue;
+		}
+		spare->fd = fd;
+		spare->allocated = allocated;
+		/* The file isn't needed anymore, see wal_set_spare_files(). */
+		if (i >= writer->spare_files)
+			wal_remove_spare(writer, i);
+	}
+	return 0;
 }
 
 /** WAL writer main loop.  */
@@ -1202,7 +1984,7 @@ wal_writer_f(va_list ap)
 	coio_enable();
 
 	struct cbus_endpoint endpoint;
-	cbus_endpoint_create(&endpoint, "wal", fiber_schedule_cb, fiber());
+	cbus_endpoint_create(&endpoint, "wal", wal_writer_fetch_cb, fiber());
 	/*
 	 * Create a pipe to TX thread. Use a high priority
 	 * endpoint, to ensure that WAL messages are delivered
@@ -1210,7 +1992,50 @@ wal_writer_f(va_list ap)
 	 */
 	cpipe_create(&writer->tx_prio_pipe, "tx_prio");
 
-	cbus_loop(&endpoint);
+	if (writer->wal_mode == WAL_FSYNC) {
+		writer->sync_fiber = fiber_new("wal_fsync", wal_fsync_f);
+		if (writer->sync_fiber == NULL)
+			panic("failed to start the WAL sync fiber");
+		fiber_set_joinable(writer->sync_fiber, true);
+		fiber_start(writer->sync_fiber);
+	}
+
+	if (writer->wal_mode != WAL_NONE) {
+		writer->spare_fiber = fiber_new("wal_spare", wal_spare_f);
+		if (writer->spare_fiber == NULL)
+			panic("failed to start the WAL spare fiber");
+		fiber_set_joinable(writer->spare_fiber, true);
+		fiber_start(writer->spare_fiber);
+	}
+
+	wal_writer_loop(writer, &endpoint);
+
+	if (writer->spare_fiber != NULL) {
+		fiber_cancel(writer->spare_fiber);
+		fiber_join(writer->spare_fiber);
+	}
+	/*
+	 * Spare files aren't reused after restart, so remove them
+	 * not to waste disk space. A file may be left behind if
+	 * the spare fiber was cancelled while preparing it hence
+	 * try to remove all of them.
+	 */
+	for (int i = 0; i < WAL_SPARE_FILES_MAX; i++) {
+		if (writer->spares[i].fd >= 0) {
+			close(writer->spares[i].fd);
+			writer->spares[i].fd = -1;
+		}
+		char filename[PATH_MAX];
+		wal_spare_filename(writer, i, filename, sizeof(filename));
+		if (unlink(filename) != 0 && errno != ENOENT)
+			say_syserror("error while removing %s", filename);
+	}
+
+	if (writer->sync_fiber != NULL) {
+		wal_wait_synced(writer);
+		fiber_cancel(writer->sync_fiber);
+		fiber_join(writer->sync_fiber);
+	}
 
 	/*
 	 * Create a new empty WAL on shutdown so that we don't
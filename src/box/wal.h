@@ -74,6 +74,23 @@ enum {
 /** String constants for the supported modes. */
 extern const char *wal_mode_STRS[];
 
+/** Compression codec of WAL tx blocks. */
+enum wal_compression {
+	/** Write tx blocks uncompressed. */
+	WAL_COMPRESSION_NONE,
+	/** Compress big enough tx blocks with zstd. */
+	WAL_COMPRESSION_ZSTD,
+	wal_compression_MAX
+};
+extern const char *wal_compression_strs[];
+
+enum {
+	/** Min zstd compression level of WAL tx blocks. */
+	WAL_COMPRESSION_LEVEL_MIN = -100,
+	/** Max zstd compression level of WAL tx blocks. */
+	WAL_COMPRESSION_LEVEL_MAX = 22,
+};
+
 extern int wal_dir_lock;
 
 #if defined(__cplusplus)
@@ -263,6 +280,57 @@ wal_set_checkpoint_threshold(int64_t threshold);
 void
 wal_set_queue_max_size(int64_t size);
 
+/**
+ * Set the max time a WAL write may be delayed in order to be
+ * grouped with following writes. 0 disables group commit.
+ */
+void
+wal_set_commit_delay(double delay);
+
+/**
+ * Set the size of a group of WAL writes that is written to disk
+ * without waiting for the commit delay to expire.
+ */
+void
+wal_set_commit_min_size(int64_t size);
+
+enum {
+	/** Max number of spare WAL files, see wal_set_spare_files(). */
+	WAL_SPARE_FILES_MAX = 8,
+};
+
+/**
+ * Set the number of empty WAL files with disk space preallocated
+ * for them that are kept ready to be used on WAL rotation.
+ */
+void
+wal_set_spare_files(int count);
+
+/**
+ * Enable or disable direct I/O for WAL files, see
+ * xlog_opts::direct_io. Takes effect on the next WAL file.
+ */
+void
+wal_set_direct_io(bool direct_io);
+
+/**
+ * Set the codec and the zstd compression level of WAL tx
+ * blocks, see xlog_opts::compression_level. Takes effect on
+ * the next WAL file.
+ */
+void
+wal_set_compression(enum wal_compression compression, int level);
+
+struct info_handler;
+
+/** Dump WAL writer statistics to an info handler. */
+void
+wal_stat(struct info_handler *h);
+
+/** Reset WAL writer statistics. */
+void
+wal_reset_stat(void);
+
 /**
  * Remove WAL files that are not needed by consumers reading
  * rows at @vclock or newer.
@@ -88,6 +88,11 @@ enum {
 	 * Maybe this should be a configuration option.
 	 */
 	XLOG_TX_COMPRESS_THRESHOLD = 2 * 1024,
+	/**
+	 * Alignment of file offsets, lengths and buffers
+	 * used for direct I/O.
+	 */
+	XLOG_DIO_ALIGN = 4096,
 };
 
 const struct xlog_opts xlog_opts_default = {
@@ -96,6 +101,10 @@ const struct xlog_opts xlog_opts_default = {
 	.free_cache = false,
 	.sync_is_async = false,
 	.no_compression = false,
+	.compression_level = 0,
+	.zcdict = NULL,
+	.direct_io = false,
+	.index_step = 0,
 };
 
 /* {{{ struct xlog_meta */
@@ -114,6 +123,9 @@ enum {
 #define VCLOCK_KEY "VClock"
 #define VERSION_KEY "Version"
 #define PREV_VCLOCK_KEY "PrevVClock"
+#define INDEX_FILETYPE "INDEX"
+#define INDEX_FILE_SIZE_KEY "Size"
+#define INDEX_ENTRIES_KEY "Entries"
 
 static const char v13[] = "0.13";
 static const char v12[] = "0.12";
@@ -676,6 +688,31 @@ xdir_complete_gc(eio_req *req)
 	return 0;
 }
 
+/**
+ * Return the name of the sparse index file of an xlog,
+ * see xlog_opts::index_step.
+ */
+static const char *
+xlog_index_filename(const char *filename)
+{
+	return tt_snprintf(PATH_MAX, "%s.index", filename);
+}
+
+/** Remove the index file of an xlog that is being removed. */
+static void
+xdir_remove_index(struct xdir *dir, const char *filename, unsigned flags)
+{
+	if (dir->opts.index_step == 0)
+		return;
+	const char *index_filename = xlog_index_filename(filename);
+	if (flags & XDIR_GC_ASYNC) {
+		eio_unlink(index_filename, 0, xdir_complete_gc, NULL);
+	} else {
+		int rc = unlink(index_filename);
+		xdir_say_gc(rc, errno, index_filename);
+	}
+}
+
 void
 xdir_collect_garbage(struct xdir *dir, int64_t signature, unsigned flags)
 {
@@ -690,6 +727,7 @@ xdir_collect_garbage(struct xdir *dir, int64_t signature, unsigned flags)
 			int rc = unlink(filename);
 			xdir_say_gc(rc, errno, filename);
 		}
+		xdir_remove_index(dir, filename, flags);
 		vclockset_remove(&dir->index, vclock);
 		free(vclock);
 
@@ -698,6 +736,26 @@ xdir_collect_garbage(struct xdir *dir, int64_t signature, unsigned flags)
 	}
 }
 
+int
+xdir_recycle_xlog(struct xdir *dir, int64_t signature, const char *filename)
+{
+	struct vclock *vclock = vclockset_first(&dir->index);
+	if (vclock == NULL || vclock_sum(vclock) >= signature)
+		return -1;
+	const char *old_filename =
+		xdir_format_filename(dir, vclock_sum(vclock), NONE);
+	if (rename(old_filename, filename) != 0) {
+		if (errno != ENOENT)
+			say_syserror("error while renaming %s", old_filename);
+		return -1;
+	}
+	say_info("recycled %s", old_filename);
+	xdir_remove_index(dir, old_filename, 0);
+	vclockset_remove(&dir->index, vclock);
+	free(vclock);
+	return 0;
+}
+
 int
 xdir_remove_file_by_vclock(struct xdir *dir, struct vclock *to_remove)
 {
@@ -710,6 +768,7 @@ xdir_remove_file_by_vclock(struct xdir *dir, struct vclock *to_remove)
 	xdir_say_gc(rc, errno, filename);
 	if (rc != 0)
 		return -1;
+	xdir_remove_index(dir, filename, 0);
 	vclockset_remove(&dir->index, find);
 	free(find);
 	return 0;
@@ -786,6 +845,7 @@ static int
 xlog_init(struct xlog *xlog, const struct xlog_opts *opts)
 {
 	memset(xlog, 0, sizeof(*xlog));
+	xlog->dio_fd = -1;
 	xlog->opts = *opts;
 	xlog->sync_time = ev_monotonic_time();
 	xlog->is_autocommit = true;
@@ -807,6 +867,7 @@ xlog_clear(struct xlog *l)
 {
 	memset(l, 0, sizeof(*l));
 	l->fd = -1;
+	l->dio_fd = -1;
 }
 
 static void
@@ -817,17 +878,154 @@ xlog_destroy(struct xlog *xlog)
 	obuf_destroy(&xlog->obuf);
 	obuf_destroy(&xlog->zbuf);
 	ZSTD_freeCCtx(xlog->zctx);
+	if (xlog->dio_fd >= 0)
+		close(xlog->dio_fd);
+	free(xlog->dio_buf);
+	free(xlog->index);
 	TRASH(xlog);
 	xlog->fd = -1;
+	xlog->dio_fd = -1;
+}
+
+/** Make sure the direct I/O buffer can store @size bytes. */
+static int
+xlog_dio_reserve(struct xlog *xlog, size_t size)
+{
+	if (size <= xlog->dio_buf_size)
+		return 0;
+	size_t new_size = MAX(xlog->dio_buf_size, (size_t)XLOG_DIO_ALIGN);
+	while (new_size < size)
+		new_size *= 2;
+	void *buf;
+	if (posix_memalign(&buf, XLOG_DIO_ALIGN, new_size) != 0) {
+		diag_set(OutOfMemory, new_size, "posix_memalign",
+			 "xlog direct I/O buffer");
+		return -1;
+	}
+	memcpy(buf, xlog->dio_buf, xlog->dio_len);
+	free(xlog->dio_buf);
+	xlog->dio_buf = buf;
+	xlog->dio_buf_size = new_size;
+	return 0;
+}
+
+/**
+ * Open the file for direct I/O if it's enabled in the options.
+ * Must be called when the xlog file is ready for appending.
+ */
+static int
+xlog_dio_open(struct xlog *xlog)
+{
+	assert(xlog->dio_fd < 0);
+	if (!xlog->opts.direct_io)
+		return 0;
+#ifdef O_DIRECT
+	int fd = open(xlog->filename, O_WRONLY | O_DIRECT);
+	if (fd < 0) {
+		if (errno != EINVAL) {
+			diag_set(SystemError, "failed to open file '%s'",
+				 xlog->filename);
+			return -1;
+		}
+		say_warn("%s: direct I/O is not supported, "
+			 "proceeding without it", xlog->filename);
+		return 0;
+	}
+	/* Load the partial last block. */
+	size_t tail = xlog->offset % XLOG_DIO_ALIGN;
+	if (xlog_dio_reserve(xlog, XLOG_DIO_ALIGN) != 0)
+		goto err;
+	if (fio_pread(xlog->fd, xlog->dio_buf, tail,
+		      xlog->offset - tail) != (ssize_t)tail) {
+		diag_set(SystemError, "failed to read file '%s'",
+			 xlog->filename);
+		goto err;
+	}
+	xlog->dio_len = tail;
+	xlog->dio_fd = fd;
+	return 0;
+err:
+	close(fd);
+	return -1;
+#else
+	say_warn("%s: direct I/O is not supported, proceeding without it",
+		 xlog->filename);
+	return 0;
+#endif /* O_DIRECT */
+}
+
+/**
+ * Append data to an xlog file opened for direct I/O. The data
+ * is appended to the partial last block kept in the aligned
+ * buffer, and the buffer is written with O_DIRECT in whole
+ * blocks, the last one padded with zeros. The partial last block
+ * stays in the buffer to be rewritten next time. The padding is
+ * cut off when the file is closed, see xlog_write_eof(), while
+ * readers stop at it, see xlog_cursor_check_dio_padding().
+ */
+static ssize_t
+xlog_dio_writev(struct xlog *log, struct iovec *iov, int iovcnt)
+{
+	size_t len = 0;
+	for (int i = 0; i < iovcnt; i++)
+		len += iov[i].iov_len;
+	size_t total = log->dio_len + len;
+	size_t padded = DIV_ROUND_UP(total, XLOG_DIO_ALIGN) * XLOG_DIO_ALIGN;
+	if (xlog_dio_reserve(log, padded) != 0)
+		return -1;
+	char *pos = log->dio_buf + log->dio_len;
+	for (int i = 0; i < iovcnt; i++) {
+		memcpy(pos, iov[i].iov_base, iov[i].iov_len);
+		pos += iov[i].iov_len;
+	}
+	memset(pos, 0, padded - total);
+	off_t start = log->offset - log->dio_len;
+	assert(start % XLOG_DIO_ALIGN == 0);
+	if (fio_pwriten(log->dio_fd, log->dio_buf, padded, start) != 0)
+		return -1;
+	size_t aligned = total - total % XLOG_DIO_ALIGN;
+	memmove(log->dio_buf, log->dio_buf + aligned, total - aligned);
+	log->dio_len = total - aligned;
+	return len;
+}
+
+/** Append data to an xlog file. */
+static ssize_t
+xlog_writev(struct xlog *log, struct iovec *iov, int iovcnt)
+{
+	if (log->dio_fd >= 0)
+		return xlog_dio_writev(log, iov, iovcnt);
+	return fio_writevn(log->fd, iov, iovcnt);
+}
+
+/** Write the meta block of a newly created xlog file. */
+static int
+xlog_write_meta(struct xlog *xlog)
+{
+	char meta_buf[XLOG_META_LEN_MAX];
+	/* Format metadata */
+	int meta_len = xlog_meta_format(&xlog->meta, meta_buf,
+					sizeof(meta_buf));
+	if (meta_len < 0)
+		return -1;
+	/* Formatted metadata must fit into meta_buf */
+	assert(meta_len < (int)sizeof(meta_buf));
+
+	/* Write metadata */
+	if (fio_writen(xlog->fd, meta_buf, meta_len) < 0) {
+		diag_set(SystemError, "%s: failed to write xlog meta",
+			 xlog->filename);
+		return -1;
+	}
+
+	xlog->offset = meta_len; /* first log starts after meta */
+	return 0;
 }
 
 int
 xlog_create(struct xlog *xlog, const char *name, int flags,
 	    const struct xlog_meta *meta, const struct xlog_opts *opts)
 {
-	char meta_buf[XLOG_META_LEN_MAX];
-	int meta_len;
-
 	/*
 	 * Check whether a file with this name already exists.
 	 * We don't overwrite existing files.
@@ -872,28 +1070,92 @@ xlog_create(struct xlog *xlog, const char *name, int flags,
 		goto err_open;
 	}
 
-	/* Format metadata */
-	meta_len = xlog_meta_format(&xlog->meta, meta_buf, sizeof(meta_buf));
-	if (meta_len < 0)
+	if (xlog_write_meta(xlog) != 0 || xlog_dio_open(xlog) != 0)
 		goto err_write;
-	/* Formatted metadata must fit into meta_buf */
-	assert(meta_len < (int)sizeof(meta_buf));
+	return 0;
+err_write:
+	close(xlog->fd);
+	unlink(xlog->filename); /* try to remove incomplete file */
+err_open:
+	xlog_destroy(xlog);
+err:
+	return -1;
+}
 
-	/* Write metadata */
-	if (fio_writen(xlog->fd, meta_buf, meta_len) < 0) {
-		diag_set(SystemError, "%s: failed to write xlog meta",
-			 xlog->filename);
-		goto err_write;
+int
+xlog_create_spare(const char *filename, size_t len, size_t *allocated)
+{
+	int fd = open(filename, O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		diag_set(SystemError, "failed to create file '%s'", filename);
+		return -1;
 	}
+	/* The file may be a recycled xlog. */
+	if (ftruncate(fd, 0) != 0) {
+		diag_set(SystemError, "failed to truncate file '%s'",
+			 filename);
+		goto err;
+	}
+	*allocated = 0;
+#ifdef HAVE_FALLOCATE
+	/* See the comment in xlog_fallocate(). */
+	if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, len) == 0) {
+		*allocated = len;
+	} else if (errno != ENOSYS && errno != EOPNOTSUPP) {
+		diag_set(SystemError, "%s: can't allocate disk space",
+			 filename);
+		goto err;
+	}
+#else
+	(void)len;
+#endif /* HAVE_FALLOCATE */
+	return fd;
+err:
+	close(fd);
+	unlink(filename);
+	return -1;
+}
 
-	xlog->offset = meta_len; /* first log starts after meta */
+/**
+ * Same as xlog_create(), but instead of creating a new file
+ * adopts a spare file created with xlog_create_spare().
+ */
+static int
+xlog_create_from_spare(struct xlog *xlog, const char *name,
+		       const char *spare, int fd, size_t allocated,
+		       const struct xlog_meta *meta,
+		       const struct xlog_opts *opts)
+{
+	if (access(name, F_OK) == 0) {
+		errno = EEXIST;
+		diag_set(SystemError, "file '%s' already exists", name);
+		goto err;
+	}
+
+	if (xlog_init(xlog, opts) != 0)
+		goto err;
+
+	xlog->meta = *meta;
+	xlog->is_inprogress = true;
+	snprintf(xlog->filename, sizeof(xlog->filename), "%s%s", name,
+		 inprogress_suffix);
+
+	if (rename(spare, xlog->filename) != 0) {
+		diag_set(SystemError, "failed to rename '%s' file", spare);
+		goto err_rename;
+	}
+	xlog->fd = fd;
+	if (xlog_write_meta(xlog) != 0 || xlog_dio_open(xlog) != 0)
+		goto err_write;
+	if (allocated > (size_t)xlog->offset)
+		xlog->allocated = allocated - xlog->offset;
 	return 0;
 err_write:
-	close(xlog->fd);
 	unlink(xlog->filename); /* try to remove incomplete file */
-err_open:
+err_rename:
 	xlog_destroy(xlog);
 err:
+	close(fd);
 	return -1;
 }
 
@@ -961,6 +1223,8 @@ no_eof:
 			goto err_read;
 		}
 	}
+	if (xlog_dio_open(xlog) != 0)
+		goto err_read;
 	return 0;
 err_read:
 	close(xlog->fd);
@@ -993,12 +1257,11 @@ xdir_touch_xlog(struct xdir *dir, const struct vclock *vclock)
  * In case of error, writes a message to the error log
  * and sets errno.
  */
-int
-xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
-		 const struct vclock *vclock)
+static void
+xdir_create_xlog_meta(struct xdir *dir, const struct vclock *vclock,
+		      struct xlog_meta *meta)
 {
-	int64_t signature = vclock_sum(vclock);
-	assert(signature >= 0);
+	assert(vclock_sum(vclock) >= 0);
 	assert(!tt_uuid_is_nil(dir->instance_uuid));
 
 	/*
@@ -1009,11 +1272,19 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 	if (dir->type == XLOG && !vclockset_empty(&dir->index))
 		prev_vclock = vclockset_last(&dir->index);
 
-	struct xlog_meta meta;
-	xlog_meta_create(&meta, dir->filetype, dir->instance_uuid,
+	xlog_meta_create(meta, dir->filetype, dir->instance_uuid,
 			 vclock, prev_vclock);
+}
 
-	const char *filename = xdir_format_filename(dir, signature, NONE);
+int
+xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
+		 const struct vclock *vclock)
+{
+	struct xlog_meta meta;
+	xdir_create_xlog_meta(dir, vclock, &meta);
+
+	const char *filename = xdir_format_filename(dir, vclock_sum(vclock),
+						    NONE);
 	if (xlog_create(xlog, filename, dir->open_wflags, &meta,
 			&dir->opts) != 0)
 		return -1;
@@ -1029,6 +1300,29 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 	return 0;
 }
 
+int
+xdir_create_xlog_from_spare(struct xdir *dir, struct xlog *xlog,
+			    const struct vclock *vclock, const char *spare,
+			    int fd, size_t allocated)
+{
+	struct xlog_meta meta;
+	xdir_create_xlog_meta(dir, vclock, &meta);
+
+	const char *filename = xdir_format_filename(dir, vclock_sum(vclock),
+						    NONE);
+	if (xlog_create_from_spare(xlog, filename, spare, fd, allocated,
+				   &meta, &dir->opts) != 0)
+		return -1;
+
+	if (dir->suffix != INPROGRESS && xlog_rename(xlog)) {
+		int save_errno = errno;
+		xlog_close(xlog, false);
+		errno = save_errno;
+		return -1;
+	}
+	return 0;
+}
+
 ssize_t
 xlog_fallocate(struct xlog *log, size_t len)
 {
@@ -1114,7 +1408,7 @@ xlog_tx_write_plain(struct xlog *log)
 		return -1;
 	});
 
-	ssize_t written = fio_writevn(log->fd, log->obuf.iov, log->obuf.pos + 1);
+	ssize_t written = xlog_writev(log, log->obuf.iov, log->obuf.pos + 1);
 	if (written < 0) {
 		diag_set(SystemError, "failed to write to '%s' file",
 			 log->filename);
@@ -1136,8 +1430,14 @@ xlog_tx_write_zstd(struct xlog *log)
 
 	uint32_t crc32c = 0;
 	struct iovec *iov;
-	/* 3 is compression level. */
-	ZSTD_compressBegin(log->zctx, 3);
+	if (log->opts.zcdict != NULL) {
+		ZSTD_compressBegin_usingCDict(log->zctx, log->opts.zcdict);
+	} else {
+		int level = log->opts.compression_level != 0 ?
+			    log->opts.compression_level :
+			    XLOG_COMPRESSION_LEVEL_DEFAULT;
+		ZSTD_compressBegin(log->zctx, level);
+	}
 	size_t offset = XLOG_FIXHEADER_SIZE;
 	for (iov = log->obuf.iov; iov->iov_len; ++iov) {
 		/* Estimate max output buffer size. */
@@ -1204,8 +1504,7 @@ xlog_tx_write_zstd(struct xlog *log)
 	});
 
 	ssize_t written;
-	written = fio_writevn(log->fd, log->zbuf.iov,
-			      log->zbuf.pos + 1);
+	written = xlog_writev(log, log->zbuf.iov, log->zbuf.pos + 1);
 	if (written < 0) {
 		diag_set(SystemError, "failed to write to '%s' file",
 			 log->filename);
@@ -1420,6 +1719,94 @@ xlog_flush(struct xlog *log)
 	return xlog_tx_write(log);
 }
 
+void
+xlog_add_index_entry(struct xlog *log, const struct vclock *vclock)
+{
+	if (log->opts.index_step == 0 || obuf_size(&log->obuf) > 0)
+		return;
+	off_t last_offset = log->index_size > 0 ?
+			    log->index[log->index_size - 1].offset : 0;
+	if (log->offset < last_offset + (off_t)log->opts.index_step)
+		return;
+	if (log->index_size == log->index_capacity) {
+		int capacity = MAX(log->index_capacity * 2, 16);
+		struct xlog_index_entry *index = realloc(log->index,
+					capacity * sizeof(*index));
+		/* The index is optional, don't fail writes. */
+		if (index == NULL)
+			return;
+		log->index = index;
+		log->index_capacity = capacity;
+	}
+	struct xlog_index_entry *entry = &log->index[log->index_size++];
+	entry->offset = log->offset;
+	vclock_copy(&entry->vclock, vclock);
+}
+
+/**
+ * Save the sparse index of an xlog to a separate file, see
+ * xlog_opts::index_step. The index file stores the size of
+ * the xlog so that a reader can check that it matches the
+ * xlog. It's written under a temporary name and renamed then
+ * so that a reader never sees a partially written index.
+ */
+static int
+xlog_write_index(struct xlog *l, off_t file_size)
+{
+	char filename[PATH_MAX];
+	char tmp_filename[PATH_MAX];
+	snprintf(filename, sizeof(filename), "%s",
+		 xlog_index_filename(l->filename));
+	snprintf(tmp_filename, sizeof(tmp_filename), "%s%s",
+		 filename, inprogress_suffix);
+
+	size_t size = XLOG_META_LEN_MAX +
+		      l->index_size * (VCLOCK_STR_LEN_MAX + 32);
+	char *buf = malloc(size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "xlog index");
+		return -1;
+	}
+	int len = snprintf(buf, size, "%s\n%s\n"
+			   INDEX_FILE_SIZE_KEY ": %lld\n"
+			   INDEX_ENTRIES_KEY ": %d\n\n",
+			   INDEX_FILETYPE, v13, (long long)file_size,
+			   l->index_size);
+	for (int i = 0; i < l->index_size; i++) {
+		struct xlog_index_entry *entry = &l->index[i];
+		len += snprintf(buf + len, size - len, "%lld %s\n",
+				(long long)entry->offset,
+				vclock_to_string(&entry->vclock));
+	}
+	assert((size_t)len < size);
+
+	int rc = -1;
+	int fd = open(tmp_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		diag_set(SystemError, "failed to create file '%s'",
+			 tmp_filename);
+		goto out;
+	}
+	if (fio_writen(fd, buf, len) < 0) {
+		diag_set(SystemError, "failed to write file '%s'",
+			 tmp_filename);
+		close(fd);
+		unlink(tmp_filename);
+		goto out;
+	}
+	close(fd);
+	if (rename(tmp_filename, filename) != 0) {
+		diag_set(SystemError, "failed to rename '%s' file",
+			 tmp_filename);
+		unlink(tmp_filename);
+		goto out;
+	}
+	rc = 0;
+out:
+	free(buf);
+	return rc;
+}
+
 static int
 sync_cb(eio_req *req)
 {
@@ -1460,15 +1847,24 @@ xlog_write_eof(struct xlog *l)
 	});
 
 	/*
-	 * Free disk space preallocated with xlog_fallocate().
+	 * Free disk space preallocated with xlog_fallocate() and
+	 * cut off the padding of the last block written with
+	 * direct I/O, see xlog_dio_writev().
 	 * Don't write the eof marker if this fails, otherwise
 	 * we'll get "data after eof marker" error on recovery.
 	 */
-	if (l->allocated > 0 && ftruncate(l->fd, l->offset) < 0) {
+	if ((l->allocated > 0 || l->dio_fd >= 0) &&
+	    ftruncate(l->fd, l->offset) < 0) {
 		diag_set(SystemError, "ftruncate() failed");
 		return -1;
 	}
 
+	/* Direct I/O writes don't move the file position. */
+	if (l->dio_fd >= 0 && lseek(l->fd, l->offset, SEEK_SET) < 0) {
+		diag_set(SystemError, "lseek() failed");
+		return -1;
+	}
+
 	if (fio_writen(l->fd, &eof_marker, sizeof(eof_marker)) < 0) {
 		diag_set(SystemError, "write() failed");
 		return -1;
@@ -1484,6 +1880,11 @@ xlog_close(struct xlog *l, bool reuse_fd)
 		say_error("%s: failed to write EOF marker: %s", l->filename,
 			  diag_last_error(diag_get())->errmsg);
 
+	if (rc == 0 && l->index_size > 0 && !l->is_inprogress &&
+	    xlog_write_index(l, l->offset + sizeof(eof_marker)) != 0)
+		say_warn("%s: failed to write index: %s", l->filename,
+			 diag_last_error(diag_get())->errmsg);
+
 	/*
 	 * Sync the file before closing, since
 	 * otherwise we can end up with a partially
@@ -1516,6 +1917,10 @@ xlog_atfork(struct xlog *xlog)
 	 */
 	close(xlog->fd);
 	xlog->fd = -1;
+	if (xlog->dio_fd >= 0) {
+		close(xlog->dio_fd);
+		xlog->dio_fd = -1;
+	}
 }
 
 /* }}} */
@@ -1691,7 +2096,8 @@ xlog_fixheader_decode(struct xlog_fixheader *fixheader,
 
 int
 xlog_tx_decode(const char *data, const char *data_end,
-	       char *rows, char *rows_end, ZSTD_DStream *zdctx)
+	       char *rows, char *rows_end, ZSTD_DStream *zdctx,
+	       const ZSTD_DDict *zddict)
 {
 	/* Decode fixheader */
 	struct xlog_fixheader fixheader;
@@ -1730,7 +2136,10 @@ xlog_tx_decode(const char *data, const char *data_end,
 
 	/* Decompress zstd rows */
 	assert(fixheader.magic == zrow_marker);
-	ZSTD_initDStream(zdctx);
+	if (zddict != NULL)
+		ZSTD_initDStream_usingDDict(zdctx, zddict);
+	else
+		ZSTD_initDStream(zdctx);
 	int rc = xlog_cursor_decompress(&rows, rows_end, &data, data_end,
 					zdctx);
 	if (rc < 0) {
@@ -1873,6 +2282,55 @@ xlog_cursor_find_tx_magic(struct xlog_cursor *i)
 	return 0;
 }
 
+/**
+ * Check if a zero magic the cursor is positioned at starts the
+ * padding of the last block of a WAL file written with direct
+ * I/O, see xlog_dio_writev(). The padding is cut off when the
+ * file is closed, but a reader may see it while the file is
+ * being written or after a crash. It is always in the last
+ * block of the file, which ends on a block boundary then, and
+ * spans to the end of the file. Zeros anywhere else are an
+ * error, as before.
+ *
+ * If the cursor is at the padding, the read buffer is dropped
+ * so that data written over the padding later is read from the
+ * file next time.
+ *
+ * @retval 1 the cursor is at the padding, there's no more data
+ * @retval 0 not the padding, the data should be parsed as usual
+ * @retval -1 error
+ */
+static int
+xlog_cursor_check_dio_padding(struct xlog_cursor *i)
+{
+	if (i->fd < 0 || strcmp(i->meta.filetype, "XLOG") != 0)
+		return 0;
+	off_t pos = xlog_cursor_pos(i);
+	struct stat st;
+	if (fstat(i->fd, &st) != 0) {
+		diag_set(SystemError, "failed to stat file '%s'", i->name);
+		return -1;
+	}
+	if (st.st_size % XLOG_DIO_ALIGN != 0 || st.st_size <= pos ||
+	    st.st_size - pos >= XLOG_DIO_ALIGN)
+		return 0;
+	char buf[XLOG_DIO_ALIGN];
+	ssize_t len = fio_pread(i->fd, buf, st.st_size - pos, pos);
+	if (len < 0) {
+		diag_set(SystemError, "failed to read file '%s'", i->name);
+		return -1;
+	}
+	/* Reread the data from the file in any case. */
+	ibuf_reset(&i->rbuf);
+	i->read_offset = pos;
+	for (ssize_t k = 0; k < len; k++) {
+		/* Data has been written over the padding. */
+		if (buf[k] != 0)
+			return 0;
+	}
+	return 1;
+}
+
 int
 xlog_cursor_next_tx(struct xlog_cursor *i)
 {
@@ -1889,6 +2347,11 @@ xlog_cursor_next_tx(struct xlog_cursor *i)
 		/* eof marker found */
 		goto eof_found;
 	}
+	if (load_u32(i->rbuf.rpos) == 0) {
+		rc = xlog_cursor_check_dio_padding(i);
+		if (rc != 0)
+			return rc;
+	}
 
 	ssize_t to_load;
 	while ((to_load = xlog_tx_cursor_create(&i->tx_cursor,
@@ -2088,4 +2551,107 @@ xlog_cursor_close(struct xlog_cursor *i, bool reuse_fd)
 	 */
 }
 
+/**
+ * Look up the offset of the last tx such that all rows written
+ * before it are covered by @vclock in an xlog index file.
+ * Returns 0 if there's no such tx, -1 if the index is missing
+ * or doesn't match an xlog of size @file_size.
+ */
+static off_t
+xlog_index_lookup(const char *filename, off_t file_size,
+		  const struct vclock *vclock, bool ignore0)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		if (errno != ENOENT)
+			say_syserror("failed to open '%s' file", filename);
+		return -1;
+	}
+	off_t result = -1;
+	char *buf = NULL;
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		say_syserror("failed to stat '%s' file", filename);
+		goto out;
+	}
+	buf = malloc(st.st_size + 1);
+	if (buf == NULL)
+		goto out;
+	if (fio_pread(fd, buf, st.st_size, 0) != st.st_size)
+		goto invalid;
+	buf[st.st_size] = '\0';
+
+	char version[16];
+	long long size;
+	int count, header_len = 0;
+	if (sscanf(buf, INDEX_FILETYPE "\n%15s\n"
+		   INDEX_FILE_SIZE_KEY ": %lld\n"
+		   INDEX_ENTRIES_KEY ": %d%n",
+		   version, &size, &count, &header_len) != 3 ||
+	    header_len == 0 || strncmp(buf + header_len, "\n\n", 2) != 0 ||
+	    strcmp(version, v13) != 0)
+		goto invalid;
+	if (size != file_size) {
+		/* The index was written for another file. */
+		goto out;
+	}
+	result = 0;
+	char *pos = buf + header_len + 2;
+	char *end = buf + st.st_size;
+	for (int i = 0; i < count; i++) {
+		char *eol = memchr(pos, '\n', end - pos);
+		if (eol == NULL)
+			goto invalid;
+		*eol = '\0';
+		char *p;
+		long long offset = strtoll(pos, &p, 10);
+		if (p == pos || *p != ' ' || offset <= 0 ||
+		    offset >= file_size)
+			goto invalid;
+		struct vclock entry_vclock;
+		vclock_create(&entry_vclock);
+		if (vclock_from_string(&entry_vclock, p + 1) != 0)
+			goto invalid;
+		int cmp = vclock_compare_generic(&entry_vclock, vclock,
+						 ignore0);
+		if (cmp <= 0 && offset > result)
+			result = offset;
+		pos = eol + 1;
+	}
+	if (pos != end)
+		goto invalid;
+out:
+	free(buf);
+	close(fd);
+	return result;
+invalid:
+	say_warn("%s: invalid index file, ignoring", filename);
+	result = -1;
+	goto out;
+}
+
+void
+xlog_cursor_seek(struct xlog_cursor *cursor, const struct vclock *vclock,
+		 bool ignore0)
+{
+	assert(cursor->state == XLOG_CURSOR_ACTIVE);
+	if (cursor->fd < 0)
+		return;
+	struct stat st;
+	if (fstat(cursor->fd, &st) != 0)
+		return;
+	char filename[PATH_MAX];
+	snprintf(filename, sizeof(filename), "%s",
+		 xlog_index_filename(cursor->name));
+	off_t offset = xlog_index_lookup(filename, st.st_size, vclock,
+					 ignore0);
+	off_t pos = xlog_cursor_pos(cursor);
+	if (offset <= pos)
+		return;
+	ibuf_reset(&cursor->rbuf);
+	cursor->read_offset = offset;
+	say_info("%s: skipped %lld bytes using index", cursor->name,
+		 (long long)(offset - pos));
+}
+
 /* }}} */
@@ -82,6 +82,49 @@ struct xlog_opts {
 	 * to be read frequently, e.g. L1 run files in Vinyl.
 	 */
 	bool no_compression;
+	/**
+	 * Zstd compression level. 0 means the default level,
+	 * see XLOG_COMPRESSION_LEVEL_DEFAULT. Negative levels
+	 * select fast zstd modes, which trade compression ratio
+	 * for speed. The level doesn't affect the block format.
+	 */
+	int compression_level;
+	/**
+	 * If set, xlog blocks are compressed with this dictionary.
+	 * The compression level is taken from the dictionary then.
+	 * Such blocks can't be read by xlog_cursor, only decoded
+	 * with xlog_tx_decode() given the same dictionary.
+	 */
+	const ZSTD_CDict *zcdict;
+	/**
+	 * If this flag is set, the xlog writer bypasses the page
+	 * cache: whole blocks are written with O_DIRECT from an
+	 * aligned buffer, and only the partial last block goes
+	 * through the page cache, so that the file size always
+	 * matches the size of written data.
+	 *
+	 * This option is useful for WAL files, which are written
+	 * once and shouldn't compete for the page cache with data
+	 * files.
+	 */
+	bool direct_io;
+	/**
+	 * If set, the xlog writer maintains a sparse index mapping
+	 * vclocks to file offsets with an entry per this number of
+	 * bytes written, see xlog_add_index_entry(). The index is
+	 * saved to a separate file next to the xlog on close and
+	 * allows a reader to skip the beginning of the file, see
+	 * xlog_cursor_seek().
+	 *
+	 * This option is useful for WAL files, which are read by
+	 * relays starting from an arbitrary vclock.
+	 */
+	uint64_t index_step;
+};
+
+enum {
+	/** Zstd compression level used by default. */
+	XLOG_COMPRESSION_LEVEL_DEFAULT = 3,
 };
 
 extern const struct xlog_opts xlog_opts_default;
@@ -235,11 +278,21 @@ enum {
 
 /**
  * Remove files whose signature is less than specified.
- * For possible values of @flags see XDIR_GC_*.
+ * For possible values of @flags see XDIR_GC_*. Index files
+ * of removed WAL files are removed too, see xlog_opts::index_step.
  */
 void
 xdir_collect_garbage(struct xdir *dir, int64_t signature, unsigned flags);
 
+/**
+ * Instead of removing the oldest file whose signature is less
+ * than specified, rename it to @filename so that it can be
+ * reused, see xlog_create_spare(). Returns -1 if there's no
+ * such file or it couldn't be renamed.
+ */
+int
+xdir_recycle_xlog(struct xdir *dir, int64_t signature, const char *filename);
+
 /**
  * Unlink single file with given vclock. If there's no file corresponding to
  * this vclock then log an error and return -1.
@@ -335,6 +388,14 @@ xlog_meta_create(struct xlog_meta *meta, const char *filetype,
 
 /* }}} */
 
+/** An entry of the sparse xlog index, see xlog_opts::index_step. */
+struct xlog_index_entry {
+	/** Offset of a tx in the file. */
+	off_t offset;
+	/** Vclock covering all rows written before the tx. */
+	struct vclock vclock;
+};
+
 /**
  * A single log file - a snapshot, a vylog or a write ahead log.
  */
@@ -401,6 +462,30 @@ struct xlog {
 	uint64_t synced_size;
 	/** Time when xlog wast synced last time */
 	double sync_time;
+	/**
+	 * Descriptor of the file opened with O_DIRECT or -1 if
+	 * direct I/O isn't used, see xlog_opts::direct_io.
+	 */
+	int dio_fd;
+	/**
+	 * Aligned bounce buffer for direct I/O. Starts with the
+	 * partial last block of the file, which is rewritten with
+	 * O_DIRECT, padded with zeros, on each write.
+	 */
+	char *dio_buf;
+	/** Size of the direct I/O buffer. */
+	size_t dio_buf_size;
+	/** Length of the partial last block stored in dio_buf. */
+	size_t dio_len;
+	/**
+	 * Sparse index of the file, see xlog_opts::index_step.
+	 * Saved to a separate file by xlog_close().
+	 */
+	struct xlog_index_entry *index;
+	/** Number of entries in the index. */
+	int index_size;
+	/** Number of entries the index array has room for. */
+	int index_capacity;
 };
 
 /**
@@ -489,6 +574,30 @@ xlog_is_open(struct xlog *l)
 int
 xlog_rename(struct xlog *l);
 
+/**
+ * Create an empty spare file that can later be turned into
+ * an xlog with xdir_create_xlog_from_spare(), or truncate
+ * an existing one, and preallocate @len bytes of disk space
+ * for it. The amount of preallocated space is returned in
+ * @allocated (it's 0 if the OS doesn't support fallocate).
+ *
+ * Returns the file descriptor on success, -1 on error.
+ */
+int
+xlog_create_spare(const char *filename, size_t len, size_t *allocated);
+
+/**
+ * Same as xdir_create_xlog(), but instead of creating a new
+ * file renames a spare file created with xlog_create_spare(),
+ * which is open with @fd and has @allocated bytes of disk
+ * space preallocated for it. The descriptor is owned by @xlog
+ * on success and closed on failure.
+ */
+int
+xdir_create_xlog_from_spare(struct xdir *dir, struct xlog *xlog,
+			    const struct vclock *vclock, const char *spare,
+			    int fd, size_t allocated);
+
 /**
  * Allocate @size bytes of disk space at the end of the given
  * xlog file.
@@ -538,6 +647,16 @@ xlog_tx_rollback(struct xlog *log);
 ssize_t
 xlog_flush(struct xlog *log);
 
+/**
+ * Let the xlog know that all rows written to it so far are
+ * covered by @vclock. Adds an entry to the sparse index if
+ * enough data has been written since the last entry, see
+ * xlog_opts::index_step. Must be called between transactions,
+ * when there are no buffered rows.
+ */
+void
+xlog_add_index_entry(struct xlog *log, const struct vclock *vclock);
+
 
 /**
  * Sync a log file. The exact action is defined
@@ -627,13 +746,16 @@ xlog_tx_cursor_pos(struct xlog_tx_cursor *tx_cursor)
  * @param data_end the end of @a data buffer
  * @param[out] rows a buffer to store decoded rows
  * @param[out] rows_end the end of @a rows buffer
+ * @param zdctx decompression context
+ * @param zddict dictionary the tx was compressed with or NULL,
+ *               see xlog_opts::zcdict
  * @retval  0 success
  * @retval -1 error, check diag
  */
 int
 xlog_tx_decode(const char *data, const char *data_end,
 	       char *rows, char *rows_end,
-	       ZSTD_DStream *zdctx);
+	       ZSTD_DStream *zdctx, const ZSTD_DDict *zddict);
 
 /* }}} */
 
@@ -740,6 +862,20 @@ xlog_cursor_openmem(struct xlog_cursor *cursor, const char *data, size_t size,
 void
 xlog_cursor_close(struct xlog_cursor *cursor, bool reuse_fd);
 
+/**
+ * Skip the beginning of the file a cursor has just been opened
+ * for up to the last tx such that all rows written before it
+ * are covered by @vclock, i.e. would be skipped by a reader
+ * following @vclock anyway. Uses the index file written by
+ * the xlog writer, see xlog_opts::index_step. Leaves the
+ * cursor as is if there's no index or it doesn't match the
+ * file. If @ignore0 is set, the 0th vclock component, which
+ * is used for replica-local rows, is ignored.
+ */
+void
+xlog_cursor_seek(struct xlog_cursor *cursor, const struct vclock *vclock,
+		 bool ignore0);
+
 /**
  * Open next tx from xlog
  * @param cursor cursor
@@ -6,7 +6,7 @@ local socket = require('socket')
 local fio = require('fio')
 local uuid = require('uuid')
 local msgpack = require('msgpack')
-test:plan(109)
+test:plan(122)
 
 --------------------------------------------------------------------------------
 -- Invalid values
@@ -25,6 +25,7 @@ invalid('memtx_min_tuple_size', 0)
 invalid('memtx_min_tuple_size', -1)
 invalid('memtx_min_tuple_size', 1048281)
 invalid('memtx_min_tuple_size', 1000000000)
+invalid('memtx_checkpoint_max_deltas', -1)
 invalid('replication', '//guest@localhost:3301')
 invalid('replication_timeout', -1)
 invalid('replication_timeout', 0)
@@ -49,7 +50,19 @@ invalid('vinyl_run_count_per_level', 0)
 invalid('vinyl_run_size_ratio', 1)
 invalid('vinyl_bloom_fpr', 0)
 invalid('vinyl_bloom_fpr', 1.1)
+invalid('vinyl_page_index_cache', -1)
+invalid('vinyl_max_subcompactions', 0)
+invalid('vinyl_upsert_squash_threshold', -1)
+invalid('vinyl_upsert_squash_threshold', 129)
+invalid('vinyl_max_write_stall', -1)
+invalid('vinyl_max_compaction_debt', -1)
 invalid('wal_queue_max_size', -1)
+invalid('wal_commit_delay', -1)
+invalid('wal_commit_min_size', -1)
+invalid('wal_spare_files', -1)
+invalid('wal_spare_files', 9)
+invalid('wal_compression', 'lz4')
+invalid('wal_compression_level', 23)
 
 local function invalid_combinations(name, val)
     local status, result = pcall(box.cfg, val)
@@ -26,6 +26,7 @@ box.cfg{replication = {}}
 box.cfg{memtx_memory = "100500"}
 box.cfg{memtx_memory = -1}
 box.cfg{vinyl_memory = -1}
+box.cfg{vinyl_page_index_cache = -1}
 box.cfg{vinyl = "vinyl"}
 box.cfg{vinyl_write_threads = "threads"}
 --
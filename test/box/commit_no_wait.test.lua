@@ -0,0 +1,49 @@
+test_run = require('test_run').new()
+errinj = box.error.injection
+
+--
+-- box.commit({wait = 'none'}) returns before the WAL write.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+box.commit(1)
+box.commit({wait = 1})
+box.commit({wait = 'foo'})
+box.commit({}, {})
+box.commit({wait = 'complete'})
+
+lsn = box.info.lsn
+committed = false
+errinj.set('ERRINJ_WAL_DELAY', true)
+box.begin() s:replace{1} box.on_commit(function() committed = true end) box.commit({wait = 'none'})
+s:get(1)
+box.info.lsn == lsn
+committed
+errinj.set('ERRINJ_WAL_DELAY', false)
+box.ctl.wal_sync()
+box.info.lsn == lsn + 1
+committed
+
+-- The default mode waits for the write.
+box.begin() s:replace{2} box.commit({wait = 'complete'})
+box.info.lsn == lsn + 2
+
+-- A failed write rolls the transaction back.
+rolled_back = false
+errinj.set('ERRINJ_WAL_WRITE', true)
+box.begin() s:replace{3} box.on_rollback(function() rolled_back = true end) box.commit({wait = 'none'})
+test_run:wait_cond(function() return rolled_back end)
+s:get(3)
+errinj.set('ERRINJ_WAL_WRITE', false)
+
+-- Many transactions in flight.
+errinj.set('ERRINJ_WAL_DELAY', true)
+for i = 10, 100 do box.begin() s:replace{i} box.commit({wait = 'none'}) end
+box.info.lsn == lsn + 2
+errinj.set('ERRINJ_WAL_DELAY', false)
+box.ctl.wal_sync()
+box.info.lsn == lsn + 93
+s:count()
+
+s:drop()
@@ -0,0 +1,38 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Group commit: wal_commit_delay and wal_commit_min_size.
+--
+box.cfg.wal_commit_delay
+box.cfg.wal_commit_min_size
+box.cfg{wal_commit_delay = -1}
+box.cfg{wal_commit_min_size = -1}
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+-- Without a delay every batch is written right away.
+box.stat.reset()
+for i = 1, 10 do s:replace{i} end
+stat = box.stat.wal()
+stat.commit_delay
+stat.batch_count
+stat.batch_size
+stat.batch_wait
+
+-- The configured delay is used as is unless wal_mode is 'fsync'.
+box.cfg{wal_commit_delay = 0.1, wal_commit_min_size = 1024 * 1024}
+box.stat.wal().commit_delay
+
+-- Transactions committed by concurrent fibers within the delay
+-- are written together, in order.
+box.stat.reset()
+ch = fiber.channel(10)
+for i = 1, 10 do fiber.create(function() fiber.sleep(i * 0.001) s:replace{i, i} ch:put(true) end) end
+for i = 1, 10 do ch:get() end
+box.stat.wal().batch_count < 10
+s:select()
+
+box.cfg{wal_commit_delay = 0, wal_commit_min_size = 64 * 1024}
+s:drop()
@@ -0,0 +1,110 @@
+test_run = require('test_run').new()
+fio = require('fio')
+
+--
+-- Values of non-indexed fields longer than blob_threshold are
+-- stored in a separate blob file.
+--
+temp = box.schema.space.create('temp')
+_ = temp:create_index('pk')
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {run_count_per_level = 10, blob_threshold = 100})
+s.index.pk.options.blob_threshold
+
+test_run:cmd("setopt delimiter ';'")
+function count_blobs()
+    local path = fio.pathjoin(box.cfg.vinyl_dir, s.id, s.index.pk.id)
+    return #fio.glob(fio.pathjoin(path, '*.blob'))
+end;
+function check()
+    local r = {}
+    for _, t in s:pairs() do
+        table.insert(r, string.format('%d %d %d', t[1], #t[2], t[3]))
+    end
+    return r
+end;
+test_run:cmd("setopt delimiter ''");
+
+for i = 1, 10 do s:replace{i, string.rep('x', 200), i} end
+box.snapshot()
+count_blobs() -- 1
+
+-- UPSERTs are applied to values read from the blob file.
+-- Statements that are not changed by compaction keep
+-- referring to the blob file of the compacted run.
+for i = 1, 5 do s:upsert({i, '', 0}, {{'=', 3, 100}}) end
+for i = 11, 15 do s:replace{i, 'y', i} end
+box.snapshot()
+count_blobs() -- 1
+s.index.pk:compact()
+test_run:wait_cond(function() return s.index.pk:stat().disk.compaction.count > 0 end)
+s.index.pk:stat().run_count -- 1
+count_blobs() -- 2
+check()
+
+-- The blob file of a compacted run is kept while
+-- it is referenced, including after restart.
+test_run:cmd('restart server default')
+test_run = require('test_run').new()
+fio = require('fio')
+s = box.space.test
+temp = box.space.temp
+test_run:cmd("setopt delimiter ';'")
+function count_blobs()
+    local path = fio.pathjoin(box.cfg.vinyl_dir, s.id, s.index.pk.id)
+    return #fio.glob(fio.pathjoin(path, '*.blob'))
+end;
+function check()
+    local r = {}
+    for _, t in s:pairs() do
+        table.insert(r, string.format('%d %d %d', t[1], #t[2], t[3]))
+    end
+    return r
+end;
+test_run:cmd("setopt delimiter ''");
+default_checkpoint_count = box.cfg.checkpoint_count
+box.cfg{checkpoint_count = 1}
+temp:auto_increment{}
+box.snapshot()
+count_blobs() -- 2
+check()
+
+-- Blob files are deleted once no run refers to them.
+for i = 1, 10 do s:replace{i, 'y', i} end
+box.snapshot()
+s.index.pk:compact()
+test_run:wait_cond(function() return s.index.pk:stat().disk.compaction.count > 0 end)
+s.index.pk:stat().run_count -- 1
+temp:auto_increment{}
+box.snapshot()
+count_blobs() -- 0
+check()
+
+s:drop()
+temp:drop()
+box.cfg{checkpoint_count = default_checkpoint_count}
+
+--
+-- A deferred DELETE is generated from the resolved tuple if
+-- a secondary index created after a field was moved to a blob
+-- file indexes this field.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {run_count_per_level = 10, blob_threshold = 100})
+for i = 1, 5 do s:replace{i, string.rep(tostring(i), 200)} end
+box.snapshot()
+sk = s:create_index('sk', {run_count_per_level = 10, parts = {2, 'string'}})
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+box.cfg{vinyl_cache = vinyl_cache}
+for i = 1, 5 do s:replace{i, tostring(i)} end
+box.snapshot()
+pk:compact()
+test_run:wait_cond(function() return pk:stat().disk.compaction.count > 0 end)
+box.snapshot()
+sk:compact()
+test_run:wait_cond(function() return sk:stat().disk.compaction.count > 0 end)
+sk:stat().rows -- 5 new REPLACEs
+sk:select()
+s:drop()
@@ -0,0 +1,49 @@
+test_run = require('test_run').new()
+
+--
+-- A secondary index is built from the primary index runs in
+-- worker threads if vinyl_max_subcompactions > 1.
+--
+box.cfg{vinyl_max_subcompactions = 3}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {range_size = 64 * 1024, page_size = 1024})
+pad = string.rep('x', 200)
+for i = 1, 1000 do s:replace{i, i % 100, 1000 - i, pad} end
+box.snapshot()
+for i = 1, 1000, 2 do s:replace{i, i % 100, 2000 - i, pad} end
+for i = 1, 1000, 10 do s:delete{i} end
+
+-- Non-unique index.
+_ = s:create_index('i1', {unique = false, parts = {2, 'unsigned'}})
+test_run:grep_log('default', 'building index from') ~= nil
+s.index.i1:count() == s:count()
+s.index.i1:count{10} -- 10
+s.index.i1:pairs({10}):take(2):map(function(t) return t[1] end):totable()
+s.index.i1:select({9}, {iterator = 'lt', limit = 1})[1][1]
+
+-- Unique index.
+_ = s:create_index('i2', {parts = {3, 'unsigned'}})
+s.index.i2:count() == s:count()
+s.index.i2:get{1001}[1]
+s.index.i2:get{1997}[1]
+s.index.i2:get{1999} -- nil, deleted
+s.index.i2:get{997} -- nil, overwritten
+s.index.i2:select({}, {limit = 1})[1][1]
+
+-- Unique constraint violation.
+ok, err = pcall(s.create_index, s, 'i3', {parts = {2, 'unsigned'}})
+ok, err.code == box.error.TUPLE_FOUND
+s.index.i3 == nil
+
+-- Nullable unique index allows multiple nulls.
+_ = s:create_index('i4', {parts = {5, 'unsigned', is_nullable = true}})
+s.index.i4:count() == s:count()
+s.index.i4:drop()
+
+-- The new index survives restart.
+test_run:cmd('restart server default')
+s = box.space.test
+s.index.i1:count() == s:count()
+s.index.i2:count() == s:count()
+s:drop()
@@ -0,0 +1,64 @@
+test_run = require('test_run').new()
+
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 100 * 1000}
+
+--
+-- A scan doesn't evict tuples that were read more than once.
+--
+hot = box.schema.space.create('hot', {engine = 'vinyl'})
+_ = hot:create_index('pk')
+cold = box.schema.space.create('cold', {engine = 'vinyl'})
+_ = cold:create_index('pk')
+pad = string.rep('x', 1000)
+for i = 1, 20 do hot:replace{i, pad} end
+for i = 1, 200 do cold:replace{i, pad} end
+box.snapshot()
+for i = 1, 20 do hot:get{i} end
+for i = 1, 20 do hot:get{i} end
+hot.index.pk:stat().cache.rows
+#cold:select()
+cold.index.pk:stat().cache.evict.rows > 0
+hot.index.pk:stat().cache.rows
+hot.index.pk:stat().cache.evict.rows
+
+--
+-- A select with fill_cache = false doesn't populate the cache.
+--
+_ = cold:create_index('sk', {parts = {1, 'unsigned', 2, 'string'}})
+st1 = cold.index.pk:stat().cache
+st2 = cold.index.sk:stat().cache
+#cold:select({}, {fill_cache = false})
+#cold.index.sk:select({}, {fill_cache = false})
+cold.index.pk:stat().cache.put.rows - st1.put.rows
+cold.index.sk:stat().cache.put.rows - st2.put.rows
+#cold.index.sk:select({}, {fill_cache = true, limit = 10})
+cold.index.sk:stat().cache.put.rows - st2.put.rows
+hot:drop()
+cold:drop()
+
+--
+-- The share of the cache that may be used by an index.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {cache_share = 2})
+s:create_index('pk', {cache_share = -1})
+s:create_index('pk', {cache_share = 'x'})
+pk = s:create_index('pk', {cache_share = 0.1})
+pk.options.cache_share
+for i = 1, 100 do s:replace{i, pad} end
+#s:select()
+pk:stat().cache.rows > 0
+pk:stat().cache.bytes < 15 * 1000
+pk:alter{cache_share = 0}
+s.index.pk.options.cache_share
+st = pk:stat().cache
+for i = 1, 100 do s:get{i} end
+pk:stat().cache.put.rows - st.put.rows
+pk:alter{cache_share = 1}
+s.index.pk.options.cache_share
+#s:select()
+pk:stat().cache.bytes > 50 * 1000
+s:drop()
+
+box.cfg{vinyl_cache = vinyl_cache}
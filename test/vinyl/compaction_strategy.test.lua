@@ -0,0 +1,45 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Tiered compaction strategy and TTL-based compaction.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {compaction_strategy = 'universal'})
+s:create_index('pk', {compaction_ttl = -1})
+
+_ = s:create_index('pk', {run_count_per_level = 2, compaction_strategy = 'tiered'})
+s.index.pk.options.compaction_strategy
+s.index.pk.options.compaction_ttl
+
+test_run:cmd("setopt delimiter ';'")
+function dump()
+    for i = 1, 10 do
+        s:replace{i, i}
+    end
+    box.snapshot()
+end;
+test_run:cmd("setopt delimiter ''");
+
+-- Runs of the same tier get merged once the tier is full.
+dump()
+dump()
+s.index.pk:stat().run_count -- 2
+test_run:wait_cond(function() dump() return s.index.pk:stat().disk.compaction.count > 0 end)
+s:count()
+s:drop()
+
+-- A range whose oldest run has expired gets compacted.
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {run_count_per_level = 10, compaction_strategy = 'tiered', compaction_ttl = 1})
+s.index.pk.options.compaction_ttl
+dump()
+dump()
+s.index.pk:stat().run_count -- 2
+s.index.pk:stat().disk.compaction.count -- 0
+fiber.sleep(1.1)
+dump()
+test_run:wait_cond(function() return s.index.pk:stat().disk.compaction.count > 0 end)
+test_run:wait_cond(function() return s.index.pk:stat().run_count == 1 end)
+s:count()
+s:drop()
@@ -0,0 +1,85 @@
+test_run = require('test_run').new()
+
+--
+-- Page compression options.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {compression = 'lz4'})
+s:create_index('pk', {compression_level = 0})
+s:create_index('pk', {compression_level = 23})
+_ = s:create_index('pk', {compression = 'none'})
+s.index.pk.options.compression
+s.index.pk.options.compression_level
+s.index.pk.options.compression_dict_size
+_ = s:create_index('sk', {parts = {2, 'string'}, compression_level = 19, compression_dict_size = 4096})
+s.index.sk.options.compression
+s.index.sk.options.compression_level
+s.index.sk.options.compression_dict_size
+s:drop()
+
+test_run:cmd("setopt delimiter ';'")
+function fill(s)
+    for k = 0, 1 do
+        for i = 1, 1000 do
+            if i % 2 == k then
+                s:replace{i, string.format('user%05d@example.com', i),
+                          string.rep('payload ' .. i % 10, 10)}
+            end
+        end
+        box.snapshot()
+    end
+    s.index.pk:compact()
+    test_run:wait_cond(function()
+        return s.index.pk:stat().disk.compaction.count > 0
+    end)
+end;
+function check(s)
+    local count = 0
+    for _, t in s:pairs() do
+        if t[2] ~= string.format('user%05d@example.com', t[1]) then
+            return t
+        end
+        count = count + 1
+    end
+    return count
+end;
+test_run:cmd("setopt delimiter ''");
+
+-- Uncompressed pages.
+s1 = box.schema.space.create('test1', {engine = 'vinyl'})
+_ = s1:create_index('pk', {run_count_per_level = 10, compression = 'none'})
+fill(s1)
+st = s1.index.pk:stat().disk
+st.bytes_compressed >= st.bytes
+check(s1)
+
+-- Pages compressed with a dictionary trained on the run data.
+s2 = box.schema.space.create('test2', {engine = 'vinyl'})
+_ = s2:create_index('pk', {run_count_per_level = 10, compression_level = 9, compression_dict_size = 1024})
+fill(s2)
+st = s2.index.pk:stat().disk
+st.bytes_compressed < st.bytes
+check(s2)
+
+-- The dictionary is loaded from the index file on recovery.
+test_run:cmd('restart server default')
+test_run = require('test_run').new()
+s1 = box.space.test1
+s2 = box.space.test2
+test_run:cmd("setopt delimiter ';'")
+function check(s)
+    local count = 0
+    for _, t in s:pairs() do
+        if t[2] ~= string.format('user%05d@example.com', t[1]) then
+            return t
+        end
+        count = count + 1
+    end
+    return count
+end;
+test_run:cmd("setopt delimiter ''");
+check(s1)
+check(s2)
+
+s1:drop()
+s2:drop()
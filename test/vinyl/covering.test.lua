@@ -0,0 +1,64 @@
+test_run = require('test_run').new()
+
+--
+-- Covering secondary indexes.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:format({{'id', 'unsigned'}, {'k', 'unsigned'}, {'v', 'string'}, {'data', 'string'}})
+pk = s:create_index('pk', {run_count_per_level = 10})
+s:create_index('sk', {parts = {'k'}, covers = {'x'}})
+s:create_index('sk', {parts = {'k'}, covers = {64}})
+s:create_index('sk', {parts = {'k'}, covers = 'v'})
+sk = s:create_index('sk', {parts = {'k'}, covers = {'v'}, run_count_per_level = 10})
+sk.options.covers
+pk:alter({covers = {3}})
+
+for i = 1, 10 do s:replace{i, i * 10, 'x' .. i, string.rep('y', 10)} end
+box.snapshot()
+
+-- Fields that are neither indexed nor covered aren't stored on disk.
+sk:select({}, {covering = true, limit = 3})
+sk:select({}, {limit = 1})
+
+-- DELETEs are written to a covering index right away.
+s:update(1, {{'=', 3, 'new'}})
+s:delete(2)
+box.begin() s:replace{3, 30, 'a', 'b'} s:replace{3, 30, 'c', 'd'} s:delete{3} box.commit()
+box.snapshot()
+sk:select({}, {covering = true, limit = 3})
+
+sk:compact()
+test_run:wait_cond(function() return sk:stat().disk.compaction.count > 0 end)
+sk:select({}, {covering = true, limit = 3})
+
+-- Tuples stored in memory are returned as is.
+s:replace{11, 110, 'x11', 'z'}
+sk:select({110}, {covering = true})
+
+-- A covering select doesn't look up the primary index.
+lookup = pk:stat().lookup
+#sk:select({}, {covering = true})
+pk:stat().lookup - lookup
+#sk:select({})
+pk:stat().lookup - lookup
+
+test_run:cmd('restart server default')
+s = box.space.test
+sk = s.index.sk
+sk:select({}, {covering = true, limit = 3})
+
+-- Changing covered fields rebuilds the index.
+sk:alter({covers = {'v', 'data'}})
+sk.options.covers
+box.snapshot()
+sk:select({}, {covering = true, limit = 3})
+
+-- Memtx indexes return full tuples.
+m = box.schema.space.create('memtx')
+_ = m:create_index('pk')
+_ = m:create_index('sk', {parts = {2, 'unsigned'}, covers = {3}})
+m:replace{1, 10, 'a', 'b'}
+m.index.sk:select({}, {covering = true})
+m:drop()
+
+s:drop()
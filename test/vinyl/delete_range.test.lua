@@ -0,0 +1,86 @@
+test_run = require('test_run').new()
+
+--
+-- index:delete_range(from, to) deletes all tuples whose primary
+-- keys are within [from, to] by writing a single range tombstone.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}})
+for i = 1, 20 do s:replace{i, i * 10} end
+box.snapshot()
+for i = 11, 30 do s:replace{i, i * 10 + 1} end
+
+s.index.pk:delete_range({5}, {25})
+s:select()
+s.index.sk:select()
+s:get(10)
+s.index.sk:get(101)
+s:count()
+
+-- Newer statements are not affected.
+s:replace{10, 1000}
+s:upsert({11, 0}, {{'+', 2, 1}})
+s:select()
+s.index.sk:select()
+
+-- Errors.
+s.index.sk:delete_range({10}, {20})
+s.index.pk:delete_range({'a'}, {20})
+s.index.pk:delete_range({1, 2}, {20})
+box.begin() s:replace{100, 1000} ok, err = pcall(s.index.pk.delete_range, s.index.pk, {1}, {2}) box.rollback()
+ok, tostring(err)
+box.begin() s.index.pk:delete_range({1}, {2}) ok, err = pcall(s.replace, s, {100, 1000}) box.rollback()
+ok, tostring(err)
+s:get(1)
+m = box.schema.space.create('memtx')
+_ = m:create_index('pk')
+m.index.pk:delete_range({1}, {2})
+m:drop()
+-- A replica that may not know DELETE_RANGE blocks it.
+_ = box.space._cluster:insert{10, 'aaaaaaaa-aaaa-aaaa-aaaa-aaaaaaaaaaaa'}
+s.index.pk:delete_range({1}, {2})
+_ = box.space._cluster:delete{10}
+
+-- The tombstone survives restart.
+test_run:cmd('restart server default')
+s = box.space.test
+s:select()
+s.index.sk:select()
+
+-- Major compaction purges deleted statements and the tombstone.
+box.snapshot()
+s.index.pk:compact()
+s.index.sk:compact()
+test_run:wait_cond(function() return s.index.pk:stat().disk.rows == 11 end)
+test_run:wait_cond(function() return s.index.sk:stat().disk.rows == 11 end)
+test_run:wait_log('default', 'purged range tombstone', nil, 10) ~= nil
+s:select()
+s.index.sk:select()
+
+-- Empty bounds delete everything.
+s.index.pk:delete_range({}, {})
+s:select()
+
+-- Only transactions that have read deleted keys conflict with
+-- range deletion.
+for i = 1, 10 do s:replace{i, i} end
+txn_proxy = require('txn_proxy')
+c1 = txn_proxy.new()
+c2 = txn_proxy.new()
+c3 = txn_proxy.new()
+c1:begin()
+c2:begin()
+c3:begin()
+c1("s:get(1)")
+c2("s:get(5)")
+c3("s.index.sk:get(6)")
+c1("s:replace{101, 101}")
+c2("s:replace{102, 102}")
+c3("s:replace{103, 103}")
+s.index.pk:delete_range({4}, {7})
+c1:commit()
+c2:commit()
+c3:commit()
+s:select()
+s:drop()
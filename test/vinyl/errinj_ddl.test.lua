@@ -353,3 +353,45 @@ _ = s:create_index('secondary', {parts = {2, 'unsigned'}}) -- error
 box.error.injection.set('ERRINJ_WAL_DELAY', false)
 box.error.injection.set('ERRINJ_WAL_SYNC', false)
 s:drop()
+
+--
+-- Check that tuples inserted while a unique index is built
+-- in worker threads are checked for uniqueness.
+--
+box.cfg{vinyl_max_subcompactions = 2}
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 100 do s:replace{i, i} end
+box.snapshot()
+
+box.error.injection.set('ERRINJ_VY_RUN_WRITE_DELAY', true)
+ch = fiber.channel(1)
+test_run:cmd("setopt delimiter ';'")
+_ = fiber.create(function()
+    local ok, err = pcall(s.create_index, s, 'sk', {parts = {2, 'unsigned'}})
+    ch:put(ok or err.message)
+end);
+test_run:cmd("setopt delimiter ''");
+fiber.sleep(0.01)
+s:replace{101, 101} -- ok
+s:replace{102, 50} -- conflicts with {50, 50}
+box.error.injection.set('ERRINJ_VY_RUN_WRITE_DELAY', false)
+ch:get()
+s.index.sk == nil
+s:delete{102}
+
+box.error.injection.set('ERRINJ_VY_RUN_WRITE_DELAY', true)
+test_run:cmd("setopt delimiter ';'")
+_ = fiber.create(function()
+    local ok, err = pcall(s.create_index, s, 'sk', {parts = {2, 'unsigned'}})
+    ch:put(ok or err.message)
+end);
+test_run:cmd("setopt delimiter ''");
+fiber.sleep(0.01)
+s:replace{102, 102}
+box.error.injection.set('ERRINJ_VY_RUN_WRITE_DELAY', false)
+ch:get()
+s.index.sk:count() -- 102
+s.index.sk:get{102}
+s:drop()
+box.cfg{vinyl_max_subcompactions = 1}
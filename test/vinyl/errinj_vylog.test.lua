@@ -203,3 +203,45 @@ test_run:cmd('restart server default')
 s = box.space.test
 s.index[1] == nil
 s:drop()
+
+--
+-- Check that the metadata log is compacted when it grows too big
+-- and that the instance recovers from the compacted log.
+--
+fio = require('fio')
+xlog = require('xlog')
+
+test_run:cmd("setopt delimiter ';'")
+function vylog_has_compact_record()
+    local files = fio.glob(fio.pathjoin(box.cfg.vinyl_dir, '*.vylog'))
+    table.sort(files)
+    for _, row in xlog.pairs(files[#files]) do
+        if row.BODY.tuple[1] == 18 then
+            return true
+        end
+    end
+    return false
+end;
+test_run:cmd("setopt delimiter ''");
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 10 do s:replace{i, i} end
+box.snapshot()
+
+box.error.injection.set('ERRINJ_VY_LOG_COMPACT_THRESHOLD', 0)
+for i = 1, 5 do s:create_index('sk', {parts = {2, 'unsigned'}}) s.index.sk:drop() end
+test_run:wait_cond(function() return test_run:grep_log('default', 'compacted vylog') ~= nil end)
+box.error.injection.set('ERRINJ_VY_LOG_COMPACT_THRESHOLD', -1)
+vylog_has_compact_record()
+
+_ = s:create_index('sk', {parts = {2, 'unsigned'}})
+s:replace{11, 11}
+
+test_run:cmd('restart server default')
+
+s = box.space.test
+s:count()
+s.index.sk:select{11}
+s.index.sk:count()
+s:drop()
@@ -819,6 +819,34 @@ box.commit()
 
 s:drop()
 
+--
+-- If a range consists of a single run slice while memory and
+-- the cache are empty, the iterator skips the merge and reads
+-- the run directly. Check that it switches back to the merge
+-- if the space is modified during iteration.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 10 do s:replace{i} end
+box.snapshot()
+lookup = s.index.pk:stat().cache.lookup
+s:select()
+s.index.pk:stat().cache.lookup - lookup -- 0
+lookup = s.index.pk:stat().cache.lookup
+s:select()
+s.index.pk:stat().cache.lookup - lookup > 0 -- cache is used
+s:drop()
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 10 do s:replace{i} end
+box.snapshot()
+box.begin()
+res = {}
+for _, t in s:pairs() do table.insert(res, t[1]) if t[1] == 5 then s:replace{20} s:delete{7} end end
+box.commit()
+res
+s:drop()
+
 -- Collect all iterators to make sure no read views are left behind,
 -- as they might disrupt the following test run.
 collectgarbage()
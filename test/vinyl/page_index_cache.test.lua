@@ -0,0 +1,51 @@
+test_run = require('test_run').new()
+
+--
+-- Page index and bloom filter of a large run are split into
+-- partitions stored in the run file and loaded on demand.
+--
+box.cfg{vinyl_cache = 0}
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 64, run_count_per_level = 10})
+pad = string.rep('x', 64)
+for i = 1, 1000 do s:replace{i, pad} end
+box.snapshot()
+
+stat = s.index.pk:stat()
+stat.disk.pages > 64 -- true
+mem = box.stat.vinyl().memory.page_index
+mem < stat.disk.index_size -- true
+
+s:get{500}[1]
+s:select({100}, {iterator = 'lt', limit = 1})[1][1]
+s:select({100}, {iterator = 'ge', limit = 1})[1][1]
+s:count()
+box.stat.vinyl().memory.page_index > mem -- true
+
+for i = 1001, 1100 do s:get{i} end
+s.index.pk:stat().disk.iterator.bloom.hit > 0 -- true
+
+-- Setting the cache size to 0 unloads all partitions.
+box.cfg{vinyl_page_index_cache = 0}
+box.stat.vinyl().memory.page_index == mem -- true
+s:get{1000}[1]
+box.stat.vinyl().memory.page_index == mem -- true
+
+-- Compaction of partitioned runs.
+for i = 1, 1000, 2 do s:delete{i} end
+box.snapshot()
+s.index.pk:compact()
+test_run:wait_cond(function() return s.index.pk:stat().disk.compaction.count > 0 end)
+s:count()
+s:get{1} -- nil
+s:get{2}[1]
+
+-- Recovery.
+test_run:cmd('restart server default')
+s = box.space.test
+s:count()
+s:get{999} -- nil
+s:get{1000}[1]
+s:select({500}, {iterator = 'le', limit = 1})[1][1]
+box.cfg.vinyl_page_index_cache
+s:drop()
@@ -0,0 +1,44 @@
+test_run = require('test_run').new()
+
+--
+-- A run iterator reads up to readahead_pages pages ahead once
+-- it notices that it reads pages one after another.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {readahead_pages = 65})
+s:create_index('pk', {readahead_pages = -1})
+_ = s:create_index('pk', {page_size = 1024, range_size = 1024 * 1024, readahead_pages = 4})
+s.index.pk.options.readahead_pages
+pad = string.rep('x', 100)
+for i = 1, 1000 do s:replace{i, pad} end
+box.snapshot()
+
+function readahead() return s.index.pk:stat().disk.iterator.readahead end
+readahead()
+
+-- Full scan uses all pages read ahead.
+#s:select({}, {fill_cache = false})
+st = readahead()
+st.pages > 0
+st.pages == st.used
+#s:select({}, {iterator = 'LE', fill_cache = false})
+st = readahead()
+st.pages == st.used
+
+-- Pages read ahead are dropped if the iterator stops.
+#s:select({}, {limit = 100, fill_cache = false})
+st = readahead()
+st.pages > st.used
+
+-- Point lookups don't read ahead.
+st = readahead()
+for i = 1, 1000, 10 do s:get(i) end
+readahead().pages == st.pages
+
+-- Readahead can be disabled without rebuilding the index.
+s.index.pk:alter{readahead_pages = 0}
+s.index.pk.options.readahead_pages
+st = readahead()
+#s:select({}, {fill_cache = false})
+readahead().pages == st.pages
+s:drop()
@@ -0,0 +1,39 @@
+test_run = require('test_run').new()
+
+--
+-- The regulator adjusts the dump watermark and the disk-based
+-- rate limit to keep transaction stalls and compaction debt
+-- within the limits set by vinyl_max_write_stall and
+-- vinyl_max_compaction_debt. Zero means no limit.
+--
+box.cfg.vinyl_max_write_stall
+box.cfg.vinyl_max_compaction_debt
+box.cfg{vinyl_max_write_stall = -1}
+box.cfg{vinyl_max_compaction_debt = -1}
+box.cfg.vinyl_max_write_stall
+box.cfg.vinyl_max_compaction_debt
+
+st = box.stat.vinyl().regulator
+type(st.write_stall)
+type(st.compaction_debt)
+-- No limits - the regulator keeps the defaults.
+st.dump_margin
+st.rate_limit_scale
+
+box.cfg{vinyl_max_write_stall = 0.5}
+box.cfg{vinyl_max_compaction_debt = 1024 * 1024 * 1024}
+box.cfg.vinyl_max_write_stall
+box.cfg.vinyl_max_compaction_debt
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 100 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+s:count()
+st = box.stat.vinyl().regulator
+st.dump_margin >= 1.5
+st.rate_limit_scale >= 1
+s:drop()
+
+box.cfg{vinyl_max_write_stall = 0}
+box.cfg{vinyl_max_compaction_debt = 0}
@@ -0,0 +1,37 @@
+test_run = require('test_run').new()
+
+--
+-- Compaction of a big range is split between several worker
+-- threads if vinyl_max_subcompactions > 1.
+--
+box.cfg{vinyl_max_subcompactions = 0}
+box.cfg.vinyl_max_subcompactions
+box.cfg{vinyl_max_subcompactions = 2}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {run_count_per_level = 1, range_size = 64 * 1024, page_size = 1024})
+pad = string.rep('x', 200)
+for i = 1, 1000 do s:replace{i, pad} end
+box.snapshot()
+for i = 1, 1000 do s:replace{i, pad, i} end
+box.snapshot()
+
+test_run:wait_cond(function() return s.index.pk:stat().disk.compaction.count > 0 end)
+test_run:grep_log('default', 'split compaction of range') ~= nil
+s.index.pk:stat().range_count -- 2
+s.index.pk:stat().run_count -- 2
+s:count()
+s:get{1}[3]
+s:get{2}[3]
+s:get{999}[3]
+s:select({500}, {iterator = 'ge', limit = 2})[2][1]
+s:select({500}, {iterator = 'lt', limit = 2})[2][1]
+
+-- Recovery.
+test_run:cmd('restart server default')
+s = box.space.test
+s.index.pk:stat().range_count -- 2
+s:count()
+s:get{999}[3]
+box.cfg.vinyl_max_subcompactions
+s:drop()
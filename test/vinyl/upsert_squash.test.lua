@@ -0,0 +1,39 @@
+test_run = require('test_run').new()
+
+--
+-- Successive UPSERTs for the same key are squashed in the
+-- background once their number reaches the value of the
+-- vinyl_upsert_squash_threshold option. Zero disables it.
+--
+box.cfg.vinyl_upsert_squash_threshold
+box.cfg{vinyl_upsert_squash_threshold = -1}
+box.cfg{vinyl_upsert_squash_threshold = 129}
+box.cfg.vinyl_upsert_squash_threshold
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+-- Write a run so that UPSERTs aren't turned into REPLACEs on commit.
+s:replace{1, 0}
+box.snapshot()
+
+box.cfg{vinyl_upsert_squash_threshold = 10}
+for i = 1, 100 do s:upsert({1, 0}, {{'+', 2, 1}}) end
+st = s.index.pk:stat().upsert
+st.scheduled > 0 and st.scheduled <= 10
+test_run:wait_cond(function() return s.index.pk:stat().upsert.squashed == st.scheduled end)
+s:get(1)
+
+-- Disabled squashing.
+box.cfg{vinyl_upsert_squash_threshold = 0}
+for i = 1, 200 do s:upsert({1, 0}, {{'+', 2, 1}}) end
+s.index.pk:stat().upsert.scheduled - st.scheduled
+
+-- The counter saturates at the max threshold, so the chain
+-- is squashed as soon as squashing is enabled back.
+box.cfg{vinyl_upsert_squash_threshold = 128}
+s:upsert({1, 0}, {{'+', 2, 1}})
+s.index.pk:stat().upsert.scheduled - st.scheduled
+test_run:wait_cond(function() return s.index.pk:stat().upsert.squashed == st.scheduled + 1 end)
+s:get(1)
+
+s:drop()
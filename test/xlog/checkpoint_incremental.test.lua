@@ -0,0 +1,112 @@
+test_run = require('test_run').new()
+fio = require('fio')
+xlog = require('xlog')
+
+--
+-- memtx_checkpoint_max_deltas: up to this many checkpoints made
+-- after a full one only store tuples changed since the previous
+-- checkpoint.
+--
+box.cfg{memtx_checkpoint_max_deltas = -1}
+box.cfg{memtx_checkpoint_max_deltas = 2}
+
+test_run:cmd("setopt delimiter ';'")
+function last_snap()
+    local files = fio.glob(fio.pathjoin(box.cfg.memtx_dir, '*.snap'))
+    table.sort(files)
+    return files[#files]
+end;
+function is_delta(path)
+    local f = fio.open(path)
+    local header = f:read(512)
+    f:close()
+    return header:find('PrevVClock') ~= nil
+end;
+function rows(path)
+    local result = {}
+    for _, row in xlog.pairs(path) do
+        if row.BODY.space_id == s.id then
+            table.insert(result, {row.HEADER.type,
+                                  row.BODY.tuple or row.BODY.key})
+        end
+    end
+    return result
+end;
+test_run:cmd("setopt delimiter ''");
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 10 do s:replace{i} end
+
+-- The first checkpoint is a full one.
+box.snapshot()
+is_delta(last_snap())
+#rows(last_snap())
+
+-- The next ones only store changed tuples and deleted keys.
+s:replace{11}
+s:update(1, {{'=', 2, 'a'}})
+s:delete(2)
+s:delete(3)
+s:insert{3, 'b'}
+box.snapshot()
+is_delta(last_snap())
+rows(last_snap())
+
+s:delete(11)
+s:replace{4, 'c'}
+box.snapshot()
+is_delta(last_snap())
+rows(last_snap())
+
+-- A backup includes all snapshots the checkpoint depends on.
+files = box.backup.start()
+snap_count = 0
+for _, f in ipairs(files) do if f:endswith('.snap') then snap_count = snap_count + 1 end end
+snap_count
+box.backup.stop()
+
+-- Recovery applies incremental snapshots on top of the full one.
+test_run:cmd('restart server default')
+test_run = require('test_run').new()
+fio = require('fio')
+s = box.space.test
+s:select()
+
+test_run:cmd("setopt delimiter ';'")
+function last_snap()
+    local files = fio.glob(fio.pathjoin(box.cfg.memtx_dir, '*.snap'))
+    table.sort(files)
+    return files[#files]
+end;
+function is_delta(path)
+    local f = fio.open(path)
+    local header = f:read(512)
+    f:close()
+    return header:find('PrevVClock') ~= nil
+end;
+test_run:cmd("setopt delimiter ''");
+
+-- Changes made while incremental checkpoints were disabled
+-- aren't tracked so the next checkpoint is a full one.
+box.cfg{memtx_checkpoint_max_deltas = 1}
+s:replace{12}
+box.snapshot()
+is_delta(last_snap())
+
+-- A full checkpoint is made once the limit is reached.
+s:replace{13}
+box.snapshot()
+is_delta(last_snap())
+s:replace{14}
+box.snapshot()
+is_delta(last_snap())
+
+-- Schema changes force a full checkpoint.
+box.schema.space.create('test2'):drop()
+s:replace{15}
+box.snapshot()
+is_delta(last_snap())
+
+box.cfg{memtx_checkpoint_max_deltas = 0}
+s:drop()
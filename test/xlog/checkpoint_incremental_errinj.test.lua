@@ -0,0 +1,52 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+fio = require('fio')
+errinj = box.error.injection
+
+test_run:cmd("setopt delimiter ';'")
+function last_snap()
+    local files = fio.glob(fio.pathjoin(box.cfg.memtx_dir, '*.snap'))
+    table.sort(files)
+    return files[#files]
+end;
+function is_delta(path)
+    local f = fio.open(path)
+    local header = f:read(512)
+    f:close()
+    return header:find('PrevVClock') ~= nil
+end;
+test_run:cmd("setopt delimiter ''");
+
+box.cfg{memtx_checkpoint_max_deltas = 2}
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 10 do s:replace{i} end
+box.snapshot()
+snap = last_snap()
+
+--
+-- Turning incremental checkpoints off while one is running
+-- cancels it, because changes aren't tracked anymore.
+--
+s:replace{11}
+s:delete(1)
+errinj.set('ERRINJ_SNAP_WRITE_DELAY', true)
+ch = fiber.channel(1)
+_ = fiber.create(function() ch:put({pcall(box.snapshot)}) end)
+test_run:wait_cond(function() return box.info.gc().checkpoint_is_in_progress end)
+box.cfg{memtx_checkpoint_max_deltas = 0}
+s:delete(2)
+s:replace{12}
+errinj.set('ERRINJ_SNAP_WRITE_DELAY', false)
+res = ch:get()
+res[1], tostring(res[2])
+last_snap() == snap
+
+-- The next checkpoint is a full one.
+box.snapshot()
+is_delta(last_snap())
+
+test_run:cmd('restart server default')
+s = box.space.test
+s:select()
+s:drop()
@@ -0,0 +1,9 @@
+#!/usr/bin/env tarantool
+
+box.cfg{
+    listen                  = os.getenv("LISTEN"),
+    wal_max_size            = 500,
+    wal_recovery_read_ahead = true,
+}
+
+require('console').listen(os.getenv('ADMIN'))
@@ -0,0 +1,48 @@
+test_run = require('test_run').new()
+fio = require('fio')
+
+--
+-- wal_compression and wal_compression_level select the codec
+-- of WAL tx blocks. They take effect on the next WAL file.
+--
+test_run:cmd("setopt delimiter ';'")
+function last_xlog()
+    local files = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))
+    table.sort(files)
+    return files[#files]
+end;
+function has_zstd_blocks()
+    local f = fio.open(last_xlog())
+    local data = f:read()
+    f:close()
+    return string.find(data, '\xd5\xba\x0b\xba', 1, true) ~= nil
+end;
+test_run:cmd("setopt delimiter ''");
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+box.cfg{wal_compression = 'none'}
+box.snapshot()
+_ = s:replace{1, string.rep('a', 5000)}
+has_zstd_blocks()
+
+-- Fast zstd mode.
+box.cfg{wal_compression = 'zstd', wal_compression_level = -5}
+box.snapshot()
+_ = s:replace{2, string.rep('b', 5000)}
+has_zstd_blocks()
+
+box.cfg{wal_compression_level = 19}
+box.snapshot()
+_ = s:replace{3, string.rep('c', 5000)}
+has_zstd_blocks()
+
+-- WAL files written with different codecs are recovered.
+test_run:cmd('restart server default')
+s = box.space.test
+s:count()
+s:get(1)[2] == string.rep('a', 5000)
+s:get(2)[2] == string.rep('b', 5000)
+s:get(3)[2] == string.rep('c', 5000)
+s:drop()
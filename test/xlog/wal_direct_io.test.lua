@@ -0,0 +1,45 @@
+test_run = require('test_run').new()
+
+--
+-- wal_direct_io: WAL files are written bypassing the page cache.
+-- The xlog format doesn't change. If the file system doesn't
+-- support direct I/O, WAL files are written as usual.
+--
+box.cfg.wal_direct_io
+box.cfg{wal_direct_io = true}
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+-- Write rows of different sizes so that some writes end on
+-- a block boundary and some don't. Random data isn't compressed.
+data = {} math.randomseed(42) for i = 1, 20 do local c = {} for j = 1, i * 1000 - 1 do c[j] = string.char(math.random(0, 255)) end data[i] = table.concat(c) end
+for i = 1, 20 do s:replace{i, data[i]} end
+box.begin() for i = 21, 40 do s:replace{i, data[i - 20]} end box.commit()
+for i = 1, 40 do assert(s:get(i)[2] == data[(i - 1) % 20 + 1]) end
+
+-- Readers stop at the zero padding of the last block of the
+-- current WAL. The padding is cut off when the WAL is closed.
+fio = require('fio')
+xlog = require('xlog')
+files = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog')) table.sort(files) wal = files[#files]
+last = nil for _, row in xlog.pairs(wal) do last = row end
+last.BODY.tuple[1]
+box.snapshot()
+last = nil for _, row in xlog.pairs(wal) do last = row end
+last.BODY.tuple[1]
+-- Zeros anywhere but at the end of the last block of a WAL are
+-- still an error.
+f = fio.open(wal, {'O_RDONLY'}) content = f:read(fio.stat(wal).size) f:close()
+broken = fio.pathjoin(fio.tempdir(), fio.basename(wal))
+f = fio.open(broken, {'O_WRONLY', 'O_CREAT'}, tonumber('644', 8)) f:write(content:sub(1, 200000) .. string.rep('\0', 8192) .. content:sub(208193)) f:close()
+ok = pcall(function() for _ in xlog.pairs(broken) do end end)
+ok
+
+test_run:cmd('restart server default')
+data = {} math.randomseed(42) for i = 1, 20 do local c = {} for j = 1, i * 1000 - 1 do c[j] = string.char(math.random(0, 255)) end data[i] = table.concat(c) end
+s = box.space.test
+s:count()
+for i = 1, 40 do assert(s:get(i)[2] == data[(i - 1) % 20 + 1]) end
+box.cfg.wal_direct_io
+s:drop()
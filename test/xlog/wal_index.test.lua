@@ -0,0 +1,44 @@
+test_run = require('test_run').new()
+
+--
+-- A WAL file gets a sparse index mapping vclocks to file offsets
+-- when it's closed. Relays use it to skip rows the replica has.
+--
+test_run:cmd('create server master with script = "xlog/wal_index.lua"')
+test_run:cmd('start server master')
+test_run:cmd('create server replica with rpl_master=master, script="xlog/replica.lua"')
+
+test_run:cmd('switch master')
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+-- Use random data, because WAL blocks are compressed.
+digest = require('digest')
+for i = 1, 150 do s:replace{i, digest.urandom(10000)} end
+
+test_run:cmd('start server replica')
+test_run:cmd('switch replica')
+test_run:wait_cond(function() return box.space.test ~= nil and box.space.test:count() == 150 end)
+test_run:cmd('switch master')
+test_run:cmd('stop server replica')
+
+-- Rotate the WAL so that the index is written.
+for i = 151, 300 do s:replace{i, digest.urandom(10000)} end
+box.snapshot()
+fio = require('fio')
+#fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog.index'))
+
+-- The relay seeks to the rows the replica doesn't have.
+test_run:cmd('start server replica')
+test_run:cmd('switch replica')
+test_run:wait_cond(function() return box.space.test:count() == 300 end)
+box.space.test:get(300)[1]
+test_run:cmd('switch default')
+test_run:grep_log('master', 'skipped %d+ bytes using index') ~= nil
+
+test_run:cmd('stop server replica')
+test_run:cmd('cleanup server replica')
+test_run:cmd('delete server replica')
+test_run:cmd('stop server master')
+test_run:cmd('cleanup server master')
+test_run:cmd('delete server master')
@@ -0,0 +1,37 @@
+test_run = require('test_run').new()
+
+--
+-- WAL files except the last one are read ahead in a separate
+-- thread on recovery if wal_recovery_read_ahead is set.
+--
+test_run:cmd('create server test with script = "xlog/read_ahead.lua"')
+test_run:cmd('start server test')
+test_run:cmd('switch test')
+
+fio = require('fio')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 100 do s:replace{i, string.rep('x', i)} end
+#fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog')) > 10
+for i = 1, 100, 2 do s:delete{i} end
+
+test_run:cmd('restart server test')
+s = box.space.test
+s:count()
+s:get(1)
+s:get(2)[2] == string.rep('x', 2)
+s:get(100)[2] == string.rep('x', 100)
+test_run:cmd('switch default')
+test_run:grep_log('test', 'reading %d+ WAL files ahead') ~= nil
+
+-- Rows written after recovery are recovered as well.
+test_run:cmd('switch test')
+for i = 101, 120 do s:replace{i} end
+test_run:cmd('restart server test')
+box.space.test:count()
+box.space.test:max()
+
+test_run:cmd('switch default')
+test_run:cmd('stop server test')
+test_run:cmd('cleanup server test')
+test_run:cmd('delete server test')
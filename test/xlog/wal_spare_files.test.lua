@@ -0,0 +1,39 @@
+test_run = require('test_run').new()
+fio = require('fio')
+
+--
+-- wal_spare_files: the WAL thread keeps empty WAL files with
+-- disk space preallocated for them and uses them on rotation.
+--
+function spare(i) return fio.pathjoin(box.cfg.wal_dir, 'spare' .. i .. '.xlog.inprogress') end
+function spares_ready() return fio.path.exists(spare(0)) and fio.path.exists(spare(1)) end
+
+box.cfg{wal_spare_files = 2}
+test_run:wait_cond(spares_ready)
+fio.stat(spare(0)).size
+fio.stat(spare(1)).size
+
+-- WAL files are rotated after every few writes (wal_max_size = 500).
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 20 do s:replace{i, string.rep('x', 100)} end
+
+-- Used spare files are replaced.
+test_run:wait_cond(spares_ready)
+fio.stat(spare(0)).size
+fio.stat(spare(1)).size
+
+-- WAL files created from spare files are recovered.
+test_run:cmd('restart server default')
+fio = require('fio')
+s = box.space.test
+s:count()
+s:get(20)[1]
+
+-- Spare files aren't reused after restart so they are
+-- removed on shutdown.
+box.cfg.wal_spare_files
+test_run:wait_cond(function() return not fio.path.exists(fio.pathjoin(box.cfg.wal_dir, 'spare0.xlog.inprogress')) end)
+test_run:wait_cond(function() return not fio.path.exists(fio.pathjoin(box.cfg.wal_dir, 'spare1.xlog.inprogress')) end)
+
+s:drop()